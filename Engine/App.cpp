@@ -25,6 +25,19 @@
 
 using std::tr1::shared_ptr;
 
+// Profiler names of the pass that lights the scene, by LightCullTechnique
+// NOTE: Forward techniques draw the geometry in the same pass
+static const char* kLightingPassNames[] = {
+    "Forward",
+    "Forward with pre-Z",
+    "Lighting: deferred",
+    "Lighting: quad",
+    "Lighting: quad deferred",
+    "Lighting: compute tile",
+    "Lighting: clustered",
+    "Forward clustered",
+};
+
 // NOTE: Must match layout of shader constant buffers
 
 __declspec(align(16))
@@ -41,6 +54,13 @@ struct PerFrameConstants
     unsigned int mFramebufferDimensionsZ;
     unsigned int mFramebufferDimensionsW;
 
+    unsigned int mClusterDimensionsX;
+    unsigned int mClusterDimensionsY;
+    unsigned int mClusterDimensionsZ;
+    unsigned int mClusterDimensionsW;
+    D3DXVECTOR4 mClusterSliceParams;
+    unsigned int mLightCount;
+
     UIConstants mUI;
 };
 
@@ -49,8 +69,14 @@ App::App(ID3D11Device *d3dDevice, unsigned int activeLights, unsigned int msaaSa
     : mMSAASamples(msaaSamples)
     , mTotalTime(0.0f)
     , mActiveLights(0)
+    , mVisibleLights(0)
+    , mCullLights(true)
     , mLightBuffer(0)
     , mDepthBufferReadOnlyDSV(0)
+    , mClusterDimensionsX(0)
+    , mClusterDimensionsY(0)
+    , mProfiler(0)
+    , mGpuProfiler(0)
 {
     std::string msaaSamplesStr;
     {
@@ -70,6 +96,7 @@ App::App(ID3D11Device *d3dDevice, unsigned int activeLights, unsigned int msaaSa
     // Create shaders, Careful moving the shaders. Moving them causes memory exceptions during runtime.
 #pragma region Create Shaders
     mGeometryVS = new VertexShader(d3dDevice, L"Rendering.hlsl", "GeometryVS", defines);
+    mGeometryPackedVS = new VertexShader(d3dDevice, L"Rendering.hlsl", "GeometryPackedVS", defines);
 
     mGBufferPS = new PixelShader(d3dDevice, L"GBuffer.hlsl", "GBufferPS", defines);
     mGBufferAlphaTestPS = new PixelShader(d3dDevice, L"GBuffer.hlsl", "GBufferAlphaTestPS", defines);
@@ -89,6 +116,11 @@ App::App(ID3D11Device *d3dDevice, unsigned int activeLights, unsigned int msaaSa
     mBasicLoopPerSamplePS = new PixelShader(d3dDevice, L"BasicLoop.hlsl", "BasicLoopPerSamplePS", defines);
     mComputeShaderTileCS = new ComputeShader(d3dDevice, L"ComputeShaderTile.hlsl", "ComputeShaderTileCS", defines);
 
+    mClusterAssignCS = new ComputeShader(d3dDevice, L"ClusteredShading.hlsl", "ClusterAssignCS", defines);
+    mClusteredDeferredPS = new PixelShader(d3dDevice, L"ClusteredShading.hlsl", "ClusteredDeferredPS", defines);
+    mClusteredDeferredPerSamplePS = new PixelShader(d3dDevice, L"ClusteredShading.hlsl", "ClusteredDeferredPerSamplePS", defines);
+    mClusteredForwardPS = new PixelShader(d3dDevice, L"ClusteredShading.hlsl", "ClusteredForwardPS", defines);
+
     mGPUQuadVS = new VertexShader(d3dDevice, L"GPUQuad.hlsl", "GPUQuadVS", defines);
     mGPUQuadGS = new GeometryShader(d3dDevice, L"GPUQuad.hlsl", "GPUQuadGS", defines);
     mGPUQuadPS = new PixelShader(d3dDevice, L"GPUQuad.hlsl", "GPUQuadPS", defines);
@@ -119,6 +151,15 @@ App::App(ID3D11Device *d3dDevice, unsigned int activeLights, unsigned int msaaSa
             {"position",  0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0,  D3D11_INPUT_PER_VERTEX_DATA, 0},
             {"normal",    0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0},
             {"texCoord",  0, DXGI_FORMAT_R32G32_FLOAT,    0, 24, D3D11_INPUT_PER_VERTEX_DATA, 0},
+            // Per-object transforms, one ObjectConstants (Rendering/DrawBatcher.h) per instance
+            {"worldViewProj", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 0,   D3D11_INPUT_PER_INSTANCE_DATA, 1},
+            {"worldViewProj", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 16,  D3D11_INPUT_PER_INSTANCE_DATA, 1},
+            {"worldViewProj", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 32,  D3D11_INPUT_PER_INSTANCE_DATA, 1},
+            {"worldViewProj", 3, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 48,  D3D11_INPUT_PER_INSTANCE_DATA, 1},
+            {"worldView",     0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 64,  D3D11_INPUT_PER_INSTANCE_DATA, 1},
+            {"worldView",     1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 80,  D3D11_INPUT_PER_INSTANCE_DATA, 1},
+            {"worldView",     2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 96,  D3D11_INPUT_PER_INSTANCE_DATA, 1},
+            {"worldView",     3, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 112, D3D11_INPUT_PER_INSTANCE_DATA, 1},
         };
         
         d3dDevice->CreateInputLayout( 
@@ -128,6 +169,36 @@ App::App(ID3D11Device *d3dDevice, unsigned int activeLights, unsigned int msaaSa
             &mMeshVertexLayout);
 
         bytecode->Release();
+
+        // Scene graph models use the compact vertices packed by ModelClass
+        hr = D3DX11CompileFromFile(L"Rendering.hlsl", defines, 0, "GeometryPackedVS", "vs_5_0", shaderFlags, 0, 0, &bytecode, 0, 0);
+        if (FAILED(hr)) {
+            assert(false);      // It worked earlier...
+        }
+
+        const D3D11_INPUT_ELEMENT_DESC packedLayout[] =
+        {
+            {"position",  0, DXGI_FORMAT_R16G16B16A16_SNORM, 0, 0,  D3D11_INPUT_PER_VERTEX_DATA, 0},
+            {"texCoord",  0, DXGI_FORMAT_R16G16_FLOAT,       0, 8,  D3D11_INPUT_PER_VERTEX_DATA, 0},
+            {"normal",    0, DXGI_FORMAT_R16G16_SNORM,       0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0},
+            // Per-object transforms, one ObjectConstants (Rendering/DrawBatcher.h) per instance
+            {"worldViewProj", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 0,   D3D11_INPUT_PER_INSTANCE_DATA, 1},
+            {"worldViewProj", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 16,  D3D11_INPUT_PER_INSTANCE_DATA, 1},
+            {"worldViewProj", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 32,  D3D11_INPUT_PER_INSTANCE_DATA, 1},
+            {"worldViewProj", 3, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 48,  D3D11_INPUT_PER_INSTANCE_DATA, 1},
+            {"worldView",     0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 64,  D3D11_INPUT_PER_INSTANCE_DATA, 1},
+            {"worldView",     1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 80,  D3D11_INPUT_PER_INSTANCE_DATA, 1},
+            {"worldView",     2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 96,  D3D11_INPUT_PER_INSTANCE_DATA, 1},
+            {"worldView",     3, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 112, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+        };
+
+        d3dDevice->CreateInputLayout( 
+            packedLayout, ARRAYSIZE(packedLayout), 
+            bytecode->GetBufferPointer(),
+            bytecode->GetBufferSize(), 
+            &mPackedMeshVertexLayout);
+
+        bytecode->Release();
     }
 #pragma endregion
 
@@ -234,9 +305,14 @@ App::~App()
     SAFE_RELEASE(mDepthState);
     SAFE_RELEASE(mDoubleSidedRasterizerState);
     SAFE_RELEASE(mRasterizerState);
+    SAFE_RELEASE(mPackedMeshVertexLayout);
     SAFE_RELEASE(mMeshVertexLayout);
     delete mSkyboxPS;
     delete mSkyboxVS;
+    delete mClusteredForwardPS;
+    delete mClusteredDeferredPerSamplePS;
+    delete mClusteredDeferredPS;
+    delete mClusterAssignCS;
     delete mComputeShaderTileCS;
     delete mGPUQuadDLResolvePerSamplePS;
     delete mGPUQuadDLResolvePS;
@@ -255,6 +331,7 @@ App::~App()
     delete mForwardPS;
     delete mGBufferAlphaTestPS;
     delete mGBufferPS;
+    delete mGeometryPackedVS;
     delete mGeometryVS;
 #pragma endregion
 }
@@ -273,6 +350,9 @@ void App::OnD3D11ResizedSwapChain(ID3D11Device* d3dDevice,
     mLitBufferPS = 0;
     mLitBufferCS = 0;
     mDeferredLightingAccumBuffer = 0;
+    mClusterLights = 0;
+    mClusterLightIndices = 0;
+    mClusterLightCounter = 0;
     mDepthBuffer = 0;
     SAFE_RELEASE(mDepthBufferReadOnlyDSV);
 
@@ -316,6 +396,20 @@ void App::OnD3D11ResizedSwapChain(ID3D11Device* d3dDevice,
         D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE,
         sampleDesc));
 
+    // light clusters, a column of slices behind each screen tile
+    mClusterDimensionsX = (mGBufferWidth + CLUSTER_TILE_DIM - 1) / CLUSTER_TILE_DIM;
+    mClusterDimensionsY = (mGBufferHeight + CLUSTER_TILE_DIM - 1) / CLUSTER_TILE_DIM;
+    unsigned int clusters = mClusterDimensionsX * mClusterDimensionsY * CLUSTER_SLICES;
+
+    mClusterLights = shared_ptr< StructuredBuffer<ClusterLightRange> >(new StructuredBuffer<ClusterLightRange>(
+        d3dDevice, clusters));
+
+    mClusterLightIndices = shared_ptr< StructuredBuffer<unsigned int> >(new StructuredBuffer<unsigned int>(
+        d3dDevice, clusters * CLUSTER_AVERAGE_LIGHTS));
+
+    mClusterLightCounter = shared_ptr< StructuredBuffer<unsigned int> >(new StructuredBuffer<unsigned int>(
+        d3dDevice, 1, D3D11_BIND_UNORDERED_ACCESS));
+
 
     // G-Buffer
 
@@ -352,9 +446,7 @@ void App::OnD3D11ResizedSwapChain(ID3D11Device* d3dDevice,
 //#MSH Controls the light parameters, their "randomness" and their motion
 void App::InitializeLightParameters(ID3D11Device* d3dDevice)
 {
-    mPointLightParameters.resize(MAX_LIGHTS);
-    mLightInitialTransform.resize(MAX_LIGHTS);
-    mPointLightPositionWorld.resize(MAX_LIGHTS);
+    mLights.Resize(MAX_LIGHTS);
 
     // Use a constant seed for consistency
     std::tr1::mt19937 rng(1337);
@@ -371,8 +463,7 @@ void App::InitializeLightParameters(ID3D11Device* d3dDevice)
     const float attenuationStartFactor = 0.8f;
     
     for (unsigned int i = 0; i < MAX_LIGHTS; ++i) {
-        PointLight& params = mPointLightParameters[i];
-        PointLightInitTransform& init = mLightInitialTransform[i];
+        LightOrbit init;
 
         init.radius = std::sqrt(radiusNormDist(rng)) * maxRadius;
         init.angle = angleDist(rng);
@@ -381,9 +472,9 @@ void App::InitializeLightParameters(ID3D11Device* d3dDevice)
         init.animationSpeed = (animationDirection(rng) * 2 - 1) * animationSpeedDist(rng) / init.radius;
         
         // HSL->RGB, vary light hue
-        params.color = intensityDist(rng) * HueToRGB(hueDist(rng));
-        params.attenuationEnd = attenuationDist(rng);
-        params.attenuationBegin = attenuationStartFactor * params.attenuationEnd;
+        D3DXVECTOR3 color = intensityDist(rng) * HueToRGB(hueDist(rng));
+        float attenuationEnd = attenuationDist(rng);
+        mLights.SetLight(i, init, color, attenuationStartFactor * attenuationEnd, attenuationEnd);
     }
 }
 
@@ -404,15 +495,8 @@ void App::Move(float elapsedTime)
 {
     mTotalTime += elapsedTime;
 
-    // Update positions of active lights
-    for (unsigned int i = 0; i < mActiveLights; ++i) {
-        const PointLightInitTransform& initTransform = mLightInitialTransform[i];
-        float angle = initTransform.angle + mTotalTime * initTransform.animationSpeed;
-        mPointLightPositionWorld[i] = D3DXVECTOR3(
-            initTransform.radius * std::cos(angle),
-            initTransform.height,
-            initTransform.radius * std::sin(angle));
-    }
+    // Update positions of active lights, four at a time
+    mLights.Move(mTotalTime, mActiveLights);
 }
 
 
@@ -438,6 +522,13 @@ void App::Render(ID3D11DeviceContext* d3dDeviceContext,
     D3DXMATRIXA16 cameraWorldViewProj = worldMatrix * cameraViewProj;
 #pragma endregion
 
+    // Setup lights first, as the frame constants hold how many made it into the light buffer
+    ID3D11ShaderResourceView *lightBufferSRV;
+    {
+        ScopedCpuTimer timer(mProfiler, "Lights");
+        lightBufferSRV = SetupLights(d3dDeviceContext, cameraView, cameraViewProj);
+    }
+
 	// Fill in frame constants
 #pragma region Frame constants
     {
@@ -457,11 +548,30 @@ void App::Render(ID3D11DeviceContext* d3dDeviceContext,
         constants->mFramebufferDimensionsZ = 0;     // Unused
         constants->mFramebufferDimensionsW = 0;     // Unused
 
+        // Slices are spaced exponentially from CLUSTER_NEAR_Z to the far plane:
+        // slice = log2(z) * scale + bias puts CLUSTER_NEAR_Z at 0 and the far plane at CLUSTER_SLICES
+        // NOTE: Complementary Z => the camera's near clip is the far plane
+        float clusterSliceScale = CLUSTER_SLICES * std::log(2.0f) / std::log(viewerCamera->GetNearClip() / CLUSTER_NEAR_Z);
+        constants->mClusterDimensionsX = mClusterDimensionsX;
+        constants->mClusterDimensionsY = mClusterDimensionsY;
+        constants->mClusterDimensionsZ = CLUSTER_SLICES;
+        constants->mClusterDimensionsW = 0;         // Unused
+        constants->mClusterSliceParams = D3DXVECTOR4(clusterSliceScale,
+            -clusterSliceScale * std::log(CLUSTER_NEAR_Z) / std::log(2.0f), 0.0f, 0.0f);
+        constants->mLightCount = mVisibleLights;
+
         constants->mUI = *ui;
         
         d3dDeviceContext->Unmap(mPerFrameConstants, 0);
     }
 #pragma endregion
+
+    // Cull the scene against the camera, for every geometry pass below
+    {
+        ScopedCpuTimer timer(mProfiler, "Scene culling");
+        sceneGraph.ComputeInFrustumFlags(cameraViewProj);
+    }
+
 #pragma region Old Code
 	/*
     // Geometry phase
@@ -480,23 +590,41 @@ void App::Render(ID3D11DeviceContext* d3dDeviceContext,
 	}*/
 #pragma endregion
 
-    // Setup lights
-    ID3D11ShaderResourceView *lightBufferSRV = SetupLights(d3dDeviceContext, cameraView);
+    // Clustered techniques assign the lights up front: unlike tiles, clusters don't depend on the depth buffer
+    if (ui->lightCullTechnique == CULL_CLUSTERED || ui->lightCullTechnique == CULL_FORWARD_CLUSTERED) {
+        ScopedGpuTimer timer(mGpuProfiler, d3dDeviceContext, "Light clusters");
+        AssignLightClusters(d3dDeviceContext, lightBufferSRV);
+    }
+
+    const char* lightingPassName = kLightingPassNames[ui->lightCullTechnique];
 
     // Forward rendering takes a different path here
 	//#MSH Else statement is the deffered methods, the other two should be removable for the final product
     if (ui->lightCullTechnique == CULL_FORWARD_NONE) 
 	{
+        ScopedGpuTimer timer(mGpuProfiler, d3dDeviceContext, lightingPassName);
         RenderForward(d3dDeviceContext, sceneGraph, lightBufferSRV, viewerCamera, viewport, ui, false);
     }
 	else if (ui->lightCullTechnique == CULL_FORWARD_PREZ_NONE) 
 	{
+        ScopedGpuTimer timer(mGpuProfiler, d3dDeviceContext, lightingPassName);
         RenderForward(d3dDeviceContext, sceneGraph, lightBufferSRV, viewerCamera, viewport, ui, true);
+    } 
+	else if (ui->lightCullTechnique == CULL_FORWARD_CLUSTERED) 
+	{
+        ScopedGpuTimer timer(mGpuProfiler, d3dDeviceContext, lightingPassName);
+        RenderForward(d3dDeviceContext, sceneGraph, lightBufferSRV, viewerCamera, viewport, ui, false);
     } 
 	else
 	{
-        RenderGBuffer(d3dDeviceContext,sceneGraph, viewerCamera, viewport, ui);
-        ComputeLighting(d3dDeviceContext, lightBufferSRV, viewport, ui);
+        {
+            ScopedGpuTimer timer(mGpuProfiler, d3dDeviceContext, "G-buffer");
+            RenderGBuffer(d3dDeviceContext,sceneGraph, viewerCamera, viewport, ui);
+        }
+        {
+            ScopedGpuTimer timer(mGpuProfiler, d3dDeviceContext, lightingPassName);
+            ComputeLighting(d3dDeviceContext, lightBufferSRV, viewport, ui);
+        }
 	}
 
 	{
@@ -514,24 +642,28 @@ void App::Render(ID3D11DeviceContext* d3dDeviceContext,
 
     // Render skybox and tonemap
 	//#MSH skybox is rendered last because its a requirement for the deferred rendering
-    RenderSkyboxAndToneMap(d3dDeviceContext, backBuffer, skybox,
-        mDepthBuffer->GetShaderResource(), viewport, ui);
+    {
+        ScopedGpuTimer timer(mGpuProfiler, d3dDeviceContext, "Skybox and tone map");
+        RenderSkyboxAndToneMap(d3dDeviceContext, backBuffer, skybox,
+            mDepthBuffer->GetShaderResource(), viewport, ui);
+    }
 }
 
 
 ID3D11ShaderResourceView * App::SetupLights(ID3D11DeviceContext* d3dDeviceContext,
-                                            const D3DXMATRIXA16& cameraView)
+                                            const D3DXMATRIXA16& cameraView,
+                                            const D3DXMATRIXA16& cameraViewProj)
 {
-    // Transform light world positions into view space and store in our parameters array
-    D3DXVec3TransformCoordArray(&mPointLightParameters[0].positionView, sizeof(PointLight),
-        &mPointLightPositionWorld[0], sizeof(D3DXVECTOR3), &cameraView, mActiveLights);
-    
-    // Copy light list into shader buffer
+    // Transform light world positions into view space straight into the shader buffer,
+    // leaving out those outside the view frustum if asked
+    // NOTE: PointLight is laid out exactly as ViewLight
     {
-        PointLight* light = mLightBuffer->MapDiscard(d3dDeviceContext);
-        for (unsigned int i = 0; i < mActiveLights; ++i) {
-            light[i] = mPointLightParameters[i];
-        }
+        Frustum frustum;
+        ExtractFrustum(*reinterpret_cast<const Matrix4*>(&cameraViewProj), &frustum);
+
+        ViewLight* light = reinterpret_cast<ViewLight*>(mLightBuffer->MapDiscard(d3dDeviceContext));
+        mVisibleLights = mLights.Write(*reinterpret_cast<const Matrix4*>(&cameraView),
+            mCullLights ? &frustum : 0, mActiveLights, light);
         mLightBuffer->Unmap(d3dDeviceContext);
     }
     
@@ -539,6 +671,36 @@ ID3D11ShaderResourceView * App::SetupLights(ID3D11DeviceContext* d3dDeviceContex
 }
 
 
+void App::AssignLightClusters(ID3D11DeviceContext* d3dDeviceContext,
+                              ID3D11ShaderResourceView *lightBufferSRV)
+{
+    // Hand out the index list from the start again
+    const UINT zeros[4] = {0, 0, 0, 0};
+    d3dDeviceContext->ClearUnorderedAccessViewUint(mClusterLightCounter->GetUnorderedAccess(), zeros);
+
+    d3dDeviceContext->CSSetConstantBuffers(0, 1, &mPerFrameConstants);
+    d3dDeviceContext->CSSetShaderResources(5, 1, &lightBufferSRV);
+
+    ID3D11UnorderedAccessView *clusterUAVs[3] = {
+        mClusterLights->GetUnorderedAccess(),
+        mClusterLightIndices->GetUnorderedAccess(),
+        mClusterLightCounter->GetUnorderedAccess()
+    };
+    d3dDeviceContext->CSSetUnorderedAccessViews(0, 3, clusterUAVs, 0);
+    d3dDeviceContext->CSSetShader(mClusterAssignCS->GetShader(), 0, 0);
+
+    // One group per screen tile, for all the slices behind it
+    d3dDeviceContext->Dispatch(mClusterDimensionsX, mClusterDimensionsY, 1);
+
+    // Cleanup (aka make the runtime happy)
+    d3dDeviceContext->CSSetShader(0, 0, 0);
+    ID3D11ShaderResourceView *nullSRV[1] = {0};
+    d3dDeviceContext->CSSetShaderResources(5, 1, nullSRV);
+    ID3D11UnorderedAccessView *nullUAV[3] = {0, 0, 0};
+    d3dDeviceContext->CSSetUnorderedAccessViews(0, 3, nullUAV, 0);
+}
+
+
 void App::RenderGBuffer(ID3D11DeviceContext* d3dDeviceContext,
                         SceneGraph& sceneGraph,
                         const CFirstPersonCamera* viewerCamera,
@@ -575,6 +737,8 @@ void App::RenderGBuffer(ID3D11DeviceContext* d3dDeviceContext,
 
 	D3DXMATRIXA16 cameraProj = *viewerCamera->GetProjMatrix();
     D3DXMATRIXA16 cameraView = *viewerCamera->GetViewMatrix();
+    // The scene graph records its draws through this, rather than the context directly
+    D3D11CommandList commands(d3dDeviceContext);
 #pragma region Old Code
 	/*D3DXMATRIXA16 worldMatrix;
 	D3DXMATRIXA16 scaleMatrix;
@@ -588,7 +752,7 @@ void App::RenderGBuffer(ID3D11DeviceContext* d3dDeviceContext,
 	{
 		d3dDeviceContext->RSSetState(mRasterizerState);
         d3dDeviceContext->PSSetShader(mGBufferPS->GetShader(), 0, 0);
-		sceneGraph.Render(d3dDeviceContext,mPerFrameConstants,cameraView,cameraProj);
+		sceneGraph.Render(commands,cameraView,cameraProj,mPackedMeshVertexLayout,mGeometryPackedVS->GetShader());
 	}
 #pragma region Old Code
    /* D3DXMATRIXA16 cameraWorldViewProj =scaleMatrix * worldMatrix * cameraViewProj;
@@ -750,13 +914,13 @@ void App::ComputeLighting(ID3D11DeviceContext* d3dDeviceContext,
         // Do pixel frequency shading
         d3dDeviceContext->PSSetShader(deferredLighting ? mGPUQuadDLPS->GetShader() : mGPUQuadPS->GetShader(), 0, 0);
         d3dDeviceContext->OMSetDepthStencilState(mEqualStencilState, 0);
-        d3dDeviceContext->Draw(mActiveLights, 0);
+        d3dDeviceContext->Draw(mVisibleLights, 0);
         
         if (mMSAASamples > 1) {
             // Do sample frequency shading
             d3dDeviceContext->PSSetShader(deferredLighting ? mGPUQuadDLPerSamplePS->GetShader() : mGPUQuadPerSamplePS->GetShader(), 0, 0);
             d3dDeviceContext->OMSetDepthStencilState(mEqualStencilState, 1);
-            d3dDeviceContext->Draw(mActiveLights, 0);
+            d3dDeviceContext->Draw(mVisibleLights, 0);
         }
 		#pragma endregion
 
@@ -794,9 +958,11 @@ void App::ComputeLighting(ID3D11DeviceContext* d3dDeviceContext,
     break;
 #pragma endregion
 
-#pragma region CULL_DEFERRED_NONE
+#pragma region CULL_DEFERRED_NONE & CULL_CLUSTERED
     case CULL_DEFERRED_NONE:
-    {
+    case CULL_CLUSTERED: {
+        bool clustered = (ui->lightCullTechnique == CULL_CLUSTERED);
+
         // Clear
         const float zeros[4] = {0.0f, 0.0f, 0.0f, 0.0f};
         d3dDeviceContext->ClearRenderTargetView(mLitBufferPS->GetRenderTarget(), zeros);
@@ -816,6 +982,10 @@ void App::ComputeLighting(ID3D11DeviceContext* d3dDeviceContext,
         d3dDeviceContext->PSSetConstantBuffers(0, 1, &mPerFrameConstants);
         d3dDeviceContext->PSSetShaderResources(0, static_cast<UINT>(mGBufferSRV.size()), &mGBufferSRV.front());
         d3dDeviceContext->PSSetShaderResources(5, 1, &lightBufferSRV);
+        if (clustered) {
+            ID3D11ShaderResourceView *clusterSRVs[2] = {mClusterLights->GetShaderResource(), mClusterLightIndices->GetShaderResource()};
+            d3dDeviceContext->PSSetShaderResources(8, 2, clusterSRVs);
+        }
 #pragma endregion
 
         if (mMSAASamples > 1) {
@@ -834,13 +1004,13 @@ void App::ComputeLighting(ID3D11DeviceContext* d3dDeviceContext,
         d3dDeviceContext->OMSetBlendState(mLightingBlendState, 0, 0xFFFFFFFF);
 
         // Do pixel frequency shading
-        d3dDeviceContext->PSSetShader(mBasicLoopPS->GetShader(), 0, 0);
+        d3dDeviceContext->PSSetShader(clustered ? mClusteredDeferredPS->GetShader() : mBasicLoopPS->GetShader(), 0, 0);
         d3dDeviceContext->OMSetDepthStencilState(mEqualStencilState, 0);
         d3dDeviceContext->Draw(3, 0);
 
         if (mMSAASamples > 1) {
             // Do sample frequency shading
-            d3dDeviceContext->PSSetShader(mBasicLoopPerSamplePS->GetShader(), 0, 0);
+            d3dDeviceContext->PSSetShader(clustered ? mClusteredDeferredPerSamplePS->GetShader() : mBasicLoopPerSamplePS->GetShader(), 0, 0);
             d3dDeviceContext->OMSetDepthStencilState(mEqualStencilState, 1);
             d3dDeviceContext->Draw(3, 0);
         }
@@ -856,10 +1026,10 @@ void App::ComputeLighting(ID3D11DeviceContext* d3dDeviceContext,
     d3dDeviceContext->GSSetShader(0, 0, 0);
     d3dDeviceContext->PSSetShader(0, 0, 0);
     d3dDeviceContext->OMSetRenderTargets(0, 0, 0);
-    ID3D11ShaderResourceView* nullSRV[8] = {0, 0, 0, 0, 0, 0, 0, 0};
-    d3dDeviceContext->VSSetShaderResources(0, 8, nullSRV);
-    d3dDeviceContext->PSSetShaderResources(0, 8, nullSRV);
-    d3dDeviceContext->CSSetShaderResources(0, 8, nullSRV);
+    ID3D11ShaderResourceView* nullSRV[10] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    d3dDeviceContext->VSSetShaderResources(0, 10, nullSRV);
+    d3dDeviceContext->PSSetShaderResources(0, 10, nullSRV);
+    d3dDeviceContext->CSSetShaderResources(0, 10, nullSRV);
     ID3D11UnorderedAccessView *nullUAV[1] = {0};
     d3dDeviceContext->CSSetUnorderedAccessViews(0, 1, nullUAV, 0);
 #pragma endregion
@@ -951,9 +1121,17 @@ ID3D11ShaderResourceView * App::RenderForward(ID3D11DeviceContext* d3dDeviceCont
     d3dDeviceContext->PSSetSamplers(0, 1, &mDiffuseSampler);
     // Diffuse texture set per-material by DXUT mesh routines
 
+    bool clustered = (ui->lightCullTechnique == CULL_FORWARD_CLUSTERED);
+    if (clustered) {
+        ID3D11ShaderResourceView *clusterSRVs[2] = {mClusterLights->GetShaderResource(), mClusterLightIndices->GetShaderResource()};
+        d3dDeviceContext->PSSetShaderResources(8, 2, clusterSRVs);
+    }
+
     d3dDeviceContext->OMSetDepthStencilState(mDepthState, 0);
     D3DXMATRIXA16 cameraProj = *viewerCamera->GetProjMatrix();
     D3DXMATRIXA16 cameraView = *viewerCamera->GetViewMatrix();
+    // The scene graph records its draws through this, rather than the context directly
+    D3D11CommandList commands(d3dDeviceContext);
     // Pre-Z pass if requested
     if (doPreZ) {
         d3dDeviceContext->OMSetRenderTargets(0, 0, mDepthBuffer->GetDepthStencil());
@@ -963,7 +1141,7 @@ ID3D11ShaderResourceView * App::RenderForward(ID3D11DeviceContext* d3dDeviceCont
 		{
 			d3dDeviceContext->RSSetState(mRasterizerState);
             d3dDeviceContext->PSSetShader(0, 0, 0);
-			sceneGraph.Render(d3dDeviceContext,mPerFrameConstants,cameraView,cameraProj);
+			sceneGraph.Render(commands,cameraView,cameraProj,mPackedMeshVertexLayout,mGeometryPackedVS->GetShader());
 		}
 #pragma region Old Code
 		/*
@@ -996,8 +1174,8 @@ ID3D11ShaderResourceView * App::RenderForward(ID3D11DeviceContext* d3dDeviceCont
 	if(sceneGraph.IsLoaded())
 	{
 		d3dDeviceContext->RSSetState(mRasterizerState);
-        d3dDeviceContext->PSSetShader(mForwardPS->GetShader(), 0, 0);
-		sceneGraph.Render(d3dDeviceContext,mPerFrameConstants,cameraView,cameraProj);
+        d3dDeviceContext->PSSetShader(clustered ? mClusteredForwardPS->GetShader() : mForwardPS->GetShader(), 0, 0);
+		sceneGraph.Render(commands,cameraView,cameraProj,mPackedMeshVertexLayout,mGeometryPackedVS->GetShader());
 	}
 #pragma region Old Code
 	/*
@@ -23,6 +23,8 @@
 #include <vector>
 #include <memory>
 #include "SceneGraph.h"
+#include "Lighting/LightSystem.h"
+#include "Profiling/D3D11GpuProfiler.h"
 
 class SceneGraph;
 
@@ -33,6 +35,8 @@ enum LightCullTechnique {
     CULL_QUAD,
     CULL_QUAD_DEFERRED_LIGHTING,
     CULL_COMPUTE_SHADER_TILE,
+    CULL_CLUSTERED,
+    CULL_FORWARD_CLUSTERED,
 };
 
 // NOTE: Must match shader equivalent structure
@@ -46,7 +50,7 @@ struct UIConstants
     unsigned int lightCullTechnique;
 };
 
-// NOTE: Must match shader equivalent structure
+// NOTE: Must match shader equivalent structure, and ViewLight in Lighting/TileLightCuller.h
 struct PointLight
 {
     D3DXVECTOR3 positionView;
@@ -55,14 +59,12 @@ struct PointLight
     float attenuationEnd;
 };
 
-// Host-side world-space initial transform data
-struct PointLightInitTransform
+// Where a cluster's lights are in the cluster light index list
+// NOTE: Must match gClusterLights in ClusteredShading.hlsl
+struct ClusterLightRange
 {
-    // Cylindrical coordinates
-    float radius;
-    float angle;
-    float height;
-    float animationSpeed;
+    unsigned int first;
+    unsigned int count;
 };
 
 // Flat framebuffer RGBA16-encoded
@@ -95,6 +97,18 @@ public:
     
     void SetActiveLights(ID3D11Device* d3dDevice, unsigned int activeLights);
     unsigned int GetActiveLights() const { return mActiveLights; }
+
+    // Leaves lights entirely outside the view out of the light buffer
+    void SetLightCulling(bool cullLights) { mCullLights = cullLights; }
+    // Lights in the light buffer as of the last Render
+    unsigned int GetVisibleLights() const { return mVisibleLights; }
+
+    // Passes of Render are timed into these; either may be null
+    void SetProfilers(FrameProfiler* profiler, D3D11GpuProfiler* gpuProfiler)
+    {
+        mProfiler = profiler;
+        mGpuProfiler = gpuProfiler;
+    }
     
 private:
     void InitializeLightParameters(ID3D11Device* d3dDevice);
@@ -103,9 +117,14 @@ private:
     // - Most of these functions should all be called after initializing per frame/pass constants, etc.
     //   as the shaders that they invoke bind those constant buffers.
 
-    // Set up shader light buffer
+    // Set up shader light buffer, and the number of lights in it
     ID3D11ShaderResourceView * SetupLights(ID3D11DeviceContext* d3dDeviceContext,
-                                           const D3DXMATRIXA16& cameraView);
+                                           const D3DXMATRIXA16& cameraView,
+                                           const D3DXMATRIXA16& cameraViewProj);
+
+    // Assigns the lights to clusters, for the clustered techniques
+    void AssignLightClusters(ID3D11DeviceContext* d3dDeviceContext,
+                             ID3D11ShaderResourceView *lightBufferSRV);
 
     // Forward rendering of geometry into
     ID3D11ShaderResourceView * RenderForward(ID3D11DeviceContext* d3dDeviceContext,
@@ -140,8 +159,10 @@ private:
     float mTotalTime;
 
     ID3D11InputLayout* mMeshVertexLayout;
+    ID3D11InputLayout* mPackedMeshVertexLayout;
 
     VertexShader* mGeometryVS;
+    VertexShader* mGeometryPackedVS;
 
     PixelShader* mGBufferPS;
     PixelShader* mGBufferAlphaTestPS;
@@ -163,6 +184,11 @@ private:
 
     ComputeShader* mComputeShaderTileCS;
 
+    ComputeShader* mClusterAssignCS;
+    PixelShader* mClusteredDeferredPS;
+    PixelShader* mClusteredDeferredPerSamplePS;
+    PixelShader* mClusteredForwardPS;
+
     VertexShader* mGPUQuadVS;
     GeometryShader* mGPUQuadGS;
     PixelShader* mGPUQuadPS;
@@ -208,11 +234,22 @@ private:
     // We also need a read-only depth stencil view for techniques that read the G-buffer while also using Z-culling
     ID3D11DepthStencilView* mDepthBufferReadOnlyDSV;
 
+    // Light clusters: one range per cluster, and the light indices they point into
+    unsigned int mClusterDimensionsX;
+    unsigned int mClusterDimensionsY;
+    std::tr1::shared_ptr<StructuredBuffer<ClusterLightRange> > mClusterLights;
+    std::tr1::shared_ptr<StructuredBuffer<unsigned int> > mClusterLightIndices;
+    // How much of the index list has been used; cleared before each assignment
+    std::tr1::shared_ptr<StructuredBuffer<unsigned int> > mClusterLightCounter;
+
     // Lighting state
     unsigned int mActiveLights;
-    std::vector<PointLightInitTransform> mLightInitialTransform;
-    std::vector<PointLight> mPointLightParameters;
-    std::vector<D3DXVECTOR3> mPointLightPositionWorld;
+    unsigned int mVisibleLights;
+    bool mCullLights;
+
+    FrameProfiler* mProfiler;
+    D3D11GpuProfiler* mGpuProfiler;
+    LightSystem mLights;
     
     StructuredBuffer<PointLight>* mLightBuffer;
 #pragma endregion
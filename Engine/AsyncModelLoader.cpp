@@ -0,0 +1,124 @@
+#include "AsyncModelLoader.h"
+
+
+// Used for models that don't refer to a texture of their own.
+static WCHAR* const modelTextureFile = L"..\\media\\cube\\seafloor.dds";
+
+
+ModelLoadRequest::ModelLoadRequest(const string& fileName)
+	: fileName(fileName), state(Pending)
+{
+}
+
+
+AsyncModelLoader::AsyncModelLoader()
+	: shuttingDown(false)
+{
+}
+
+AsyncModelLoader::~AsyncModelLoader()
+{
+	Shutdown();
+}
+
+ModelLoadRequestPtr AsyncModelLoader::Load(const string& fileName)
+{
+	lock_guard<mutex> guard(lock);
+
+	// Has this file already been requested?
+	unordered_map<string, ModelLoadRequestPtr>::const_iterator existing = requests.find(fileName);
+
+	if(existing != requests.end())
+	{
+		return existing->second;
+	}
+
+	// Threads are started on first use, rather than when the (global) scene graph is constructed.
+	if(workers.empty())
+	{
+		StartWorkers();
+	}
+
+	ModelLoadRequestPtr request(new ModelLoadRequest(fileName));
+
+	requests[fileName] = request;
+	queue.push_back(request);
+
+	workAvailable.notify_one();
+
+	return request;
+}
+
+void AsyncModelLoader::Shutdown()
+{
+	{
+		lock_guard<mutex> guard(lock);
+
+		shuttingDown = true;
+		queue.clear();
+	}
+
+	workAvailable.notify_all();
+
+	for(size_t i = 0; i < workers.size(); i++)
+	{
+		workers[i].join();
+	}
+
+	workers.clear();
+	requests.clear();
+	shuttingDown = false;
+}
+
+void AsyncModelLoader::StartWorkers()
+{
+	// Leave one core free for the device thread.
+	unsigned int threadCount = thread::hardware_concurrency();
+
+	threadCount = (threadCount > 1) ? threadCount - 1 : 1;
+
+	for(unsigned int i = 0; i < threadCount; i++)
+	{
+		workers.push_back(thread(&AsyncModelLoader::WorkerThread, this));
+	}
+}
+
+void AsyncModelLoader::WorkerThread()
+{
+	for(;;)
+	{
+		ModelLoadRequestPtr request;
+
+		// Wait for something to load.
+		{
+			unique_lock<mutex> guard(lock);
+
+			while(queue.empty() && !shuttingDown)
+			{
+				workAvailable.wait(guard);
+			}
+
+			if(shuttingDown)
+			{
+				return;
+			}
+
+			request = queue.front();
+			queue.pop_front();
+		}
+
+		// Parse the file and build the vertex and index arrays.
+		shared_ptr<ModelClass::ModelData> data(new ModelClass::ModelData);
+
+		if(ModelClass::LoadModelData((char*)request->fileName.c_str(), modelTextureFile, data.get()))
+		{
+			// The data must be visible before the state says it is ready.
+			request->data = data;
+			request->state = ModelLoadRequest::Ready;
+		}
+		else
+		{
+			request->state = ModelLoadRequest::Failed;
+		}
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "modelclass.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+using namespace std;
+
+// A model file being loaded on one of the AsyncModelLoader threads.
+class ModelLoadRequest
+{
+public:
+	enum State
+	{
+		Pending,
+		Ready,
+		Failed,
+	};
+
+	ModelLoadRequest(const string& fileName);
+
+	bool IsDone() const { return state != Pending; }
+	bool Succeeded() const { return state == Ready; }
+
+	string fileName;
+
+	// Only valid once IsDone returns true. Shared by every mesh that loads this file.
+	shared_ptr<ModelClass::ModelData const> data;
+
+private:
+	friend class AsyncModelLoader;
+
+	atomic<int> state;
+};
+
+typedef shared_ptr<ModelLoadRequest> ModelLoadRequestPtr;
+
+
+// Parses model files on a pool of worker threads, so the device thread only has to
+// create the GPU resources once the CPU side data is ready.
+class AsyncModelLoader
+{
+public:
+	AsyncModelLoader();
+	~AsyncModelLoader();
+
+	// Queues a file to be loaded. Requests for a file that is already loading (or has
+	// been loaded) share the same request, so each file is only parsed once.
+	ModelLoadRequestPtr Load(const string& fileName);
+
+	// Drops any queued work, waits for the worker threads to finish, and forgets loaded files.
+	void Shutdown();
+
+private:
+	void StartWorkers();
+	void WorkerThread();
+
+	vector<thread> workers;
+
+	deque<ModelLoadRequestPtr> queue;
+	unordered_map<string, ModelLoadRequestPtr> requests;
+
+	mutex lock;
+	condition_variable workAvailable;
+	bool shuttingDown;
+};
@@ -20,9 +20,8 @@
 //--------------------------------------------------------------------------------------
 float4 BasicLoop(FullScreenTriangleVSOut input, uint sampleIndex)
 {
-    // How many total lights?
-    uint totalLights, dummy;
-    gLight.GetDimensions(totalLights, dummy);
+    // How many total lights? Those culled on the CPU leave the end of the buffer unused
+    uint totalLights = mLightCount;
     
     float3 lit = float3(0.0f, 0.0f, 0.0f);
 
@@ -34,7 +34,7 @@ public:
     ID3D11ShaderResourceView* GetShaderResource() { return mShaderResource; }
 
     // Only valid for dynamic buffers
-    // TODO: Support NOOVERWRITE ring buffer?
+    // NOTE: See UploadRing in Rendering/UploadRing.h for writing a little at a time without a discard
     T* MapDiscard(ID3D11DeviceContext* d3dDeviceContext);
     void Unmap(ID3D11DeviceContext* d3dDeviceContext);
 
@@ -96,6 +96,3 @@ void StructuredBuffer<T>::Unmap(ID3D11DeviceContext* d3dDeviceContext)
 {
     d3dDeviceContext->Unmap(mBuffer, 0);
 }
-
-
-// TODO: Constant buffers
@@ -0,0 +1,229 @@
+// Copyright 2010 Intel Corporation
+// All Rights Reserved
+//
+// Permission is granted to use, copy, distribute and prepare derivative works of this
+// software for any purpose and without fee, provided, that the above copyright notice
+// and this statement appear in all copies.  Intel makes no representations about the
+// suitability of this software for any purpose.  THIS SOFTWARE IS PROVIDED "AS IS."
+// INTEL SPECIFICALLY DISCLAIMS ALL WARRANTIES, EXPRESS OR IMPLIED, AND ALL LIABILITY,
+// INCLUDING CONSEQUENTIAL AND OTHER INDIRECT DAMAGES, FOR THE USE OF THIS SOFTWARE,
+// INCLUDING LIABILITY FOR INFRINGEMENT OF ANY PROPRIETARY RIGHTS, AND INCLUDING THE
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.  Intel does not
+// assume any responsibility for any errors which may appear in this software nor any
+// responsibility to update it.
+
+#ifndef CLUSTERED_SHADING_HLSL
+#define CLUSTERED_SHADING_HLSL
+
+#include "GBuffer.hlsl"
+#include "Forward.hlsl"
+#include "ShaderDefines.h"
+
+// The view frustum is split into clusters: CLUSTER_TILE_DIM pixel screen tiles, each cut
+// into CLUSTER_SLICES depth slices. ClusterAssignCS lists the lights reaching each cluster,
+// then shading only loops over the lights of the cluster a sample falls in. Unlike
+// ComputeShaderTile.hlsl this doesn't look at the depth buffer, so it works the same for
+// forward and deferred shading, and for surfaces that aren't in the depth buffer at all.
+
+// Where each cluster's lights start in gClusterLightIndices, and how many there are
+StructuredBuffer<uint2> gClusterLights : register(t8);
+StructuredBuffer<uint> gClusterLightIndices : register(t9);
+
+RWStructuredBuffer<uint2> gClusterLightsRW : register(u0);
+RWStructuredBuffer<uint> gClusterLightIndicesRW : register(u1);
+// How much of gClusterLightIndicesRW has been handed out; cleared to 0 before assignment
+RWStructuredBuffer<uint> gClusterLightCounter : register(u2);
+
+// Lights found in each cluster of the column, and where the next one goes
+groupshared uint sSliceCount[CLUSTER_SLICES];
+groupshared uint sSliceNext[CLUSTER_SLICES];
+groupshared uint sSliceEnd[CLUSTER_SLICES];
+
+//--------------------------------------------------------------------------------------
+uint ClusterSlice(float viewSpaceZ)
+{
+    float slice = log2(max(viewSpaceZ, CLUSTER_NEAR_Z)) * mClusterSliceParams.x + mClusterSliceParams.y;
+    return min(uint(max(slice, 0.0f)), CLUSTER_SLICES - 1);
+}
+
+uint ClusterIndex(uint2 tile, uint slice)
+{
+    return (slice * mClusterDimensions.y + tile.y) * mClusterDimensions.x + tile.x;
+}
+
+// Does the light reach the column of clusters with these side planes, and if so, which slices?
+bool ClusterLightSlices(float4 sidePlanes[4], PointLight light, out uint firstSlice, out uint lastSlice)
+{
+    bool inColumn = true;
+    [unroll] for (uint i = 0; i < 4; ++i) {
+        float d = dot(sidePlanes[i], float4(light.positionView, 1.0f));
+        inColumn = inColumn && (d >= -light.attenuationEnd);
+    }
+
+    // Only samples between the near and far planes get shaded
+    float minZ = light.positionView.z - light.attenuationEnd;
+    float maxZ = light.positionView.z + light.attenuationEnd;
+    inColumn = inColumn && maxZ >= mCameraNearFar.x && minZ < mCameraNearFar.y;
+
+    firstSlice = ClusterSlice(minZ);
+    lastSlice = ClusterSlice(maxZ);
+    return inColumn;
+}
+
+// One group per screen tile, assigning lights to all the clusters behind it. The lights are
+// gone through twice: once to count how many land in each cluster, so the column's lists can
+// be allocated together and packed tightly, then again to write them.
+[numthreads(CLUSTER_GROUP_SIZE, 1, 1)]
+void ClusterAssignCS(uint3 groupId    : SV_GroupID,
+                     uint  groupIndex : SV_GroupIndex)
+{
+    // How many total lights? Those culled on the CPU leave the end of the buffer unused
+    uint totalLights = mLightCount;
+
+    // Side planes of the tile, worked out as in ComputeShaderTile.hlsl
+    float2 tileScale = float2(mFramebufferDimensions.xy) * rcp(float(2 * CLUSTER_TILE_DIM));
+    float2 tileBias = tileScale - float2(groupId.xy);
+
+    float4 c1 = float4(mCameraProj._11 * tileScale.x, 0.0f, tileBias.x, 0.0f);
+    float4 c2 = float4(0.0f, -mCameraProj._22 * tileScale.y, tileBias.y, 0.0f);
+    float4 c4 = float4(0.0f, 0.0f, 1.0f, 0.0f);
+
+    float4 sidePlanes[4];
+    sidePlanes[0] = c4 - c1;
+    sidePlanes[1] = c4 + c1;
+    sidePlanes[2] = c4 - c2;
+    sidePlanes[3] = c4 + c2;
+    [unroll] for (uint i = 0; i < 4; ++i) {
+        sidePlanes[i] *= rcp(length(sidePlanes[i].xyz));
+    }
+
+    // NOTE: Loop variables are scoped in blocks below since fxc lets them leak out of the loop
+    {
+        for (uint slice = groupIndex; slice < CLUSTER_SLICES; slice += CLUSTER_GROUP_SIZE) {
+            sSliceCount[slice] = 0;
+        }
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    // Count the lights in each cluster
+    {
+        for (uint lightIndex = groupIndex; lightIndex < totalLights; lightIndex += CLUSTER_GROUP_SIZE) {
+            uint firstSlice, lastSlice;
+            [branch] if (ClusterLightSlices(sidePlanes, gLight[lightIndex], firstSlice, lastSlice)) {
+                for (uint slice = firstSlice; slice <= lastSlice; ++slice) {
+                    InterlockedAdd(sSliceCount[slice], 1);
+                }
+            }
+        }
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    // Allocate the column's lists in one go. If the index list runs out, the lists that
+    // don't fit are cut short.
+    if (groupIndex == 0) {
+        uint columnLights = 0;
+        {
+            for (uint slice = 0; slice < CLUSTER_SLICES; ++slice) {
+                columnLights += sSliceCount[slice];
+            }
+        }
+
+        uint capacity, stride;
+        gClusterLightIndicesRW.GetDimensions(capacity, stride);
+
+        uint first;
+        InterlockedAdd(gClusterLightCounter[0], columnLights, first);
+        {
+            for (uint slice = 0; slice < CLUSTER_SLICES; ++slice) {
+                uint count = min(sSliceCount[slice], capacity - min(first, capacity));
+                gClusterLightsRW[ClusterIndex(groupId.xy, slice)] = uint2(first, count);
+                sSliceNext[slice] = first;
+                sSliceEnd[slice] = first + count;
+                first += sSliceCount[slice];
+            }
+        }
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    // Fill them in
+    {
+        for (uint lightIndex = groupIndex; lightIndex < totalLights; lightIndex += CLUSTER_GROUP_SIZE) {
+            uint firstSlice, lastSlice;
+            [branch] if (ClusterLightSlices(sidePlanes, gLight[lightIndex], firstSlice, lastSlice)) {
+                for (uint slice = firstSlice; slice <= lastSlice; ++slice) {
+                    uint listIndex;
+                    InterlockedAdd(sSliceNext[slice], 1, listIndex);
+                    if (listIndex < sSliceEnd[slice]) {
+                        gClusterLightIndicesRW[listIndex] = lightIndex;
+                    }
+                }
+            }
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------
+// Lights the surface with the lights of its cluster
+float3 ClusteredLighting(SurfaceData surface, float2 positionViewport)
+{
+    uint2 tile = uint2(positionViewport) / CLUSTER_TILE_DIM;
+    uint2 clusterLights = gClusterLights[ClusterIndex(tile, ClusterSlice(surface.positionView.z))];
+
+    float3 lit = float3(0.0f, 0.0f, 0.0f);
+
+    [branch] if (mUI.visualizeLightCount) {
+        lit = (float(clusterLights.y) * rcp(255.0f)).xxx;
+    } else {
+        for (uint clusterLightIndex = 0; clusterLightIndex < clusterLights.y; ++clusterLightIndex) {
+            PointLight light = gLight[gClusterLightIndices[clusterLights.x + clusterLightIndex]];
+            AccumulateBRDF(surface, light, lit);
+        }
+    }
+
+    return lit;
+}
+
+float4 ClusteredDeferred(FullScreenTriangleVSOut input, uint sampleIndex)
+{
+    SurfaceData surface = ComputeSurfaceDataFromGBufferSample(uint2(input.positionViewport.xy), sampleIndex);
+
+    float3 lit = float3(0.0f, 0.0f, 0.0f);
+
+    // Avoid shading skybox/background pixels
+    if (surface.positionView.z < mCameraNearFar.y) {
+        lit = ClusteredLighting(surface, input.positionViewport.xy);
+    }
+
+    return float4(lit, 1.0f);
+}
+
+float4 ClusteredDeferredPS(FullScreenTriangleVSOut input) : SV_Target
+{
+    // Shade only sample 0
+    return ClusteredDeferred(input, 0);
+}
+
+float4 ClusteredDeferredPerSamplePS(FullScreenTriangleVSOut input, uint sampleIndex : SV_SampleIndex) : SV_Target
+{
+    float4 result;
+    if (mUI.visualizePerSampleShading) {
+        result = float4(1, 0, 0, 1);
+    } else {
+        result = ClusteredDeferred(input, sampleIndex);
+    }
+    return result;
+}
+
+// As ForwardPS. MSAA is resolved by the hardware as usual, and since the clusters don't
+// depend on depth, this works as well for blended geometry drawn after the opaque.
+float4 ClusteredForwardPS(GeometryVSOut input) : SV_Target
+{
+    SurfaceData surface = ComputeSurfaceDataFromGeometry(input);
+    float3 lit = ClusteredLighting(surface, input.position.xy);
+    return float4(ApplyAmbient(surface, lit), 1.0f);
+}
+
+#endif // CLUSTERED_SHADING_HLSL
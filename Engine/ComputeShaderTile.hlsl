@@ -25,7 +25,7 @@ groupshared uint sMinZ;
 groupshared uint sMaxZ;
 
 // Light list for the tile
-groupshared uint sTileLightIndices[MAX_LIGHTS];
+groupshared uint sTileLightIndices[COMPUTE_SHADER_TILE_MAX_LIGHTS];
 groupshared uint sTileNumLights;
 
 
@@ -61,9 +61,8 @@ void ComputeShaderTileCS(uint3 groupId          : SV_GroupID,
     // around a compiler bug on Fermi.
     uint groupIndex = groupThreadId.y * COMPUTE_SHADER_TILE_GROUP_DIM + groupThreadId.x;
     
-    // How many total lights?
-    uint totalLights, dummy;
-    gLight.GetDimensions(totalLights, dummy);
+    // How many total lights? Those culled on the CPU leave the end of the buffer unused
+    uint totalLights = mLightCount;
 
     uint2 globalCoords = dispatchThreadId.xy;
 
@@ -161,13 +160,16 @@ void ComputeShaderTileCS(uint3 groupId          : SV_GroupID,
             // Compaction might be better if we expect a lot of lights
             uint listIndex;
             InterlockedAdd(sTileNumLights, 1, listIndex);
-            sTileLightIndices[listIndex] = lightIndex;
+            // NOTE: Lights past what shared memory holds are dropped; clustered shading has no such limit
+            if (listIndex < COMPUTE_SHADER_TILE_MAX_LIGHTS) {
+                sTileLightIndices[listIndex] = lightIndex;
+            }
         }
     }
 
     GroupMemoryBarrierWithGroupSync();
     
-    uint numLights = sTileNumLights;
+    uint numLights = min(sTileNumLights, COMPUTE_SHADER_TILE_MAX_LIGHTS);
 
     // Only process onscreen pixels (tiles can span screen edges)
     if (all(globalCoords < mFramebufferDimensions.xy)) {
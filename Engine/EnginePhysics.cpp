@@ -1,4 +1,6 @@
 #include "EnginePhysics.h"
+#include "Physics/ForceField.h"
+#include "PhysXDispatcher.h"
 
 namespace EnginePhysics
 {
@@ -27,7 +29,10 @@ namespace EnginePhysics
 		#define BLOCK_NUM 100
 		#define STRONG_UNIVERSAL_GRAVITATIONAL_FORCE 200.0f
 		#define WEAK_UNIVERSAL_GRAVITATIONAL_FORCE 100.0f
-		#define INVERSE_SQUARE_GRAVITATIONAL_FORCE 200.0f
+		//Planet gravity used to pull every box once for each box, so it scales with the box count
+		#define INVERSE_SQUARE_GRAVITATIONAL_FORCE (200.0f * BLOCK_NUM)
+		#define ORBIT_FORCE 40.0f
+		#define MAX_SUBSTEPS 4
 
 	#pragma endregion
 
@@ -39,6 +44,7 @@ namespace EnginePhysics
 		static PxSimulationFilterShader gDefaultFilterShader = PxDefaultSimulationFilterShader;
 
 		PxScene* gScene = NULL;
+		PhysXDispatcher* gDispatcher = NULL;
 		PxReal myTimestep = 1.0f/60.0f;
 
 		vector<PhysXObject*> *allActors;
@@ -66,27 +72,49 @@ namespace EnginePhysics
 
 		GravityState currentGravState = GravityState::ZERO;
 
+		//The state the boxes' scene gravity flags were last set for
+		int gravityFlagsState = -1;
+
+		//Every box's acceleration from the planets, worked out together each step
+		WorkerPool* forceWorkers = NULL;
+		ForceField* forceField = NULL;
+
 		bool isPaused = false;
 
+		//Between simulate and fetchResults
+		bool isSimulating = false;
+
+		//A step beyond currentPose has been started; its results go to the next step that's due
+		bool isStepAhead = false;
+
+		//Real time not yet simulated, always less than a step after AdvancePhysX
+		PxReal accumulator = 0.0f;
+
+		//Steps read so far, to tell which objects moved in the latest one
+		unsigned int stepCount = 0;
+
+		//Objects that moved in the latest step, and the step before it
+		vector<PhysXObject*> activeObjects;
+		vector<PhysXObject*> lastActiveObjects;
+
+		//Objects that have come to rest since the last GetRenderPoses, to be drawn once more where they stopped
+		vector<PhysXObject*> settledObjects;
+
 	#pragma endregion
 
 	#pragma region Prototypes
 
 		void DisableGravity(PxRigidActor* actor);
 		void EnableGravity(PxRigidActor* actor);
-		void ApplyGravity(PxRigidActor* actor, PxVec3 source, PxReal power);
-		void ApplyInverseSquareGravity(PxRigidActor* actor, PxVec3 source, PxReal power);
-		void UpdatePhysXObject(PhysXObject* object);
 		void ResetScene();
+		void SimulatePhysX();
+		void FetchPhysX();
+		void SaveStates(bool resetPrevious);
+		void ReadActiveTransforms();
+		RigidPose ToRigidPose(const PxTransform& transform);
+		void ApplyForceField();
+		void AddForceSource(ForceSourceType type, PxVec3 position, PxReal strength, PxVec3 axis = PxVec3(0.0f));
 
-		void ApplyZeroGravity(PhysXObject* object);
-		void ApplyNormalGravity(PhysXObject* object);
-		void ApplyPlanetGravity(PhysXObject* object);
-		void ApplyPullDouble(PhysXObject* object);
-		void ApplyPullPush(PhysXObject* object);
-		void ApplyPullSingle(PhysXObject* object);
-		void ApplyPullTriple(PhysXObject* object);
-		void ApplyPushPull(PhysXObject* object);
 		void ApplyOrbitVelocity(PxRigidActor* box, float power);
 		void SetVelocity(PxVec3 newVelocity, PhysXObject* object);
 		void RandomVelocities(PhysXObject* object, int powerMax, int seedMultiplier = 1);
@@ -116,11 +144,15 @@ namespace EnginePhysics
 
 			sceneDesc.gravity=PxVec3(0.0f, -9.8f, 0.0f);
 
+			//Report which actors moved each step, so sleeping ones needn't be read back
+			sceneDesc.flags |= PxSceneFlag::eENABLE_ACTIVETRANSFORMS;
+
 			if(!sceneDesc.cpuDispatcher)
 			{
-				PxDefaultCpuDispatcher* mCpuDispatcher = PxDefaultCpuDispatcherCreate(3);
+				//A worker per core, less the one rendering while the step runs
+				gDispatcher = new PhysXDispatcher();
 
-				sceneDesc.cpuDispatcher = mCpuDispatcher;
+				sceneDesc.cpuDispatcher = gDispatcher;
 			}
 
 			if(!sceneDesc.filterShader)
@@ -142,6 +174,7 @@ namespace EnginePhysics
 
 				PxShape* shape = plane->actor->createShape(PxPlaneGeometry(), *mMaterial);
 
+				plane->actor->userData = plane;
 				gScene->addActor(*(plane->actor));
 				allActors->push_back(plane);
 				planes.push_back(plane);
@@ -161,6 +194,7 @@ namespace EnginePhysics
 
 				EnableGravity(planet->actor);
 
+				planet->actor->userData = planet;
 				gScene->addActor(*(planet->actor));
 				allActors->push_back(planet);
 				planets.push_back(planet);
@@ -209,76 +243,126 @@ namespace EnginePhysics
 				cube->actor->isRigidDynamic()->setAngularDamping(0.75);
 				cube->actor->isRigidDynamic()->setLinearVelocity(PxVec3(0,0,0));
 
+				cube->actor->userData = cube;
 				gScene->addActor(*(cube->actor));
 				allActors->push_back(cube);
 				boxes.push_back(cube);
 			}
 
+			accumulator = 0.0f;
+			isStepAhead = false;
+			SaveStates(true);
+
+			if(!forceField)
+			{
+				forceWorkers = new WorkerPool();
+				forceField = new ForceField(forceWorkers);
+			}
+			gravityFlagsState = -1;
+
 			cubeList = allActors;
 		}
 
-		void StepPhysX()
+		void AdvancePhysX(float elapsedTime, bool overlap)
 		{
-			if(!isPaused && gScene)
+			if(isPaused || !gScene)
 			{
-				for(int i = 0; i < boxes.size(); i++)
-				{
-					switch(currentGravState)
-					{
-						case GravityState::ZERO:
-							ApplyZeroGravity(boxes[i]);
-							break;
-
-						case GravityState::NORMAL:
-							ApplyNormalGravity(boxes[i]);
-							break;
-				
-						case GravityState::PLANET_GRAVITY:
-							ApplyPlanetGravity(boxes[i]);
-							break;
-
-						case GravityState::PULL_DOUBLE:
-							ApplyPullDouble(boxes[i]);
-							break;
-
-						case GravityState::PULL_PUSH:
-							ApplyPullPush(boxes[i]);
-							break;
-
-						case GravityState::PULL_SINGLE:
-							ApplyPullSingle(boxes[i]);
-							break;
-
-						case GravityState::PULL_TRIPLE:
-							ApplyPullTriple(boxes[i]);
-							break;
-
-						case GravityState::PUSH_PULL:
-							ApplyPushPull(boxes[i]);
-							break;
-
-						case GravityState::ORBITS:
-							boxes[i]->actor->isRigidDynamic()->setLinearVelocity(PxVec3(0,0,0));
-							ApplyOrbitVelocity(boxes[i]->actor, 40);
-							break;
-					}
+				return;
+			}
 
-					UpdatePhysXObject(boxes[i]);
+			//Time past the cap is dropped, so a long frame slows the simulation down rather
+			//than costing more steps, and making the next frame longer still
+			accumulator = PxMin(accumulator + elapsedTime, MAX_SUBSTEPS * myTimestep);
+
+			while(accumulator >= myTimestep)
+			{
+				//The step started last frame is the one due now; otherwise run one here
+				if(!isStepAhead)
+				{
+					SimulatePhysX();
 				}
+				FetchPhysX();
+				isStepAhead = false;
+
+				ReadActiveTransforms();
+				accumulator -= myTimestep;
+			}
+
+			//Start the next step now, from the state just saved, so it's done by the time it's due
+			if(overlap && !isStepAhead)
+			{
+				SimulatePhysX();
+				isStepAhead = true;
+			}
+		}
+
+		PxTransform GetRenderPose(const PhysXObject* object)
+		{
+			PxReal alpha = accumulator / myTimestep;
+			PxQuat q0 = object->previousPose.q;
+			PxQuat q1 = object->currentPose.q;
+
+			//Take the shorter way round
+			if(q0.dot(q1) < 0.0f)
+			{
+				q1 = -q1;
+			}
+
+			PxVec3 p = object->previousPose.p + (object->currentPose.p - object->previousPose.p) * alpha;
+			PxQuat q = q0 * (1.0f - alpha) + q1 * alpha;
+
+			return PxTransform(p, q.getNormalized());
+		}
+
+		void GetRenderPoses(vector<SceneHandle>* ids, vector<RigidPose>* poses)
+		{
+			ids->clear();
+			poses->clear();
+
+			//Settled objects go first, so one that has since woken up is overwritten by its moving pose
+			for(int i = 0; i < settledObjects.size(); i++)
+			{
+				ids->push_back(settledObjects[i]->id);
+				poses->push_back(ToRigidPose(settledObjects[i]->currentPose));
+			}
+			settledObjects.clear();
+
+			for(int i = 0; i < activeObjects.size(); i++)
+			{
+				ids->push_back(activeObjects[i]->id);
+				poses->push_back(ToRigidPose(GetRenderPose(activeObjects[i])));
+			}
+		}
+
+		void SimulatePhysX()
+		{
+			//Steps must not overlap
+			FetchPhysX();
+
+			if(!isPaused && gScene)
+			{
+				ApplyForceField();
 
 				gScene->simulate(myTimestep);
+				isSimulating = true;
+			}
+		}
 
-				while(!gScene->fetchResults())
-				{
-					//we can do some work here while the
-					//frame is simulating, but I don't have anything
-					//for the moment
-				}
+		void FetchPhysX()
+		{
+			if(isSimulating)
+			{
+				//Sleeps until the simulation is done rather than spinning on the main thread
+				gScene->fetchResults(true);
+				isSimulating = false;
 			}
 		}
 
 		void ShutdownPhysX()
 		{
+			//Actors can't be released while the scene is simulating
+			FetchPhysX();
+
 			if(allActors)
 			{
 				for(int i = 0; i < allActors->size(); i++)
@@ -293,11 +377,26 @@ namespace EnginePhysics
 			}
 			if(gScene){gScene->release();gScene=NULL;}
 
+			//Only once the scene that submits to it is gone
+			delete gDispatcher;
+			gDispatcher = NULL;
+
 			if(gPhysicsSDK){gPhysicsSDK->release();gPhysicsSDK=NULL;}
+
+			delete forceField;
+			forceField = NULL;
+			delete forceWorkers;
+			forceWorkers = NULL;
 		}
 
 		void ProcessKey(unsigned char key)
 		{
+			//Keys that change actors wait for the running step, so changes land between steps
+			if(key == '2' || key == 'r' || key == ' ' || key == '\n' || key == '\r' || key == 'v')
+			{
+				FetchPhysX();
+			}
+
 			switch(key)
 			{
 				case '0':
@@ -349,6 +448,10 @@ namespace EnginePhysics
 				case 'r':
 				case ' ':
 					ResetScene();
+					//Teleported, so nothing to interpolate from, and a step started from the old
+					//poses is stale
+					isStepAhead = false;
+					SaveStates(true);
 					break;
 
 				case '\n':
@@ -376,65 +479,119 @@ namespace EnginePhysics
 
 	#pragma region Private Methods
 		
-		void ApplyZeroGravity(PhysXObject* object)
+		void ApplyForceField()
 		{
-			DisableGravity(object->actor);
-		}
+			//Scene gravity is only on in NORMAL, so only touch the flags when the state changes
+			if(gravityFlagsState != currentGravState)
+			{
+				for(int i = 0; i < boxes.size(); i++)
+				{
+					if(currentGravState == GravityState::NORMAL)
+					{
+						EnableGravity(boxes[i]->actor);
+					}
+					else
+					{
+						DisableGravity(boxes[i]->actor);
+					}
+				}
+				gravityFlagsState = currentGravState;
+			}
 
-		void ApplyNormalGravity(PhysXObject* object)
-		{
-			EnableGravity(object->actor);
-		}
+			forceField->ClearSources();
 
-		void ApplyPlanetGravity(PhysXObject* object)
-		{
-			DisableGravity(object->actor);
-			for(int j = 0; j < planets.size(); j++)
+			switch(currentGravState)
 			{
-				ApplyInverseSquareGravity(object->actor, planets[j]->actor->getGlobalPose().p, INVERSE_SQUARE_GRAVITATIONAL_FORCE);
+				case GravityState::PLANET_GRAVITY:
+					for(int j = 0; j < planets.size(); j++)
+					{
+						AddForceSource(ForceInverseSquare, planets[j]->actor->getGlobalPose().p, INVERSE_SQUARE_GRAVITATIONAL_FORCE);
+					}
+					break;
+
+				case GravityState::PULL_DOUBLE:
+					AddForceSource(ForceAttract, planetTransforms[1].p, STRONG_UNIVERSAL_GRAVITATIONAL_FORCE);
+					AddForceSource(ForceAttract, planetTransforms[2].p, STRONG_UNIVERSAL_GRAVITATIONAL_FORCE);
+					break;
+
+				case GravityState::PULL_PUSH:
+					AddForceSource(ForceAttract, planetTransforms[0].p, STRONG_UNIVERSAL_GRAVITATIONAL_FORCE);
+					AddForceSource(ForceAttract, planetTransforms[2].p, -WEAK_UNIVERSAL_GRAVITATIONAL_FORCE);
+					break;
+
+				case GravityState::PULL_SINGLE:
+					AddForceSource(ForceAttract, planetTransforms[0].p, STRONG_UNIVERSAL_GRAVITATIONAL_FORCE);
+					break;
+
+				case GravityState::PULL_TRIPLE:
+					AddForceSource(ForceAttract, planetTransforms[0].p, STRONG_UNIVERSAL_GRAVITATIONAL_FORCE);
+					AddForceSource(ForceAttract, planetTransforms[2].p, STRONG_UNIVERSAL_GRAVITATIONAL_FORCE);
+					AddForceSource(ForceAttract, planetTransforms[1].p, STRONG_UNIVERSAL_GRAVITATIONAL_FORCE);
+					break;
+
+				case GravityState::PUSH_PULL:
+					AddForceSource(ForceAttract, planetTransforms[0].p, -WEAK_UNIVERSAL_GRAVITATIONAL_FORCE);
+					AddForceSource(ForceAttract, planetTransforms[2].p, STRONG_UNIVERSAL_GRAVITATIONAL_FORCE);
+					break;
+
+				case GravityState::ORBITS:
+					{
+						//One random axis for the step, as every box used to get the same one
+						PxVec3 axis = CreateRandomVector(10);
+
+						for(int j = 0; j < planets.size(); j++)
+						{
+							AddForceSource(ForceOrbit, planets[j]->actor->getGlobalPose().p, ORBIT_FORCE, axis);
+						}
+					}
+					break;
 			}
-		}
 
-		void ApplyPullDouble(PhysXObject* object)
-		{
-				DisableGravity(object->actor);
+			//ZERO and NORMAL leave the boxes to PhysX
+			if(currentGravState == GravityState::ZERO || currentGravState == GravityState::NORMAL)
+			{
+				return;
+			}
 
-				ApplyGravity(object->actor, planetTransforms[1].p, STRONG_UNIVERSAL_GRAVITATIONAL_FORCE);
-				ApplyGravity(object->actor, planetTransforms[2].p, STRONG_UNIVERSAL_GRAVITATIONAL_FORCE);
-		}
+			//Solve the whole field from the poses already read back, then add the results in one pass
+			forceField->Resize(boxes.size());
+			for(int i = 0; i < boxes.size(); i++)
+			{
+				PxVec3 pos = boxes[i]->currentPose.p;
 
-		void ApplyPullPush(PhysXObject* object)
-		{
-				DisableGravity(object->actor);
-			
-				ApplyGravity(object->actor, planetTransforms[0].p, STRONG_UNIVERSAL_GRAVITATIONAL_FORCE);
-				ApplyGravity(object->actor, planetTransforms[2].p, -WEAK_UNIVERSAL_GRAVITATIONAL_FORCE);
-		}
+				forceField->SetPosition(i, pos.x, pos.y, pos.z);
+			}
 
-		void ApplyPullSingle(PhysXObject* object)
-		{
-				DisableGravity(object->actor);
-			
-				ApplyGravity(object->actor, planetTransforms[0].p, STRONG_UNIVERSAL_GRAVITATIONAL_FORCE);
-		}
+			forceField->Evaluate();
 
-		void ApplyPullTriple(PhysXObject* object)
-		{
-				DisableGravity(object->actor);
-			
-				ApplyGravity(object->actor, planetTransforms[0].p, STRONG_UNIVERSAL_GRAVITATIONAL_FORCE);
-				ApplyGravity(object->actor, planetTransforms[2].p, STRONG_UNIVERSAL_GRAVITATIONAL_FORCE);
-				ApplyGravity(object->actor, planetTransforms[1].p, STRONG_UNIVERSAL_GRAVITATIONAL_FORCE);
+			for(int i = 0; i < boxes.size(); i++)
+			{
+				PxRigidDynamic* box = boxes[i]->actor->isRigidDynamic();
+
+				if(currentGravState == GravityState::ORBITS)
+				{
+					box->setLinearVelocity(PxVec3(0,0,0));
+				}
+				box->addForce(PxVec3(forceField->AccelerationX(i), forceField->AccelerationY(i), forceField->AccelerationZ(i)),
+					PxForceMode::eACCELERATION);
+			}
 		}
 
-		void ApplyPushPull(PhysXObject* object)
+		void AddForceSource(ForceSourceType type, PxVec3 position, PxReal strength, PxVec3 axis)
 		{
-				DisableGravity(object->actor);
-			
-				ApplyGravity(object->actor, planetTransforms[0].p, -WEAK_UNIVERSAL_GRAVITATIONAL_FORCE);
-				ApplyGravity(object->actor, planetTransforms[2].p, STRONG_UNIVERSAL_GRAVITATIONAL_FORCE);
+			ForceSource source;
+
+			source.type = type;
+			source.x = position.x;
+			source.y = position.y;
+			source.z = position.z;
+			source.strength = strength;
+			source.axisX = axis.x;
+			source.axisY = axis.y;
+			source.axisZ = axis.z;
+			forceField->AddSource(source);
 		}
-	
+
 		void ApplyOrbitVelocity(PxRigidActor* box, float power)
 		{
 			for(int i = 0; i < planets.size(); i++)
@@ -468,54 +625,74 @@ namespace EnginePhysics
 			actor->setActorFlag(PxActorFlag::eDISABLE_GRAVITY, false);
 		}
 
-		void ApplyGravity(PxRigidActor* actor, PxVec3 source, PxReal power)
+		void SaveStates(bool resetPrevious)
 		{
-			PxVec3 dir, norm, force;
-		
-			//Disables the scene gravity so we can apply our own
-			DisableGravity(actor);
-
-			dir = source - actor->getGlobalPose().p;
+			settledObjects.clear();
+			for(int i = 0; i < allActors->size(); i++)
+			{
+				PhysXObject* object = (*allActors)[i];
 
-			norm = dir.getNormalized();
+				PxTransform pose = object->actor->getGlobalPose();
 
-			force = (norm * power);
+				object->previousPose = resetPrevious ? pose : object->currentPose;
+				object->currentPose = pose;
 
-			actor->isRigidBody()->addForce(force, PxForceMode::eACCELERATION);
+				//Every object is redrawn, moving or not
+				settledObjects.push_back(object);
+			}
 		}
 
-		void ApplyInverseSquareGravity(PxRigidActor* actor, PxVec3 source, PxReal power)
+		void ReadActiveTransforms()
 		{
-			PxVec3 dir;
-			PxReal distSquared;
-			PxVec3 norm;
-			PxVec3 force;
-			int objectNum = boxes.size();
+			PxU32 count = 0;
+			const PxActiveTransform* transforms = gScene->getActiveTransforms(count);
 
-			for(int i = 0; i < objectNum; i++)
+			stepCount++;
+			lastActiveObjects.swap(activeObjects);
+			activeObjects.clear();
+
+			for(PxU32 i = 0; i < count; i++)
 			{
-				//Disables the scene gravity so we can apply our own
-				DisableGravity(boxes[i]->actor);
+				PhysXObject* object = (PhysXObject*)transforms[i].userData;
 
-				dir = source - boxes[i]->actor->getGlobalPose().p;
+				//Actors added without an object have nothing to draw
+				if(!object)
+				{
+					continue;
+				}
 
-				distSquared = dir.magnitudeSquared();
-				distSquared = (distSquared < 10) ? 10000 : distSquared;
+				object->previousPose = object->currentPose;
+				object->currentPose = transforms[i].actor2World;
+				object->lastActiveStep = stepCount;
+				activeObjects.push_back(object);
+			}
 
-				norm = dir.getNormalized();
-				force = (norm * power) / distSquared;
+			//Objects that stopped this step stay where they are, after one last draw
+			for(int i = 0; i < lastActiveObjects.size(); i++)
+			{
+				PhysXObject* object = lastActiveObjects[i];
 
-				boxes[i]->actor->isRigidBody()->addForce(force, PxForceMode::eACCELERATION);
+				if(object->lastActiveStep != stepCount)
+				{
+					object->previousPose = object->currentPose;
+					settledObjects.push_back(object);
+				}
 			}
 		}
 
-		void UpdatePhysXObject(PhysXObject* object)
+		RigidPose ToRigidPose(const PxTransform& transform)
 		{
-			PxVec3 pos = object->actor->getGlobalPose().p;
+			RigidPose pose;
+
+			pose.rotation[0] = transform.q.x;
+			pose.rotation[1] = transform.q.y;
+			pose.rotation[2] = transform.q.z;
+			pose.rotation[3] = transform.q.w;
+			pose.position[0] = transform.p.x;
+			pose.position[1] = transform.p.y;
+			pose.position[2] = transform.p.z;
 
-			object->x = pos.x;
-			object->y = pos.y;
-			object->z = pos.z;
+			return pose;
 		}
 
 		void ResetScene()
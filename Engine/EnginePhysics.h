@@ -32,7 +32,18 @@ using namespace physx;
 
 namespace EnginePhysics
 {	
-	void StepPhysX();
+	//Runs as many fixed steps as the elapsed time adds up to, up to a cap, keeping the
+	//last two states of each object. With overlap, the step after those is started
+	//without waiting for it, to run alongside rendering
+	void AdvancePhysX(float elapsedTime, bool overlap);
+
+	//Where to draw an object: between its last two states, by how far real time is
+	//past the earlier one
+	PxTransform GetRenderPose(const PhysXObject* object);
+
+	//The render poses of the objects moving as of the latest step, and of any that have
+	//stopped or been moved by hand since the last call. Objects at rest aren't listed
+	void GetRenderPoses(vector<SceneHandle>* ids, vector<RigidPose>* poses);
 
 	void InitializePhysX(vector<PhysXObject*>* &cubeList);
 
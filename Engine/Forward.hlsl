@@ -18,11 +18,21 @@
 #include "Rendering.hlsl"
 
 //--------------------------------------------------------------------------------------
+// Where the lights barely reach, falls back to a dim ambient
+float3 ApplyAmbient(SurfaceData surface, float3 lit)
+{
+	float3 ambientLight = float3(0.01f,0.01125f,0.01275f);
+	if(lit.x <ambientLight.x && lit.y <ambientLight.y && lit.z<ambientLight.z)
+	{
+		lit.xyz= surface.albedo.xyz* ambientLight;
+	}
+    return lit;
+}
+
 float4 ForwardPS(GeometryVSOut input) : SV_Target
 {
-    // How many total lights?
-    uint totalLights, dummy;
-    gLight.GetDimensions(totalLights, dummy);
+    // How many total lights? Those culled on the CPU leave the end of the buffer unused
+    uint totalLights = mLightCount;
 	SurfaceData surface = ComputeSurfaceDataFromGeometry(input);
     float3 lit = float3(0.0f, 0.0f, 0.0f);
 
@@ -36,12 +46,7 @@ float4 ForwardPS(GeometryVSOut input) : SV_Target
         }
     }
 
-	float3 ambientLight = float3(0.01f,0.01125f,0.01275f);
-	if(lit.x <ambientLight.x && lit.y <ambientLight.y && lit.z<ambientLight.z)
-	{
-		lit.xyz= surface.albedo.xyz* ambientLight;
-	}
-    return float4(lit, 1.0f);
+    return float4(ApplyAmbient(surface, lit), 1.0f);
 }
 
 float4 ForwardAlphaTestPS(GeometryVSOut input) : SV_Target
@@ -0,0 +1,393 @@
+#include "ClusterLightCuller.h"
+#include "LightCullMath.h"
+
+#include <algorithm>
+
+
+// The shader's log2, which the C runtime of older compilers doesn't have.
+static float Log2(float x)
+{
+    return logf(x) * 1.44269504f;
+}
+
+
+#ifdef SCENE_USE_SSE
+// The lanes of a group of four that hold the first count lights.
+static int LaneMask(uint32_t count)
+{
+    return count >= 4 ? 15 : (1 << count) - 1;
+}
+#endif
+
+
+static void StartLists(ClusterSetup const& setup, ClusterLightLists* result)
+{
+    result->tilesX = TileCount(setup.width, setup.tileSize);
+    result->tilesY = TileCount(setup.height, setup.tileSize);
+    result->slices = setup.slices;
+    result->sliceNearZ = setup.sliceNearZ;
+    result->sliceScale = (float)setup.slices / Log2(setup.farZ / setup.sliceNearZ);
+    result->sliceBias = -Log2(setup.sliceNearZ) * result->sliceScale;
+}
+
+
+// The slices reached by a light at view space z, as ClusterLightSlices. Returns false if it
+// is entirely outside the near and far planes.
+static bool LightSlices(ClusterSetup const& setup, ClusterLightLists const& lists, float z, float radius,
+    uint32_t* firstSlice, uint32_t* lastSlice)
+{
+    float minZ = z - radius;
+    float maxZ = z + radius;
+
+    *firstSlice = lists.Slice(minZ);
+    *lastSlice = lists.Slice(maxZ);
+
+    return maxZ >= setup.nearZ && minZ < setup.farZ;
+}
+
+
+uint32_t ClusterLightLists::Slice(float viewZ) const
+{
+    float slice = Log2(max(viewZ, sliceNearZ)) * sliceScale + sliceBias;
+
+    return min((uint32_t)max(slice, 0.0f), slices - 1);
+}
+
+
+ClusterLightCuller::ClusterLightCuller(WorkerPool* pool)
+    : pool(pool), lightCount(0)
+{
+}
+
+
+void ClusterLightCuller::Assign(ClusterSetup const& setup, ViewLight const* lights, uint32_t lightCount, ClusterLightLists* result)
+{
+    StartLists(setup, result);
+
+    uint32_t tilesX = result->tilesX;
+    uint32_t tilesY = result->tilesY;
+    uint32_t slices = result->slices;
+    uint32_t padded = (lightCount + 3) & ~3u;
+    uint32_t i;
+
+    this->lightCount = lightCount;
+
+    // Gather the lights into arrays of each component, to test four at once.
+    lightX.resize(padded);
+    lightY.resize(padded);
+    lightZ.resize(padded);
+    lightNegativeRadius.resize(padded);
+
+    for (i = 0; i < padded; i++)
+    {
+        bool isLight = i < lightCount;
+
+        lightX[i] = isLight ? lights[i].positionView[0] : 0.0f;
+        lightY[i] = isLight ? lights[i].positionView[1] : 0.0f;
+        lightZ[i] = isLight ? lights[i].positionView[2] : 0.0f;
+        lightNegativeRadius[i] = isLight ? -lights[i].attenuationEnd : 0.0f;
+    }
+
+    // The side planes of each column of tiles are the same for every row.
+    columnPlanes.resize(tilesX * 4);
+    for (i = 0; i < tilesX; i++)
+    {
+        SidePlane(setup.projectionX, setup.width, setup.tileSize, i, -1.0f, &columnPlanes[i * 4]);
+        SidePlane(setup.projectionX, setup.width, setup.tileSize, i, 1.0f, &columnPlanes[i * 4 + 2]);
+    }
+
+    if (rows.size() < tilesY)
+    {
+        rows.resize(tilesY);
+    }
+
+    RunTasks(tilesY, [&](uint32_t row)
+    {
+        AssignRow(setup, row, result);
+    });
+
+    // Join the rows' lists, a slice at a time.
+    uint32_t total = 0;
+
+    for (uint32_t row = 0; row < tilesY; row++)
+    {
+        total += (uint32_t)rows[row].found.size();
+    }
+    result->lights.resize(total);
+    result->first.resize(tilesX * tilesY * slices + 1);
+
+    uint32_t next = 0;
+
+    for (uint32_t slice = 0; slice < slices; slice++)
+    {
+        for (uint32_t row = 0; row < tilesY; row++)
+        {
+            RowScratch const& scratch = rows[row];
+
+            for (uint32_t column = 0; column < tilesX; column++)
+            {
+                uint32_t cluster = column * slices + slice;
+                uint32_t count = scratch.counts[cluster];
+
+                result->first[result->Cluster(column, row, slice)] = next;
+                if (count)
+                {
+                    copy(scratch.found.begin() + scratch.first[cluster], scratch.found.begin() + scratch.first[cluster] + count,
+                        result->lights.begin() + next);
+                }
+                next += count;
+            }
+        }
+    }
+    result->first[tilesX * tilesY * slices] = next;
+}
+
+
+void ClusterLightCuller::RunTasks(uint32_t taskCount, function<void(uint32_t)> const& task)
+{
+    if (pool)
+    {
+        pool->Run(taskCount, task);
+        return;
+    }
+
+    for (uint32_t i = 0; i < taskCount; i++)
+    {
+        task(i);
+    }
+}
+
+
+void ClusterLightCuller::AssignRow(ClusterSetup const& setup, uint32_t row, ClusterLightLists* result)
+{
+    RowScratch& scratch = rows[row];
+    uint32_t tilesX = result->tilesX;
+    uint32_t slices = result->slices;
+    float rowPlanes[4];
+    uint32_t i;
+
+    // The shader's y runs up the screen, so its c2 has the projection negated.
+    SidePlane(-setup.projectionY, setup.height, setup.tileSize, row, -1.0f, &rowPlanes[0]);
+    SidePlane(-setup.projectionY, setup.height, setup.tileSize, row, 1.0f, &rowPlanes[2]);
+
+    scratch.x.clear();
+    scratch.z.clear();
+    scratch.negativeRadius.clear();
+    scratch.index.clear();
+    scratch.found.clear();
+    scratch.first.resize(tilesX * slices);
+    scratch.counts.assign(tilesX * slices, 0);
+    scratch.next.resize(slices);
+
+    // Keep the lights in front of the row's top and bottom planes.
+#ifdef SCENE_USE_SSE
+    __m128 topY = _mm_set1_ps(rowPlanes[0]), topZ = _mm_set1_ps(rowPlanes[1]);
+    __m128 bottomY = _mm_set1_ps(rowPlanes[2]), bottomZ = _mm_set1_ps(rowPlanes[3]);
+
+    for (i = 0; i < lightX.size(); i += 4)
+    {
+        __m128 y = _mm_load_ps(&lightY[i]);
+        __m128 z = _mm_load_ps(&lightZ[i]);
+        __m128 negativeRadius = _mm_load_ps(&lightNegativeRadius[i]);
+        __m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(topY, y), _mm_mul_ps(topZ, z)), negativeRadius);
+
+        inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(bottomY, y), _mm_mul_ps(bottomZ, z)), negativeRadius));
+
+        // Leave out the padding.
+        int mask = _mm_movemask_ps(inside) & LaneMask(lightCount - i);
+
+        while (mask)
+        {
+            uint32_t light = i + FirstLane(mask);
+
+            scratch.x.push_back(lightX[light]);
+            scratch.z.push_back(lightZ[light]);
+            scratch.negativeRadius.push_back(lightNegativeRadius[light]);
+            scratch.index.push_back(light);
+            mask &= mask - 1;
+        }
+    }
+#else
+    for (i = 0; i < lightCount; i++)
+    {
+        if (rowPlanes[0] * lightY[i] + rowPlanes[1] * lightZ[i] >= lightNegativeRadius[i] &&
+            rowPlanes[2] * lightY[i] + rowPlanes[3] * lightZ[i] >= lightNegativeRadius[i])
+        {
+            scratch.x.push_back(lightX[i]);
+            scratch.z.push_back(lightZ[i]);
+            scratch.negativeRadius.push_back(lightNegativeRadius[i]);
+            scratch.index.push_back(i);
+        }
+    }
+#endif
+
+    uint32_t rowLights = (uint32_t)scratch.index.size();
+
+    while (scratch.x.size() & 3)
+    {
+        scratch.x.push_back(0.0f);
+        scratch.z.push_back(0.0f);
+        scratch.negativeRadius.push_back(0.0f);
+    }
+
+    for (uint32_t column = 0; column < tilesX; column++)
+    {
+        float const* planes = &columnPlanes[column * 4];
+        uint32_t* counts = &scratch.counts[column * slices];
+        uint32_t slice;
+
+        // Find the slices each light in the tile reaches, and count the lights in each cluster.
+        scratch.hits.clear();
+
+        auto keep = [&](uint32_t light)
+        {
+            uint32_t firstSlice, lastSlice;
+
+            if (LightSlices(setup, *result, scratch.z[light], -scratch.negativeRadius[light], &firstSlice, &lastSlice))
+            {
+                scratch.hits.push_back(scratch.index[light]);
+                scratch.hits.push_back(firstSlice);
+                scratch.hits.push_back(lastSlice);
+                for (slice = firstSlice; slice <= lastSlice; slice++)
+                {
+                    counts[slice]++;
+                }
+            }
+        };
+
+#ifdef SCENE_USE_SSE
+        __m128 leftX = _mm_set1_ps(planes[0]), leftZ = _mm_set1_ps(planes[1]);
+        __m128 rightX = _mm_set1_ps(planes[2]), rightZ = _mm_set1_ps(planes[3]);
+
+        for (i = 0; i < rowLights; i += 4)
+        {
+            __m128 x = _mm_load_ps(&scratch.x[i]);
+            __m128 z = _mm_load_ps(&scratch.z[i]);
+            __m128 negativeRadius = _mm_load_ps(&scratch.negativeRadius[i]);
+            __m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(leftX, x), _mm_mul_ps(leftZ, z)), negativeRadius);
+
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(rightX, x), _mm_mul_ps(rightZ, z)), negativeRadius));
+
+            int mask = _mm_movemask_ps(inside) & LaneMask(rowLights - i);
+
+            while (mask)
+            {
+                keep(i + FirstLane(mask));
+                mask &= mask - 1;
+            }
+        }
+#else
+        for (i = 0; i < rowLights; i++)
+        {
+            float x = scratch.x[i], z = scratch.z[i], negativeRadius = scratch.negativeRadius[i];
+
+            if (planes[0] * x + planes[1] * z >= negativeRadius && planes[2] * x + planes[3] * z >= negativeRadius)
+            {
+                keep(i);
+            }
+        }
+#endif
+
+        // Lay the tile's clusters out one after another, then fill them in.
+        uint32_t start = (uint32_t)scratch.found.size();
+
+        for (slice = 0; slice < slices; slice++)
+        {
+            scratch.first[column * slices + slice] = start;
+            scratch.next[slice] = start;
+            start += counts[slice];
+        }
+        scratch.found.resize(start);
+
+        for (i = 0; i < scratch.hits.size(); i += 3)
+        {
+            for (slice = scratch.hits[i + 1]; slice <= scratch.hits[i + 2]; slice++)
+            {
+                scratch.found[scratch.next[slice]++] = scratch.hits[i];
+            }
+        }
+    }
+}
+
+
+void ClusterLightCuller::AssignReference(ClusterSetup const& setup, ViewLight const* lights, uint32_t lightCount, ClusterLightLists* result)
+{
+    StartLists(setup, result);
+
+    uint32_t tilesX = result->tilesX;
+    uint32_t tilesY = result->tilesY;
+    vector<vector<uint32_t> > clusterLights(tilesX * tilesY * result->slices);
+
+    for (uint32_t groupY = 0; groupY < tilesY; groupY++)
+    {
+        for (uint32_t groupX = 0; groupX < tilesX; groupX++)
+        {
+            // The tile's side planes, from the relevant columns of its projection.
+            float tileScaleX = (float)setup.width / (float)(2 * setup.tileSize);
+            float tileScaleY = (float)setup.height / (float)(2 * setup.tileSize);
+            float tileBiasX = tileScaleX - (float)groupX;
+            float tileBiasY = tileScaleY - (float)groupY;
+            float c1[4] = { setup.projectionX * tileScaleX, 0.0f, tileBiasX, 0.0f };
+            float c2[4] = { 0.0f, -setup.projectionY * tileScaleY, tileBiasY, 0.0f };
+            float c4[4] = { 0.0f, 0.0f, 1.0f, 0.0f };
+            float sidePlanes[4][4];
+            int i, j;
+
+            for (j = 0; j < 4; j++)
+            {
+                sidePlanes[0][j] = c4[j] - c1[j];
+                sidePlanes[1][j] = c4[j] + c1[j];
+                sidePlanes[2][j] = c4[j] - c2[j];
+                sidePlanes[3][j] = c4[j] + c2[j];
+            }
+
+            for (i = 0; i < 4; i++)
+            {
+                float* plane = sidePlanes[i];
+                float scale = 1.0f / sqrtf(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+
+                for (j = 0; j < 4; j++)
+                {
+                    plane[j] *= scale;
+                }
+            }
+
+            // Point light sphere against the column, then its depth range against the slices.
+            for (uint32_t lightIndex = 0; lightIndex < lightCount; lightIndex++)
+            {
+                ViewLight const& light = lights[lightIndex];
+                bool inColumn = true;
+
+                for (i = 0; i < 4; i++)
+                {
+                    float d = sidePlanes[i][0] * light.positionView[0] + sidePlanes[i][1] * light.positionView[1] +
+                        sidePlanes[i][2] * light.positionView[2] + sidePlanes[i][3];
+
+                    inColumn = inColumn && d >= -light.attenuationEnd;
+                }
+
+                float minZ = light.positionView[2] - light.attenuationEnd;
+                float maxZ = light.positionView[2] + light.attenuationEnd;
+
+                inColumn = inColumn && maxZ >= setup.nearZ && minZ < setup.farZ;
+
+                if (inColumn)
+                {
+                    for (uint32_t slice = result->Slice(minZ); slice <= result->Slice(maxZ); slice++)
+                    {
+                        clusterLights[result->Cluster(groupX, groupY, slice)].push_back(lightIndex);
+                    }
+                }
+            }
+        }
+    }
+
+    result->first.clear();
+    result->lights.clear();
+    for (size_t cluster = 0; cluster < clusterLights.size(); cluster++)
+    {
+        result->first.push_back((uint32_t)result->lights.size());
+        result->lights.insert(result->lights.end(), clusterLights[cluster].begin(), clusterLights[cluster].end());
+    }
+    result->first.push_back((uint32_t)result->lights.size());
+}
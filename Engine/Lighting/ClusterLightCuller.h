@@ -0,0 +1,101 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "../Scene/SceneMath.h"
+#include "../Scene/SceneStore.h"
+#include "../Scene/WorkerPool.h"
+#include "TileLightCuller.h"
+
+using namespace std;
+
+
+// What clustered shading is given besides the lights. Unlike tiles, clusters don't depend
+// on the depth buffer.
+struct ClusterSetup
+{
+    uint32_t width;             // Of the screen, in pixels.
+    uint32_t height;
+    uint32_t tileSize;          // Pixels along each side of a cluster, as CLUSTER_TILE_DIM.
+    uint32_t slices;            // Depth slices behind each tile, as CLUSTER_SLICES.
+
+    // The projection's _11 and _22.
+    float projectionX;
+    float projectionY;
+
+    // Only view space z in [nearZ, farZ) is shaded. Slices are spaced exponentially from
+    // sliceNearZ to farZ, and everything nearer than sliceNearZ is in the first.
+    float nearZ;
+    float farZ;
+    float sliceNearZ;           // As CLUSTER_NEAR_Z.
+};
+
+
+// The lights touching each cluster. Clusters are in slices from the nearest, each slice in
+// rows of tiles from the top left, as ClusterIndex in ClusteredShading.hlsl.
+struct ClusterLightLists
+{
+    uint32_t tilesX;
+    uint32_t tilesY;
+    uint32_t slices;
+    float sliceNearZ;
+    float sliceScale;           // The slice of view space z is log2(z) * sliceScale + sliceBias,
+    float sliceBias;            // as mClusterSliceParams.
+    vector<uint32_t> first;     // Where each cluster's lights start, with the end of the last cluster after them.
+    vector<uint32_t> lights;    // Indices into the lights, ascending within each cluster.
+
+    uint32_t Cluster(uint32_t tileX, uint32_t tileY, uint32_t slice) const { return (slice * tilesY + tileY) * tilesX + tileX; }
+    uint32_t Slice(float viewZ) const;
+    uint32_t Count(uint32_t cluster) const { return first[cluster + 1] - first[cluster]; }
+    uint32_t const* Lights(uint32_t cluster) const { return lights.empty() ? 0 : &lights[first[cluster]]; }
+};
+
+
+// Assigns point lights to clusters the way ClusterAssignCS does: a light is kept in a column
+// of clusters if its sphere of influence is not entirely behind any of the tile's four side
+// planes, and goes into each slice its depth range overlaps. As TileLightCuller, this checks
+// the shader and measures cluster sizes on the CPU, headless. Lights are tested four at a
+// time, against a row's top and bottom planes then each tile's left and right, and rows of
+// tiles are split across a WorkerPool, if one is given.
+class ClusterLightCuller
+{
+public:
+    explicit ClusterLightCuller(WorkerPool* pool = 0);
+
+    void Assign(ClusterSetup const& setup, ViewLight const* lights, uint32_t lightCount, ClusterLightLists* result);
+
+    // The shader's loop written out one tile and one light at a time, to check Assign against.
+    // The lists come out the same.
+    static void AssignReference(ClusterSetup const& setup, ViewLight const* lights, uint32_t lightCount, ClusterLightLists* result);
+
+private:
+    typedef SceneStore::FloatArray FloatArray;
+
+    // The lights left in one row of tiles, and those found in each of its clusters, by tile
+    // then slice.
+    struct RowScratch
+    {
+        FloatArray x, z, negativeRadius;
+        vector<uint32_t> index;
+        vector<uint32_t> hits;      // Light, first slice and last slice of the lights in one tile.
+        vector<uint32_t> found;
+        vector<uint32_t> first;     // Where each cluster's lights start in found.
+        vector<uint32_t> counts;
+        vector<uint32_t> next;
+    };
+
+    void RunTasks(uint32_t taskCount, function<void(uint32_t)> const& task);
+    void AssignRow(ClusterSetup const& setup, uint32_t row, ClusterLightLists* result);
+
+    WorkerPool* pool;
+
+    // The lights, padded to a multiple of four. The padding is masked out of every test.
+    FloatArray lightX, lightY, lightZ, lightNegativeRadius;
+    uint32_t lightCount;
+
+    // The left and right planes of each column of tiles, as x and z: their y and w are 0.
+    vector<float> columnPlanes;
+
+    vector<RowScratch> rows;
+};
@@ -0,0 +1,986 @@
+// Command line benchmark for binning point lights into screen tiles on the CPU, with no
+// dependency on Direct3D or Windows, so it can run on a headless build machine.
+//
+// Usage:
+//   lightbench bench [-n frames] [-w width] [-h height] [-s samples] [-l lights] [-t threads]
+//       Renders a depth buffer of a floor and pillars, scatters moving lights through the view,
+//       and times binning them into 8, 16, 32 and 64 pixel tiles: one light and tile at a time as
+//       the shader does, then four lights at a time on one thread and on every core. Reports how
+//       many lights land in each tile, which must stay under COMPUTE_SHADER_TILE_MAX_LIGHTS.
+//   lightbench clusters [-n frames] [-w width] [-h height] [-l lights] [-t threads]
+//       Times assigning 1024, 4096 and 16384 lights (or just -l) to the clusters of
+//       ClusteredShading.hlsl, sized as in ShaderDefines.h, and reports whether the lists fit
+//       the index list the engine allocates for them.
+//   lightbench lights [-n frames] [-w width] [-h height] [-l lights]
+//       Times moving 1000, 10000 and 100000 lights (or just -l) around their orbits and writing
+//       them in view space into a light buffer, from the engine's default camera: as App used to,
+//       one structure at a time then a copy, and with LightSystem, with and without culling the
+//       lights outside the view.
+//   lightbench check [-w width] [-h height] [-l lights]
+//       Compares the tile and cluster lists against the one at a time references, for several
+//       tile sizes and sample counts, and checks that every light reaching a sample is in its
+//       tile's and its cluster's list. Then compares LightSystem against its references, and
+//       its culling against the view. Exits with 1 on failure.
+//
+// The default is a 1920x1080 depth buffer with one sample per pixel, 1024 lights, 20 frames,
+// and a thread per core. Checking defaults to 1000x700 and 256 lights, as every sample is
+// tested against every light.
+
+#include "../ClusterLightCuller.h"
+#include "../LightSystem.h"
+#include "../TileLightCuller.h"
+#include "../../ShaderDefines.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+
+// As the engine's camera: a 45 degree field of view, with near and far swapped in the
+// projection, so the depth buffer is 1 at the near plane and 0 at the far one.
+static float const FieldOfView = 3.14159265f / 4.0f;
+static float const NearZ = 0.05f;
+static float const FarZ = 300.0f;
+static float const FloorY = -5.0f;
+static float const PillarTop = 10.0f;
+static uint32_t const PillarCount = 24;
+
+
+// Small deterministic generator, so runs are repeatable.
+static uint32_t Random(uint32_t* state)
+{
+    *state = *state * 1664525 + 1013904223;
+
+    return *state >> 8;
+}
+
+
+static float RandomFloat(uint32_t* state, float low, float high)
+{
+    return low + (Random(state) & 0xFFFF) * ((high - low) / 65535.0f);
+}
+
+
+static double Seconds(Clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::duration<double>>(Clock::now() - start).count();
+}
+
+
+static void MakeSetup(TileCullSetup* setup, uint32_t width, uint32_t height, uint32_t samples, uint32_t tileSize)
+{
+    float yScale = 1.0f / tanf(FieldOfView * 0.5f);
+
+    setup->width = width;
+    setup->height = height;
+    setup->samples = samples;
+    setup->tileSize = tileSize;
+    setup->projectionX = yScale * height / width;
+    setup->projectionY = yScale;
+    setup->projectionZ = NearZ / (NearZ - FarZ);
+    setup->projectionW = -FarZ * NearZ / (NearZ - FarZ);
+    setup->nearZ = NearZ;
+    setup->farZ = FarZ;
+}
+
+
+// Clusters as the engine sizes them, for the same camera.
+static void MakeClusterSetup(ClusterSetup* setup, uint32_t width, uint32_t height)
+{
+    float yScale = 1.0f / tanf(FieldOfView * 0.5f);
+
+    setup->width = width;
+    setup->height = height;
+    setup->tileSize = CLUSTER_TILE_DIM;
+    setup->slices = CLUSTER_SLICES;
+    setup->projectionX = yScale * height / width;
+    setup->projectionY = yScale;
+    setup->nearZ = NearZ;
+    setup->farZ = FarZ;
+    setup->sliceNearZ = CLUSTER_NEAR_Z;
+}
+
+
+// A floor below the camera, with pillars standing on it at different depths, and nothing
+// above the horizon. Each sample looks along a slightly different ray, so the samples of a
+// pixel on an edge can hit different things.
+static void RenderDepth(TileCullSetup const& setup, vector<float>* depth)
+{
+    float pillarX[PillarCount], pillarZ[PillarCount], pillarWidth[PillarCount];
+    uint32_t random = 7;
+
+    for (uint32_t i = 0; i < PillarCount; i++)
+    {
+        pillarZ[i] = RandomFloat(&random, 5.0f, 150.0f);
+        pillarX[i] = RandomFloat(&random, -0.4f, 0.4f) * pillarZ[i];
+        pillarWidth[i] = RandomFloat(&random, 0.5f, 4.0f);
+    }
+
+    depth->resize((size_t)setup.width * setup.height * setup.samples);
+
+    for (uint32_t y = 0; y < setup.height; y++)
+    {
+        for (uint32_t x = 0; x < setup.width; x++)
+        {
+            for (uint32_t sample = 0; sample < setup.samples; sample++)
+            {
+                float offset = (sample + 0.5f) / setup.samples;
+                float rayX = ((x + offset) / setup.width * 2.0f - 1.0f) / setup.projectionX;
+                float rayY = (1.0f - (y + 1.0f - offset) / setup.height * 2.0f) / setup.projectionY;
+                float z = FarZ;
+
+                if (rayY < 0.0f)
+                {
+                    z = min(z, FloorY / rayY);
+                }
+                for (uint32_t i = 0; i < PillarCount; i++)
+                {
+                    float hitX = rayX * pillarZ[i], hitY = rayY * pillarZ[i];
+
+                    if (pillarZ[i] < z && fabsf(hitX - pillarX[i]) < pillarWidth[i] && hitY >= FloorY && hitY < PillarTop)
+                    {
+                        z = pillarZ[i];
+                    }
+                }
+
+                // Back into the depth buffer; the background is at the far plane.
+                (*depth)[((size_t)y * setup.width + x) * setup.samples + sample] =
+                    z >= FarZ ? 0.0f : setup.projectionZ + setup.projectionW / z;
+            }
+        }
+    }
+}
+
+
+// Lights of the engine's sizes, in front of the camera, around the floor and pillars.
+static void MakeLights(float projectionX, uint32_t count, vector<ViewLight>* lights)
+{
+    uint32_t random = 1337;
+
+    lights->resize(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        ViewLight& light = (*lights)[i];
+        float z = RandomFloat(&random, 1.0f, 150.0f);
+
+        light.positionView[0] = RandomFloat(&random, -1.2f, 1.2f) * z / projectionX;
+        light.positionView[1] = RandomFloat(&random, FloorY, PillarTop + 5.0f);
+        light.positionView[2] = z;
+        light.attenuationEnd = RandomFloat(&random, 2.0f, 15.0f);
+        light.attenuationBegin = 0.8f * light.attenuationEnd;
+        light.color[0] = light.color[1] = light.color[2] = 0.3f;
+    }
+}
+
+
+static void MoveLights(vector<ViewLight> const& start, int frame, vector<ViewLight>* lights)
+{
+    for (size_t i = 0; i < start.size(); i++)
+    {
+        (*lights)[i].positionView[0] = start[i].positionView[0] + 3.0f * sinf(frame * 0.05f + i);
+        (*lights)[i].positionView[2] = start[i].positionView[2] + 3.0f * cosf(frame * 0.05f + i);
+    }
+}
+
+
+static void Report(char const* name, double seconds, int frames, TileLightLists const& lists)
+{
+    uint32_t tiles = lists.tilesX * lists.tilesY;
+    uint32_t most = 0;
+
+    for (uint32_t i = 0; i < tiles; i++)
+    {
+        most = max(most, lists.Count(i));
+    }
+
+    printf("%-30s %9.3f ms/frame %8.1f lights/tile %6u most %9.1f KB of lists\n", name, seconds / frames * 1e3,
+        (double)lists.lights.size() / tiles, most, lists.lights.size() * sizeof(uint32_t) / 1024.0);
+}
+
+
+static void BenchTileSize(uint32_t width, uint32_t height, uint32_t samples, uint32_t lightCount, uint32_t tileSize, int frames, WorkerPool* pool)
+{
+    TileCullSetup setup;
+    vector<float> depth;
+    vector<ViewLight> start, lights;
+    TileLightLists lists;
+    char name[64];
+    int frame;
+
+    MakeSetup(&setup, width, height, samples, tileSize);
+    RenderDepth(setup, &depth);
+    MakeLights(setup.projectionX, lightCount, &start);
+    lights = start;
+
+    printf("%ux%u tiles of %u pixels\n", (width + tileSize - 1) / tileSize, (height + tileSize - 1) / tileSize, tileSize);
+
+    // The reference is slow, so only gets a few frames.
+    int referenceFrames = min(frames, 3);
+    double seconds = 0.0;
+
+    for (frame = 0; frame < referenceFrames; frame++)
+    {
+        MoveLights(start, frame, &lights);
+
+        Clock::time_point begin = Clock::now();
+        TileLightCuller::CullReference(setup, &depth[0], &lights[0], lightCount, &lists);
+        seconds += Seconds(begin);
+    }
+    Report("one light at a time", seconds, referenceFrames, lists);
+
+    TileLightCuller serial;
+    TileLightCuller parallel(pool);
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        TileLightCuller& culler = pass ? parallel : serial;
+
+        seconds = 0.0;
+        for (frame = 0; frame < frames; frame++)
+        {
+            MoveLights(start, frame, &lights);
+
+            Clock::time_point begin = Clock::now();
+            culler.Cull(setup, &depth[0], &lights[0], lightCount, &lists);
+            seconds += Seconds(begin);
+        }
+
+        sprintf(name, "four at a time, %u threads", pass ? pool->ThreadCount() : 1);
+        Report(name, seconds, frames, lists);
+    }
+}
+
+
+static int Bench(uint32_t width, uint32_t height, uint32_t samples, uint32_t lights, int frames, unsigned int threads)
+{
+    WorkerPool pool(threads);
+
+    printf("%ux%u with %u samples, %u lights, %d frames\n", width, height, samples, lights, frames);
+
+    for (uint32_t tileSize = 8; tileSize <= 64; tileSize *= 2)
+    {
+        BenchTileSize(width, height, samples, lights, tileSize, frames, &pool);
+    }
+
+    return 0;
+}
+
+
+static void ReportClusters(char const* name, double seconds, int frames, ClusterLightLists const& lists)
+{
+    uint32_t clusters = lists.tilesX * lists.tilesY * lists.slices;
+    uint32_t most = 0, lit = 0;
+
+    for (uint32_t i = 0; i < clusters; i++)
+    {
+        most = max(most, lists.Count(i));
+        lit += lists.Count(i) ? 1 : 0;
+    }
+
+    printf("%-30s %9.3f ms/frame %8.1f lights/cluster %6u most %6u clusters lit %9.1f KB of lists\n", name, seconds / frames * 1e3,
+        (double)lists.lights.size() / clusters, most, lit, lists.lights.size() * sizeof(uint32_t) / 1024.0);
+}
+
+
+static void BenchClusterLights(uint32_t width, uint32_t height, uint32_t lightCount, int frames, WorkerPool* pool)
+{
+    ClusterSetup setup;
+    vector<ViewLight> start, lights;
+    ClusterLightLists lists;
+    char name[64];
+    int frame;
+
+    MakeClusterSetup(&setup, width, height);
+    MakeLights(setup.projectionX, lightCount, &start);
+    lights = start;
+
+    printf("%u lights\n", lightCount);
+
+    int referenceFrames = min(frames, 3);
+    double seconds = 0.0;
+
+    for (frame = 0; frame < referenceFrames; frame++)
+    {
+        MoveLights(start, frame, &lights);
+
+        Clock::time_point begin = Clock::now();
+        ClusterLightCuller::AssignReference(setup, &lights[0], lightCount, &lists);
+        seconds += Seconds(begin);
+    }
+    ReportClusters("one light at a time", seconds, referenceFrames, lists);
+
+    ClusterLightCuller serial;
+    ClusterLightCuller parallel(pool);
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        ClusterLightCuller& culler = pass ? parallel : serial;
+
+        seconds = 0.0;
+        for (frame = 0; frame < frames; frame++)
+        {
+            MoveLights(start, frame, &lights);
+
+            Clock::time_point begin = Clock::now();
+            culler.Assign(setup, &lights[0], lightCount, &lists);
+            seconds += Seconds(begin);
+        }
+
+        sprintf(name, "four at a time, %u threads", pass ? pool->ThreadCount() : 1);
+        ReportClusters(name, seconds, frames, lists);
+    }
+
+    // The engine has room for CLUSTER_AVERAGE_LIGHTS a cluster, and cuts the lists short past that.
+    uint32_t capacity = lists.tilesX * lists.tilesY * lists.slices * CLUSTER_AVERAGE_LIGHTS;
+
+    printf("%u of the %u light indices the engine allocates: %s\n", (uint32_t)lists.lights.size(), capacity,
+        lists.lights.size() <= capacity ? "fits" : "OVERFLOWS");
+}
+
+
+static int BenchClusters(uint32_t width, uint32_t height, uint32_t lights, int frames, unsigned int threads)
+{
+    WorkerPool pool(threads);
+
+    printf("%ux%u in %ux%ux%u clusters, %d frames\n", width, height, (width + CLUSTER_TILE_DIM - 1) / CLUSTER_TILE_DIM,
+        (height + CLUSTER_TILE_DIM - 1) / CLUSTER_TILE_DIM, CLUSTER_SLICES, frames);
+
+    if (lights)
+    {
+        BenchClusterLights(width, height, lights, frames, &pool);
+        return 0;
+    }
+
+    for (lights = 1024; lights <= 16384; lights *= 4)
+    {
+        BenchClusterLights(width, height, lights, frames, &pool);
+    }
+
+    return 0;
+}
+
+
+// Lights as App::InitializeLightParameters scatters them: circling the origin within 100
+// units, up to 20 high. The parameters are left at the origin.
+static void MakeOrbits(uint32_t count, vector<LightOrbit>* orbits, vector<ViewLight>* parameters)
+{
+    uint32_t random = 1337;
+
+    orbits->resize(count);
+    parameters->resize(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        LightOrbit& orbit = (*orbits)[i];
+        ViewLight& light = (*parameters)[i];
+
+        orbit.radius = sqrtf(RandomFloat(&random, 0.0001f, 1.0f)) * 100.0f;
+        orbit.angle = RandomFloat(&random, 0.0f, 2.0f * 3.14159265f);
+        orbit.height = RandomFloat(&random, 0.0f, 20.0f);
+        orbit.animationSpeed = (Random(&random) & 1 ? 1.0f : -1.0f) * RandomFloat(&random, 2.0f, 20.0f) / orbit.radius;
+
+        light.positionView[0] = light.positionView[1] = light.positionView[2] = 0.0f;
+        light.color[0] = RandomFloat(&random, 0.0f, 0.5f);
+        light.color[1] = RandomFloat(&random, 0.0f, 0.5f);
+        light.color[2] = RandomFloat(&random, 0.0f, 0.5f);
+        light.attenuationEnd = RandomFloat(&random, 2.0f, 15.0f);
+        light.attenuationBegin = 0.8f * light.attenuationEnd;
+    }
+}
+
+
+static void MakeLightSystem(vector<LightOrbit> const& orbits, vector<ViewLight> const& parameters, LightSystem* system)
+{
+    system->Resize((uint32_t)orbits.size());
+    for (uint32_t i = 0; i < orbits.size(); i++)
+    {
+        system->SetLight(i, orbits[i], parameters[i].color, parameters[i].attenuationBegin, parameters[i].attenuationEnd);
+    }
+}
+
+
+// The engine's default view, from (100, 5, 5) towards the origin, as D3DXMatrixLookAtLH and
+// D3DXMatrixPerspectiveFovLH make it, with near and far swapped.
+static void MakeCamera(float aspect, Matrix4* view, Matrix4* viewProj)
+{
+    float eye[3] = { 100.0f, 5.0f, 5.0f };
+    float axisZ[3] = { -eye[0], -eye[1], -eye[2] };
+    float axisX[3], axisY[3];
+    float length;
+    int i;
+
+    length = sqrtf(axisZ[0] * axisZ[0] + axisZ[1] * axisZ[1] + axisZ[2] * axisZ[2]);
+    for (i = 0; i < 3; i++)
+    {
+        axisZ[i] /= length;
+    }
+
+    // Up cross z, then z cross x.
+    axisX[0] = axisZ[2];
+    axisX[1] = 0.0f;
+    axisX[2] = -axisZ[0];
+    length = sqrtf(axisX[0] * axisX[0] + axisX[2] * axisX[2]);
+    axisX[0] /= length;
+    axisX[2] /= length;
+    axisY[0] = axisZ[1] * axisX[2] - axisZ[2] * axisX[1];
+    axisY[1] = axisZ[2] * axisX[0] - axisZ[0] * axisX[2];
+    axisY[2] = axisZ[0] * axisX[1] - axisZ[1] * axisX[0];
+
+    MatrixIdentity(view);
+    for (i = 0; i < 3; i++)
+    {
+        view->m[i][0] = axisX[i];
+        view->m[i][1] = axisY[i];
+        view->m[i][2] = axisZ[i];
+    }
+    view->m[3][0] = -(axisX[0] * eye[0] + axisX[1] * eye[1] + axisX[2] * eye[2]);
+    view->m[3][1] = -(axisY[0] * eye[0] + axisY[1] * eye[1] + axisY[2] * eye[2]);
+    view->m[3][2] = -(axisZ[0] * eye[0] + axisZ[1] * eye[1] + axisZ[2] * eye[2]);
+
+    float yScale = 1.0f / tanf(FieldOfView * 0.5f);
+    Matrix4 proj;
+
+    memset(&proj, 0, sizeof(proj));
+    proj.m[0][0] = yScale / aspect;
+    proj.m[1][1] = yScale;
+    proj.m[2][2] = NearZ / (NearZ - FarZ);
+    proj.m[2][3] = 1.0f;
+    proj.m[3][2] = -FarZ * NearZ / (NearZ - FarZ);
+
+    MatrixMultiply(viewProj, *view, proj);
+}
+
+
+// The lights as App kept them before LightSystem: orbits and parameters in arrays of
+// structures, world positions in their own array, transformed into the parameters by
+// D3DXVec3TransformCoordArray, then copied light by light into the mapped buffer.
+struct LegacyLights
+{
+    vector<LightOrbit> orbits;
+    vector<ViewLight> parameters;
+    vector<float> positions;
+
+    void Move(float time)
+    {
+        for (size_t i = 0; i < orbits.size(); i++)
+        {
+            LightOrbit const& orbit = orbits[i];
+            float angle = orbit.angle + time * orbit.animationSpeed;
+
+            positions[i * 3 + 0] = orbit.radius * cosf(angle);
+            positions[i * 3 + 1] = orbit.height;
+            positions[i * 3 + 2] = orbit.radius * sinf(angle);
+        }
+    }
+
+    void Write(Matrix4 const& view, ViewLight* lights)
+    {
+        for (size_t i = 0; i < orbits.size(); i++)
+        {
+            float const* p = &positions[i * 3];
+            float w = p[0] * view.m[0][3] + p[1] * view.m[1][3] + p[2] * view.m[2][3] + view.m[3][3];
+
+            for (int j = 0; j < 3; j++)
+            {
+                parameters[i].positionView[j] = (p[0] * view.m[0][j] + p[1] * view.m[1][j] + p[2] * view.m[2][j] + view.m[3][j]) / w;
+            }
+        }
+        for (size_t i = 0; i < orbits.size(); i++)
+        {
+            lights[i] = parameters[i];
+        }
+    }
+};
+
+
+static void ReportLights(char const* name, double seconds, int frames, uint32_t lightCount, uint32_t written)
+{
+    printf("%-30s %9.3f ms/frame %8.2f ns/light %8u written\n", name, seconds / frames * 1e3,
+        seconds / frames / lightCount * 1e9, written);
+}
+
+
+static void BenchLightCount(uint32_t width, uint32_t height, uint32_t lightCount, int frames)
+{
+    LightSystem system;
+    LegacyLights legacy;
+    vector<ViewLight> mapped(lightCount);
+    Matrix4 view, viewProj;
+    Frustum frustum;
+    uint32_t written = 0;
+    int frame;
+
+    MakeOrbits(lightCount, &legacy.orbits, &legacy.parameters);
+    MakeLightSystem(legacy.orbits, legacy.parameters, &system);
+    legacy.positions.resize(lightCount * 3);
+    MakeCamera((float)width / height, &view, &viewProj);
+    ExtractFrustum(viewProj, &frustum);
+
+    printf("%u lights\n", lightCount);
+
+    double seconds = 0.0;
+
+    for (frame = 0; frame < frames; frame++)
+    {
+        Clock::time_point begin = Clock::now();
+        legacy.Move(frame / 60.0f);
+        legacy.Write(view, &mapped[0]);
+        seconds += Seconds(begin);
+    }
+    ReportLights("structures, then a copy", seconds, frames, lightCount, lightCount);
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        seconds = 0.0;
+        for (frame = 0; frame < frames; frame++)
+        {
+            Clock::time_point begin = Clock::now();
+            system.Move(frame / 60.0f, lightCount);
+            written = system.Write(view, pass ? &frustum : 0, lightCount, &mapped[0]);
+            seconds += Seconds(begin);
+        }
+        ReportLights(pass ? "four at a time, culled" : "four at a time", seconds, frames, lightCount, written);
+    }
+}
+
+
+static int BenchLights(uint32_t width, uint32_t height, uint32_t lights, int frames)
+{
+    printf("Moving and writing lights for a %ux%u view, %d frames\n", width, height, frames);
+
+    if (lights)
+    {
+        BenchLightCount(width, height, lights, frames);
+        return 0;
+    }
+
+    for (lights = 1000; lights <= 100000; lights *= 10)
+    {
+        BenchLightCount(width, height, lights, frames);
+    }
+
+    return 0;
+}
+
+
+static bool SameLists(TileLightLists const& a, TileLightLists const& b)
+{
+    return a.tilesX == b.tilesX && a.tilesY == b.tilesY && a.first == b.first && a.lights == b.lights && a.minZ == b.minZ && a.maxZ == b.maxZ;
+}
+
+
+// Every light whose sphere reaches a sample must be in the sample's tile, or the sample would
+// go unlit. Samples are checked at the pixel's center, as the shader reconstructs them.
+static bool CheckCovered(TileCullSetup const& setup, vector<float> const& depth, vector<ViewLight> const& lights, TileLightLists const& lists)
+{
+    vector<bool> listed(lights.size());
+
+    for (uint32_t y = 0; y < setup.height; y += 3)
+    {
+        for (uint32_t x = 0; x < setup.width; x += 3)
+        {
+            uint32_t tile = (y / setup.tileSize) * lists.tilesX + x / setup.tileSize;
+            uint32_t i;
+
+            fill(listed.begin(), listed.end(), false);
+            for (i = 0; i < lists.Count(tile); i++)
+            {
+                listed[lists.Lights(tile)[i]] = true;
+            }
+
+            for (uint32_t sample = 0; sample < setup.samples; sample++)
+            {
+                float z = setup.projectionW / (depth[((size_t)y * setup.width + x) * setup.samples + sample] - setup.projectionZ);
+                float positionX = ((x + 0.5f) / setup.width * 2.0f - 1.0f) / setup.projectionX * z;
+                float positionY = (1.0f - (y + 0.5f) / setup.height * 2.0f) / setup.projectionY * z;
+
+                if (z < setup.nearZ || z >= setup.farZ)
+                {
+                    continue;
+                }
+
+                for (i = 0; i < lights.size(); i++)
+                {
+                    float dx = lights[i].positionView[0] - positionX;
+                    float dy = lights[i].positionView[1] - positionY;
+                    float dz = lights[i].positionView[2] - z;
+                    float reach = 0.999f * lights[i].attenuationEnd;
+
+                    if (dx * dx + dy * dy + dz * dz < reach * reach && !listed[i])
+                    {
+                        printf("FAILED: light %u reaches pixel %u, %u but is not in its tile\n", i, x, y);
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+
+static bool SameClusterLists(ClusterLightLists const& a, ClusterLightLists const& b)
+{
+    return a.tilesX == b.tilesX && a.tilesY == b.tilesY && a.slices == b.slices && a.first == b.first && a.lights == b.lights;
+}
+
+
+// Every light reaching a point must be in the point's cluster. Clusters don't depend on the
+// depth buffer, so points are taken along the ray through each pixel's center, at depths
+// spread through every slice.
+static bool CheckClustersCovered(ClusterSetup const& setup, vector<ViewLight> const& lights, ClusterLightLists const& lists)
+{
+    static uint32_t const Depths = 48;
+    vector<bool> listed(lights.size());
+
+    for (uint32_t y = 0; y < setup.height; y += 7)
+    {
+        for (uint32_t x = 0; x < setup.width; x += 7)
+        {
+            for (uint32_t d = 0; d < Depths; d++)
+            {
+                float z = NearZ * powf(FarZ / NearZ, (d + 0.5f) / Depths);
+                float positionX = ((x + 0.5f) / setup.width * 2.0f - 1.0f) / setup.projectionX * z;
+                float positionY = (1.0f - (y + 0.5f) / setup.height * 2.0f) / setup.projectionY * z;
+                uint32_t cluster = lists.Cluster(x / setup.tileSize, y / setup.tileSize, lists.Slice(z));
+                uint32_t i;
+
+                fill(listed.begin(), listed.end(), false);
+                for (i = 0; i < lists.Count(cluster); i++)
+                {
+                    listed[lists.Lights(cluster)[i]] = true;
+                }
+
+                for (i = 0; i < lights.size(); i++)
+                {
+                    float dx = lights[i].positionView[0] - positionX;
+                    float dy = lights[i].positionView[1] - positionY;
+                    float dz = lights[i].positionView[2] - z;
+                    float reach = 0.999f * lights[i].attenuationEnd;
+
+                    if (dx * dx + dy * dy + dz * dz < reach * reach && !listed[i])
+                    {
+                        printf("FAILED: light %u reaches pixel %u, %u at depth %g but is not in its cluster\n", i, x, y, z);
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+
+static int CheckClusters(uint32_t width, uint32_t height, uint32_t lightCount)
+{
+    static uint32_t const tileSizes[] = { 16, CLUSTER_TILE_DIM };
+    WorkerPool pool;
+
+    for (int t = 0; t < 2; t++)
+    {
+        ClusterSetup setup;
+        vector<ViewLight> start, lights;
+        ClusterLightLists expected, lists;
+
+        MakeClusterSetup(&setup, width, height);
+        setup.tileSize = tileSizes[t];
+        MakeLights(setup.projectionX, lightCount, &start);
+        lights = start;
+
+        ClusterLightCuller serial;
+        ClusterLightCuller parallel(&pool);
+
+        for (int frame = 0; frame < 3; frame++)
+        {
+            MoveLights(start, frame * 20, &lights);
+            ClusterLightCuller::AssignReference(setup, &lights[0], lightCount, &expected);
+
+            for (int pass = 0; pass < 2; pass++)
+            {
+                (pass ? parallel : serial).Assign(setup, &lights[0], lightCount, &lists);
+
+                if (!SameClusterLists(lists, expected))
+                {
+                    printf("FAILED: %u pixel clusters, frame %d, %s: the lists differ from the reference\n",
+                        tileSizes[t], frame, pass ? "parallel" : "serial");
+                    return 1;
+                }
+            }
+
+            if (!CheckClustersCovered(setup, lights, lists))
+            {
+                printf("FAILED: %u pixel clusters, frame %d\n", tileSizes[t], frame);
+                return 1;
+            }
+        }
+
+        printf("%2u pixel clusters, %u slices: %u lights in %u clusters over 3 frames: ok\n", tileSizes[t], setup.slices,
+            (uint32_t)lists.lights.size(), lists.tilesX * lists.tilesY * lists.slices);
+    }
+
+    return 0;
+}
+
+
+// Checks that the four wide Move lands within tolerance of the C runtime's, that Write writes
+// the same lights as the reference, and that culling keeps every light whose center is in view
+// and drops every light whose sphere is entirely outside it.
+static int CheckLights(uint32_t width, uint32_t height, uint32_t lightCount)
+{
+    static float const times[] = { 0.0f, 1.7f, 60.0f };
+    float projectionY = 1.0f / tanf(FieldOfView * 0.5f);
+    float projectionX = projectionY * height / width;
+    Matrix4 view, viewProj;
+    Frustum frustum;
+
+    MakeCamera((float)width / height, &view, &viewProj);
+    ExtractFrustum(viewProj, &frustum);
+
+    // Counts that aren't a multiple of four check the padding is left out.
+    for (uint32_t count = lightCount; count <= lightCount + 3; count += 3)
+    {
+        vector<LightOrbit> orbits;
+        vector<ViewLight> parameters, all, expected, lights;
+        LightSystem system, reference;
+
+        MakeOrbits(count, &orbits, &parameters);
+        MakeLightSystem(orbits, parameters, &system);
+        MakeLightSystem(orbits, parameters, &reference);
+        all.resize(count);
+        expected.resize(count);
+        lights.resize(count);
+
+        for (int t = 0; t < 3; t++)
+        {
+            float worst = 0.0f;
+            uint32_t i;
+
+            system.Move(times[t], count);
+            reference.MoveReference(times[t], count);
+            for (i = 0; i < count; i++)
+            {
+                worst = max(worst, fabsf(system.X(i) - reference.X(i)));
+                worst = max(worst, fabsf(system.Z(i) - reference.Z(i)));
+            }
+            if (worst > 1e-4f)
+            {
+                printf("FAILED: %u lights at %.1f seconds: moved %g from the reference\n", count, times[t], worst);
+                return 1;
+            }
+
+            for (int pass = 0; pass < 2; pass++)
+            {
+                Frustum const* cull = pass ? &frustum : 0;
+                uint32_t expectedCount = system.WriteReference(view, cull, count, &expected[0]);
+                uint32_t written = system.Write(view, cull, count, &lights[0]);
+
+                if (written != expectedCount || memcmp(&lights[0], &expected[0], written * sizeof(ViewLight)))
+                {
+                    printf("FAILED: %u lights at %.1f seconds, %s: the lights differ from the reference\n", count, times[t],
+                        pass ? "culled" : "not culled");
+                    return 1;
+                }
+            }
+
+            // The culled lights are those of the whole set that are kept, in order.
+            uint32_t written = system.Write(view, &frustum, count, &lights[0]);
+            uint32_t kept = 0;
+
+            system.Write(view, 0, count, &all[0]);
+            for (i = 0; i < count; i++)
+            {
+                ViewLight const& light = all[i];
+                float x = light.positionView[0], y = light.positionView[1], z = light.positionView[2];
+                float radius = light.attenuationEnd;
+                bool isKept = kept < written && !memcmp(&light, &lights[kept], sizeof(ViewLight));
+                bool inView = z >= NearZ && z <= FarZ && fabsf(x) * projectionX <= z && fabsf(y) * projectionY <= z;
+                bool outOfView = z < NearZ - radius || z > FarZ + radius ||
+                    (fabsf(x) * projectionX - z) > radius * sqrtf(projectionX * projectionX + 1.0f) ||
+                    (fabsf(y) * projectionY - z) > radius * sqrtf(projectionY * projectionY + 1.0f);
+
+                if ((inView && !isKept) || (outOfView && isKept))
+                {
+                    printf("FAILED: %u lights at %.1f seconds: light %u at (%g, %g, %g) is wrongly %s\n", count, times[t], i,
+                        x, y, z, isKept ? "kept" : "culled");
+                    return 1;
+                }
+                kept += isKept ? 1 : 0;
+            }
+            if (kept != written)
+            {
+                printf("FAILED: %u lights at %.1f seconds: the culled lights are not a subset of the lights\n", count, times[t]);
+                return 1;
+            }
+
+            printf("%u lights at %4.1f seconds: moved within %g of the reference, %u in view: ok\n", count, times[t], worst, written);
+        }
+    }
+
+    return 0;
+}
+
+
+static int Check(uint32_t width, uint32_t height, uint32_t lightCount)
+{
+    static uint32_t const tileSizes[] = { 8, 16, 32 };
+    static uint32_t const sampleCounts[] = { 1, 4 };
+    WorkerPool pool;
+
+    for (int t = 0; t < 3; t++)
+    {
+        for (int s = 0; s < 2; s++)
+        {
+            TileCullSetup setup;
+            vector<float> depth;
+            vector<ViewLight> start, lights;
+            TileLightLists expected, lists;
+
+            MakeSetup(&setup, width, height, sampleCounts[s], tileSizes[t]);
+            RenderDepth(setup, &depth);
+            MakeLights(setup.projectionX, lightCount, &start);
+            lights = start;
+
+            TileLightCuller serial;
+            TileLightCuller parallel(&pool);
+
+            for (int frame = 0; frame < 3; frame++)
+            {
+                MoveLights(start, frame * 20, &lights);
+                TileLightCuller::CullReference(setup, &depth[0], &lights[0], lightCount, &expected);
+
+                for (int pass = 0; pass < 2; pass++)
+                {
+                    (pass ? parallel : serial).Cull(setup, &depth[0], &lights[0], lightCount, &lists);
+
+                    if (!SameLists(lists, expected))
+                    {
+                        printf("FAILED: %u pixel tiles, %u samples, frame %d, %s: the lists differ from the reference\n",
+                            tileSizes[t], sampleCounts[s], frame, pass ? "parallel" : "serial");
+                        return 1;
+                    }
+                }
+
+                if (!CheckCovered(setup, depth, lights, lists))
+                {
+                    printf("FAILED: %u pixel tiles, %u samples, frame %d\n", tileSizes[t], sampleCounts[s], frame);
+                    return 1;
+                }
+            }
+
+            printf("%2u pixel tiles, %u samples: %u lights in %u tiles over 3 frames: ok\n", tileSizes[t], sampleCounts[s],
+                (uint32_t)lists.lights.size(), lists.tilesX * lists.tilesY);
+        }
+    }
+
+    if (CheckClusters(width, height, lightCount))
+    {
+        return 1;
+    }
+
+    return CheckLights(width, height, lightCount);
+}
+
+
+static int Usage()
+{
+    printf("Usage: lightbench bench|clusters|lights|check [-n frames] [-w width] [-h height] [-s samples] [-l lights] [-t threads]\n");
+
+    return 2;
+}
+
+
+int main(int argc, char* argv[])
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t samples = 1;
+    uint32_t lights = 0;
+    int frames = 20;
+    unsigned int threads = 0;
+    int i;
+
+    if (argc < 2)
+    {
+        return Usage();
+    }
+
+    string command = argv[1];
+
+    for (i = 2; i < argc; i++)
+    {
+        string option = argv[i];
+
+        if (i + 1 >= argc)
+        {
+            return Usage();
+        }
+
+        if (option == "-n")
+        {
+            frames = max(1, atoi(argv[++i]));
+        }
+        else if (option == "-w")
+        {
+            width = (uint32_t)max(1, atoi(argv[++i]));
+        }
+        else if (option == "-h")
+        {
+            height = (uint32_t)max(1, atoi(argv[++i]));
+        }
+        else if (option == "-s")
+        {
+            samples = (uint32_t)max(1, atoi(argv[++i]));
+        }
+        else if (option == "-l")
+        {
+            lights = (uint32_t)max(1, atoi(argv[++i]));
+        }
+        else if (option == "-t")
+        {
+            threads = (unsigned int)max(1, atoi(argv[++i]));
+        }
+        else
+        {
+            return Usage();
+        }
+    }
+
+    if (command == "bench")
+    {
+        width = width ? width : 1920;
+        height = height ? height : 1080;
+        lights = lights ? lights : 1024;
+        return Bench(width, height, samples, lights, frames, threads);
+    }
+
+    if (command == "clusters")
+    {
+        width = width ? width : 1920;
+        height = height ? height : 1080;
+        return BenchClusters(width, height, lights, frames, threads);
+    }
+
+    if (command == "lights")
+    {
+        width = width ? width : 1920;
+        height = height ? height : 1080;
+        return BenchLights(width, height, lights, frames);
+    }
+
+    if (command == "check")
+    {
+        width = width ? width : 1000;
+        height = height ? height : 700;
+        lights = lights ? lights : 256;
+        return Check(width, height, lights);
+    }
+
+    return Usage();
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+
+#ifdef SCENE_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+// Helpers shared by the tile and cluster light cullers.
+
+
+inline uint32_t TileCount(uint32_t pixels, uint32_t tileSize)
+{
+    return (pixels + tileSize - 1) / tileSize;
+}
+
+
+// A side plane of tile i along one axis, from the shader's projection columns: the plane
+// c4 - c or c4 + c, with c = (projection * scale, tileBias), normalized. The other axis and
+// w are 0, so only the in-axis and z parts are kept.
+inline void SidePlane(float projection, uint32_t pixels, uint32_t tileSize, uint32_t tile, float sign, float* plane)
+{
+    float tileScale = (float)pixels / (float)(2 * tileSize);
+    float tileBias = tileScale - (float)tile;
+    float a = sign * projection * tileScale;
+    float c = 1.0f + sign * tileBias;
+    float scale = 1.0f / sqrtf(a * a + c * c);
+
+    plane[0] = a * scale;
+    plane[1] = c * scale;
+}
+
+
+#ifdef SCENE_USE_SSE
+// The lowest lane set in a mask from _mm_movemask_ps.
+inline uint32_t FirstLane(int mask)
+{
+    return mask & 1 ? 0 : mask & 2 ? 1 : mask & 4 ? 2 : 3;
+}
+#endif
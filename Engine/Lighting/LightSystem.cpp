@@ -0,0 +1,264 @@
+#include "LightSystem.h"
+#include "LightCullMath.h"
+
+
+#ifdef SCENE_USE_SSE
+static __m128 Select(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+
+// Sine and cosine of four angles, to within a few ulps for angles of up to a few thousand
+// turns. Whole turns are taken off to leave [-pi, pi], which is folded into [-pi/2, pi/2]
+// for the Taylor series. Only SSE1, as SCENE_USE_SSE promises no more.
+static void SinCos(__m128 angle, __m128* sine, __m128* cosine)
+{
+    __m128 const signMask = _mm_set1_ps(-0.0f);
+    __m128 const pi = _mm_set1_ps(3.14159265f);
+
+    // Adding and taking away 1.5 * 2^23 rounds to the nearest whole number of turns. 2 pi is
+    // in two parts so the first is exact when multiplied.
+    __m128 const rounding = _mm_set1_ps(12582912.0f);
+    __m128 turns = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(angle, _mm_set1_ps(0.159154943f)), rounding), rounding);
+    __m128 x = _mm_sub_ps(angle, _mm_mul_ps(turns, _mm_set1_ps(6.28125f)));
+
+    x = _mm_sub_ps(x, _mm_mul_ps(turns, _mm_set1_ps(0.00193530717958647692f)));
+
+    // sin(pi - x) = sin x and cos(pi - x) = -cos x.
+    __m128 reflect = _mm_cmpgt_ps(_mm_andnot_ps(signMask, x), _mm_set1_ps(1.57079633f));
+
+    x = Select(reflect, _mm_sub_ps(_mm_or_ps(pi, _mm_and_ps(x, signMask)), x), x);
+
+    __m128 x2 = _mm_mul_ps(x, x);
+    __m128 s = _mm_set1_ps(-2.50521084e-8f);
+    __m128 c = _mm_set1_ps(2.08767570e-9f);
+
+    s = _mm_add_ps(_mm_mul_ps(s, x2), _mm_set1_ps(2.75573192e-6f));
+    s = _mm_add_ps(_mm_mul_ps(s, x2), _mm_set1_ps(-1.98412698e-4f));
+    s = _mm_add_ps(_mm_mul_ps(s, x2), _mm_set1_ps(8.33333333e-3f));
+    s = _mm_add_ps(_mm_mul_ps(s, x2), _mm_set1_ps(-1.66666667e-1f));
+    s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, x2), x), x);
+
+    c = _mm_add_ps(_mm_mul_ps(c, x2), _mm_set1_ps(-2.75573192e-7f));
+    c = _mm_add_ps(_mm_mul_ps(c, x2), _mm_set1_ps(2.48015873e-5f));
+    c = _mm_add_ps(_mm_mul_ps(c, x2), _mm_set1_ps(-1.38888889e-3f));
+    c = _mm_add_ps(_mm_mul_ps(c, x2), _mm_set1_ps(4.16666667e-2f));
+    c = _mm_add_ps(_mm_mul_ps(c, x2), _mm_set1_ps(-0.5f));
+    c = _mm_add_ps(_mm_mul_ps(c, x2), _mm_set1_ps(1.0f));
+
+    *sine = s;
+    *cosine = _mm_xor_ps(c, _mm_and_ps(reflect, signMask));
+}
+#endif
+
+
+// Whether a sphere of influence reaches into a frustum, tested as the four wide version does,
+// so both keep the same lights.
+static bool InFrustum(Frustum const& frustum, float x, float y, float z, float radius)
+{
+    for (uint32_t i = 0; i < 6; i++)
+    {
+        float const* plane = frustum.planes[i];
+
+        if (plane[0] * x + plane[1] * y + plane[2] * z + plane[3] < -radius)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+LightSystem::LightSystem()
+    : count(0)
+{
+}
+
+
+void LightSystem::Resize(uint32_t count)
+{
+    uint32_t padded = (count + 3) & ~3u;
+
+    this->count = count;
+
+    // The padding has no radius and no light, so always lands on the origin and is never written.
+    orbitRadius.resize(padded, 0.0f);
+    orbitAngle.resize(padded, 0.0f);
+    orbitHeight.resize(padded, 0.0f);
+    orbitSpeed.resize(padded, 0.0f);
+    colorR.resize(padded, 0.0f);
+    colorG.resize(padded, 0.0f);
+    colorB.resize(padded, 0.0f);
+    attenuationBegin.resize(padded, 0.0f);
+    attenuationEnd.resize(padded, 0.0f);
+    x.resize(padded, 0.0f);
+    z.resize(padded, 0.0f);
+}
+
+
+void LightSystem::SetLight(uint32_t light, LightOrbit const& orbit, float const color[3], float attenuationBegin, float attenuationEnd)
+{
+    orbitRadius[light] = orbit.radius;
+    orbitAngle[light] = orbit.angle;
+    orbitHeight[light] = orbit.height;
+    orbitSpeed[light] = orbit.animationSpeed;
+    colorR[light] = color[0];
+    colorG[light] = color[1];
+    colorB[light] = color[2];
+    this->attenuationBegin[light] = attenuationBegin;
+    this->attenuationEnd[light] = attenuationEnd;
+    x[light] = orbit.radius * cosf(orbit.angle);
+    z[light] = orbit.radius * sinf(orbit.angle);
+}
+
+
+void LightSystem::Move(float time, uint32_t count)
+{
+#ifdef SCENE_USE_SSE
+    __m128 t = _mm_set1_ps(time);
+
+    for (uint32_t i = 0; i < count; i += 4)
+    {
+        __m128 radius = _mm_load_ps(&orbitRadius[i]);
+        __m128 angle = _mm_add_ps(_mm_load_ps(&orbitAngle[i]), _mm_mul_ps(t, _mm_load_ps(&orbitSpeed[i])));
+        __m128 sine, cosine;
+
+        SinCos(angle, &sine, &cosine);
+        _mm_store_ps(&x[i], _mm_mul_ps(radius, cosine));
+        _mm_store_ps(&z[i], _mm_mul_ps(radius, sine));
+    }
+#else
+    MoveReference(time, count);
+#endif
+}
+
+
+uint32_t LightSystem::Write(Matrix4 const& view, Frustum const* frustum, uint32_t count, ViewLight* lights) const
+{
+#ifdef SCENE_USE_SSE
+    __m128 planes[6][4];
+    __m128 rows[4][3];
+    uint32_t written = 0;
+    uint32_t i, j;
+
+    if (frustum)
+    {
+        for (i = 0; i < 6; i++)
+        {
+            for (j = 0; j < 4; j++)
+            {
+                planes[i][j] = _mm_set1_ps(frustum->planes[i][j]);
+            }
+        }
+    }
+    for (i = 0; i < 4; i++)
+    {
+        for (j = 0; j < 3; j++)
+        {
+            rows[i][j] = _mm_set1_ps(view.m[i][j]);
+        }
+    }
+
+    for (i = 0; i < count; i += 4)
+    {
+        __m128 wx = _mm_load_ps(&x[i]);
+        __m128 wy = _mm_load_ps(&orbitHeight[i]);
+        __m128 wz = _mm_load_ps(&z[i]);
+        __m128 end = _mm_load_ps(&attenuationEnd[i]);
+
+        // Leave out the padding.
+        int mask = count - i >= 4 ? 15 : (1 << (count - i)) - 1;
+
+        if (frustum)
+        {
+            __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), end);
+            __m128 inside = _mm_cmpeq_ps(end, end);
+
+            for (j = 0; j < 6; j++)
+            {
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(planes[j][0], wx), _mm_mul_ps(planes[j][1], wy)),
+                    _mm_mul_ps(planes[j][2], wz)), planes[j][3]);
+
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+            }
+            mask &= _mm_movemask_ps(inside);
+            if (!mask)
+            {
+                continue;
+            }
+        }
+
+        // Into view space, then around to one register per light for each half of ViewLight.
+        __m128 position[4], color[4];
+
+        for (j = 0; j < 3; j++)
+        {
+            position[j] = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(wx, rows[0][j]), _mm_mul_ps(wy, rows[1][j])),
+                _mm_mul_ps(wz, rows[2][j])), rows[3][j]);
+        }
+        position[3] = _mm_load_ps(&attenuationBegin[i]);
+        color[0] = _mm_load_ps(&colorR[i]);
+        color[1] = _mm_load_ps(&colorG[i]);
+        color[2] = _mm_load_ps(&colorB[i]);
+        color[3] = end;
+        _MM_TRANSPOSE4_PS(position[0], position[1], position[2], position[3]);
+        _MM_TRANSPOSE4_PS(color[0], color[1], color[2], color[3]);
+
+        // Written in order, whole lights at a time, as suits write combined memory.
+        while (mask)
+        {
+            uint32_t lane = FirstLane(mask);
+            float* light = lights[written++].positionView;
+
+            _mm_storeu_ps(light, position[lane]);
+            _mm_storeu_ps(light + 4, color[lane]);
+            mask &= mask - 1;
+        }
+    }
+    return written;
+#else
+    return WriteReference(view, frustum, count, lights);
+#endif
+}
+
+
+void LightSystem::MoveReference(float time, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        float angle = orbitAngle[i] + time * orbitSpeed[i];
+
+        x[i] = orbitRadius[i] * cosf(angle);
+        z[i] = orbitRadius[i] * sinf(angle);
+    }
+}
+
+
+uint32_t LightSystem::WriteReference(Matrix4 const& view, Frustum const* frustum, uint32_t count, ViewLight* lights) const
+{
+    uint32_t written = 0;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        float wx = x[i], wy = orbitHeight[i], wz = z[i];
+
+        if (frustum && !InFrustum(*frustum, wx, wy, wz, attenuationEnd[i]))
+        {
+            continue;
+        }
+
+        ViewLight& light = lights[written++];
+
+        for (uint32_t j = 0; j < 3; j++)
+        {
+            light.positionView[j] = wx * view.m[0][j] + wy * view.m[1][j] + wz * view.m[2][j] + view.m[3][j];
+        }
+        light.attenuationBegin = attenuationBegin[i];
+        light.color[0] = colorR[i];
+        light.color[1] = colorG[i];
+        light.color[2] = colorB[i];
+        light.attenuationEnd = attenuationEnd[i];
+    }
+    return written;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "../Scene/SceneCuller.h"
+#include "../Scene/SceneMath.h"
+#include "../Scene/SceneStore.h"
+#include "TileLightCuller.h"
+
+using namespace std;
+
+
+// How a light moves: it circles the y axis at a fixed radius and height.
+struct LightOrbit
+{
+    float radius;
+    float angle;                // At time 0.
+    float height;
+    float animationSpeed;       // Radians a second.
+};
+
+
+// The engine's point lights, kept as an array of each component. Move animates them four at
+// a time, and Write transforms them into view space and writes them out as ViewLight,
+// straight into a mapped light buffer, leaving out those outside the view frustum if asked.
+class LightSystem
+{
+public:
+    LightSystem();
+
+    void Resize(uint32_t count);
+    uint32_t Count() const { return count; }
+
+    void SetLight(uint32_t light, LightOrbit const& orbit, float const color[3], float attenuationBegin, float attenuationEnd);
+
+    // Moves the first count lights, up to Count(), to where they are time seconds in.
+    void Move(float time, uint32_t count);
+
+    // Writes the first count lights to lights, in view space. With a frustum, only the lights
+    // whose spheres of influence reach into it are written. Returns how many were written.
+    uint32_t Write(Matrix4 const& view, Frustum const* frustum, uint32_t count, ViewLight* lights) const;
+
+    // Move and Write one light at a time with the C runtime's sine and cosine, to check the
+    // others against. Write writes the same lights, and Move moves them to within a millionth
+    // or so of the orbit's radius.
+    void MoveReference(float time, uint32_t count);
+    uint32_t WriteReference(Matrix4 const& view, Frustum const* frustum, uint32_t count, ViewLight* lights) const;
+
+    // World space position of a light, as of the last Move.
+    float X(uint32_t light) const { return x[light]; }
+    float Y(uint32_t light) const { return orbitHeight[light]; }
+    float Z(uint32_t light) const { return z[light]; }
+
+private:
+    typedef SceneStore::FloatArray FloatArray;
+
+    uint32_t count;
+
+    // Padded to a multiple of four.
+    FloatArray orbitRadius, orbitAngle, orbitHeight, orbitSpeed;
+    FloatArray colorR, colorG, colorB, attenuationBegin, attenuationEnd;
+
+    // World space x and z; y is the orbit's height.
+    FloatArray x, z;
+};
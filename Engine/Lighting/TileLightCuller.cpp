@@ -0,0 +1,408 @@
+#include "TileLightCuller.h"
+#include "LightCullMath.h"
+
+#include <algorithm>
+#include <float.h>
+
+
+// Padding lights sit far behind the camera, so the near plane of every tile culls them.
+static float const PaddingZ = -1e30f;
+
+
+// Depth buffer values back into view space z, as the shader's gbuffer read does.
+static float ViewZ(TileCullSetup const& setup, float depth)
+{
+    return setup.projectionW / (depth - setup.projectionZ);
+}
+
+
+TileLightCuller::TileLightCuller(WorkerPool* pool)
+    : pool(pool), lightCount(0)
+{
+}
+
+
+void TileLightCuller::Cull(TileCullSetup const& setup, float const* depth, ViewLight const* lights, uint32_t lightCount, TileLightLists* result)
+{
+    uint32_t tilesX = TileCount(setup.width, setup.tileSize);
+    uint32_t tilesY = TileCount(setup.height, setup.tileSize);
+    uint32_t padded = (lightCount + 3) & ~3u;
+    uint32_t i;
+
+    this->lightCount = lightCount;
+
+    // Gather the lights into arrays of each component, to test four at once.
+    lightX.resize(padded);
+    lightY.resize(padded);
+    lightZ.resize(padded);
+    lightNegativeRadius.resize(padded);
+
+    for (i = 0; i < padded; i++)
+    {
+        bool isLight = i < lightCount;
+
+        lightX[i] = isLight ? lights[i].positionView[0] : 0.0f;
+        lightY[i] = isLight ? lights[i].positionView[1] : 0.0f;
+        lightZ[i] = isLight ? lights[i].positionView[2] : PaddingZ;
+        lightNegativeRadius[i] = isLight ? -lights[i].attenuationEnd : 0.0f;
+    }
+
+    // The side planes of each column of tiles are the same for every row.
+    columnPlanes.resize(tilesX * 4);
+    for (i = 0; i < tilesX; i++)
+    {
+        SidePlane(setup.projectionX, setup.width, setup.tileSize, i, -1.0f, &columnPlanes[i * 4]);
+        SidePlane(setup.projectionX, setup.width, setup.tileSize, i, 1.0f, &columnPlanes[i * 4 + 2]);
+    }
+
+    result->tilesX = tilesX;
+    result->tilesY = tilesY;
+    result->first.resize(tilesX * tilesY + 1);
+    result->minZ.resize(tilesX * tilesY);
+    result->maxZ.resize(tilesX * tilesY);
+
+    if (rows.size() < tilesY)
+    {
+        rows.resize(tilesY);
+    }
+
+    RunTasks(tilesY, [&](uint32_t row)
+    {
+        CullRow(setup, depth, row, result);
+    });
+
+    // Join the rows' lists, in order.
+    uint32_t total = 0;
+
+    for (uint32_t row = 0; row < tilesY; row++)
+    {
+        total += (uint32_t)rows[row].found.size();
+    }
+    result->lights.resize(total);
+
+    uint32_t next = 0;
+
+    for (uint32_t row = 0; row < tilesY; row++)
+    {
+        RowScratch const& scratch = rows[row];
+
+        if (!scratch.found.empty())
+        {
+            copy(scratch.found.begin(), scratch.found.end(), result->lights.begin() + next);
+        }
+        for (i = 0; i < tilesX; i++)
+        {
+            result->first[row * tilesX + i] = next;
+            next += scratch.counts[i];
+        }
+    }
+    result->first[tilesX * tilesY] = next;
+}
+
+
+void TileLightCuller::RunTasks(uint32_t taskCount, function<void(uint32_t)> const& task)
+{
+    if (pool)
+    {
+        pool->Run(taskCount, task);
+        return;
+    }
+
+    for (uint32_t i = 0; i < taskCount; i++)
+    {
+        task(i);
+    }
+}
+
+
+void TileLightCuller::CullRow(TileCullSetup const& setup, float const* depth, uint32_t row, TileLightLists* result)
+{
+    RowScratch& scratch = rows[row];
+    uint32_t tilesX = result->tilesX;
+    uint32_t top = row * setup.tileSize;
+    uint32_t bottom = min(top + setup.tileSize, setup.height);
+    float rowPlanes[4];
+    uint32_t i;
+
+    // The shader's y runs up the screen, so its c2 has the projection negated.
+    SidePlane(-setup.projectionY, setup.height, setup.tileSize, row, -1.0f, &rowPlanes[0]);
+    SidePlane(-setup.projectionY, setup.height, setup.tileSize, row, 1.0f, &rowPlanes[2]);
+
+    scratch.x.clear();
+    scratch.y.clear();
+    scratch.z.clear();
+    scratch.negativeRadius.clear();
+    scratch.index.clear();
+    scratch.found.clear();
+    scratch.counts.assign(tilesX, 0);
+
+    // Keep the lights in front of the row's top and bottom planes.
+#ifdef SCENE_USE_SSE
+    __m128 topY = _mm_set1_ps(rowPlanes[0]), topZ = _mm_set1_ps(rowPlanes[1]);
+    __m128 bottomY = _mm_set1_ps(rowPlanes[2]), bottomZ = _mm_set1_ps(rowPlanes[3]);
+
+    for (i = 0; i < lightX.size(); i += 4)
+    {
+        __m128 y = _mm_load_ps(&lightY[i]);
+        __m128 z = _mm_load_ps(&lightZ[i]);
+        __m128 negativeRadius = _mm_load_ps(&lightNegativeRadius[i]);
+        __m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(topY, y), _mm_mul_ps(topZ, z)), negativeRadius);
+
+        inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(bottomY, y), _mm_mul_ps(bottomZ, z)), negativeRadius));
+
+        // Leave out the padding.
+        int mask = _mm_movemask_ps(inside) & (lightCount - i >= 4 ? 15 : (1 << (lightCount - i)) - 1);
+
+        while (mask)
+        {
+            uint32_t light = i + FirstLane(mask);
+
+            scratch.x.push_back(lightX[light]);
+            scratch.y.push_back(lightY[light]);
+            scratch.z.push_back(lightZ[light]);
+            scratch.negativeRadius.push_back(lightNegativeRadius[light]);
+            scratch.index.push_back(light);
+            mask &= mask - 1;
+        }
+    }
+#else
+    for (i = 0; i < lightCount; i++)
+    {
+        if (rowPlanes[0] * lightY[i] + rowPlanes[1] * lightZ[i] >= lightNegativeRadius[i] &&
+            rowPlanes[2] * lightY[i] + rowPlanes[3] * lightZ[i] >= lightNegativeRadius[i])
+        {
+            scratch.x.push_back(lightX[i]);
+            scratch.y.push_back(lightY[i]);
+            scratch.z.push_back(lightZ[i]);
+            scratch.negativeRadius.push_back(lightNegativeRadius[i]);
+            scratch.index.push_back(i);
+        }
+    }
+#endif
+
+    uint32_t rowLights = (uint32_t)scratch.index.size();
+
+    while (scratch.x.size() & 3)
+    {
+        scratch.x.push_back(0.0f);
+        scratch.y.push_back(0.0f);
+        scratch.z.push_back(PaddingZ);
+        scratch.negativeRadius.push_back(0.0f);
+    }
+
+    for (uint32_t column = 0; column < tilesX; column++)
+    {
+        uint32_t tile = row * tilesX + column;
+        uint32_t begin = column * setup.tileSize * setup.samples;
+        uint32_t end = min(column * setup.tileSize + setup.tileSize, setup.width) * setup.samples;
+        float minZ = FLT_MAX, maxZ = -FLT_MAX;
+
+        // The depth range of the tile's samples, leaving out the background.
+#ifdef SCENE_USE_SSE
+        __m128 minimum = _mm_set1_ps(FLT_MAX), maximum = _mm_set1_ps(-FLT_MAX);
+        __m128 projectionZ = _mm_set1_ps(setup.projectionZ), projectionW = _mm_set1_ps(setup.projectionW);
+        __m128 nearZ = _mm_set1_ps(setup.nearZ), farZ = _mm_set1_ps(setup.farZ);
+#endif
+
+        for (uint32_t y = top; y < bottom; y++)
+        {
+            float const* line = depth + (size_t)y * setup.width * setup.samples;
+            uint32_t x = begin;
+
+#ifdef SCENE_USE_SSE
+            for (; x + 4 <= end; x += 4)
+            {
+                __m128 z = _mm_div_ps(projectionW, _mm_sub_ps(_mm_loadu_ps(line + x), projectionZ));
+                __m128 valid = _mm_and_ps(_mm_cmpge_ps(z, nearZ), _mm_cmplt_ps(z, farZ));
+
+                minimum = _mm_min_ps(minimum, _mm_or_ps(_mm_and_ps(valid, z), _mm_andnot_ps(valid, _mm_set1_ps(FLT_MAX))));
+                maximum = _mm_max_ps(maximum, _mm_or_ps(_mm_and_ps(valid, z), _mm_andnot_ps(valid, _mm_set1_ps(-FLT_MAX))));
+            }
+#endif
+            for (; x < end; x++)
+            {
+                float z = ViewZ(setup, line[x]);
+
+                if (z >= setup.nearZ && z < setup.farZ)
+                {
+                    minZ = min(minZ, z);
+                    maxZ = max(maxZ, z);
+                }
+            }
+        }
+
+#ifdef SCENE_USE_SSE
+        SCENE_ALIGN16 float lanes[2][4];
+
+        _mm_store_ps(lanes[0], minimum);
+        _mm_store_ps(lanes[1], maximum);
+        for (i = 0; i < 4; i++)
+        {
+            minZ = min(minZ, lanes[0][i]);
+            maxZ = max(maxZ, lanes[1][i]);
+        }
+#endif
+
+        result->minZ[tile] = minZ;
+        result->maxZ[tile] = maxZ;
+
+        if (minZ > maxZ)
+        {
+            continue;
+        }
+
+        float const* planes = &columnPlanes[column * 4];
+        uint32_t count = 0;
+
+#ifdef SCENE_USE_SSE
+        __m128 leftX = _mm_set1_ps(planes[0]), leftZ = _mm_set1_ps(planes[1]);
+        __m128 rightX = _mm_set1_ps(planes[2]), rightZ = _mm_set1_ps(planes[3]);
+        __m128 tileMinZ = _mm_set1_ps(minZ), tileMaxZ = _mm_set1_ps(maxZ);
+
+        for (i = 0; i < rowLights; i += 4)
+        {
+            __m128 x = _mm_load_ps(&scratch.x[i]);
+            __m128 z = _mm_load_ps(&scratch.z[i]);
+            __m128 negativeRadius = _mm_load_ps(&scratch.negativeRadius[i]);
+            __m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(leftX, x), _mm_mul_ps(leftZ, z)), negativeRadius);
+
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(rightX, x), _mm_mul_ps(rightZ, z)), negativeRadius));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_sub_ps(z, tileMinZ), negativeRadius));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_sub_ps(tileMaxZ, z), negativeRadius));
+
+            int mask = _mm_movemask_ps(inside);
+
+            while (mask)
+            {
+                scratch.found.push_back(scratch.index[i + FirstLane(mask)]);
+                count++;
+                mask &= mask - 1;
+            }
+        }
+#else
+        for (i = 0; i < rowLights; i++)
+        {
+            float x = scratch.x[i], z = scratch.z[i], negativeRadius = scratch.negativeRadius[i];
+
+            if (planes[0] * x + planes[1] * z >= negativeRadius && planes[2] * x + planes[3] * z >= negativeRadius &&
+                z - minZ >= negativeRadius && maxZ - z >= negativeRadius)
+            {
+                scratch.found.push_back(scratch.index[i]);
+                count++;
+            }
+        }
+#endif
+
+        scratch.counts[column] = count;
+    }
+}
+
+
+void TileLightCuller::CullReference(TileCullSetup const& setup, float const* depth, ViewLight const* lights, uint32_t lightCount, TileLightLists* result)
+{
+    uint32_t tilesX = TileCount(setup.width, setup.tileSize);
+    uint32_t tilesY = TileCount(setup.height, setup.tileSize);
+
+    result->tilesX = tilesX;
+    result->tilesY = tilesY;
+    result->first.clear();
+    result->lights.clear();
+    result->minZ.clear();
+    result->maxZ.clear();
+
+    for (uint32_t groupY = 0; groupY < tilesY; groupY++)
+    {
+        for (uint32_t groupX = 0; groupX < tilesX; groupX++)
+        {
+            float minTileZ = FLT_MAX, maxTileZ = -FLT_MAX;
+
+            result->first.push_back((uint32_t)result->lights.size());
+
+            // Work out Z bounds for the tile's samples, leaving out the background.
+            for (uint32_t y = groupY * setup.tileSize; y < (groupY + 1) * setup.tileSize && y < setup.height; y++)
+            {
+                for (uint32_t x = groupX * setup.tileSize; x < (groupX + 1) * setup.tileSize && x < setup.width; x++)
+                {
+                    for (uint32_t sample = 0; sample < setup.samples; sample++)
+                    {
+                        float viewSpaceZ = ViewZ(setup, depth[((size_t)y * setup.width + x) * setup.samples + sample]);
+
+                        if (viewSpaceZ >= setup.nearZ && viewSpaceZ < setup.farZ)
+                        {
+                            minTileZ = min(minTileZ, viewSpaceZ);
+                            maxTileZ = max(maxTileZ, viewSpaceZ);
+                        }
+                    }
+                }
+            }
+
+            result->minZ.push_back(minTileZ);
+            result->maxZ.push_back(maxTileZ);
+
+            if (minTileZ > maxTileZ)
+            {
+                continue;
+            }
+
+            // The tile's frustum, from the relevant columns of its projection.
+            float tileScaleX = (float)setup.width / (float)(2 * setup.tileSize);
+            float tileScaleY = (float)setup.height / (float)(2 * setup.tileSize);
+            float tileBiasX = tileScaleX - (float)groupX;
+            float tileBiasY = tileScaleY - (float)groupY;
+            float c1[4] = { setup.projectionX * tileScaleX, 0.0f, tileBiasX, 0.0f };
+            float c2[4] = { 0.0f, -setup.projectionY * tileScaleY, tileBiasY, 0.0f };
+            float c4[4] = { 0.0f, 0.0f, 1.0f, 0.0f };
+            float frustumPlanes[6][4];
+            int i, j;
+
+            for (j = 0; j < 4; j++)
+            {
+                frustumPlanes[0][j] = c4[j] - c1[j];
+                frustumPlanes[1][j] = c4[j] + c1[j];
+                frustumPlanes[2][j] = c4[j] - c2[j];
+                frustumPlanes[3][j] = c4[j] + c2[j];
+            }
+            frustumPlanes[4][0] = 0.0f;
+            frustumPlanes[4][1] = 0.0f;
+            frustumPlanes[4][2] = 1.0f;
+            frustumPlanes[4][3] = -minTileZ;
+            frustumPlanes[5][0] = 0.0f;
+            frustumPlanes[5][1] = 0.0f;
+            frustumPlanes[5][2] = -1.0f;
+            frustumPlanes[5][3] = maxTileZ;
+
+            for (i = 0; i < 4; i++)
+            {
+                float* plane = frustumPlanes[i];
+                float scale = 1.0f / sqrtf(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+
+                for (j = 0; j < 4; j++)
+                {
+                    plane[j] *= scale;
+                }
+            }
+
+            // Point light sphere against the tile frustum.
+            for (uint32_t lightIndex = 0; lightIndex < lightCount; lightIndex++)
+            {
+                ViewLight const& light = lights[lightIndex];
+                bool inFrustum = true;
+
+                for (i = 0; i < 6; i++)
+                {
+                    float d = frustumPlanes[i][0] * light.positionView[0] + frustumPlanes[i][1] * light.positionView[1] +
+                        frustumPlanes[i][2] * light.positionView[2] + frustumPlanes[i][3];
+
+                    inFrustum = inFrustum && d >= -light.attenuationEnd;
+                }
+
+                if (inFrustum)
+                {
+                    result->lights.push_back(lightIndex);
+                }
+            }
+        }
+    }
+
+    result->first.push_back((uint32_t)result->lights.size());
+}
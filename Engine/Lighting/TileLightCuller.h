@@ -0,0 +1,102 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "../Scene/SceneMath.h"
+#include "../Scene/SceneStore.h"
+#include "../Scene/WorkerPool.h"
+
+using namespace std;
+
+
+// A point light in view space.
+// NOTE: Must match PointLight in App.h and Rendering.hlsl, so the engine's lights can be passed as they are.
+struct ViewLight
+{
+    float positionView[3];
+    float attenuationBegin;
+    float color[3];
+    float attenuationEnd;
+};
+
+
+// What the tiled lighting pass is given besides the depth buffer and the lights.
+struct TileCullSetup
+{
+    uint32_t width;             // Of the depth buffer, in pixels.
+    uint32_t height;
+    uint32_t samples;           // Depth values per pixel, stored one after another.
+    uint32_t tileSize;          // Pixels along each side of a tile, as COMPUTE_SHADER_TILE_GROUP_DIM.
+
+    // The projection's _11, _22, _33 and _43. The last two turn depth buffer values back into view space z.
+    float projectionX;
+    float projectionY;
+    float projectionZ;
+    float projectionW;
+
+    // Samples with view space z outside [nearZ, farZ) are background, and light nothing.
+    float nearZ;
+    float farZ;
+};
+
+
+// The lights touching each tile, tiles in rows from the top left.
+struct TileLightLists
+{
+    uint32_t tilesX;
+    uint32_t tilesY;
+    vector<uint32_t> first;     // Where each tile's lights start, with the end of the last tile after them.
+    vector<uint32_t> lights;    // Indices into the lights, ascending within each tile.
+    vector<float> minZ;         // View space depth range of each tile's samples. Tiles of nothing but
+    vector<float> maxZ;         // background have minZ above maxZ, and no lights.
+
+    uint32_t Count(uint32_t tile) const { return first[tile + 1] - first[tile]; }
+    uint32_t const* Lights(uint32_t tile) const { return lights.empty() ? 0 : &lights[first[tile]]; }
+};
+
+
+// Bins point lights into screen tiles the way ComputeShaderTile.hlsl does: each tile's frustum
+// is closed off at the depth range of its samples, and a light is kept if its sphere of
+// influence is not entirely behind any of the six planes. This runs on the CPU, headless, as
+// a check on the shader and for measuring tile sizes. Lights are tested four at a time:
+// first against the top and bottom planes shared by a row of tiles, then the survivors
+// against each tile's other four. Rows of tiles are split across a WorkerPool, if one is given.
+class TileLightCuller
+{
+public:
+    explicit TileLightCuller(WorkerPool* pool = 0);
+
+    // depth holds setup.samples depth buffer values for each pixel, in rows from the top left.
+    void Cull(TileCullSetup const& setup, float const* depth, ViewLight const* lights, uint32_t lightCount, TileLightLists* result);
+
+    // The shader's loop written out one tile and one light at a time, as plainly as possible,
+    // to check Cull against. The lists come out the same.
+    static void CullReference(TileCullSetup const& setup, float const* depth, ViewLight const* lights, uint32_t lightCount, TileLightLists* result);
+
+private:
+    typedef SceneStore::FloatArray FloatArray;
+
+    // The lights left in one row of tiles, and the indices of those found in each tile.
+    struct RowScratch
+    {
+        FloatArray x, y, z, negativeRadius;
+        vector<uint32_t> index;
+        vector<uint32_t> found;
+        vector<uint32_t> counts;
+    };
+
+    void RunTasks(uint32_t taskCount, function<void(uint32_t)> const& task);
+    void CullRow(TileCullSetup const& setup, float const* depth, uint32_t row, TileLightLists* result);
+
+    WorkerPool* pool;
+
+    // The lights, padded to a multiple of four with lights that touch nothing.
+    FloatArray lightX, lightY, lightZ, lightNegativeRadius;
+    uint32_t lightCount;
+
+    // The left and right planes of each column of tiles, as x and z: their y and w are 0.
+    vector<float> columnPlanes;
+
+    vector<RowScratch> rows;
+};
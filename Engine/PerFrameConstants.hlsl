@@ -32,6 +32,9 @@ cbuffer PerFrameConstants : register(b0)
     float4x4 mCameraProj;
     float4 mCameraNearFar;
     uint4 mFramebufferDimensions;
+    uint4 mClusterDimensions;       // Tiles across, tiles down, slices
+    float4 mClusterSliceParams;     // Slice of view space z is log2(z) * x + y
+    uint mLightCount;               // Lights in gLight this frame
     
     UIConstants mUI;
 };
@@ -0,0 +1,34 @@
+#include "PhysXDispatcher.h"
+
+
+PhysXDispatcher::PhysXDispatcher(unsigned int workerCount)
+	: scheduler(RunTask, this, workerCount)
+{
+}
+
+
+PhysXDispatcher::~PhysXDispatcher(void)
+{
+}
+
+
+void PhysXDispatcher::submitTask(physx::pxtask::BaseTask& task)
+{
+	scheduler.Submit(&task);
+}
+
+
+physx::PxU32 PhysXDispatcher::getWorkerCount() const
+{
+	return scheduler.WorkerCount();
+}
+
+
+void PhysXDispatcher::RunTask(void* task, void* context)
+{
+	physx::pxtask::BaseTask* baseTask = (physx::pxtask::BaseTask*)task;
+
+	//As the default dispatcher does: the task is done with once it has run
+	baseTask->runProfiled();
+	baseTask->release();
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#ifndef PHYSXDISPATCHER_4182013504
+#define PHYSXDISPATCHER_4182013504
+
+#include <PxPhysicsAPI.h>
+#include "Physics/TaskScheduler.h"
+
+//Runs PhysX's tasks in place of PxDefaultCpuDispatcher, whose workers all share one job list
+//and are all woken for every job. Here each worker keeps the tasks it spawns on its own deque
+//and steals from the others when it runs out, and a submit wakes at most one sleeping worker
+class PhysXDispatcher : public physx::pxtask::CpuDispatcher
+{
+public:
+	//With no worker count, one for every core but the one that renders
+	PhysXDispatcher(unsigned int workerCount = 0);
+	virtual ~PhysXDispatcher(void);
+
+	virtual void submitTask(physx::pxtask::BaseTask& task);
+	virtual physx::PxU32 getWorkerCount() const;
+
+private:
+	static void RunTask(void* task, void* context);
+
+	TaskScheduler scheduler;
+};
+
+#endif
@@ -3,14 +3,14 @@
 
 PhysXObject::PhysXObject()
 {
-	this->id = -1;
-	this->x = 0;
-	this->y = 0;
-	this->z = 0;
+	this->id = SceneHandle();
 	this->sx = 1;
 	this->sy = 1;
 	this->sz = 1;
 	this->actor = NULL;
+	this->previousPose = physx::PxTransform::createIdentity();
+	this->currentPose = physx::PxTransform::createIdentity();
+	this->lastActiveStep = 0;
 }
 
 
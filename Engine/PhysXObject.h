@@ -4,14 +4,19 @@
 #define PHYSXOBJECT_4182013503
 
 #include <PxPhysicsAPI.h>
+#include "Scene/SceneStore.h"
 
 class PhysXObject
 {
 public:
-	int id;
-	int x,y,z;
+	SceneHandle id;
 	float sx,sy,sz;
 	physx::PxRigidActor* actor;
+	//The last two physics states, which rendering interpolates between
+	physx::PxTransform previousPose;
+	physx::PxTransform currentPose;
+	//The last step the object moved in
+	unsigned int lastActiveStep;
 public:
 	PhysXObject();
 	~PhysXObject(void);
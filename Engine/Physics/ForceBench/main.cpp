@@ -0,0 +1,588 @@
+// Command line benchmark for the custom gravity of EnginePhysics, with no dependency on PhysX
+// or Windows, so it can run on a headless build machine.
+//
+// Usage:
+//   forcebench bench [-n frames] [-b bodies] [-t threads]
+//       Times working out every body's acceleration in each of the engine's gravity modes, for
+//       100, 10000 and 100000 bodies (or just -b): as EnginePhysics used to, asking each body
+//       for its pose and adding each force with a call apiece, then with ForceField one body at
+//       a time, four at a time, and four at a time on every core. The old planet gravity
+//       visited every body from every body, so it is only timed up to 10000.
+//   forcebench check [-b bodies] [-t threads]
+//       Compares ForceField against its reference in every mode, on one thread and on every
+//       core, and checks what each mode should do: orbits push at right angles to the way to
+//       the source, pulls have the source's strength, and a body at a source is left alone.
+//       Exits with 1 on failure.
+//
+// The default is 20 frames and a thread per core. Checking defaults to 10003 bodies, enough
+// for several tasks with some left over.
+
+#include "../ForceField.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+
+// As EnginePhysics.
+static float const PlanetHeight = 100.0f;
+static float const StrongGravity = 200.0f;
+static float const WeakGravity = 100.0f;
+static float const InverseSquareGravity = 20000.0f;
+static float const OrbitPower = 40.0f;
+static float const Planets[3][3] = { { 0.0f, 0.0f, 0.0f }, { 20.0f, 20.0f, 20.0f }, { -20.0f, -20.0f, -20.0f } };
+
+
+enum Mode
+{
+    PullSingle,
+    PullDouble,
+    PullTriple,
+    PullPush,
+    PushPull,
+    PlanetGravity,
+    Orbits,
+    ModeCount,
+};
+
+
+static char const* const ModeNames[ModeCount] =
+{
+    "pull single", "pull double", "pull triple", "pull push", "push pull", "planet gravity", "orbits",
+};
+
+
+// Small deterministic generator, so runs are repeatable.
+static uint32_t Random(uint32_t* state)
+{
+    *state = *state * 1664525 + 1013904223;
+
+    return *state >> 8;
+}
+
+
+static float RandomFloat(uint32_t* state, float low, float high)
+{
+    return low + (Random(state) & 0xFFFF) * ((high - low) / 65535.0f);
+}
+
+
+static double Seconds(Clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::duration<double>>(Clock::now() - start).count();
+}
+
+
+static ForceSource Source(ForceSourceType type, int planet, float strength)
+{
+    ForceSource source;
+
+    source.type = type;
+    source.x = Planets[planet][0];
+    source.y = Planets[planet][1];
+    source.z = Planets[planet][2];
+    source.strength = strength;
+    source.axisX = source.axisY = source.axisZ = 0.0f;
+
+    return source;
+}
+
+
+// The sources EnginePhysics gives each mode. Orbits push along the random axis picked for the step.
+static void AddSources(Mode mode, float const axis[3], ForceField* field)
+{
+    field->ClearSources();
+
+    switch (mode)
+    {
+    case PullSingle:
+        field->AddSource(Source(ForceAttract, 0, StrongGravity));
+        break;
+
+    case PullDouble:
+        field->AddSource(Source(ForceAttract, 1, StrongGravity));
+        field->AddSource(Source(ForceAttract, 2, StrongGravity));
+        break;
+
+    case PullTriple:
+        field->AddSource(Source(ForceAttract, 0, StrongGravity));
+        field->AddSource(Source(ForceAttract, 2, StrongGravity));
+        field->AddSource(Source(ForceAttract, 1, StrongGravity));
+        break;
+
+    case PullPush:
+        field->AddSource(Source(ForceAttract, 0, StrongGravity));
+        field->AddSource(Source(ForceAttract, 2, -WeakGravity));
+        break;
+
+    case PushPull:
+        field->AddSource(Source(ForceAttract, 0, -WeakGravity));
+        field->AddSource(Source(ForceAttract, 2, StrongGravity));
+        break;
+
+    case PlanetGravity:
+        field->AddSource(Source(ForceInverseSquare, 0, InverseSquareGravity));
+        break;
+
+    case Orbits:
+        {
+            ForceSource source = Source(ForceOrbit, 0, OrbitPower);
+
+            source.axisX = axis[0];
+            source.axisY = axis[1];
+            source.axisZ = axis[2];
+            field->AddSource(source);
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+
+static void MakeBodies(uint32_t count, uint32_t seed, vector<float>* positions)
+{
+    positions->resize(count * 3);
+    for (uint32_t i = 0; i < count * 3; i++)
+    {
+        (*positions)[i] = RandomFloat(&seed, -PlanetHeight, PlanetHeight);
+    }
+}
+
+
+static void SetPositions(vector<float> const& positions, ForceField* field)
+{
+    uint32_t count = (uint32_t)positions.size() / 3;
+
+    field->Resize(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        field->SetPosition(i, positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2]);
+    }
+}
+
+
+// Bodies as EnginePhysics saw them through PhysX: a pose to ask for and a force to add, a call
+// apiece through the actor's interface.
+class LegacyActor
+{
+public:
+    float position[3];
+    float force[3];
+
+    virtual ~LegacyActor() { }
+
+    virtual void GetPosition(float* result) const
+    {
+        result[0] = position[0];
+        result[1] = position[1];
+        result[2] = position[2];
+    }
+
+    virtual void AddForce(float x, float y, float z)
+    {
+        force[0] += x;
+        force[1] += y;
+        force[2] += z;
+    }
+};
+
+
+// The per body gravity of EnginePhysics, as it was: a switch for every body, and the pose asked
+// for again for every source.
+class LegacyGravity
+{
+public:
+    vector<LegacyActor> actors;
+
+    void Step(Mode mode)
+    {
+        for (size_t i = 0; i < actors.size(); i++)
+        {
+            LegacyActor& actor = actors[i];
+
+            switch (mode)
+            {
+            case PullSingle:
+                Apply(&actor, 0, StrongGravity);
+                break;
+
+            case PullDouble:
+                Apply(&actor, 1, StrongGravity);
+                Apply(&actor, 2, StrongGravity);
+                break;
+
+            case PullTriple:
+                Apply(&actor, 0, StrongGravity);
+                Apply(&actor, 2, StrongGravity);
+                Apply(&actor, 1, StrongGravity);
+                break;
+
+            case PullPush:
+                Apply(&actor, 0, StrongGravity);
+                Apply(&actor, 2, -WeakGravity);
+                break;
+
+            case PushPull:
+                Apply(&actor, 0, -WeakGravity);
+                Apply(&actor, 2, StrongGravity);
+                break;
+
+            case PlanetGravity:
+                // Pulled every body, not just this one.
+                ApplyInverseSquare(0, InverseSquareGravity);
+                break;
+
+            case Orbits:
+                ApplyOrbit(&actor, 0, OrbitPower, (int)i);
+                break;
+
+            default:
+                break;
+            }
+        }
+    }
+
+private:
+    static void Normalize(float* v)
+    {
+        float length = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+
+        if (length > 0.0f)
+        {
+            v[0] /= length;
+            v[1] /= length;
+            v[2] /= length;
+        }
+    }
+
+    void Apply(LegacyActor* actor, int planet, float power)
+    {
+        float d[3];
+
+        actor->GetPosition(d);
+        d[0] = Planets[planet][0] - d[0];
+        d[1] = Planets[planet][1] - d[1];
+        d[2] = Planets[planet][2] - d[2];
+        Normalize(d);
+        actor->AddForce(d[0] * power, d[1] * power, d[2] * power);
+    }
+
+    void ApplyInverseSquare(int planet, float power)
+    {
+        for (size_t i = 0; i < actors.size(); i++)
+        {
+            float d[3];
+
+            actors[i].GetPosition(d);
+            d[0] = Planets[planet][0] - d[0];
+            d[1] = Planets[planet][1] - d[1];
+            d[2] = Planets[planet][2] - d[2];
+
+            float distanceSquared = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+
+            distanceSquared = distanceSquared < 10.0f ? 10000.0f : distanceSquared;
+            Normalize(d);
+            actors[i].AddForce(d[0] * power / distanceSquared, d[1] * power / distanceSquared, d[2] * power / distanceSquared);
+        }
+    }
+
+    void ApplyOrbit(LegacyActor* actor, int planet, float power, int seed)
+    {
+        float d[3], r[3];
+
+        actor->GetPosition(d);
+        d[0] = Planets[planet][0] - d[0];
+        d[1] = Planets[planet][1] - d[1];
+        d[2] = Planets[planet][2] - d[2];
+        Normalize(d);
+
+        // A reseeded random vector, as CreateRandomVector did.
+        srand(seed);
+        r[0] = (float)(rand() % 20 - 10);
+        r[1] = (float)(rand() % 20 - 10);
+        r[2] = (float)(rand() % 20 - 10);
+
+        float along = r[0] * d[0] + r[1] * d[1] + r[2] * d[2];
+
+        actor->AddForce((r[0] - d[0] * along) * power, (r[1] - d[1] * along) * power, (r[2] - d[2] * along) * power);
+    }
+};
+
+
+static void Report(char const* name, double seconds, int frames, uint32_t bodyCount)
+{
+    printf("  %-30s %9.3f ms/step %8.2f ns/body\n", name, seconds / frames * 1e3, seconds / frames / bodyCount * 1e9);
+}
+
+
+static void BenchBodyCount(uint32_t bodyCount, int frames, WorkerPool* pool)
+{
+    static float const axis[3] = { 3.0f, -7.0f, 5.0f };
+    vector<float> positions;
+    LegacyGravity legacy;
+    ForceField serial;
+    ForceField parallel(pool);
+
+    MakeBodies(bodyCount, 1, &positions);
+    legacy.actors.resize(bodyCount);
+    for (uint32_t i = 0; i < bodyCount; i++)
+    {
+        memcpy(legacy.actors[i].position, &positions[i * 3], sizeof(legacy.actors[i].position));
+    }
+    SetPositions(positions, &serial);
+    SetPositions(positions, &parallel);
+
+    printf("%u bodies\n", bodyCount);
+
+    for (int mode = 0; mode < ModeCount; mode++)
+    {
+        double seconds;
+        int frame;
+
+        printf(" %s\n", ModeNames[mode]);
+
+        if (mode == PlanetGravity && bodyCount > 10000)
+        {
+            printf("  %-30s   skipped, a step visits every body from every body\n", "a call per body and source");
+        }
+        else
+        {
+            seconds = 0.0;
+            for (frame = 0; frame < frames; frame++)
+            {
+                Clock::time_point begin = Clock::now();
+                legacy.Step((Mode)mode);
+                seconds += Seconds(begin);
+            }
+            Report("a call per body and source", seconds, frames, bodyCount);
+        }
+
+        AddSources((Mode)mode, axis, &serial);
+        AddSources((Mode)mode, axis, &parallel);
+
+        seconds = 0.0;
+        for (frame = 0; frame < frames; frame++)
+        {
+            Clock::time_point begin = Clock::now();
+            serial.EvaluateReference();
+            seconds += Seconds(begin);
+        }
+        Report("one at a time", seconds, frames, bodyCount);
+
+        seconds = 0.0;
+        for (frame = 0; frame < frames; frame++)
+        {
+            Clock::time_point begin = Clock::now();
+            serial.Evaluate();
+            seconds += Seconds(begin);
+        }
+        Report("four at a time", seconds, frames, bodyCount);
+
+        seconds = 0.0;
+        for (frame = 0; frame < frames; frame++)
+        {
+            Clock::time_point begin = Clock::now();
+            parallel.Evaluate();
+            seconds += Seconds(begin);
+        }
+
+        char name[64];
+
+        sprintf(name, "four at a time, %u threads", pool->ThreadCount());
+        Report(name, seconds, frames, bodyCount);
+    }
+}
+
+
+static int Bench(uint32_t bodies, int frames, unsigned int threads)
+{
+    WorkerPool pool(threads);
+
+    printf("Custom gravity for bodies spread over a %g unit box, %d steps\n", PlanetHeight * 2.0f, frames);
+
+    if (bodies)
+    {
+        BenchBodyCount(bodies, frames, &pool);
+        return 0;
+    }
+
+    static uint32_t const bodyCounts[] = { 100, 10000, 100000 };
+
+    for (int i = 0; i < 3; i++)
+    {
+        BenchBodyCount(bodyCounts[i], frames, &pool);
+    }
+
+    return 0;
+}
+
+
+static bool Near(float a, float b)
+{
+    return fabsf(a - b) <= 1e-5f * max(1.0f, fabsf(b));
+}
+
+
+static int Check(uint32_t bodyCount, unsigned int threads)
+{
+    static float const axis[3] = { -4.0f, 9.0f, 2.0f };
+    WorkerPool pool(threads);
+    vector<float> positions;
+    ForceField reference, serial, parallel(&pool);
+    uint32_t i;
+
+    // Some bodies right at the sources and close to them, where the inverse square is capped.
+    MakeBodies(bodyCount, 7, &positions);
+    for (i = 0; i < 3; i++)
+    {
+        memcpy(&positions[i * 3], Planets[i], sizeof(Planets[i]));
+        positions[(i + 3) * 3] = Planets[i][0] + 1.0f;
+        positions[(i + 3) * 3 + 1] = Planets[i][1] - 2.0f;
+        positions[(i + 3) * 3 + 2] = Planets[i][2];
+    }
+    SetPositions(positions, &reference);
+    SetPositions(positions, &serial);
+    SetPositions(positions, &parallel);
+
+    for (int mode = 0; mode < ModeCount; mode++)
+    {
+        AddSources((Mode)mode, axis, &reference);
+        AddSources((Mode)mode, axis, &serial);
+        AddSources((Mode)mode, axis, &parallel);
+        reference.EvaluateReference();
+        serial.Evaluate();
+        parallel.Evaluate();
+
+        for (int pass = 0; pass < 2; pass++)
+        {
+            ForceField const& field = pass ? parallel : serial;
+
+            for (i = 0; i < bodyCount; i++)
+            {
+                if (!Near(field.AccelerationX(i), reference.AccelerationX(i)) || !Near(field.AccelerationY(i), reference.AccelerationY(i)) ||
+                    !Near(field.AccelerationZ(i), reference.AccelerationZ(i)))
+                {
+                    printf("FAILED: %s, %s: body %u gets (%g %g %g), not (%g %g %g)\n", ModeNames[mode], pass ? "parallel" : "serial", i,
+                        field.AccelerationX(i), field.AccelerationY(i), field.AccelerationZ(i),
+                        reference.AccelerationX(i), reference.AccelerationY(i), reference.AccelerationZ(i));
+                    return 1;
+                }
+            }
+        }
+
+        // What the mode does, worked out apart from ForceField.
+        for (i = 0; i < bodyCount; i++)
+        {
+            float dx = Planets[0][0] - positions[i * 3];
+            float dy = Planets[0][1] - positions[i * 3 + 1];
+            float dz = Planets[0][2] - positions[i * 3 + 2];
+            float distance = sqrtf(dx * dx + dy * dy + dz * dz);
+            float ax = reference.AccelerationX(i);
+            float ay = reference.AccelerationY(i);
+            float az = reference.AccelerationZ(i);
+            float magnitude = sqrtf(ax * ax + ay * ay + az * az);
+            bool ok = true;
+
+            if (distance == 0.0f)
+            {
+                ok = mode == PullSingle || mode == PlanetGravity || mode == Orbits ? magnitude == 0.0f : true;
+            }
+            else if (mode == PullSingle)
+            {
+                ok = fabsf(magnitude - StrongGravity) <= 1e-3f && (ax * dx + ay * dy + az * dz) > 0.0f;
+            }
+            else if (mode == PlanetGravity)
+            {
+                float expected = InverseSquareGravity / (distance * distance < 10.0f ? 10000.0f : distance * distance);
+
+                ok = fabsf(magnitude - expected) <= 1e-5f * expected;
+            }
+            else if (mode == Orbits)
+            {
+                ok = fabsf(ax * dx + ay * dy + az * dz) <= 1e-4f * magnitude * distance;
+            }
+
+            if (!ok)
+            {
+                printf("FAILED: %s: body %u at distance %g gets (%g %g %g)\n", ModeNames[mode], i, distance, ax, ay, az);
+                return 1;
+            }
+        }
+
+        printf("%-15s %u bodies, %u threads: ok\n", ModeNames[mode], bodyCount, pool.ThreadCount());
+    }
+
+    return 0;
+}
+
+
+static int Usage()
+{
+    printf("Usage: forcebench bench|check [-n frames] [-b bodies] [-t threads]\n");
+
+    return 2;
+}
+
+
+int main(int argc, char* argv[])
+{
+    uint32_t bodies = 0;
+    int frames = 20;
+    unsigned int threads = 0;
+    int i;
+
+    if (argc < 2)
+    {
+        return Usage();
+    }
+
+    string command = argv[1];
+
+    for (i = 2; i < argc; i++)
+    {
+        string option = argv[i];
+
+        if (i + 1 >= argc)
+        {
+            return Usage();
+        }
+
+        if (option == "-n")
+        {
+            frames = max(1, atoi(argv[++i]));
+        }
+        else if (option == "-b")
+        {
+            bodies = (uint32_t)max(1, atoi(argv[++i]));
+        }
+        else if (option == "-t")
+        {
+            threads = (unsigned int)max(1, atoi(argv[++i]));
+        }
+        else
+        {
+            return Usage();
+        }
+    }
+
+    if (command == "bench")
+    {
+        return Bench(bodies, frames, threads);
+    }
+
+    if (command == "check")
+    {
+        // Enough for the bodies placed at and around the sources.
+        return Check(max(bodies ? bodies : 10003u, 6u), threads);
+    }
+
+    return Usage();
+}
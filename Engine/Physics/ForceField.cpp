@@ -0,0 +1,192 @@
+#include "ForceField.h"
+
+#include <math.h>
+#include <algorithm>
+
+
+// Bodies to a task, a multiple of four.
+static uint32_t const BodiesPerTask = 4096;
+
+
+// One body's acceleration from every source, in the order they were added.
+static void EvaluateBody(vector<ForceSource> const& sources, float x, float y, float z, float* ax, float* ay, float* az)
+{
+    float sumX = 0.0f, sumY = 0.0f, sumZ = 0.0f;
+
+    for (size_t i = 0; i < sources.size(); i++)
+    {
+        ForceSource const& source = sources[i];
+        float dx = source.x - x;
+        float dy = source.y - y;
+        float dz = source.z - z;
+        float distanceSquared = dx * dx + dy * dy + dz * dz;
+
+        if (distanceSquared <= 0.0f)
+        {
+            continue;
+        }
+
+        float inverseDistance = 1.0f / sqrtf(distanceSquared);
+
+        switch (source.type)
+        {
+        case ForceAttract:
+            {
+                float scale = source.strength * inverseDistance;
+
+                sumX += dx * scale;
+                sumY += dy * scale;
+                sumZ += dz * scale;
+            }
+            break;
+
+        case ForceInverseSquare:
+            {
+                float scale = source.strength * inverseDistance / (distanceSquared < 10.0f ? 10000.0f : distanceSquared);
+
+                sumX += dx * scale;
+                sumY += dy * scale;
+                sumZ += dz * scale;
+            }
+            break;
+
+        case ForceOrbit:
+            {
+                float nx = dx * inverseDistance;
+                float ny = dy * inverseDistance;
+                float nz = dz * inverseDistance;
+                float along = source.axisX * nx + source.axisY * ny + source.axisZ * nz;
+
+                sumX += source.strength * (source.axisX - nx * along);
+                sumY += source.strength * (source.axisY - ny * along);
+                sumZ += source.strength * (source.axisZ - nz * along);
+            }
+            break;
+        }
+    }
+
+    *ax = sumX;
+    *ay = sumY;
+    *az = sumZ;
+}
+
+
+ForceField::ForceField(WorkerPool* pool)
+    : pool(pool), count(0)
+{
+}
+
+
+void ForceField::Resize(uint32_t count)
+{
+    uint32_t padded = (count + 3) & ~3u;
+
+    this->count = count;
+
+    // The padding sits at the origin, and what it gets is never read.
+    x.resize(padded, 0.0f);
+    y.resize(padded, 0.0f);
+    z.resize(padded, 0.0f);
+    accelerationX.resize(padded, 0.0f);
+    accelerationY.resize(padded, 0.0f);
+    accelerationZ.resize(padded, 0.0f);
+}
+
+
+void ForceField::Evaluate()
+{
+    uint32_t taskCount = (count + BodiesPerTask - 1) / BodiesPerTask;
+
+    if (!pool || taskCount <= 1)
+    {
+        EvaluateRange(0, count);
+        return;
+    }
+
+    pool->Run(taskCount, [this](uint32_t task)
+    {
+        EvaluateRange(task * BodiesPerTask, min(count, (task + 1) * BodiesPerTask));
+    });
+}
+
+
+void ForceField::EvaluateReference()
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        EvaluateBody(sources, x[i], y[i], z[i], &accelerationX[i], &accelerationY[i], &accelerationZ[i]);
+    }
+}
+
+
+void ForceField::EvaluateRange(uint32_t begin, uint32_t end)
+{
+#ifdef SCENE_USE_SSE
+    __m128 const zero = _mm_setzero_ps();
+    __m128 const one = _mm_set1_ps(1.0f);
+    __m128 const closeLimit = _mm_set1_ps(10.0f);
+    __m128 const closeFalloff = _mm_set1_ps(10000.0f);
+
+    for (uint32_t i = begin; i < end; i += 4)
+    {
+        __m128 px = _mm_load_ps(&x[i]);
+        __m128 py = _mm_load_ps(&y[i]);
+        __m128 pz = _mm_load_ps(&z[i]);
+        __m128 sumX = zero, sumY = zero, sumZ = zero;
+
+        for (size_t j = 0; j < sources.size(); j++)
+        {
+            ForceSource const& source = sources[j];
+            __m128 dx = _mm_sub_ps(_mm_set1_ps(source.x), px);
+            __m128 dy = _mm_sub_ps(_mm_set1_ps(source.y), py);
+            __m128 dz = _mm_sub_ps(_mm_set1_ps(source.z), pz);
+            __m128 distanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+            // Bodies at the source get an infinite inverse distance, masked off with the rest.
+            __m128 away = _mm_cmpgt_ps(distanceSquared, zero);
+            __m128 inverseDistance = _mm_div_ps(one, _mm_sqrt_ps(distanceSquared));
+            __m128 strength = _mm_set1_ps(source.strength);
+
+            if (source.type == ForceOrbit)
+            {
+                __m128 nx = _mm_mul_ps(dx, inverseDistance);
+                __m128 ny = _mm_mul_ps(dy, inverseDistance);
+                __m128 nz = _mm_mul_ps(dz, inverseDistance);
+                __m128 axisX = _mm_set1_ps(source.axisX);
+                __m128 axisY = _mm_set1_ps(source.axisY);
+                __m128 axisZ = _mm_set1_ps(source.axisZ);
+                __m128 along = _mm_add_ps(_mm_add_ps(_mm_mul_ps(axisX, nx), _mm_mul_ps(axisY, ny)), _mm_mul_ps(axisZ, nz));
+
+                sumX = _mm_add_ps(sumX, _mm_and_ps(away, _mm_mul_ps(strength, _mm_sub_ps(axisX, _mm_mul_ps(nx, along)))));
+                sumY = _mm_add_ps(sumY, _mm_and_ps(away, _mm_mul_ps(strength, _mm_sub_ps(axisY, _mm_mul_ps(ny, along)))));
+                sumZ = _mm_add_ps(sumZ, _mm_and_ps(away, _mm_mul_ps(strength, _mm_sub_ps(axisZ, _mm_mul_ps(nz, along)))));
+                continue;
+            }
+
+            __m128 scale = _mm_mul_ps(strength, inverseDistance);
+
+            if (source.type == ForceInverseSquare)
+            {
+                __m128 isClose = _mm_cmplt_ps(distanceSquared, closeLimit);
+                __m128 falloff = _mm_or_ps(_mm_and_ps(isClose, closeFalloff), _mm_andnot_ps(isClose, distanceSquared));
+
+                scale = _mm_div_ps(scale, falloff);
+            }
+            scale = _mm_and_ps(away, scale);
+
+            sumX = _mm_add_ps(sumX, _mm_mul_ps(dx, scale));
+            sumY = _mm_add_ps(sumY, _mm_mul_ps(dy, scale));
+            sumZ = _mm_add_ps(sumZ, _mm_mul_ps(dz, scale));
+        }
+
+        _mm_store_ps(&accelerationX[i], sumX);
+        _mm_store_ps(&accelerationY[i], sumY);
+        _mm_store_ps(&accelerationZ[i], sumZ);
+    }
+#else
+    for (uint32_t i = begin; i < end; i++)
+    {
+        EvaluateBody(sources, x[i], y[i], z[i], &accelerationX[i], &accelerationY[i], &accelerationZ[i]);
+    }
+#endif
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "../Scene/SceneMath.h"
+#include "../Scene/SceneStore.h"
+#include "../Scene/WorkerPool.h"
+
+using namespace std;
+
+
+enum ForceSourceType
+{
+    // Pulls with the same strength at any distance, or pushes if the strength is negative.
+    ForceAttract,
+    // Pulls with strength over the squared distance. Bodies within sqrt(10) of the source,
+    // where that would blow up, get strength / 10000 instead.
+    ForceInverseSquare,
+    // Pushes along the part of an axis at right angles to the way to the source, so bodies
+    // circle it.
+    ForceOrbit,
+};
+
+
+// A point bodies are pulled towards, pushed away from or sent around.
+struct ForceSource
+{
+    ForceSourceType type;
+    float x, y, z;
+    float strength;             // Acceleration, scaled as the type says.
+    float axisX, axisY, axisZ;  // Orbits only; need not be normalized.
+};
+
+
+// Positions of many bodies, kept as an array of each component, and the acceleration each
+// gets from every source. Evaluate takes four bodies at a time against one source after
+// another, splitting the bodies across a WorkerPool if one is given. Bodies at a source are
+// left alone by it, as they have no way to it.
+class ForceField
+{
+public:
+    explicit ForceField(WorkerPool* pool = 0);
+
+    void Resize(uint32_t count);
+    uint32_t Count() const { return count; }
+
+    void SetPosition(uint32_t body, float x, float y, float z)
+    {
+        this->x[body] = x;
+        this->y[body] = y;
+        this->z[body] = z;
+    }
+
+    void ClearSources() { sources.clear(); }
+    void AddSource(ForceSource const& source) { sources.push_back(source); }
+
+    // Sums every source's acceleration on every body.
+    void Evaluate();
+
+    // Evaluate one body and source at a time, to check the other against. Agrees to within a
+    // millionth or so of the acceleration.
+    void EvaluateReference();
+
+    // Acceleration of a body, as of the last Evaluate.
+    float AccelerationX(uint32_t body) const { return accelerationX[body]; }
+    float AccelerationY(uint32_t body) const { return accelerationY[body]; }
+    float AccelerationZ(uint32_t body) const { return accelerationZ[body]; }
+
+private:
+    typedef SceneStore::FloatArray FloatArray;
+
+    void EvaluateRange(uint32_t begin, uint32_t end);
+
+    WorkerPool* pool;
+    uint32_t count;
+    vector<ForceSource> sources;
+
+    // Padded to a multiple of four.
+    FloatArray x, y, z;
+    FloatArray accelerationX, accelerationY, accelerationZ;
+};
@@ -0,0 +1,560 @@
+// Command line benchmark for the work-stealing TaskScheduler that runs PhysX's tasks, with no
+// dependency on PhysX or Windows, so it can run on a headless build machine.
+//
+// Usage:
+//   taskbench bench [-n steps] [-t threads]
+//       Times simulated physics steps on 1, 2, 4, 8, 16 and 32 workers (or up to -t). A step
+//       is shaped like one of PxScene::simulate's: the calling thread submits a task per
+//       island, islands of very different sizes, and each spawns a few tasks that spawn a few
+//       more, then it waits as fetchResults(true) does. Each thread count is run on
+//       TaskScheduler and on a single locked queue whose every submit wakes every idle
+//       worker, as PhysX's default dispatcher does.
+//   taskbench check [-t threads]
+//       Checks the deque is last in first out for its owner and first in first out for
+//       thieves as it grows, that an owner and three thieves racing over a million items get
+//       each exactly once, and that every task of 200 steps runs exactly once on 1, 2, 3, 8
+//       and 32 workers (or just -t). Exits with 1 on failure.
+//
+// The default is 200 steps. Scaling stops at the machine's core count: beyond that the
+// workers take turns.
+
+#include "../TaskScheduler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <string>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+
+// The shape of a step. Each island task spawns Children tasks, which spawn Children each.
+static uint32_t const Islands = 16;
+static uint32_t const Children = 4;
+static uint32_t const TasksPerIsland = 1 + Children + Children * Children;
+static uint32_t const TasksPerStep = Islands * TasksPerIsland;
+
+
+static double Seconds(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+
+// Every task submitted from outside the workers goes on one locked queue, and each submit
+// wakes every waiting worker to race for it, as PhysX's default dispatcher does with its
+// shared job list and single event.
+class SharedQueueScheduler
+{
+public:
+    SharedQueueScheduler(TaskScheduler::TaskFunction run, void* context, unsigned int workerCount)
+        : run(run), context(context), shuttingDown(false)
+    {
+        for (unsigned int i = 0; i < workerCount; i++)
+        {
+            threads.push_back(thread(&SharedQueueScheduler::WorkerMain, this));
+        }
+    }
+
+    ~SharedQueueScheduler()
+    {
+        {
+            lock_guard<mutex> guard(lock);
+
+            shuttingDown = true;
+        }
+
+        workReady.notify_all();
+
+        for (size_t i = 0; i < threads.size(); i++)
+        {
+            threads[i].join();
+        }
+    }
+
+    void Submit(void* task)
+    {
+        {
+            lock_guard<mutex> guard(lock);
+
+            tasks.push_back(task);
+        }
+
+        workReady.notify_all();
+    }
+
+    uint64_t StealCount() const { return 0; }
+
+private:
+    void WorkerMain()
+    {
+        for (;;)
+        {
+            void* task;
+
+            {
+                unique_lock<mutex> guard(lock);
+
+                while (!shuttingDown && tasks.empty())
+                {
+                    workReady.wait(guard);
+                }
+
+                if (shuttingDown)
+                {
+                    return;
+                }
+
+                task = tasks.front();
+                tasks.pop_front();
+            }
+
+            run(task, context);
+        }
+    }
+
+    TaskScheduler::TaskFunction run;
+    void* context;
+    vector<thread> threads;
+    mutex lock;
+    condition_variable workReady;
+    deque<void*> tasks;
+    bool shuttingDown;
+};
+
+
+struct Step;
+
+
+// One piece of a step. Work is the number of iterations of some arithmetic it stands for.
+struct BenchTask
+{
+    Step* step;
+    uint32_t index;             // Within the step.
+    uint32_t level;             // 0 for an island, 1 for its children, 2 for theirs.
+    uint32_t work;
+};
+
+
+// What a task needs to find the rest of its step and the scheduler to submit to.
+struct Step
+{
+    void (*submit)(void* scheduler, void* task);
+    void* scheduler;
+    vector<BenchTask> tasks;
+    vector<atomic<uint32_t>*> runs;
+    atomic<uint32_t> remaining;
+    mutex lock;
+    condition_variable done;
+    float sink;
+};
+
+
+static float Work(uint32_t iterations, uint32_t seed)
+{
+    float x = (float)(seed & 0xFF) * 0.01f;
+
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        x = x * 0.999f + sqrtf(x + (float)i);
+    }
+
+    return x;
+}
+
+
+static void RunBenchTask(void* pointer, void*)
+{
+    BenchTask* task = (BenchTask*)pointer;
+    Step* step = task->step;
+
+    if (!step->runs.empty())
+    {
+        step->runs[task->index]->fetch_add(1);
+    }
+
+    float result = Work(task->work, task->index);
+
+    // Kept, so the arithmetic isn't optimized away. Racy, but only ever read to print.
+    if (result == 12345.0f)
+    {
+        step->sink = result;
+    }
+
+    // Spawned tasks follow their parent in the step's list, a subtree apiece.
+    if (task->level < 2)
+    {
+        uint32_t stride = task->level == 0 ? 1 + Children : 1;
+
+        for (uint32_t i = 0; i < Children; i++)
+        {
+            step->submit(step->scheduler, &step->tasks[task->index + 1 + i * stride]);
+        }
+    }
+
+    if (step->remaining.fetch_sub(1) == 1)
+    {
+        lock_guard<mutex> guard(step->lock);
+
+        step->done.notify_one();
+    }
+}
+
+
+// Islands get between 1 and 32 times the smallest's work, so a few dominate the step.
+static void MakeStep(Step* step, uint32_t baseWork, bool countRuns)
+{
+    uint32_t state = 7;
+
+    step->tasks.resize(TasksPerStep);
+
+    for (uint32_t island = 0; island < Islands; island++)
+    {
+        state = state * 1664525u + 1013904223u;
+
+        uint32_t islandWork = baseWork * (1 + (state >> 27));
+        uint32_t first = island * TasksPerIsland;
+
+        for (uint32_t i = 0; i < TasksPerIsland; i++)
+        {
+            BenchTask& task = step->tasks[first + i];
+
+            task.step = step;
+            task.index = first + i;
+            task.level = i == 0 ? 0 : (i - 1) % (1 + Children) == 0 ? 1 : 2;
+            task.work = islandWork;
+        }
+    }
+
+    if (countRuns)
+    {
+        for (uint32_t i = 0; i < TasksPerStep; i++)
+        {
+            step->runs.push_back(new atomic<uint32_t>(0));
+        }
+    }
+}
+
+
+template <class Scheduler>
+static void SubmitTo(void* scheduler, void* task)
+{
+    ((Scheduler*)scheduler)->Submit(task);
+}
+
+
+template <class Scheduler>
+static void RunStep(Scheduler* scheduler, Step* step)
+{
+    step->remaining = TasksPerStep;
+
+    for (uint32_t island = 0; island < Islands; island++)
+    {
+        scheduler->Submit(&step->tasks[island * TasksPerIsland]);
+    }
+
+    unique_lock<mutex> guard(step->lock);
+
+    while (step->remaining.load())
+    {
+        step->done.wait(guard);
+    }
+}
+
+
+template <class Scheduler>
+static double TimeSteps(unsigned int workers, int steps, uint32_t baseWork, uint64_t* steals)
+{
+    Step step;
+    Scheduler scheduler(RunBenchTask, 0, workers);
+
+    step.submit = SubmitTo<Scheduler>;
+    step.scheduler = &scheduler;
+    MakeStep(&step, baseWork, false);
+
+    // Warm up, so threads have started and caches are filled.
+    for (int i = 0; i < 5; i++)
+    {
+        RunStep(&scheduler, &step);
+    }
+
+    Clock::time_point start = Clock::now();
+
+    for (int i = 0; i < steps; i++)
+    {
+        RunStep(&scheduler, &step);
+    }
+
+    double seconds = Seconds(start);
+
+    *steals = scheduler.StealCount();
+
+    return seconds;
+}
+
+
+static int Bench(int steps, unsigned int maxThreads)
+{
+    static unsigned int const threadCounts[] = { 1, 2, 4, 8, 16, 32 };
+    uint32_t const baseWork = 50;
+
+    printf("%u tasks a step in %u islands, %u cores\n", TasksPerStep, Islands, thread::hardware_concurrency());
+    printf("  %-8s %22s %22s %14s\n", "workers", "shared queue", "work stealing", "steals/step");
+
+    double sharedOne = 0.0, stealingOne = 0.0;
+
+    for (size_t i = 0; i < sizeof(threadCounts) / sizeof(threadCounts[0]) && threadCounts[i] <= maxThreads; i++)
+    {
+        uint64_t steals;
+        double shared = TimeSteps<SharedQueueScheduler>(threadCounts[i], steps, baseWork, &steals) / steps;
+        double stealing = TimeSteps<TaskScheduler>(threadCounts[i], steps, baseWork, &steals) / steps;
+
+        if (i == 0)
+        {
+            sharedOne = shared;
+            stealingOne = stealing;
+        }
+
+        printf("  %-8u %9.3f ms (%5.2fx) %9.3f ms (%5.2fx) %14.1f\n", threadCounts[i],
+            shared * 1e3, sharedOne / shared, stealing * 1e3, stealingOne / stealing, (double)steals / (steps + 5));
+    }
+
+    return 0;
+}
+
+
+static int CheckDeque()
+{
+    WorkStealingDeque deque(4);
+    vector<uintptr_t> items;
+
+    // Owner order, through several growths.
+    for (uintptr_t i = 1; i <= 1000; i++)
+    {
+        deque.Push((void*)i);
+    }
+
+    for (uintptr_t i = 1000; i >= 1; i--)
+    {
+        if ((uintptr_t)deque.Pop() != i)
+        {
+            printf("FAILED: owner did not get item %u back last in first out\n", (uint32_t)i);
+            return 1;
+        }
+    }
+
+    if (deque.Pop() || deque.Steal() || !deque.IsEmpty())
+    {
+        printf("FAILED: emptied deque still has items\n");
+        return 1;
+    }
+
+    // Thief order.
+    for (uintptr_t i = 1; i <= 1000; i++)
+    {
+        deque.Push((void*)i);
+    }
+
+    for (uintptr_t i = 1; i <= 1000; i++)
+    {
+        if ((uintptr_t)deque.Steal() != i)
+        {
+            printf("FAILED: thief did not get item %u first in first out\n", (uint32_t)i);
+            return 1;
+        }
+    }
+
+    // An owner pushing and popping while three thieves steal: every item is taken exactly once.
+    uint32_t const count = 1000000;
+    WorkStealingDeque raced(16);
+    vector<atomic<uint32_t>*> seen;
+    atomic<bool> finished(false);
+    vector<thread> thieves;
+
+    for (uint32_t i = 0; i <= count; i++)
+    {
+        seen.push_back(new atomic<uint32_t>(0));
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        thieves.push_back(thread([&]()
+        {
+            while (!finished.load() || !raced.IsEmpty())
+            {
+                void* item = raced.Steal();
+
+                if (item)
+                {
+                    seen[(uintptr_t)item]->fetch_add(1);
+                }
+            }
+        }));
+    }
+
+    for (uintptr_t i = 1; i <= count; i++)
+    {
+        raced.Push((void*)i);
+
+        // Pop about one in three back, so both ends are busy.
+        if (i % 3 == 0)
+        {
+            void* item = raced.Pop();
+
+            if (item)
+            {
+                seen[(uintptr_t)item]->fetch_add(1);
+            }
+        }
+    }
+
+    finished = true;
+
+    for (size_t i = 0; i < thieves.size(); i++)
+    {
+        thieves[i].join();
+    }
+
+    int result = 0;
+
+    for (uint32_t i = 1; i <= count; i++)
+    {
+        if (seen[i]->load() != 1 && !result)
+        {
+            printf("FAILED: raced item %u was taken %u times\n", i, seen[i]->load());
+            result = 1;
+        }
+    }
+
+    for (size_t i = 0; i < seen.size(); i++)
+    {
+        delete seen[i];
+    }
+
+    if (!result)
+    {
+        printf("deque: owner and thief order through growth, %u items raced by 3 thieves: ok\n", count);
+    }
+
+    return result;
+}
+
+
+static int CheckScheduler(unsigned int workers)
+{
+    int const steps = 200;
+    Step step;
+    int result = 0;
+
+    {
+        TaskScheduler scheduler(RunBenchTask, 0, workers);
+
+        step.submit = SubmitTo<TaskScheduler>;
+        step.scheduler = &scheduler;
+        MakeStep(&step, 20, true);
+
+        for (int i = 0; i < steps; i++)
+        {
+            RunStep(&scheduler, &step);
+        }
+
+        for (uint32_t i = 0; i < TasksPerStep && !result; i++)
+        {
+            if (step.runs[i]->load() != (uint32_t)steps)
+            {
+                printf("FAILED: %u workers ran task %u %u times over %d steps\n", workers, i, step.runs[i]->load(), steps);
+                result = 1;
+            }
+        }
+
+        if (!result)
+        {
+            printf("%2u workers: %d steps of %u tasks each ran once, %llu stolen: ok\n", workers, steps, TasksPerStep,
+                (unsigned long long)scheduler.StealCount());
+        }
+    }
+
+    for (size_t i = 0; i < step.runs.size(); i++)
+    {
+        delete step.runs[i];
+    }
+
+    return result;
+}
+
+
+static int Check(unsigned int threads)
+{
+    static unsigned int const threadCounts[] = { 1, 2, 3, 8, 32 };
+
+    if (CheckDeque())
+    {
+        return 1;
+    }
+
+    if (threads)
+    {
+        return CheckScheduler(threads);
+    }
+
+    for (size_t i = 0; i < sizeof(threadCounts) / sizeof(threadCounts[0]); i++)
+    {
+        if (CheckScheduler(threadCounts[i]))
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
+static int Usage()
+{
+    printf("usage: taskbench bench [-n steps] [-t threads]\n");
+    printf("       taskbench check [-t threads]\n");
+    return 2;
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        return Usage();
+    }
+
+    std::string command = argv[1];
+    int steps = 200;
+    unsigned int threads = 0;
+
+    for (int i = 2; i + 1 < argc; i += 2)
+    {
+        if (!strcmp(argv[i], "-n"))
+        {
+            steps = atoi(argv[i + 1]);
+        }
+        else if (!strcmp(argv[i], "-t"))
+        {
+            threads = (unsigned int)atoi(argv[i + 1]);
+        }
+        else
+        {
+            return Usage();
+        }
+    }
+
+    if (command == "bench")
+    {
+        return Bench(steps > 0 ? steps : 200, threads ? threads : 32);
+    }
+
+    if (command == "check")
+    {
+        return Check(threads);
+    }
+
+    return Usage();
+}
@@ -0,0 +1,424 @@
+#include "TaskScheduler.h"
+
+#include <algorithm>
+
+
+#ifdef _MSC_VER
+#define SCHEDULER_THREAD_LOCAL __declspec(thread)
+#else
+#define SCHEDULER_THREAD_LOCAL __thread
+#endif
+
+// The scheduler the calling thread works for, if any, and which of its workers it is.
+static SCHEDULER_THREAD_LOCAL TaskScheduler const* currentScheduler = 0;
+static SCHEDULER_THREAD_LOCAL uint32_t currentWorker = 0;
+
+// Times a worker looks for work again, yielding in between, before it sleeps.
+static int const SpinRounds = 32;
+
+
+WorkStealingDeque::WorkStealingDeque(uint32_t capacity)
+{
+    int64_t size = 1;
+
+    while (size < capacity)
+    {
+        size *= 2;
+    }
+
+    top = 0;
+    bottom = 0;
+    ring = new Ring(size);
+}
+
+
+WorkStealingDeque::~WorkStealingDeque()
+{
+    delete ring.load();
+
+    for (size_t i = 0; i < retired.size(); i++)
+    {
+        delete retired[i];
+    }
+}
+
+
+void WorkStealingDeque::Push(void* item)
+{
+    int64_t b = bottom.load(memory_order_relaxed);
+    int64_t t = top.load(memory_order_acquire);
+    Ring* current = ring.load(memory_order_relaxed);
+
+    if (b - t > current->mask)
+    {
+        current = Grow(current, t, b);
+    }
+
+    current->items[b & current->mask].store(item, memory_order_relaxed);
+
+    // The item is in place before thieves can see it.
+    atomic_thread_fence(memory_order_release);
+    bottom.store(b + 1, memory_order_relaxed);
+}
+
+
+void* WorkStealingDeque::Pop()
+{
+    int64_t b = bottom.load(memory_order_relaxed) - 1;
+    Ring* current = ring.load(memory_order_relaxed);
+
+    // Claim the bottom item before looking at what thieves have taken.
+    bottom.store(b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+
+    int64_t t = top.load(memory_order_relaxed);
+
+    if (t > b)
+    {
+        bottom.store(b + 1, memory_order_relaxed);
+        return 0;
+    }
+
+    void* item = current->items[b & current->mask].load(memory_order_relaxed);
+
+    if (t == b)
+    {
+        // The last item, which a thief may be after too.
+        if (!top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+        {
+            item = 0;
+        }
+
+        bottom.store(b + 1, memory_order_relaxed);
+    }
+
+    return item;
+}
+
+
+void* WorkStealingDeque::Steal()
+{
+    int64_t t = top.load(memory_order_acquire);
+
+    atomic_thread_fence(memory_order_seq_cst);
+
+    int64_t b = bottom.load(memory_order_acquire);
+
+    if (t >= b)
+    {
+        return 0;
+    }
+
+    Ring* current = ring.load(memory_order_acquire);
+    void* item = current->items[t & current->mask].load(memory_order_relaxed);
+
+    if (!top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+    {
+        return 0;
+    }
+
+    return item;
+}
+
+
+bool WorkStealingDeque::IsEmpty() const
+{
+    return bottom.load(memory_order_acquire) <= top.load(memory_order_acquire);
+}
+
+
+WorkStealingDeque::Ring* WorkStealingDeque::Grow(Ring* old, int64_t t, int64_t b)
+{
+    Ring* grown = new Ring((old->mask + 1) * 2);
+
+    for (int64_t i = t; i < b; i++)
+    {
+        grown->items[i & grown->mask].store(old->items[i & old->mask].load(memory_order_relaxed), memory_order_relaxed);
+    }
+
+    ring.store(grown, memory_order_release);
+    retired.push_back(old);
+
+    return grown;
+}
+
+
+TaskScheduler::TaskScheduler(TaskFunction run, void* context, unsigned int workerCount)
+    : run(run), context(context)
+{
+    if (!workerCount)
+    {
+        workerCount = DefaultWorkerCount();
+    }
+
+    injectedCount = 0;
+    sleeping = 0;
+    shuttingDown = false;
+
+    for (unsigned int i = 0; i < workerCount; i++)
+    {
+        Worker* worker = new Worker;
+
+        worker->randomState = 0x9E3779B9u * (i + 1);
+        worker->steals = 0;
+        worker->woken = false;
+        workers.push_back(worker);
+    }
+
+    // Every worker exists before any starts stealing from the others.
+    for (unsigned int i = 0; i < workerCount; i++)
+    {
+        workers[i]->handle = thread(&TaskScheduler::WorkerMain, this, i);
+    }
+}
+
+
+TaskScheduler::~TaskScheduler()
+{
+    shuttingDown = true;
+
+    // Workers check the flag after going on the idle list, so none can be missed here.
+    {
+        lock_guard<mutex> guard(idleLock);
+
+        for (size_t i = 0; i < idle.size(); i++)
+        {
+            lock_guard<mutex> parkGuard(idle[i]->parkLock);
+
+            idle[i]->woken = true;
+            idle[i]->wake.notify_one();
+        }
+
+        idle.clear();
+        sleeping = 0;
+    }
+
+    // All of them stop before any goes, as the others may be stealing from it.
+    for (size_t i = 0; i < workers.size(); i++)
+    {
+        workers[i]->handle.join();
+    }
+
+    for (size_t i = 0; i < workers.size(); i++)
+    {
+        delete workers[i];
+    }
+}
+
+
+unsigned int TaskScheduler::DefaultWorkerCount()
+{
+    unsigned int cores = thread::hardware_concurrency();
+
+    return cores > 1 ? cores - 1 : 1;
+}
+
+
+void TaskScheduler::Submit(void* task)
+{
+    if (currentScheduler == this)
+    {
+        workers[currentWorker]->tasks.Push(task);
+    }
+    else
+    {
+        lock_guard<mutex> guard(injectedLock);
+
+        injected.push_back(task);
+        injectedCount++;
+    }
+
+    // Pairs with the fence in Park: either the sleeper sees the task, or this sees the sleeper.
+    atomic_thread_fence(memory_order_seq_cst);
+
+    if (sleeping.load(memory_order_relaxed))
+    {
+        WakeOne();
+    }
+}
+
+
+uint64_t TaskScheduler::StealCount() const
+{
+    uint64_t steals = 0;
+
+    for (size_t i = 0; i < workers.size(); i++)
+    {
+        steals += workers[i]->steals.load(memory_order_relaxed);
+    }
+
+    return steals;
+}
+
+
+void TaskScheduler::WorkerMain(uint32_t index)
+{
+    Worker* worker = workers[index];
+
+    currentScheduler = this;
+    currentWorker = index;
+
+    while (!shuttingDown.load(memory_order_relaxed))
+    {
+        void* task = FindWork(index);
+
+        for (int i = 0; !task && i < SpinRounds; i++)
+        {
+            this_thread::yield();
+            task = FindWork(index);
+        }
+
+        if (task)
+        {
+            run(task, context);
+        }
+        else
+        {
+            Park(worker);
+        }
+    }
+
+    currentScheduler = 0;
+}
+
+
+void* TaskScheduler::FindWork(uint32_t index)
+{
+    Worker* worker = workers[index];
+    void* task = worker->tasks.Pop();
+
+    if (task)
+    {
+        return task;
+    }
+
+    if (injectedCount.load(memory_order_relaxed))
+    {
+        lock_guard<mutex> guard(injectedLock);
+
+        if (!injected.empty())
+        {
+            task = injected.front();
+            injected.pop_front();
+            injectedCount--;
+
+            return task;
+        }
+    }
+
+    uint32_t count = (uint32_t)workers.size();
+
+    if (count < 2)
+    {
+        return 0;
+    }
+
+    // Xorshift, so thieves spread out over the victims rather than all trying the first.
+    uint32_t random = worker->randomState;
+
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+    worker->randomState = random;
+
+    for (uint32_t i = 0, victim = random % count; i < count; i++, victim = (victim + 1) % count)
+    {
+        if (victim == index)
+        {
+            continue;
+        }
+
+        task = workers[victim]->tasks.Steal();
+
+        if (task)
+        {
+            worker->steals.fetch_add(1, memory_order_relaxed);
+            return task;
+        }
+    }
+
+    return 0;
+}
+
+
+bool TaskScheduler::HasWork() const
+{
+    if (injectedCount.load(memory_order_relaxed))
+    {
+        return true;
+    }
+
+    for (size_t i = 0; i < workers.size(); i++)
+    {
+        if (!workers[i]->tasks.IsEmpty())
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+void TaskScheduler::Park(Worker* worker)
+{
+    {
+        lock_guard<mutex> guard(idleLock);
+
+        idle.push_back(worker);
+        sleeping++;
+    }
+
+    // A task submitted before the sleeper was counted has to be seen here instead, as its
+    // submitter didn't wake anyone. The same goes for a steal that lost its race.
+    atomic_thread_fence(memory_order_seq_cst);
+
+    if (HasWork() || shuttingDown.load(memory_order_relaxed))
+    {
+        lock_guard<mutex> guard(idleLock);
+        vector<Worker*>::iterator found = find(idle.begin(), idle.end(), worker);
+
+        if (found != idle.end())
+        {
+            idle.erase(found);
+            sleeping--;
+            return;
+        }
+
+        // Already taken off the list to be woken, so take the wake up below.
+    }
+
+    unique_lock<mutex> guard(worker->parkLock);
+
+    while (!worker->woken)
+    {
+        worker->wake.wait(guard);
+    }
+
+    worker->woken = false;
+}
+
+
+void TaskScheduler::WakeOne()
+{
+    Worker* worker;
+
+    {
+        lock_guard<mutex> guard(idleLock);
+
+        if (idle.empty())
+        {
+            return;
+        }
+
+        // The most recent sleeper, whose cache is the least likely to have gone cold.
+        worker = idle.back();
+        idle.pop_back();
+        sleeping--;
+    }
+
+    lock_guard<mutex> guard(worker->parkLock);
+
+    worker->woken = true;
+    worker->wake.notify_one();
+}
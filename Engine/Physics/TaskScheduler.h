@@ -0,0 +1,127 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+
+// A Chase-Lev deque of task pointers. The owning thread pushes and pops at the bottom, last in
+// first out, with no locking unless it takes the last item; other threads steal from the top.
+// Grows as needed; the old rings are kept until the deque goes, as a thief may still be reading
+// one. Items may not be null.
+class WorkStealingDeque
+{
+public:
+    explicit WorkStealingDeque(uint32_t capacity = 256);
+    ~WorkStealingDeque();
+
+    // Owner only.
+    void Push(void* item);
+    void* Pop();
+
+    // Any thread. Null if the deque is empty, or another thread took the item first.
+    void* Steal();
+
+    // May be out of date by the time it returns.
+    bool IsEmpty() const;
+
+private:
+    WorkStealingDeque(WorkStealingDeque const&);
+    WorkStealingDeque& operator=(WorkStealingDeque const&);
+
+    struct Ring
+    {
+        explicit Ring(int64_t capacity) : mask(capacity - 1), items(new atomic<void*>[(size_t)capacity]) {}
+        ~Ring() { delete[] items; }
+
+        int64_t mask;               // Capacity, a power of two, less one.
+        atomic<void*>* items;
+    };
+
+    Ring* Grow(Ring* ring, int64_t top, int64_t bottom);
+
+    // Kept on separate cache lines, as thieves write one and the owner the other.
+    atomic<int64_t> top;
+    char topPadding[64];
+    atomic<int64_t> bottom;
+    char bottomPadding[64];
+
+    atomic<Ring*> ring;
+    vector<Ring*> retired;
+};
+
+
+// Threads that each keep a deque of tasks. A task submitted from one of the workers goes on
+// its own deque, so the work it spawns stays on the core that has its data; anything else
+// goes on a shared queue. Workers take their newest task first, then the shared queue, then
+// steal the oldest task of another worker, starting at a random one. With nothing to do they
+// spin briefly, then sleep; each submit wakes at most one sleeper, rather than all of them.
+//
+// Tasks are opaque, non-null pointers passed to the run function. Any still queued when the
+// scheduler goes are dropped, so wait for everything submitted first.
+class TaskScheduler
+{
+public:
+    typedef void (*TaskFunction)(void* task, void* context);
+
+    // With no worker count, uses DefaultWorkerCount.
+    TaskScheduler(TaskFunction run, void* context, unsigned int workerCount = 0);
+    ~TaskScheduler();
+
+    // A worker for every core but the one the submitting thread runs on, and at least one.
+    static unsigned int DefaultWorkerCount();
+
+    unsigned int WorkerCount() const { return (unsigned int)workers.size(); }
+
+    // Any thread, including workers running a task.
+    void Submit(void* task);
+
+    // Tasks taken from another worker, since the scheduler was created.
+    uint64_t StealCount() const;
+
+private:
+    TaskScheduler(TaskScheduler const&);
+    TaskScheduler& operator=(TaskScheduler const&);
+
+    struct Worker
+    {
+        WorkStealingDeque tasks;
+        uint32_t randomState;
+        atomic<uint64_t> steals;
+
+        // Set, under the lock, by whoever takes the worker off the idle list.
+        mutex parkLock;
+        condition_variable wake;
+        bool woken;
+
+        thread handle;
+    };
+
+    void WorkerMain(uint32_t index);
+    void* FindWork(uint32_t index);
+    bool HasWork() const;
+    void Park(Worker* worker);
+    void WakeOne();
+
+    TaskFunction run;
+    void* context;
+    vector<Worker*> workers;
+
+    // Tasks submitted from outside the workers.
+    mutex injectedLock;
+    deque<void*> injected;
+    atomic<uint32_t> injectedCount;
+
+    // Sleeping workers, the most recent last.
+    mutex idleLock;
+    vector<Worker*> idle;
+    atomic<uint32_t> sleeping;
+
+    atomic<bool> shuttingDown;
+};
@@ -0,0 +1,195 @@
+#include "D3D11GpuProfiler.h"
+
+
+static ID3D11Query* CreateQuery(ID3D11Device* device, D3D11_QUERY type)
+{
+    D3D11_QUERY_DESC desc;
+    ID3D11Query* query = 0;
+
+    desc.Query = type;
+    desc.MiscFlags = 0;
+    if (FAILED(device->CreateQuery(&desc, &query)))
+    {
+        return 0;
+    }
+    return query;
+}
+
+
+static void Release(ID3D11Query* query)
+{
+    if (query)
+    {
+        query->Release();
+    }
+}
+
+
+// Whether a query's result is in, without flushing or waiting.
+template <typename T>
+static bool Ready(ID3D11DeviceContext* context, ID3D11Query* query, T* data)
+{
+    return context->GetData(query, data, sizeof(*data), D3D11_ASYNC_GETDATA_DONOTFLUSH) == S_OK;
+}
+
+
+D3D11GpuProfiler::D3D11GpuProfiler(ID3D11Device* device, FrameProfiler* profiler)
+    : profiler(profiler), nextFrame(0), recording(0)
+{
+    for (uint32_t i = 0; i < FrameLatency; i++)
+    {
+        Frame& frame = frames[i];
+
+        frame.disjoint = CreateQuery(device, D3D11_QUERY_TIMESTAMP_DISJOINT);
+        for (uint32_t j = 0; j < MaxScopes; j++)
+        {
+            frame.scopes[j].name = 0;
+            frame.scopes[j].depth = 0;
+            frame.scopes[j].begin = CreateQuery(device, D3D11_QUERY_TIMESTAMP);
+            frame.scopes[j].end = CreateQuery(device, D3D11_QUERY_TIMESTAMP);
+        }
+        frame.scopeCount = 0;
+        frame.index = 0;
+        frame.pending = false;
+    }
+}
+
+
+D3D11GpuProfiler::~D3D11GpuProfiler()
+{
+    for (uint32_t i = 0; i < FrameLatency; i++)
+    {
+        Release(frames[i].disjoint);
+        for (uint32_t j = 0; j < MaxScopes; j++)
+        {
+            Release(frames[i].scopes[j].begin);
+            Release(frames[i].scopes[j].end);
+        }
+    }
+}
+
+
+void D3D11GpuProfiler::BeginFrame(ID3D11DeviceContext* context)
+{
+    Frame& frame = frames[nextFrame % FrameLatency];
+
+    recording = 0;
+    open.clear();
+
+    // Still waiting on this frame's queries from FrameLatency frames ago, or without queries.
+    if (frame.pending || !frame.disjoint)
+    {
+        return;
+    }
+
+    recording = &frame;
+    frame.scopeCount = 0;
+    frame.index = profiler->FrameIndex();
+    context->Begin(frame.disjoint);
+    BeginScope(context, "Frame");
+}
+
+
+void D3D11GpuProfiler::EndFrame(ID3D11DeviceContext* context)
+{
+    if (recording)
+    {
+        while (!open.empty())
+        {
+            EndScope(context);
+        }
+        context->End(recording->disjoint);
+        recording->pending = true;
+        recording = 0;
+        nextFrame++;
+    }
+
+    Collect(context);
+}
+
+
+void D3D11GpuProfiler::BeginScope(ID3D11DeviceContext* context, char const* name)
+{
+    if (!recording)
+    {
+        return;
+    }
+
+    if (recording->scopeCount == MaxScopes || !recording->scopes[recording->scopeCount].begin ||
+        !recording->scopes[recording->scopeCount].end)
+    {
+        open.push_back(MaxScopes);
+        return;
+    }
+
+    Scope& scope = recording->scopes[recording->scopeCount];
+
+    scope.name = name;
+    scope.depth = (uint32_t)open.size();
+    context->End(scope.begin);
+    open.push_back(recording->scopeCount++);
+}
+
+
+void D3D11GpuProfiler::EndScope(ID3D11DeviceContext* context)
+{
+    if (!recording || open.empty())
+    {
+        return;
+    }
+
+    if (open.back() != MaxScopes)
+    {
+        context->End(recording->scopes[open.back()].end);
+    }
+    open.pop_back();
+}
+
+
+void D3D11GpuProfiler::Collect(ID3D11DeviceContext* context)
+{
+    for (uint32_t i = 0; i < FrameLatency; i++)
+    {
+        Frame& frame = frames[(nextFrame + i) % FrameLatency];
+        D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint;
+
+        if (!frame.pending)
+        {
+            continue;
+        }
+        if (!Ready(context, frame.disjoint, &disjoint))
+        {
+            // Later frames can't be done before this one.
+            return;
+        }
+
+        // The disjoint query ends after every timestamp, so those are in too.
+        events.clear();
+        for (uint32_t j = 0; j < frame.scopeCount && !disjoint.Disjoint; j++)
+        {
+            Scope const& scope = frame.scopes[j];
+            UINT64 begin, end, frameBegin;
+
+            if (!Ready(context, scope.begin, &begin) || !Ready(context, scope.end, &end) ||
+                !Ready(context, frame.scopes[0].begin, &frameBegin))
+            {
+                events.clear();
+                break;
+            }
+
+            ProfileEvent event;
+
+            event.name = scope.name;
+            event.depth = scope.depth;
+            event.begin = (double)(begin - frameBegin) * 1000.0 / disjoint.Frequency;
+            event.duration = (double)(end - begin) * 1000.0 / disjoint.Frequency;
+            events.push_back(event);
+        }
+
+        if (!events.empty())
+        {
+            profiler->AddGpuEvents(frame.index, &events[0], (uint32_t)events.size());
+        }
+        frame.pending = false;
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <d3d11.h>
+
+#include "FrameProfiler.h"
+
+
+// Times scopes on the GPU with timestamp queries, and hands them to a FrameProfiler once
+// they're ready. Queries are kept for a few frames in flight and only read when the GPU has
+// finished with them, so profiling never stalls the CPU. If the GPU falls further behind
+// than that, frames go untimed. Frames whose clock changed part way are dropped.
+class D3D11GpuProfiler
+{
+public:
+    // The device and profiler must outlive it.
+    D3D11GpuProfiler(ID3D11Device* device, FrameProfiler* profiler);
+    ~D3D11GpuProfiler();
+
+    // Call after the FrameProfiler's BeginFrame and before its EndFrame. The frame is the
+    // depth 0 scope, named "Frame".
+    void BeginFrame(ID3D11DeviceContext* context);
+    void EndFrame(ID3D11DeviceContext* context);
+
+    // Scopes past the first MaxScopes of a frame are left out.
+    void BeginScope(ID3D11DeviceContext* context, char const* name);
+    void EndScope(ID3D11DeviceContext* context);
+
+private:
+    static uint32_t const FrameLatency = 4;
+    static uint32_t const MaxScopes = 32;
+
+    struct Scope
+    {
+        char const* name;
+        uint32_t depth;
+        ID3D11Query* begin;
+        ID3D11Query* end;
+    };
+
+    struct Frame
+    {
+        ID3D11Query* disjoint;
+        Scope scopes[MaxScopes];
+        uint32_t scopeCount;
+        uint64_t index;
+        bool pending;
+    };
+
+    D3D11GpuProfiler(D3D11GpuProfiler const&);
+    D3D11GpuProfiler& operator=(D3D11GpuProfiler const&);
+
+    // Reads back the frames the GPU has finished, oldest first.
+    void Collect(ID3D11DeviceContext* context);
+
+    FrameProfiler* profiler;
+    Frame frames[FrameLatency];
+    uint32_t nextFrame;
+
+    // The frame being recorded, or null if there's none or it couldn't be.
+    Frame* recording;
+    // Scopes of the recording frame not yet ended, innermost last, or MaxScopes for those left out.
+    vector<uint32_t> open;
+    vector<ProfileEvent> events;
+};
+
+
+// Times a GPU scope until it goes out of scope. The profiler may be null.
+class ScopedGpuTimer
+{
+public:
+    ScopedGpuTimer(D3D11GpuProfiler* profiler, ID3D11DeviceContext* context, char const* name)
+        : profiler(profiler), context(context)
+    {
+        if (profiler)
+        {
+            profiler->BeginScope(context, name);
+        }
+    }
+
+    ~ScopedGpuTimer()
+    {
+        if (profiler)
+        {
+            profiler->EndScope(context);
+        }
+    }
+
+private:
+    ScopedGpuTimer(ScopedGpuTimer const&);
+    ScopedGpuTimer& operator=(ScopedGpuTimer const&);
+
+    D3D11GpuProfiler* profiler;
+    ID3D11DeviceContext* context;
+};
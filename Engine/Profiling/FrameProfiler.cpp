@@ -0,0 +1,308 @@
+#include "FrameProfiler.h"
+
+#include <string.h>
+#include <algorithm>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <chrono>
+#endif
+
+
+// The clock, in ticks. Visual Studio 2012's high_resolution_clock only ticks every
+// millisecond or so, so Windows uses the performance counter.
+static int64_t Ticks()
+{
+#ifdef _WIN32
+    LARGE_INTEGER ticks;
+
+    QueryPerformanceCounter(&ticks);
+    return ticks.QuadPart;
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+
+static double TicksPerMillisecond()
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency;
+
+    QueryPerformanceFrequency(&frequency);
+    return frequency.QuadPart / 1000.0;
+#else
+    return 1e6;
+#endif
+}
+
+
+// Writes a name as a JSON string.
+static void WriteString(FILE* file, char const* name)
+{
+    fputc('"', file);
+    for (char const* c = name; *c; c++)
+    {
+        if (*c == '"' || *c == '\\')
+        {
+            fputc('\\', file);
+            fputc(*c, file);
+        }
+        else if ((unsigned char)*c < 0x20)
+        {
+            fprintf(file, "\\u%04x", (unsigned char)*c);
+        }
+        else
+        {
+            fputc(*c, file);
+        }
+    }
+    fputc('"', file);
+}
+
+
+FrameProfiler::FrameProfiler(uint32_t historyFrames)
+    : frames(historyFrames ? historyFrames : 1), frameIndex(0), inFrame(false), start(Ticks())
+{
+    for (size_t i = 0; i < frames.size(); i++)
+    {
+        frames[i].index = ~0ull;
+        frames[i].complete = false;
+        frames[i].hasGpu = false;
+    }
+}
+
+
+double FrameProfiler::Now() const
+{
+    static double const ticksPerMillisecond = TicksPerMillisecond();
+
+    return (Ticks() - start) / ticksPerMillisecond;
+}
+
+
+void FrameProfiler::BeginFrame()
+{
+    if (inFrame)
+    {
+        EndFrame();
+    }
+
+    Frame& frame = frames[frameIndex % frames.size()];
+
+    frame.index = frameIndex;
+    frame.complete = false;
+    frame.hasGpu = false;
+    frame.cpu.clear();
+    frame.gpu.clear();
+
+    inFrame = true;
+    open.clear();
+    BeginScope("Frame");
+}
+
+
+void FrameProfiler::EndFrame()
+{
+    if (!inFrame)
+    {
+        return;
+    }
+
+    // Close anything left open along with the frame.
+    Frame& frame = frames[frameIndex % frames.size()];
+    double now = Now();
+
+    while (!open.empty())
+    {
+        frame.cpu[open.back()].duration = now - frame.cpu[open.back()].begin;
+        open.pop_back();
+    }
+
+    frame.complete = true;
+    inFrame = false;
+    frameIndex++;
+}
+
+
+void FrameProfiler::BeginScope(char const* name)
+{
+    if (!inFrame)
+    {
+        return;
+    }
+
+    Frame& frame = frames[frameIndex % frames.size()];
+    ProfileEvent event;
+
+    event.name = name;
+    event.depth = (uint32_t)open.size();
+    event.begin = Now();
+    event.duration = 0.0;
+
+    open.push_back((uint32_t)frame.cpu.size());
+    frame.cpu.push_back(event);
+}
+
+
+void FrameProfiler::EndScope()
+{
+    // Only EndFrame ends the frame.
+    if (!inFrame || open.size() < 2)
+    {
+        return;
+    }
+
+    ProfileEvent& event = frames[frameIndex % frames.size()].cpu[open.back()];
+
+    event.duration = Now() - event.begin;
+    open.pop_back();
+}
+
+
+FrameProfiler::Frame const* FrameProfiler::FindFrame(uint64_t index) const
+{
+    Frame const& frame = frames[index % frames.size()];
+
+    return frame.index == index ? &frame : 0;
+}
+
+
+void FrameProfiler::AddGpuEvents(uint64_t index, ProfileEvent const* events, uint32_t count)
+{
+    Frame& frame = frames[index % frames.size()];
+
+    if (frame.index != index || frame.cpu.empty())
+    {
+        return;
+    }
+
+    double begin = frame.cpu[0].begin;
+
+    frame.gpu.assign(events, events + count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        frame.gpu[i].begin += begin;
+    }
+    frame.hasGpu = true;
+}
+
+
+void FrameProfiler::Summarize(ProfileTrack track, uint32_t frameCount, vector<ProfileSummary>* summaries) const
+{
+    summaries->clear();
+
+    // The latest frame with times on the track.
+    uint32_t history = (uint32_t)min<uint64_t>(frames.size(), frameIndex);
+    Frame const* latest = 0;
+    uint32_t back;
+
+    for (back = 1; back <= history && !latest; back++)
+    {
+        Frame const* frame = FindFrame(frameIndex - back);
+
+        if (frame && frame->complete && (track == ProfileCpu || frame->hasGpu))
+        {
+            latest = frame;
+        }
+    }
+    if (!latest)
+    {
+        return;
+    }
+
+    vector<ProfileEvent> const& events = track == ProfileCpu ? latest->cpu : latest->gpu;
+
+    summaries->resize(events.size());
+    for (size_t i = 0; i < events.size(); i++)
+    {
+        ProfileSummary& summary = (*summaries)[i];
+        double total = 0.0;
+        uint32_t found = 0;
+
+        // Sum each frame's scopes of the same name and depth, as a scope may run more than once.
+        for (back = 0; back < frameCount && back <= latest->index; back++)
+        {
+            Frame const* frame = FindFrame(latest->index - back);
+
+            if (!frame || !frame->complete || (track == ProfileGpu && !frame->hasGpu))
+            {
+                continue;
+            }
+
+            vector<ProfileEvent> const& others = track == ProfileCpu ? frame->cpu : frame->gpu;
+            bool seen = false;
+
+            for (size_t j = 0; j < others.size(); j++)
+            {
+                if (others[j].depth == events[i].depth && !strcmp(others[j].name, events[i].name))
+                {
+                    total += others[j].duration;
+                    seen = true;
+                }
+            }
+            found += seen ? 1 : 0;
+        }
+
+        summary.name = events[i].name;
+        summary.depth = events[i].depth;
+        summary.milliseconds = found ? total / found : 0.0;
+    }
+}
+
+
+bool FrameProfiler::WriteChromeTrace(FILE* file) const
+{
+    uint64_t first = frameIndex > frames.size() ? frameIndex - frames.size() : 0;
+
+    // Name the two threads, then every scope as a complete event, in microseconds.
+    fprintf(file, "{\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n");
+    fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}");
+
+    for (uint64_t index = first; index < frameIndex; index++)
+    {
+        Frame const* frame = FindFrame(index);
+
+        if (!frame || !frame->complete)
+        {
+            continue;
+        }
+
+        for (int track = 0; track < 2; track++)
+        {
+            vector<ProfileEvent> const& events = track == ProfileCpu ? frame->cpu : frame->gpu;
+
+            for (size_t i = 0; i < events.size(); i++)
+            {
+                fprintf(file, ",\n{\"name\":");
+                WriteString(file, events[i].name);
+                fprintf(file, ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d,\"args\":{\"frame\":%llu}}",
+                    track == ProfileCpu ? "cpu" : "gpu", events[i].begin * 1e3, events[i].duration * 1e3, track + 1,
+                    (unsigned long long)frame->index);
+            }
+        }
+    }
+
+    fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+    return !ferror(file);
+}
+
+
+bool FrameProfiler::SaveChromeTrace(char const* path) const
+{
+    FILE* file = fopen(path, "w");
+
+    if (!file)
+    {
+        return false;
+    }
+
+    bool written = WriteChromeTrace(file);
+
+    return fclose(file) == 0 && written;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+using namespace std;
+
+
+// One timed scope. Names are not copied, so must be string literals or otherwise outlive
+// the profiler.
+struct ProfileEvent
+{
+    char const* name;
+    uint32_t depth;             // 0 for the whole frame, 1 for the scopes directly inside it.
+    double begin;               // Milliseconds since the profiler was created.
+    double duration;            // Milliseconds.
+};
+
+
+enum ProfileTrack
+{
+    ProfileCpu,
+    ProfileGpu,
+};
+
+
+// A scope's time averaged over recent frames, for an overlay.
+struct ProfileSummary
+{
+    char const* name;
+    uint32_t depth;
+    double milliseconds;
+};
+
+
+// Keeps the last few hundred frames of nested CPU scopes, and the GPU scopes a GPU profiler
+// reads back for them a few frames later. Averages them for display and writes them out as
+// a Chrome trace (chrome://tracing, or ui.perfetto.dev).
+//
+// CPU scopes are timed on the thread that runs the frame: begin and end them from that
+// thread only. Scopes outside BeginFrame and EndFrame are ignored.
+class FrameProfiler
+{
+public:
+    explicit FrameProfiler(uint32_t historyFrames = 300);
+
+    // The frame is the depth 0 scope, named "Frame".
+    void BeginFrame();
+    void EndFrame();
+
+    void BeginScope(char const* name);
+    void EndScope();
+
+    // The frame being recorded, or the next one to be, counting from 0.
+    uint64_t FrameIndex() const { return frameIndex; }
+
+    // Milliseconds since the profiler was created.
+    double Now() const;
+
+    // The GPU scopes of a frame, with begin counting from the GPU starting the frame. They are
+    // placed at the CPU's start of the frame, as the two clocks can't be compared. Frames
+    // that have fallen out of the history are dropped.
+    void AddGpuEvents(uint64_t frame, ProfileEvent const* events, uint32_t count);
+
+    // The scopes of the latest frame with times on the track, each averaged over up to
+    // frames of the frames before it, in the order they began.
+    void Summarize(ProfileTrack track, uint32_t frames, vector<ProfileSummary>* summaries) const;
+
+    // Every complete frame in the history, CPU scopes on one thread and GPU on another.
+    bool WriteChromeTrace(FILE* file) const;
+    bool SaveChromeTrace(char const* path) const;
+
+private:
+    struct Frame
+    {
+        uint64_t index;
+        bool complete;
+        bool hasGpu;
+        vector<ProfileEvent> cpu;
+        vector<ProfileEvent> gpu;
+    };
+
+    Frame const* FindFrame(uint64_t index) const;
+
+    vector<Frame> frames;
+    uint64_t frameIndex;
+    bool inFrame;
+
+    // Indices into the frame's CPU events of the open scopes, innermost last.
+    vector<uint32_t> open;
+
+    int64_t start;
+};
+
+
+// Times a CPU scope until it goes out of scope. The profiler may be null.
+class ScopedCpuTimer
+{
+public:
+    ScopedCpuTimer(FrameProfiler* profiler, char const* name)
+        : profiler(profiler)
+    {
+        if (profiler)
+        {
+            profiler->BeginScope(name);
+        }
+    }
+
+    ~ScopedCpuTimer()
+    {
+        if (profiler)
+        {
+            profiler->EndScope();
+        }
+    }
+
+private:
+    ScopedCpuTimer(ScopedCpuTimer const&);
+    ScopedCpuTimer& operator=(ScopedCpuTimer const&);
+
+    FrameProfiler* profiler;
+};
@@ -0,0 +1,482 @@
+// Command line benchmark and check for the frame profiler, with no dependency on Direct3D or
+// Windows, so it can run on a headless build machine.
+//
+// Usage:
+//   profilebench bench [-n frames] [-s scopes]
+//       Times beginning and ending CPU scopes, nested as the engine's frame nests them,
+//       summarizing them for the overlay, and writing the history as a Chrome trace.
+//   profilebench check
+//       Records frames of nested scopes with known GPU times arriving a few frames late, and
+//       checks the nesting, the averages, and that the trace is well formed JSON with every
+//       scope in it. Exits with 1 on failure.
+//   profilebench trace <path>
+//       Writes a Chrome trace of a few made up frames, to look at in chrome://tracing.
+//
+// The default is 1000 frames of 16 scopes.
+
+#include "../FrameProfiler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+
+// The CPU and GPU scopes of the engine's frame.
+static char const* const CpuScopes[] = { "Scene update", "Physics step", "Render", "Lights", "HUD" };
+static char const* const GpuScopes[] = { "G-buffer", "Lighting: compute tile", "Skybox and tone map" };
+static double const GpuTimes[] = { 2.0, 3.5, 0.5 };
+
+// How many frames late GPU times arrive, as with D3D11GpuProfiler.
+static uint32_t const GpuLatency = 3;
+
+
+static double Seconds(Clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::duration<double>>(Clock::now() - start).count();
+}
+
+
+// Spins for about a number of milliseconds of the profiler's clock.
+static void Spin(FrameProfiler const& profiler, double milliseconds)
+{
+    double end = profiler.Now() + milliseconds;
+
+    while (profiler.Now() < end)
+    {
+    }
+}
+
+
+// The GPU scopes of a frame, as D3D11GpuProfiler reads them back: the frame, then each pass
+// in turn, with a little time between.
+static void MakeGpuEvents(vector<ProfileEvent>* events)
+{
+    double begin = 0.1;
+
+    events->clear();
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        ProfileEvent event = { GpuScopes[i], 1, begin, GpuTimes[i] };
+
+        events->push_back(event);
+        begin += GpuTimes[i] + 0.1;
+    }
+
+    ProfileEvent frame = { "Frame", 0, 0.0, begin };
+
+    events->insert(events->begin(), frame);
+}
+
+
+// A frame as main.cpp records it, with Lights inside Render, and the GPU times of the frame
+// GpuLatency before.
+static void RecordFrame(FrameProfiler* profiler, vector<ProfileEvent> const& gpu, double spin)
+{
+    profiler->BeginFrame();
+    for (uint32_t i = 0; i < 5; i++)
+    {
+        if (i == 3)
+        {
+            continue;
+        }
+
+        ScopedCpuTimer timer(profiler, CpuScopes[i]);
+
+        if (i == 2)
+        {
+            ScopedCpuTimer lights(profiler, CpuScopes[3]);
+
+            Spin(*profiler, spin);
+        }
+        Spin(*profiler, spin);
+    }
+    if (profiler->FrameIndex() >= GpuLatency)
+    {
+        profiler->AddGpuEvents(profiler->FrameIndex() - GpuLatency, &gpu[0], (uint32_t)gpu.size());
+    }
+    profiler->EndFrame();
+}
+
+
+static int Bench(int frames, uint32_t scopes)
+{
+    FrameProfiler profiler;
+    vector<ProfileSummary> summaries;
+    int frame;
+
+    printf("%d frames of %u scopes\n", frames, scopes);
+
+    Clock::time_point begin = Clock::now();
+
+    for (frame = 0; frame < frames; frame++)
+    {
+        profiler.BeginFrame();
+        for (uint32_t i = 0; i < scopes; i++)
+        {
+            // Two levels deep, as a pass inside Render.
+            ScopedCpuTimer outer(&profiler, CpuScopes[i % 5]);
+            ScopedCpuTimer inner(&profiler, CpuScopes[(i + 1) % 5]);
+        }
+        profiler.EndFrame();
+    }
+
+    double seconds = Seconds(begin);
+
+    printf("%-30s %9.1f ns/scope\n", "begin and end", seconds / ((double)frames * scopes * 2) * 1e9);
+
+    begin = Clock::now();
+    for (frame = 0; frame < frames; frame++)
+    {
+        profiler.Summarize(ProfileCpu, 30, &summaries);
+    }
+    seconds = Seconds(begin);
+    printf("%-30s %9.3f ms/frame for %u lines\n", "summarize 30 frames", seconds / frames * 1e3, (uint32_t)summaries.size());
+
+    FILE* file = tmpfile();
+
+    if (!file)
+    {
+        printf("Couldn't open a temporary file\n");
+        return 1;
+    }
+
+    begin = Clock::now();
+    profiler.WriteChromeTrace(file);
+    seconds = Seconds(begin);
+    printf("%-30s %9.3f ms for %ld KB\n", "write trace", seconds * 1e3, ftell(file) / 1024);
+    fclose(file);
+
+    return 0;
+}
+
+
+// Walks a JSON value, well enough to tell whether the trace is well formed, counting the
+// complete events ("ph":"X") in it.
+struct JsonReader
+{
+    char const* p;
+    uint32_t completeEvents;
+
+    void Skip()
+    {
+        while (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')
+        {
+            p++;
+        }
+    }
+
+    bool String(string* value)
+    {
+        if (*p++ != '"')
+        {
+            return false;
+        }
+        value->clear();
+        while (*p != '"')
+        {
+            if (!*p || (unsigned char)*p < 0x20)
+            {
+                return false;
+            }
+            if (*p == '\\')
+            {
+                p++;
+                if (*p == 'u')
+                {
+                    p += 4;
+                }
+                else if (!strchr("\"\\/bfnrt", *p))
+                {
+                    return false;
+                }
+            }
+            *value += *p++;
+        }
+        p++;
+        return true;
+    }
+
+    bool Value()
+    {
+        string text;
+
+        Skip();
+        if (*p == '{')
+        {
+            string key;
+            bool first = true;
+
+            p++;
+            for (Skip(); *p != '}'; Skip())
+            {
+                if (!first && *p++ != ',')
+                {
+                    return false;
+                }
+                Skip();
+                if (!String(&key))
+                {
+                    return false;
+                }
+                Skip();
+                if (*p++ != ':')
+                {
+                    return false;
+                }
+                Skip();
+                if (key == "ph" && *p == '"')
+                {
+                    if (!String(&text))
+                    {
+                        return false;
+                    }
+                    completeEvents += text == "X" ? 1 : 0;
+                }
+                else if (!Value())
+                {
+                    return false;
+                }
+                first = false;
+            }
+            p++;
+            return true;
+        }
+        if (*p == '[')
+        {
+            bool first = true;
+
+            p++;
+            for (Skip(); *p != ']'; Skip())
+            {
+                if ((!first && *p++ != ',') || !Value())
+                {
+                    return false;
+                }
+                first = false;
+            }
+            p++;
+            return true;
+        }
+        if (*p == '"')
+        {
+            return String(&text);
+        }
+
+        char* end;
+
+        strtod(p, &end);
+        if (end == p)
+        {
+            return false;
+        }
+        p = end;
+        return true;
+    }
+};
+
+
+static bool Near(double a, double b, double tolerance)
+{
+    return a >= b - tolerance && a <= b + tolerance;
+}
+
+
+static int Check()
+{
+    uint32_t const history = 20;
+    FrameProfiler profiler(history);
+    vector<ProfileEvent> gpu;
+    vector<ProfileSummary> summaries;
+    uint32_t frame, i;
+
+    MakeGpuEvents(&gpu);
+
+    // Scopes outside a frame are ignored, and don't upset those inside.
+    {
+        ScopedCpuTimer outside(&profiler, "Outside");
+
+        for (frame = 0; frame < 30; frame++)
+        {
+            RecordFrame(&profiler, gpu, 0.05);
+        }
+    }
+
+    // The CPU tree: Frame, then the scopes in order, with Lights inside Render.
+    profiler.Summarize(ProfileCpu, 10, &summaries);
+
+    static char const* const expectedNames[] = { "Frame", "Scene update", "Physics step", "Render", "Lights", "HUD" };
+    static uint32_t const expectedDepths[] = { 0, 1, 1, 1, 2, 1 };
+
+    if (summaries.size() != 6)
+    {
+        printf("FAILED: %u CPU scopes, expected 6\n", (uint32_t)summaries.size());
+        return 1;
+    }
+    for (i = 0; i < 6; i++)
+    {
+        if (strcmp(summaries[i].name, expectedNames[i]) || summaries[i].depth != expectedDepths[i])
+        {
+            printf("FAILED: CPU scope %u is %s at depth %u, expected %s at %u\n", i, summaries[i].name, summaries[i].depth,
+                expectedNames[i], expectedDepths[i]);
+            return 1;
+        }
+    }
+
+    // Each spins for 0.05 ms, Render twice over; the frame holds them all.
+    double expectedTimes[] = { 0.25, 0.05, 0.05, 0.1, 0.05, 0.05 };
+
+    for (i = 0; i < 6; i++)
+    {
+        if (summaries[i].milliseconds < expectedTimes[i] || summaries[i].milliseconds > expectedTimes[i] + 5.0)
+        {
+            printf("FAILED: %s took %.3f ms, expected at least %.3f\n", summaries[i].name, summaries[i].milliseconds, expectedTimes[i]);
+            return 1;
+        }
+    }
+    printf("CPU: %u scopes nested as recorded, %.3f ms a frame: ok\n", (uint32_t)summaries.size(), summaries[0].milliseconds);
+
+    // The GPU times are the frame's, GpuLatency late, and averaged exactly.
+    profiler.Summarize(ProfileGpu, 10, &summaries);
+    if (summaries.size() != gpu.size())
+    {
+        printf("FAILED: %u GPU scopes, expected %u\n", (uint32_t)summaries.size(), (uint32_t)gpu.size());
+        return 1;
+    }
+    for (i = 0; i < gpu.size(); i++)
+    {
+        if (strcmp(summaries[i].name, gpu[i].name) || !Near(summaries[i].milliseconds, gpu[i].duration, 1e-9))
+        {
+            printf("FAILED: GPU scope %u is %s at %.3f ms, expected %s at %.3f\n", i, summaries[i].name, summaries[i].milliseconds,
+                gpu[i].name, gpu[i].duration);
+            return 1;
+        }
+    }
+    printf("GPU: %u scopes, %.3f ms a frame: ok\n", (uint32_t)summaries.size(), summaries[0].milliseconds);
+
+    // Times for frames that have left the history are dropped.
+    profiler.AddGpuEvents(0, &gpu[0], (uint32_t)gpu.size());
+
+    // The trace holds every scope of the history: 6 CPU scopes a frame, and the GPU ones of
+    // all but the latest GpuLatency frames.
+    FILE* file = tmpfile();
+
+    if (!file || !profiler.WriteChromeTrace(file))
+    {
+        printf("FAILED: couldn't write the trace\n");
+        return 1;
+    }
+
+    string json((size_t)ftell(file), '\0');
+
+    rewind(file);
+    json.resize(fread(&json[0], 1, json.size(), file));
+    fclose(file);
+
+    JsonReader reader = { json.c_str(), 0 };
+    uint32_t expectedEvents = history * 6 + (history - GpuLatency) * (uint32_t)gpu.size();
+
+    if (!reader.Value() || (reader.Skip(), *reader.p))
+    {
+        printf("FAILED: the trace is not well formed, at byte %u\n", (uint32_t)(reader.p - json.c_str()));
+        return 1;
+    }
+    if (reader.completeEvents != expectedEvents)
+    {
+        printf("FAILED: %u events in the trace, expected %u\n", reader.completeEvents, expectedEvents);
+        return 1;
+    }
+    printf("trace: %u events in %u KB of JSON: ok\n", reader.completeEvents, (uint32_t)(json.size() / 1024));
+
+    return 0;
+}
+
+
+static int Trace(char const* path)
+{
+    FrameProfiler profiler;
+    vector<ProfileEvent> gpu;
+
+    MakeGpuEvents(&gpu);
+    for (uint32_t frame = 0; frame < 10; frame++)
+    {
+        RecordFrame(&profiler, gpu, 0.5);
+    }
+
+    if (!profiler.SaveChromeTrace(path))
+    {
+        printf("Couldn't write %s\n", path);
+        return 1;
+    }
+    printf("Wrote %s\n", path);
+
+    return 0;
+}
+
+
+static int Usage()
+{
+    printf("Usage: profilebench bench|check [-n frames] [-s scopes]\n");
+    printf("       profilebench trace <path>\n");
+
+    return 2;
+}
+
+
+int main(int argc, char* argv[])
+{
+    int frames = 1000;
+    uint32_t scopes = 16;
+    int i;
+
+    if (argc < 2)
+    {
+        return Usage();
+    }
+
+    string command = argv[1];
+
+    if (command == "trace")
+    {
+        return argc == 3 ? Trace(argv[2]) : Usage();
+    }
+
+    for (i = 2; i < argc; i++)
+    {
+        string option = argv[i];
+
+        if (i + 1 >= argc)
+        {
+            return Usage();
+        }
+
+        if (option == "-n")
+        {
+            frames = max(1, atoi(argv[++i]));
+        }
+        else if (option == "-s")
+        {
+            scopes = (uint32_t)max(1, atoi(argv[++i]));
+        }
+        else
+        {
+            return Usage();
+        }
+    }
+
+    if (command == "bench")
+    {
+        return Bench(frames, scopes);
+    }
+
+    if (command == "check")
+    {
+        return Check();
+    }
+
+    return Usage();
+}
@@ -48,18 +48,57 @@ struct GeometryVSOut
     float2 texCoord     : texCoord;
 };
 
-GeometryVSOut GeometryVS(GeometryVSIn input)
+// Per-object transforms, read per instance from the scene graph's ring buffer (input slot 1)
+// NOTE: Must match ObjectConstants in Rendering/DrawBatcher.h
+struct ObjectVSIn
+{
+    float4 worldViewProj[4] : worldViewProj;    // Rows
+    float4 worldView[4]     : worldView;        // Rows
+};
+
+GeometryVSOut GeometryVS(GeometryVSIn input, ObjectVSIn object)
 {
     GeometryVSOut output;
 
-    output.position     = mul(float4(input.position, 1.0f), mCameraWorldViewProj);
-    output.positionView = mul(float4(input.position, 1.0f), mCameraWorldView).xyz;
-    output.normal       = mul(float4(input.normal, 0.0f), mCameraWorldView).xyz;
+    float4x4 worldViewProj = float4x4(object.worldViewProj[0], object.worldViewProj[1],
+                                      object.worldViewProj[2], object.worldViewProj[3]);
+    float4x4 worldView     = float4x4(object.worldView[0], object.worldView[1],
+                                      object.worldView[2], object.worldView[3]);
+
+    output.position     = mul(float4(input.position, 1.0f), worldViewProj);
+    output.positionView = mul(float4(input.position, 1.0f), worldView).xyz;
+    output.normal       = mul(float4(input.normal, 0.0f), worldView).xyz;
     output.texCoord     = input.texCoord;
     
     return output;
 }
 
+// Compact vertices, as packed by ModelClass
+struct GeometryPackedVSIn
+{
+    float4 position : position;     // Quantized: the world matrix includes the model's scale and offset
+    float2 normal   : normal;       // Octahedral encoded
+    float2 texCoord : texCoord;
+};
+
+float3 DecodeOctahedralNormal(float2 encoded)
+{
+    float3 normal = float3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+    float fold = saturate(-normal.z);
+    normal.xy += (normal.xy >= 0.0f ? -fold : fold);
+    return normalize(normal);
+}
+
+GeometryVSOut GeometryPackedVS(GeometryPackedVSIn input, ObjectVSIn object)
+{
+    GeometryVSIn unpacked;
+    unpacked.position = input.position.xyz;
+    unpacked.normal   = DecodeOctahedralNormal(input.normal);
+    unpacked.texCoord = input.texCoord;
+
+    return GeometryVS(unpacked, object);
+}
+
 float3 ComputeFaceNormal(float3 position)
 {
     return cross(ddx_coarse(position), ddy_coarse(position));
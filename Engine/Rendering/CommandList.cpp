@@ -0,0 +1,126 @@
+#include "CommandList.h"
+
+
+CommandStats::CommandStats()
+    : commands(0), maps(0), bytesUploaded(0), bindings(0), draws(0), instances(0), dispatches(0), executes(0)
+{
+}
+
+
+void* CommandList::Map(RenderBuffer* buffer, MapType type, uint32_t bytes)
+{
+    stats.commands++;
+    stats.maps++;
+    stats.bytesUploaded += bytes;
+    return DoMap(buffer, type);
+}
+
+void CommandList::Unmap(RenderBuffer* buffer)
+{
+    stats.commands++;
+    DoUnmap(buffer);
+}
+
+void CommandList::SetInputLayout(RenderInputLayout* layout)
+{
+    stats.commands++;
+    stats.bindings++;
+    DoSetInputLayout(layout);
+}
+
+void CommandList::SetVertexBuffers(uint32_t slot, uint32_t count, RenderBuffer* const* buffers, uint32_t const* strides, uint32_t const* offsets)
+{
+    stats.commands++;
+    stats.bindings++;
+    DoSetVertexBuffers(slot, count, buffers, strides, offsets);
+}
+
+void CommandList::SetIndexBuffer(RenderBuffer* buffer, IndexFormat format, uint32_t offset)
+{
+    stats.commands++;
+    stats.bindings++;
+    DoSetIndexBuffer(buffer, format, offset);
+}
+
+void CommandList::SetPrimitiveTopology(PrimitiveTopology topology)
+{
+    stats.commands++;
+    stats.bindings++;
+    DoSetPrimitiveTopology(topology);
+}
+
+void CommandList::SetShader(ShaderStage stage, RenderShader* shader)
+{
+    stats.commands++;
+    stats.bindings++;
+    DoSetShader(stage, shader);
+}
+
+void CommandList::SetConstantBuffers(ShaderStage stage, uint32_t slot, uint32_t count, RenderBuffer* const* buffers)
+{
+    stats.commands++;
+    stats.bindings++;
+    DoSetConstantBuffers(stage, slot, count, buffers);
+}
+
+void CommandList::SetShaderResources(ShaderStage stage, uint32_t slot, uint32_t count, RenderView* const* views)
+{
+    stats.commands++;
+    stats.bindings++;
+    DoSetShaderResources(stage, slot, count, views);
+}
+
+void CommandList::DrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex)
+{
+    stats.commands++;
+    stats.draws++;
+    stats.instances++;
+    DoDrawIndexed(indexCount, startIndex, baseVertex);
+}
+
+void CommandList::DrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance)
+{
+    stats.commands++;
+    stats.draws++;
+    stats.instances += instanceCount;
+    DoDrawIndexedInstanced(indexCount, instanceCount, startIndex, baseVertex, startInstance);
+}
+
+void CommandList::Dispatch(uint32_t x, uint32_t y, uint32_t z)
+{
+    stats.commands++;
+    stats.dispatches++;
+    DoDispatch(x, y, z);
+}
+
+RenderState* CommandList::CaptureState()
+{
+    return DoCaptureState();
+}
+
+void CommandList::ReleaseState(RenderState* state)
+{
+    if (state)
+    {
+        DoReleaseState(state);
+    }
+}
+
+void CommandList::SetState(RenderState* state)
+{
+    stats.commands++;
+    stats.bindings++;
+    DoSetState(state);
+}
+
+RecordedCommands* CommandList::Finish()
+{
+    return DoFinish();
+}
+
+void CommandList::Execute(RecordedCommands* recorded)
+{
+    stats.commands++;
+    stats.executes++;
+    DoExecute(recorded);
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <stdint.h>
+
+
+// Handles to backend objects. They are never defined: each backend casts them to its own types,
+// e.g. RenderBuffer to ID3D11Buffer.
+struct RenderBuffer;
+struct RenderView;
+struct RenderShader;
+struct RenderInputLayout;
+// Everything bound to a list at some point, to start others from.
+struct RenderState;
+// What a deferred list recorded, to be run by Execute.
+struct RecordedCommands;
+
+enum MapType
+{
+    MAP_WRITE_DISCARD,          // Contents are lost, so the GPU can keep reading the old ones.
+    MAP_WRITE_NO_OVERWRITE      // Contents are kept; the caller promises not to touch what the GPU reads.
+};
+
+enum BufferBinding
+{
+    BIND_VERTEX_BUFFER,
+    BIND_INDEX_BUFFER,
+    BIND_CONSTANT_BUFFER
+};
+
+enum IndexFormat
+{
+    INDEX_16,
+    INDEX_32
+};
+
+enum PrimitiveTopology
+{
+    TOPOLOGY_TRIANGLE_LIST
+};
+
+enum ShaderStage
+{
+    STAGE_VERTEX,
+    STAGE_PIXEL,
+    STAGE_COMPUTE
+};
+
+
+// What a command list has been asked to do, whatever the backend.
+struct CommandStats
+{
+    CommandStats();
+
+    uint32_t commands;      // Of every kind.
+    uint32_t maps;
+    uint64_t bytesUploaded; // As given to Map.
+    uint32_t bindings;      // Shaders, buffers, views, layouts and topology.
+    uint32_t draws;
+    uint32_t instances;     // Drawn by the draws.
+    uint32_t dispatches;
+    uint32_t executes;      // Of recorded commands, which are counted by the lists that recorded them.
+};
+
+
+// Creates the resources the engine writes from the CPU each frame.
+class CommandList;
+
+class RenderDevice
+{
+public:
+    virtual ~RenderDevice() { }
+
+    // Returns null on failure.
+    virtual RenderBuffer* CreateDynamicBuffer(uint32_t bytes, BufferBinding binding) = 0;
+    virtual void ReleaseBuffer(RenderBuffer* buffer) = 0;
+
+    // A list that records commands for Execute to run later, so it can be filled on another
+    // thread. Returns null on failure. The caller deletes it.
+    virtual CommandList* CreateDeferredCommandList() = 0;
+};
+
+
+// The operations the renderer records for a frame: mapping dynamic buffers, binding shaders and
+// buffers, and drawing. Each is counted, then passed to the backend.
+//
+// A list is used by one thread at a time. To record on several threads, capture the state of
+// the immediate list, start a deferred list on each thread from it, Finish them, and Execute
+// what they recorded on the immediate list, in the order it should run.
+class CommandList
+{
+public:
+    virtual ~CommandList() { }
+
+    // Maps the whole buffer, returning its start. bytes is how much the caller will write.
+    void* Map(RenderBuffer* buffer, MapType type, uint32_t bytes);
+    void Unmap(RenderBuffer* buffer);
+
+    void SetInputLayout(RenderInputLayout* layout);
+    void SetVertexBuffers(uint32_t slot, uint32_t count, RenderBuffer* const* buffers, uint32_t const* strides, uint32_t const* offsets);
+    void SetIndexBuffer(RenderBuffer* buffer, IndexFormat format, uint32_t offset);
+    void SetPrimitiveTopology(PrimitiveTopology topology);
+    void SetShader(ShaderStage stage, RenderShader* shader);
+    void SetConstantBuffers(ShaderStage stage, uint32_t slot, uint32_t count, RenderBuffer* const* buffers);
+    void SetShaderResources(ShaderStage stage, uint32_t slot, uint32_t count, RenderView* const* views);
+
+    void DrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex);
+    void DrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance);
+    void Dispatch(uint32_t x, uint32_t y, uint32_t z);
+
+    // Captures everything bound, e.g. the render targets and pixel shader a pass set up.
+    // Release it once the lists started from it are finished.
+    RenderState* CaptureState();
+    void ReleaseState(RenderState* state);
+    // Binds everything captured, e.g. first thing on a deferred list, which starts with nothing bound.
+    void SetState(RenderState* state);
+
+    // Ends recording on a deferred list, returning the commands, or null on failure. The list
+    // can then record again, from nothing bound.
+    RecordedCommands* Finish();
+    // Runs, then frees, what a deferred list recorded. What was bound to this list stays bound.
+    void Execute(RecordedCommands* recorded);
+
+    CommandStats const& Stats() const { return stats; }
+    void ResetStats() { stats = CommandStats(); }
+
+protected:
+    virtual void* DoMap(RenderBuffer* buffer, MapType type) = 0;
+    virtual void DoUnmap(RenderBuffer* buffer) = 0;
+    virtual void DoSetInputLayout(RenderInputLayout* layout) = 0;
+    virtual void DoSetVertexBuffers(uint32_t slot, uint32_t count, RenderBuffer* const* buffers, uint32_t const* strides, uint32_t const* offsets) = 0;
+    virtual void DoSetIndexBuffer(RenderBuffer* buffer, IndexFormat format, uint32_t offset) = 0;
+    virtual void DoSetPrimitiveTopology(PrimitiveTopology topology) = 0;
+    virtual void DoSetShader(ShaderStage stage, RenderShader* shader) = 0;
+    virtual void DoSetConstantBuffers(ShaderStage stage, uint32_t slot, uint32_t count, RenderBuffer* const* buffers) = 0;
+    virtual void DoSetShaderResources(ShaderStage stage, uint32_t slot, uint32_t count, RenderView* const* views) = 0;
+    virtual void DoDrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex) = 0;
+    virtual void DoDrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance) = 0;
+    virtual void DoDispatch(uint32_t x, uint32_t y, uint32_t z) = 0;
+    virtual RenderState* DoCaptureState() = 0;
+    virtual void DoReleaseState(RenderState* state) = 0;
+    virtual void DoSetState(RenderState* state) = 0;
+    virtual RecordedCommands* DoFinish() = 0;
+    virtual void DoExecute(RecordedCommands* recorded) = 0;
+
+private:
+    CommandStats stats;
+};
@@ -0,0 +1,326 @@
+#include "D3D11CommandList.h"
+
+
+static ID3D11Buffer* ToD3D11(RenderBuffer* buffer)
+{
+    return reinterpret_cast<ID3D11Buffer*>(buffer);
+}
+
+// D3D11 takes arrays of interfaces, which the handle arrays already are.
+static ID3D11Buffer* const* ToD3D11(RenderBuffer* const* buffers)
+{
+    return reinterpret_cast<ID3D11Buffer* const*>(buffers);
+}
+
+
+// How many of each kind of slot a captured state keeps. The shaders use fewer.
+static UINT const CapturedSlots = 16;
+
+// What a RenderState from a D3D11CommandList points to. Every interface holds a reference.
+struct D3D11State
+{
+    ID3D11InputLayout* inputLayout;
+    D3D11_PRIMITIVE_TOPOLOGY topology;
+
+    ID3D11VertexShader* vertexShader;
+    ID3D11Buffer* vertexConstantBuffers[CapturedSlots];
+    ID3D11ShaderResourceView* vertexResources[CapturedSlots];
+    ID3D11SamplerState* vertexSamplers[CapturedSlots];
+
+    ID3D11PixelShader* pixelShader;
+    ID3D11Buffer* pixelConstantBuffers[CapturedSlots];
+    ID3D11ShaderResourceView* pixelResources[CapturedSlots];
+    ID3D11SamplerState* pixelSamplers[CapturedSlots];
+
+    ID3D11RasterizerState* rasterizerState;
+    UINT viewportCount;
+    D3D11_VIEWPORT viewports[D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE];
+    UINT scissorCount;
+    D3D11_RECT scissors[D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE];
+
+    ID3D11RenderTargetView* renderTargets[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT];
+    ID3D11DepthStencilView* depthStencil;
+    ID3D11DepthStencilState* depthStencilState;
+    UINT stencilRef;
+    ID3D11BlendState* blendState;
+    FLOAT blendFactor[4];
+    UINT sampleMask;
+};
+
+template <typename T>
+static void ReleaseAll(T** interfaces, UINT count)
+{
+    for (UINT i = 0; i < count; i++)
+    {
+        if (interfaces[i])
+        {
+            interfaces[i]->Release();
+        }
+    }
+}
+
+
+D3D11RenderDevice::D3D11RenderDevice(ID3D11Device* device)
+    : device(device)
+{
+}
+
+RenderBuffer* D3D11RenderDevice::CreateDynamicBuffer(uint32_t bytes, BufferBinding binding)
+{
+    static UINT const bindFlags[] = { D3D11_BIND_VERTEX_BUFFER, D3D11_BIND_INDEX_BUFFER, D3D11_BIND_CONSTANT_BUFFER };
+    CD3D11_BUFFER_DESC desc(bytes, bindFlags[binding], D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
+    ID3D11Buffer* buffer = 0;
+
+    if (FAILED(device->CreateBuffer(&desc, 0, &buffer)))
+    {
+        return 0;
+    }
+    return ToRender(buffer);
+}
+
+void D3D11RenderDevice::ReleaseBuffer(RenderBuffer* buffer)
+{
+    if (buffer)
+    {
+        ToD3D11(buffer)->Release();
+    }
+}
+
+CommandList* D3D11RenderDevice::CreateDeferredCommandList()
+{
+    ID3D11DeviceContext* context = 0;
+
+    if (FAILED(device->CreateDeferredContext(0, &context)))
+    {
+        return 0;
+    }
+
+    CommandList* commands = new D3D11CommandList(context);
+
+    context->Release();
+    return commands;
+}
+
+bool D3D11RenderDevice::HasDriverCommandLists() const
+{
+    D3D11_FEATURE_DATA_THREADING threading;
+
+    if (FAILED(device->CheckFeatureSupport(D3D11_FEATURE_THREADING, &threading, sizeof(threading))))
+    {
+        return false;
+    }
+    return threading.DriverCommandLists != FALSE;
+}
+
+
+D3D11CommandList::D3D11CommandList(ID3D11DeviceContext* context)
+    : context(context)
+{
+    context->AddRef();
+}
+
+D3D11CommandList::~D3D11CommandList()
+{
+    context->Release();
+}
+
+void* D3D11CommandList::DoMap(RenderBuffer* buffer, MapType type)
+{
+    D3D11_MAPPED_SUBRESOURCE mapped;
+
+    if (FAILED(context->Map(ToD3D11(buffer), 0, type == MAP_WRITE_DISCARD ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE, 0, &mapped)))
+    {
+        return 0;
+    }
+    return mapped.pData;
+}
+
+void D3D11CommandList::DoUnmap(RenderBuffer* buffer)
+{
+    context->Unmap(ToD3D11(buffer), 0);
+}
+
+void D3D11CommandList::DoSetInputLayout(RenderInputLayout* layout)
+{
+    context->IASetInputLayout(reinterpret_cast<ID3D11InputLayout*>(layout));
+}
+
+void D3D11CommandList::DoSetVertexBuffers(uint32_t slot, uint32_t count, RenderBuffer* const* buffers, uint32_t const* strides, uint32_t const* offsets)
+{
+    context->IASetVertexBuffers(slot, count, ToD3D11(buffers), strides, offsets);
+}
+
+void D3D11CommandList::DoSetIndexBuffer(RenderBuffer* buffer, IndexFormat format, uint32_t offset)
+{
+    context->IASetIndexBuffer(ToD3D11(buffer), format == INDEX_16 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT, offset);
+}
+
+void D3D11CommandList::DoSetPrimitiveTopology(PrimitiveTopology topology)
+{
+    context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+}
+
+void D3D11CommandList::DoSetShader(ShaderStage stage, RenderShader* shader)
+{
+    switch (stage)
+    {
+    case STAGE_VERTEX:
+        context->VSSetShader(reinterpret_cast<ID3D11VertexShader*>(shader), 0, 0);
+        break;
+    case STAGE_PIXEL:
+        context->PSSetShader(reinterpret_cast<ID3D11PixelShader*>(shader), 0, 0);
+        break;
+    case STAGE_COMPUTE:
+        context->CSSetShader(reinterpret_cast<ID3D11ComputeShader*>(shader), 0, 0);
+        break;
+    }
+}
+
+void D3D11CommandList::DoSetConstantBuffers(ShaderStage stage, uint32_t slot, uint32_t count, RenderBuffer* const* buffers)
+{
+    switch (stage)
+    {
+    case STAGE_VERTEX:
+        context->VSSetConstantBuffers(slot, count, ToD3D11(buffers));
+        break;
+    case STAGE_PIXEL:
+        context->PSSetConstantBuffers(slot, count, ToD3D11(buffers));
+        break;
+    case STAGE_COMPUTE:
+        context->CSSetConstantBuffers(slot, count, ToD3D11(buffers));
+        break;
+    }
+}
+
+void D3D11CommandList::DoSetShaderResources(ShaderStage stage, uint32_t slot, uint32_t count, RenderView* const* views)
+{
+    ID3D11ShaderResourceView* const* d3dViews = reinterpret_cast<ID3D11ShaderResourceView* const*>(views);
+
+    switch (stage)
+    {
+    case STAGE_VERTEX:
+        context->VSSetShaderResources(slot, count, d3dViews);
+        break;
+    case STAGE_PIXEL:
+        context->PSSetShaderResources(slot, count, d3dViews);
+        break;
+    case STAGE_COMPUTE:
+        context->CSSetShaderResources(slot, count, d3dViews);
+        break;
+    }
+}
+
+void D3D11CommandList::DoDrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex)
+{
+    context->DrawIndexed(indexCount, startIndex, baseVertex);
+}
+
+void D3D11CommandList::DoDrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance)
+{
+    context->DrawIndexedInstanced(indexCount, instanceCount, startIndex, baseVertex, startInstance);
+}
+
+void D3D11CommandList::DoDispatch(uint32_t x, uint32_t y, uint32_t z)
+{
+    context->Dispatch(x, y, z);
+}
+
+RenderState* D3D11CommandList::DoCaptureState()
+{
+    D3D11State* state = new D3D11State();
+
+    context->IAGetInputLayout(&state->inputLayout);
+    context->IAGetPrimitiveTopology(&state->topology);
+
+    context->VSGetShader(&state->vertexShader, 0, 0);
+    context->VSGetConstantBuffers(0, CapturedSlots, state->vertexConstantBuffers);
+    context->VSGetShaderResources(0, CapturedSlots, state->vertexResources);
+    context->VSGetSamplers(0, CapturedSlots, state->vertexSamplers);
+
+    context->PSGetShader(&state->pixelShader, 0, 0);
+    context->PSGetConstantBuffers(0, CapturedSlots, state->pixelConstantBuffers);
+    context->PSGetShaderResources(0, CapturedSlots, state->pixelResources);
+    context->PSGetSamplers(0, CapturedSlots, state->pixelSamplers);
+
+    context->RSGetState(&state->rasterizerState);
+    state->viewportCount = D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE;
+    context->RSGetViewports(&state->viewportCount, state->viewports);
+    state->scissorCount = D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE;
+    context->RSGetScissorRects(&state->scissorCount, state->scissors);
+
+    context->OMGetRenderTargets(D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, state->renderTargets, &state->depthStencil);
+    context->OMGetDepthStencilState(&state->depthStencilState, &state->stencilRef);
+    context->OMGetBlendState(&state->blendState, state->blendFactor, &state->sampleMask);
+
+    return reinterpret_cast<RenderState*>(state);
+}
+
+void D3D11CommandList::DoReleaseState(RenderState* captured)
+{
+    D3D11State* state = reinterpret_cast<D3D11State*>(captured);
+
+    ReleaseAll(&state->inputLayout, 1);
+    ReleaseAll(&state->vertexShader, 1);
+    ReleaseAll(state->vertexConstantBuffers, CapturedSlots);
+    ReleaseAll(state->vertexResources, CapturedSlots);
+    ReleaseAll(state->vertexSamplers, CapturedSlots);
+    ReleaseAll(&state->pixelShader, 1);
+    ReleaseAll(state->pixelConstantBuffers, CapturedSlots);
+    ReleaseAll(state->pixelResources, CapturedSlots);
+    ReleaseAll(state->pixelSamplers, CapturedSlots);
+    ReleaseAll(&state->rasterizerState, 1);
+    ReleaseAll(state->renderTargets, D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT);
+    ReleaseAll(&state->depthStencil, 1);
+    ReleaseAll(&state->depthStencilState, 1);
+    ReleaseAll(&state->blendState, 1);
+    delete state;
+}
+
+void D3D11CommandList::DoSetState(RenderState* captured)
+{
+    D3D11State const* state = reinterpret_cast<D3D11State const*>(captured);
+
+    context->IASetInputLayout(state->inputLayout);
+    context->IASetPrimitiveTopology(state->topology);
+
+    context->VSSetShader(state->vertexShader, 0, 0);
+    context->VSSetConstantBuffers(0, CapturedSlots, state->vertexConstantBuffers);
+    context->VSSetShaderResources(0, CapturedSlots, state->vertexResources);
+    context->VSSetSamplers(0, CapturedSlots, state->vertexSamplers);
+
+    context->PSSetShader(state->pixelShader, 0, 0);
+    context->PSSetConstantBuffers(0, CapturedSlots, state->pixelConstantBuffers);
+    context->PSSetShaderResources(0, CapturedSlots, state->pixelResources);
+    context->PSSetSamplers(0, CapturedSlots, state->pixelSamplers);
+
+    context->RSSetState(state->rasterizerState);
+    context->RSSetViewports(state->viewportCount, state->viewports);
+    context->RSSetScissorRects(state->scissorCount, state->scissors);
+
+    context->OMSetRenderTargets(D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, state->renderTargets, state->depthStencil);
+    context->OMSetDepthStencilState(state->depthStencilState, state->stencilRef);
+    context->OMSetBlendState(state->blendState, state->blendFactor, state->sampleMask);
+}
+
+RecordedCommands* D3D11CommandList::DoFinish()
+{
+    ID3D11CommandList* recorded = 0;
+
+    // Start the next recording from nothing bound, rather than what this one left.
+    if (FAILED(context->FinishCommandList(FALSE, &recorded)))
+    {
+        return 0;
+    }
+    return reinterpret_cast<RecordedCommands*>(recorded);
+}
+
+void D3D11CommandList::DoExecute(RecordedCommands* recorded)
+{
+    ID3D11CommandList* commands = reinterpret_cast<ID3D11CommandList*>(recorded);
+
+    if (commands)
+    {
+        context->ExecuteCommandList(commands, TRUE);
+        commands->Release();
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <d3d11.h>
+
+#include "CommandList.h"
+
+
+// The handle types are the D3D11 interfaces themselves, so these are casts.
+inline RenderBuffer* ToRender(ID3D11Buffer* buffer) { return reinterpret_cast<RenderBuffer*>(buffer); }
+inline RenderView* ToRender(ID3D11ShaderResourceView* view) { return reinterpret_cast<RenderView*>(view); }
+inline RenderShader* ToRender(ID3D11VertexShader* shader) { return reinterpret_cast<RenderShader*>(shader); }
+inline RenderShader* ToRender(ID3D11PixelShader* shader) { return reinterpret_cast<RenderShader*>(shader); }
+inline RenderShader* ToRender(ID3D11ComputeShader* shader) { return reinterpret_cast<RenderShader*>(shader); }
+inline RenderInputLayout* ToRender(ID3D11InputLayout* layout) { return reinterpret_cast<RenderInputLayout*>(layout); }
+
+
+// Creates buffers on a D3D11 device, which must outlive it.
+class D3D11RenderDevice : public RenderDevice
+{
+public:
+    explicit D3D11RenderDevice(ID3D11Device* device);
+
+    RenderBuffer* CreateDynamicBuffer(uint32_t bytes, BufferBinding binding);
+    void ReleaseBuffer(RenderBuffer* buffer);
+    // Records on a deferred context.
+    CommandList* CreateDeferredCommandList();
+
+    ID3D11Device* Device() const { return device; }
+    // Whether the driver records deferred contexts itself. If not, the runtime does, and
+    // recording on several threads gains much less.
+    bool HasDriverCommandLists() const;
+
+private:
+    ID3D11Device* device;
+};
+
+
+// Passes commands straight to a D3D11 device context, immediate or deferred. Captured states
+// hold what the vertex and pixel shader stages, input assembler, rasterizer and output merger
+// have bound, which is all the scene passes use.
+class D3D11CommandList : public CommandList
+{
+public:
+    explicit D3D11CommandList(ID3D11DeviceContext* context);
+    ~D3D11CommandList();
+
+    // For code that still talks to D3D11 directly.
+    ID3D11DeviceContext* Context() const { return context; }
+
+protected:
+    void* DoMap(RenderBuffer* buffer, MapType type);
+    void DoUnmap(RenderBuffer* buffer);
+    void DoSetInputLayout(RenderInputLayout* layout);
+    void DoSetVertexBuffers(uint32_t slot, uint32_t count, RenderBuffer* const* buffers, uint32_t const* strides, uint32_t const* offsets);
+    void DoSetIndexBuffer(RenderBuffer* buffer, IndexFormat format, uint32_t offset);
+    void DoSetPrimitiveTopology(PrimitiveTopology topology);
+    void DoSetShader(ShaderStage stage, RenderShader* shader);
+    void DoSetConstantBuffers(ShaderStage stage, uint32_t slot, uint32_t count, RenderBuffer* const* buffers);
+    void DoSetShaderResources(ShaderStage stage, uint32_t slot, uint32_t count, RenderView* const* views);
+    void DoDrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex);
+    void DoDrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance);
+    void DoDispatch(uint32_t x, uint32_t y, uint32_t z);
+    RenderState* DoCaptureState();
+    void DoReleaseState(RenderState* state);
+    void DoSetState(RenderState* state);
+    RecordedCommands* DoFinish();
+    void DoExecute(RecordedCommands* recorded);
+
+private:
+    // Not implemented
+    D3D11CommandList(D3D11CommandList const&);
+    D3D11CommandList& operator=(D3D11CommandList const&);
+
+    ID3D11DeviceContext* context;
+};
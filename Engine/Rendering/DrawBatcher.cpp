@@ -0,0 +1,422 @@
+#include "DrawBatcher.h"
+
+#include <algorithm>
+#include <functional>
+
+#include "../Scene/WorkerPool.h"
+
+
+DrawMesh::DrawMesh()
+    : vertexBuffer(0), vertexStride(0), indexBuffer(0), indexFormat(INDEX_16), indexCount(0), texture(0), positionScale(1.0f)
+{
+    positionOffset[0] = positionOffset[1] = positionOffset[2] = 0.0f;
+}
+
+
+DrawBatcher::DrawBatcher(RenderDevice& device)
+    : device(device), batching(true)
+{
+}
+
+DrawBatcher::~DrawBatcher()
+{
+}
+
+void DrawBatcher::Clear()
+{
+    customs.clear();
+    meshes.clear();
+}
+
+void DrawBatcher::Add(DrawMesh const* mesh, uint32_t object)
+{
+    Item item;
+
+    item.material = mesh->texture;
+    item.buffers = mesh->vertexBuffer;
+    item.mesh = mesh;
+    item.custom = 0;
+    item.object = object;
+    meshes.push_back(item);
+}
+
+void DrawBatcher::Add(CustomDraw* custom, void const* key, uint32_t object)
+{
+    Item item;
+
+    item.material = key;
+    item.buffers = key;
+    item.mesh = 0;
+    item.custom = custom;
+    item.object = object;
+    customs.push_back(item);
+}
+
+void DrawBatcher::Record(CommandList& commands, Matrix4 const* worlds, DrawPass const& pass)
+{
+    uint32_t first = 0;
+
+    if (!Prepare(commands, worlds, pass, 0, &first))
+    {
+        return;
+    }
+
+    RecordCustoms(commands, worlds, pass, first, 0, (uint32_t)customs.size(), &stats);
+    RecordMeshes(commands, worlds, pass, first + (uint32_t)customs.size(), 0, (uint32_t)meshes.size(), &stats);
+
+    // Leave nothing bound to the ring, which later passes map again.
+    RenderBuffer* none = 0;
+    uint32_t zero = 0;
+
+    commands.SetVertexBuffers(pass.objectSlot, 1, &none, &zero, &zero);
+}
+
+void DrawBatcher::Record(CommandList& commands, Matrix4 const* worlds, DrawPass const& pass, WorkerPool* pool, vector<CommandList*> const& deferred)
+{
+    uint32_t first = 0;
+
+    // Without batching, every object maps the ring for itself, which only one list can do at a time.
+    if (!batching || !pool || deferred.size() < 2)
+    {
+        Record(commands, worlds, pass);
+        return;
+    }
+    if (!Prepare(commands, worlds, pass, pool, &first))
+    {
+        return;
+    }
+
+    // Each chunk is a run of whole draws, so every list draws as many instances at once as Record would.
+    FindDraws();
+
+    uint32_t customCount = (uint32_t)customs.size();
+    uint32_t drawCount = (uint32_t)drawStarts.size() - 1;
+    uint32_t chunkCount = drawCount < deferred.size() ? drawCount : (uint32_t)deferred.size();
+    RenderState* state = commands.CaptureState();
+
+    chunkStats.assign(chunkCount, BatchStats());
+    recorded.assign(chunkCount, (RecordedCommands*)0);
+
+    pool->Run(chunkCount, [&](uint32_t chunk)
+    {
+        CommandList& list = *deferred[chunk];
+        uint32_t begin = drawStarts[(uint64_t)drawCount * chunk / chunkCount];
+        uint32_t end = drawStarts[(uint64_t)drawCount * (chunk + 1) / chunkCount];
+
+        // Deferred lists start with nothing bound, so start from what the caller bound.
+        list.SetState(state);
+        RecordCustoms(list, worlds, pass, first, begin < customCount ? begin : customCount, end < customCount ? end : customCount, &chunkStats[chunk]);
+        RecordMeshes(list, worlds, pass, first + customCount, begin > customCount ? begin - customCount : 0, end > customCount ? end - customCount : 0, &chunkStats[chunk]);
+        recorded[chunk] = list.Finish();
+    });
+
+    commands.ReleaseState(state);
+
+    // Run them in the order they would have been recorded. Each leaves the caller's state as it was.
+    for (uint32_t i = 0; i < chunkCount; i++)
+    {
+        commands.Execute(recorded[i]);
+        stats.objects += chunkStats[i].objects;
+        stats.draws += chunkStats[i].draws;
+    }
+}
+
+bool DrawBatcher::Prepare(CommandList& commands, Matrix4 const* worlds, DrawPass const& pass, WorkerPool* pool, uint32_t* first)
+{
+    uint32_t count = (uint32_t)(customs.size() + meshes.size());
+
+    if (count == 0)
+    {
+        return false;
+    }
+    ReserveRing(count);
+
+    if (!batching)
+    {
+        return true;
+    }
+
+    // Write every object's transforms at once, after what earlier passes wrote.
+    Sort(&customs);
+    Sort(&meshes);
+
+    ObjectConstants* constants = static_cast<ObjectConstants*>(ring->Map(commands, count, first));
+
+    if (!constants)
+    {
+        return false;
+    }
+
+    uint32_t taskCount = pool ? (count + ObjectsPerTask - 1) / ObjectsPerTask : 1;
+    function<void(uint32_t)> write = [&](uint32_t task)
+    {
+        uint32_t begin = pool ? task * ObjectsPerTask : 0;
+        uint32_t end = pool && begin + ObjectsPerTask < count ? begin + ObjectsPerTask : count;
+
+        for (uint32_t i = begin; i < end; i++)
+        {
+            Item const& item = i < customs.size() ? customs[i] : meshes[i - customs.size()];
+
+            ComputeObjectConstants(item, worlds, pass, &constants[i]);
+        }
+    };
+
+    if (pool)
+    {
+        pool->Run(taskCount, write);
+    }
+    else
+    {
+        write(0);
+    }
+    ring->Unmap(commands);
+    return true;
+}
+
+void DrawBatcher::FindDraws()
+{
+    uint32_t customCount = (uint32_t)customs.size();
+
+    drawStarts.clear();
+    for (uint32_t i = 0; i < customCount; i++)
+    {
+        drawStarts.push_back(i);
+    }
+    for (uint32_t i = 0; i < meshes.size(); i++)
+    {
+        if (i == 0 || meshes[i].mesh != meshes[i - 1].mesh)
+        {
+            drawStarts.push_back(customCount + i);
+        }
+    }
+    drawStarts.push_back(customCount + (uint32_t)meshes.size());
+}
+
+void DrawBatcher::RecordCustoms(CommandList& commands, Matrix4 const* worlds, DrawPass const& pass, uint32_t firstElement,
+    uint32_t begin, uint32_t end, BatchStats* recordStats)
+{
+    // Custom draws read their one object from the start of the slot, so are bound at its offset.
+    for (uint32_t i = begin; i < end; i++)
+    {
+        uint32_t element = firstElement + i;
+
+        if (!batching && !MapObject(commands, customs[i], worlds, pass, &element))
+        {
+            continue;
+        }
+        BindObjects(commands, pass, element);
+        recordStats->draws += customs[i].custom->Draw(commands, customs[i].object);
+        recordStats->objects++;
+    }
+}
+
+void DrawBatcher::RecordMeshes(CommandList& commands, Matrix4 const* worlds, DrawPass const& pass, uint32_t firstElement,
+    uint32_t begin, uint32_t end, BatchStats* recordStats)
+{
+    RenderBuffer const* currentVertexBuffer = 0;
+    RenderBuffer const* currentIndexBuffer = 0;
+    RenderView const* currentTexture = 0;
+    bool objectsBound = false;
+    uint32_t run;
+
+    if (begin >= end)
+    {
+        return;
+    }
+    commands.SetInputLayout(pass.meshLayout);
+    commands.SetShader(STAGE_VERTEX, pass.meshVertexShader);
+    commands.SetPrimitiveTopology(TOPOLOGY_TRIANGLE_LIST);
+
+    for (uint32_t i = begin; i < end; i += run)
+    {
+        DrawMesh const& mesh = *meshes[i].mesh;
+        uint32_t element = firstElement + i;
+
+        // The sort put objects sharing a mesh next to each other, with their transforms one after
+        // another in the ring, so they are drawn as instances starting at the first.
+        run = 1;
+        if (batching)
+        {
+            while (i + run < end && meshes[i + run].mesh == meshes[i].mesh)
+            {
+                run++;
+            }
+        }
+        else if (!MapObject(commands, meshes[i], worlds, pass, &element))
+        {
+            continue;
+        }
+
+        // The slot is bound at the ring's start, and each draw's start instance picks its elements.
+        if (!batching || !objectsBound)
+        {
+            BindObjects(commands, pass, 0);
+            objectsBound = true;
+        }
+
+        // Only set the state that differs from the draw before.
+        if (!batching || mesh.vertexBuffer != currentVertexBuffer)
+        {
+            uint32_t offset = 0;
+
+            commands.SetVertexBuffers(0, 1, &mesh.vertexBuffer, &mesh.vertexStride, &offset);
+            currentVertexBuffer = mesh.vertexBuffer;
+        }
+        if (!batching || mesh.indexBuffer != currentIndexBuffer)
+        {
+            commands.SetIndexBuffer(mesh.indexBuffer, mesh.indexFormat, 0);
+            currentIndexBuffer = mesh.indexBuffer;
+        }
+        if (!batching)
+        {
+            commands.SetPrimitiveTopology(TOPOLOGY_TRIANGLE_LIST);
+        }
+        if (mesh.texture && (!batching || mesh.texture != currentTexture))
+        {
+            commands.SetShaderResources(STAGE_PIXEL, pass.diffuseSlot, 1, &mesh.texture);
+            currentTexture = mesh.texture;
+        }
+
+        commands.DrawIndexedInstanced(mesh.indexCount, run, 0, 0, element);
+        recordStats->draws++;
+        recordStats->objects += run;
+    }
+}
+
+void DrawBatcher::ReserveRing(uint32_t count)
+{
+    if (!ring || ring->Elements() < count)
+    {
+        uint32_t elements = count * PassesPerRing;
+
+        ring.reset();
+        ring.reset(new UploadRing(device, sizeof(ObjectConstants), elements < MinRingElements ? MinRingElements : elements));
+    }
+}
+
+// There are far fewer meshes than objects, so rather than sort every item, this sorts the
+// meshes and moves each item straight to its mesh's place, keeping the order they were added in.
+void DrawBatcher::Sort(vector<Item>* items)
+{
+    void const* lastKey = 0;
+    uint32_t lastState = 0;
+
+    stateOf.clear();
+    states.clear();
+
+    for (size_t i = 0; i < items->size(); i++)
+    {
+        Item& item = (*items)[i];
+        void const* key = item.mesh ? static_cast<void const*>(item.mesh) : item.buffers;
+
+        // Objects often come in runs of the same mesh, which saves the lookup.
+        if (key != lastKey || states.empty())
+        {
+            unordered_map<void const*, uint32_t>::iterator found = stateOf.find(key);
+
+            if (found == stateOf.end())
+            {
+                State state = { &item, 0, 0 };
+
+                found = stateOf.insert(make_pair(key, (uint32_t)states.size())).first;
+                states.push_back(state);
+            }
+            lastKey = key;
+            lastState = found->second;
+        }
+        item.state = lastState;
+        states[lastState].count++;
+    }
+
+    StateOrder order = { &states };
+    uint32_t start = 0;
+
+    stateOrder.resize(states.size());
+    for (uint32_t i = 0; i < stateOrder.size(); i++)
+    {
+        stateOrder[i] = i;
+    }
+    sort(stateOrder.begin(), stateOrder.end(), order);
+    for (uint32_t i = 0; i < stateOrder.size(); i++)
+    {
+        states[stateOrder[i]].start = start;
+        start += states[stateOrder[i]].count;
+    }
+
+    sorted.resize(items->size());
+    for (size_t i = 0; i < items->size(); i++)
+    {
+        sorted[states[(*items)[i].state].start++] = (*items)[i];
+    }
+    items->swap(sorted);
+}
+
+void DrawBatcher::ComputeObjectConstants(Item const& item, Matrix4 const* worlds, DrawPass const& pass, ObjectConstants* constants)
+{
+    Matrix4 const& objectWorld = worlds[item.object];
+    Matrix4 world;
+
+    if (item.mesh)
+    {
+        // Scaling then offsetting the positions, in front of the world matrix, scales its first
+        // three rows and adds the offset's combination of them to the last.
+        float scale = item.mesh->positionScale;
+        float const* offset = item.mesh->positionOffset;
+
+        for (int i = 0; i < 3; i++)
+        {
+            for (int j = 0; j < 4; j++)
+            {
+                world.m[i][j] = scale * objectWorld.m[i][j];
+            }
+        }
+        for (int j = 0; j < 4; j++)
+        {
+            world.m[3][j] = offset[0] * objectWorld.m[0][j] + offset[1] * objectWorld.m[1][j] + offset[2] * objectWorld.m[2][j] + objectWorld.m[3][j];
+        }
+    }
+    else
+    {
+        world = objectWorld;
+    }
+
+    MatrixMultiply(&constants->worldViewProj, world, pass.viewProj);
+    MatrixMultiply(&constants->worldView, world, pass.view);
+}
+
+bool DrawBatcher::MapObject(CommandList& commands, Item const& item, Matrix4 const* worlds, DrawPass const& pass, uint32_t* element)
+{
+    ObjectConstants* constants = static_cast<ObjectConstants*>(ring->MapDiscard(commands, 1, element));
+
+    if (!constants)
+    {
+        return false;
+    }
+    ComputeObjectConstants(item, worlds, pass, constants);
+    ring->Unmap(commands);
+    return true;
+}
+
+void DrawBatcher::BindObjects(CommandList& commands, DrawPass const& pass, uint32_t element)
+{
+    RenderBuffer* buffer = ring->Buffer();
+    uint32_t stride = sizeof(ObjectConstants);
+    uint32_t offset = element * stride;
+
+    commands.SetVertexBuffers(pass.objectSlot, 1, &buffer, &stride, &offset);
+}
+
+bool DrawBatcher::Item::operator<(Item const& other) const
+{
+    less<void const*> before;
+
+    if (material != other.material)
+    {
+        return before(material, other.material);
+    }
+    if (buffers != other.buffers)
+    {
+        return before(buffers, other.buffers);
+    }
+    return before(mesh, other.mesh);
+}
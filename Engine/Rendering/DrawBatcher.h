@@ -0,0 +1,178 @@
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "../Scene/SceneMath.h"
+#include "CommandList.h"
+#include "UploadRing.h"
+
+using namespace std;
+
+class WorkerPool;
+
+
+// Transforms for one object, fed to the vertex shader per instance.
+// NOTE: Must match ObjectVSIn in Rendering.hlsl
+struct ObjectConstants
+{
+    Matrix4 worldViewProj;
+    Matrix4 worldView;
+};
+
+
+// A mesh the batcher can draw itself: one vertex and index buffer, and an optional texture.
+struct DrawMesh
+{
+    DrawMesh();
+
+    RenderBuffer* vertexBuffer;
+    uint32_t vertexStride;
+    RenderBuffer* indexBuffer;
+    IndexFormat indexFormat;
+    uint32_t indexCount;
+    RenderView* texture;        // Null for none.
+
+    // Positions are scaled by positionScale then offset by positionOffset, in front of the
+    // object's world matrix, e.g. to undo quantization.
+    float positionScale;
+    float positionOffset[3];
+};
+
+
+// Draws what the batcher can't draw itself, e.g. a DXUT mesh, with the object's transforms bound.
+class CustomDraw
+{
+public:
+    virtual ~CustomDraw() { }
+
+    // Returns how many draws were issued.
+    virtual uint32_t Draw(CommandList& commands, uint32_t object) = 0;
+};
+
+
+// What Record needs to know besides the draws.
+struct DrawPass
+{
+    Matrix4 view;
+    Matrix4 viewProj;
+    RenderInputLayout* meshLayout;      // Bound for DrawMesh draws, after any custom draws.
+    RenderShader* meshVertexShader;
+    uint32_t diffuseSlot;               // Pixel shader slot for DrawMesh textures.
+    uint32_t objectSlot;                // Vertex buffer slot the layouts read ObjectConstants from, per instance.
+};
+
+
+struct BatchStats
+{
+    BatchStats() : objects(0), draws(0) { }
+
+    uint32_t objects;
+    uint32_t draws;     // Including those custom draws report.
+};
+
+
+// Records the draws for a list of objects. With batching, draws are sorted by texture and
+// vertex buffer, every object's ObjectConstants are written with a single map of a ring
+// buffer, and objects sharing a DrawMesh are drawn as instances of one draw. Without it,
+// each object maps and binds everything for itself, for comparison.
+class DrawBatcher
+{
+public:
+    explicit DrawBatcher(RenderDevice& device);
+    ~DrawBatcher();
+
+    void SetBatching(bool enabled) { batching = enabled; }
+    bool Batching() const { return batching; }
+
+    // Objects are indices into the world transforms passed to Record.
+    void Clear();
+    void Add(DrawMesh const* mesh, uint32_t object);
+    // Custom draws with the same key are kept together.
+    void Add(CustomDraw* custom, void const* key, uint32_t object);
+
+    // Records the draws added since Clear: custom draws first, with whatever the caller bound,
+    // then DrawMesh draws with the pass's layout and vertex shader.
+    void Record(CommandList& commands, Matrix4 const* worlds, DrawPass const& pass);
+    // As Record, but writes the transforms on every thread of the pool, and records the draws in
+    // chunks, one on each deferred list, then executes them on commands in order. The pool is
+    // only used from this thread. Falls back to Record without batching or fewer than two lists.
+    void Record(CommandList& commands, Matrix4 const* worlds, DrawPass const& pass, WorkerPool* pool, vector<CommandList*> const& deferred);
+
+    BatchStats const& Stats() const { return stats; }
+    void ResetStats() { stats = BatchStats(); }
+
+private:
+    // Not implemented
+    DrawBatcher(DrawBatcher const&);
+    DrawBatcher& operator=(DrawBatcher const&);
+
+    struct Item
+    {
+        void const* material;
+        void const* buffers;
+        DrawMesh const* mesh;
+        CustomDraw* custom;
+        uint32_t object;
+        uint32_t state;     // Index into states, while sorting.
+
+        bool operator<(Item const& other) const;
+    };
+
+    // The items sharing one mesh, or one custom draw key.
+    struct State
+    {
+        Item const* first;
+        uint32_t count;
+        uint32_t start;     // In the sorted items.
+    };
+
+    struct StateOrder
+    {
+        vector<State> const* states;
+
+        bool operator()(uint32_t a, uint32_t b) const { return *(*states)[a].first < *(*states)[b].first; }
+    };
+
+    void ReserveRing(uint32_t count);
+    // Sorts the items and, when batching, writes their transforms. Sets first to the element of
+    // the first item. Returns false if there is nothing to draw.
+    bool Prepare(CommandList& commands, Matrix4 const* worlds, DrawPass const& pass, WorkerPool* pool, uint32_t* first);
+    void Sort(vector<Item>* items);
+    // Sets drawStarts to where each draw starts, counting custom draws then meshes.
+    void FindDraws();
+    void ComputeObjectConstants(Item const& item, Matrix4 const* worlds, DrawPass const& pass, ObjectConstants* constants);
+    // Maps the transforms of a single object, when not batching.
+    bool MapObject(CommandList& commands, Item const& item, Matrix4 const* worlds, DrawPass const& pass, uint32_t* element);
+    void BindObjects(CommandList& commands, DrawPass const& pass, uint32_t element);
+    // Record the items from begin to end. firstElement is the ring element of the list's first item.
+    void RecordCustoms(CommandList& commands, Matrix4 const* worlds, DrawPass const& pass, uint32_t firstElement,
+        uint32_t begin, uint32_t end, BatchStats* recordStats);
+    void RecordMeshes(CommandList& commands, Matrix4 const* worlds, DrawPass const& pass, uint32_t firstElement,
+        uint32_t begin, uint32_t end, BatchStats* recordStats);
+
+    // Smallest ring of object constants. It is sized for a few passes before it has to wrap.
+    static uint32_t const MinRingElements = 4096;
+    static uint32_t const PassesPerRing = 4;
+    // Transforms each thread writes at a time.
+    static uint32_t const ObjectsPerTask = 1024;
+
+    RenderDevice& device;
+    unique_ptr<UploadRing> ring;
+    vector<Item> customs;
+    vector<Item> meshes;
+    bool batching;
+
+    // Reused by Sort.
+    unordered_map<void const*, uint32_t> stateOf;
+    vector<State> states;
+    vector<uint32_t> stateOrder;
+    vector<Item> sorted;
+
+    // Reused by the parallel Record.
+    vector<uint32_t> drawStarts;
+    vector<BatchStats> chunkStats;
+    vector<RecordedCommands*> recorded;
+    BatchStats stats;
+};
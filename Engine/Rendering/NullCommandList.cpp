@@ -0,0 +1,201 @@
+#include "NullCommandList.h"
+
+#include <stdexcept>
+
+
+// What a RenderBuffer from a NullRenderDevice points to. Data is 16 byte aligned, as mapped
+// D3D11 buffers are, so it can be written with aligned SSE stores.
+struct NullBuffer
+{
+    vector<uint8_t> storage;
+    uint8_t* data;
+    uint32_t size;
+    BufferBinding binding;
+};
+
+static NullBuffer* ToNull(RenderBuffer* buffer)
+{
+    return reinterpret_cast<NullBuffer*>(buffer);
+}
+
+// A captured state only needs to be told apart from others.
+struct NullState
+{
+    NullCommandList const* from;
+};
+
+static vector<RecordedCommand>* ToNull(RecordedCommands* recorded)
+{
+    return reinterpret_cast<vector<RecordedCommand>*>(recorded);
+}
+
+
+NullRenderDevice::NullRenderDevice()
+    : liveBuffers(0)
+{
+}
+
+NullRenderDevice::~NullRenderDevice()
+{
+}
+
+RenderBuffer* NullRenderDevice::CreateDynamicBuffer(uint32_t bytes, BufferBinding binding)
+{
+    NullBuffer* buffer = new NullBuffer();
+
+    buffer->storage.resize(bytes + 15);
+    buffer->data = &buffer->storage[0] + (-(intptr_t)&buffer->storage[0] & 15);
+    buffer->size = bytes;
+    buffer->binding = binding;
+    liveBuffers++;
+    return reinterpret_cast<RenderBuffer*>(buffer);
+}
+
+void NullRenderDevice::ReleaseBuffer(RenderBuffer* buffer)
+{
+    if (buffer)
+    {
+        delete ToNull(buffer);
+        liveBuffers--;
+    }
+}
+
+CommandList* NullRenderDevice::CreateDeferredCommandList()
+{
+    return new NullCommandList(true);
+}
+
+uint8_t const* NullRenderDevice::Contents(RenderBuffer* buffer)
+{
+    return ToNull(buffer)->data;
+}
+
+uint32_t NullRenderDevice::Size(RenderBuffer* buffer)
+{
+    return ToNull(buffer)->size;
+}
+
+
+NullCommandList::NullCommandList(bool record)
+    : record(record)
+{
+}
+
+void* NullCommandList::DoMap(RenderBuffer* buffer, MapType type)
+{
+    Record(RecordedCommand::MAP, buffer, type);
+    if (!buffer)
+    {
+        throw invalid_argument("Only buffers from a NullRenderDevice can be mapped.");
+    }
+    return ToNull(buffer)->data;
+}
+
+void NullCommandList::DoUnmap(RenderBuffer* buffer)
+{
+    Record(RecordedCommand::UNMAP, buffer);
+}
+
+void NullCommandList::DoSetInputLayout(RenderInputLayout* layout)
+{
+    Record(RecordedCommand::SET_INPUT_LAYOUT, layout);
+}
+
+void NullCommandList::DoSetVertexBuffers(uint32_t slot, uint32_t count, RenderBuffer* const* buffers, uint32_t const* strides, uint32_t const* offsets)
+{
+    Record(RecordedCommand::SET_VERTEX_BUFFERS, count ? buffers[0] : 0, slot, count, count ? strides[0] : 0, count ? offsets[0] : 0);
+}
+
+void NullCommandList::DoSetIndexBuffer(RenderBuffer* buffer, IndexFormat format, uint32_t offset)
+{
+    Record(RecordedCommand::SET_INDEX_BUFFER, buffer, format, offset);
+}
+
+void NullCommandList::DoSetPrimitiveTopology(PrimitiveTopology topology)
+{
+    Record(RecordedCommand::SET_PRIMITIVE_TOPOLOGY, 0, topology);
+}
+
+void NullCommandList::DoSetShader(ShaderStage stage, RenderShader* shader)
+{
+    Record(RecordedCommand::SET_SHADER, shader, stage);
+}
+
+void NullCommandList::DoSetConstantBuffers(ShaderStage stage, uint32_t slot, uint32_t count, RenderBuffer* const* buffers)
+{
+    Record(RecordedCommand::SET_CONSTANT_BUFFERS, count ? buffers[0] : 0, stage, slot, count);
+}
+
+void NullCommandList::DoSetShaderResources(ShaderStage stage, uint32_t slot, uint32_t count, RenderView* const* views)
+{
+    Record(RecordedCommand::SET_SHADER_RESOURCES, count ? views[0] : 0, stage, slot, count);
+}
+
+void NullCommandList::DoDrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex)
+{
+    Record(RecordedCommand::DRAW_INDEXED, 0, indexCount, startIndex, (uint32_t)baseVertex);
+}
+
+void NullCommandList::DoDrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance)
+{
+    Record(RecordedCommand::DRAW_INDEXED_INSTANCED, 0, indexCount, instanceCount, startIndex, (uint32_t)baseVertex, startInstance);
+}
+
+void NullCommandList::DoDispatch(uint32_t x, uint32_t y, uint32_t z)
+{
+    Record(RecordedCommand::DISPATCH, 0, x, y, z);
+}
+
+RenderState* NullCommandList::DoCaptureState()
+{
+    NullState* state = new NullState();
+
+    state->from = this;
+    return reinterpret_cast<RenderState*>(state);
+}
+
+void NullCommandList::DoReleaseState(RenderState* state)
+{
+    delete reinterpret_cast<NullState*>(state);
+}
+
+void NullCommandList::DoSetState(RenderState* state)
+{
+    Record(RecordedCommand::SET_STATE, state);
+}
+
+RecordedCommands* NullCommandList::DoFinish()
+{
+    vector<RecordedCommand>* recorded = new vector<RecordedCommand>();
+
+    recorded->swap(commands);
+    return reinterpret_cast<RecordedCommands*>(recorded);
+}
+
+void NullCommandList::DoExecute(RecordedCommands* recorded)
+{
+    Record(RecordedCommand::EXECUTE, recorded, recorded ? (uint32_t)ToNull(recorded)->size() : 0);
+    if (record && recorded)
+    {
+        commands.insert(commands.end(), ToNull(recorded)->begin(), ToNull(recorded)->end());
+    }
+    delete ToNull(recorded);
+}
+
+void NullCommandList::Record(RecordedCommand::Kind kind, void const* object, uint32_t a, uint32_t b, uint32_t c, uint32_t d, uint32_t e)
+{
+    if (!record)
+    {
+        return;
+    }
+
+    RecordedCommand command;
+    command.kind = kind;
+    command.object = object;
+    command.args[0] = a;
+    command.args[1] = b;
+    command.args[2] = c;
+    command.args[3] = d;
+    command.args[4] = e;
+    commands.push_back(command);
+}
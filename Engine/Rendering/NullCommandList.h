@@ -0,0 +1,95 @@
+#pragma once
+
+#include <vector>
+
+#include "CommandList.h"
+
+using namespace std;
+
+
+// Keeps dynamic buffers in system memory, so frames can be recorded without a GPU.
+class NullRenderDevice : public RenderDevice
+{
+public:
+    NullRenderDevice();
+    ~NullRenderDevice();
+
+    RenderBuffer* CreateDynamicBuffer(uint32_t bytes, BufferBinding binding);
+    void ReleaseBuffer(RenderBuffer* buffer);
+    // Deferred lists always record, so Execute can pass their commands on.
+    CommandList* CreateDeferredCommandList();
+
+    // What was last written to a buffer from this device.
+    static uint8_t const* Contents(RenderBuffer* buffer);
+    static uint32_t Size(RenderBuffer* buffer);
+
+    uint32_t LiveBuffers() const { return liveBuffers; }
+
+private:
+    uint32_t liveBuffers;
+};
+
+
+// A command passed to a NullCommandList, kept when it records.
+struct RecordedCommand
+{
+    enum Kind
+    {
+        MAP,
+        UNMAP,
+        SET_INPUT_LAYOUT,
+        SET_VERTEX_BUFFERS,
+        SET_INDEX_BUFFER,
+        SET_PRIMITIVE_TOPOLOGY,
+        SET_SHADER,
+        SET_CONSTANT_BUFFERS,
+        SET_SHADER_RESOURCES,
+        DRAW_INDEXED,
+        DRAW_INDEXED_INSTANCED,
+        DISPATCH,
+        SET_STATE,
+        EXECUTE         // Followed by the commands executed, if both lists record.
+    };
+
+    Kind kind;
+    void const* object;     // The buffer, layout or shader, or the first of the buffers or views bound.
+    uint32_t args[5];       // The command's numbers in order, e.g. slot, count, first stride and offset.
+};
+
+
+// Does nothing but count, and optionally record, the commands it is given. Maps write to the
+// buffers of a NullRenderDevice; every other handle is only compared, so can be anything.
+class NullCommandList : public CommandList
+{
+public:
+    explicit NullCommandList(bool record = false);
+
+    vector<RecordedCommand> const& Commands() const { return commands; }
+    void ClearCommands() { commands.clear(); }
+
+protected:
+    void* DoMap(RenderBuffer* buffer, MapType type);
+    void DoUnmap(RenderBuffer* buffer);
+    void DoSetInputLayout(RenderInputLayout* layout);
+    void DoSetVertexBuffers(uint32_t slot, uint32_t count, RenderBuffer* const* buffers, uint32_t const* strides, uint32_t const* offsets);
+    void DoSetIndexBuffer(RenderBuffer* buffer, IndexFormat format, uint32_t offset);
+    void DoSetPrimitiveTopology(PrimitiveTopology topology);
+    void DoSetShader(ShaderStage stage, RenderShader* shader);
+    void DoSetConstantBuffers(ShaderStage stage, uint32_t slot, uint32_t count, RenderBuffer* const* buffers);
+    void DoSetShaderResources(ShaderStage stage, uint32_t slot, uint32_t count, RenderView* const* views);
+    void DoDrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex);
+    void DoDrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance);
+    void DoDispatch(uint32_t x, uint32_t y, uint32_t z);
+    RenderState* DoCaptureState();
+    void DoReleaseState(RenderState* state);
+    void DoSetState(RenderState* state);
+    RecordedCommands* DoFinish();
+    void DoExecute(RecordedCommands* recorded);
+
+private:
+    void Record(RecordedCommand::Kind kind, void const* object,
+        uint32_t a = 0, uint32_t b = 0, uint32_t c = 0, uint32_t d = 0, uint32_t e = 0);
+
+    bool record;
+    vector<RecordedCommand> commands;
+};
@@ -0,0 +1,769 @@
+// Command line benchmark for recording scene draws, with the null backend standing in for
+// Direct3D, so it can run on a headless build machine.
+//
+// Usage:
+//   renderbench bench [-n frames] [-c objects] [-m meshes] [-t threads]
+//       Times culling a scene of moving objects, then recording its draws without batching, batched,
+//       and batched on one deferred list per thread, and counts the commands, draws, maps and bytes
+//       uploaded per frame.
+//   renderbench check [-c objects] [-m meshes] [-t threads]
+//       Records several passes over a culled scene in each of those ways and checks, as each draw is
+//       recorded, that every visible object is drawn exactly once, with its mesh's state bound and
+//       its own transforms in the ring. Exits with 1 on failure.
+//
+// The default is 100000 objects of 64 meshes, 200 frames, and a thread per core.
+
+#include "../DrawBatcher.h"
+#include "../NullCommandList.h"
+#include "../../Scene/SceneCuller.h"
+#include "../../Scene/SceneStore.h"
+#include "../../Scene/WorkerPool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+
+// Every so many objects is drawn by a custom draw, as DXUT meshes are in the engine.
+static uint32_t const CustomEvery = 32;
+static uint32_t const TexturesPerMesh = 8;
+static uint32_t const DiffuseSlot = 0;
+static uint32_t const ObjectSlot = 1;
+
+
+// The null backend only compares handles other than buffers it maps, so these stand in for them.
+static char fakeHandles[4];
+
+static RenderInputLayout* FakeLayout() { return reinterpret_cast<RenderInputLayout*>(&fakeHandles[0]); }
+static RenderShader* FakeShader() { return reinterpret_cast<RenderShader*>(&fakeHandles[1]); }
+
+
+static double Seconds(Clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::duration<double>>(Clock::now() - start).count();
+}
+
+
+static void Report(char const* name, double seconds, int frames, uint32_t objects)
+{
+    double perFrame = seconds / frames;
+
+    printf("%-34s %9.3f ms/frame %8.2f ns/object\n", name, perFrame * 1e3, perFrame * 1e9 / objects);
+}
+
+
+// A perspective projection looking down +z from the origin, with a 60 degree field of view.
+static void MakeViewProj(Matrix4* viewProj, float yaw)
+{
+    Matrix4 view, projection;
+    float nearClip = 1.0f, farClip = 1000.0f;
+    float yScale = 1.0f / tanf(3.14159265f / 6.0f);
+
+    MatrixIdentity(&view);
+    view.m[0][0] = cosf(yaw);
+    view.m[0][2] = -sinf(yaw);
+    view.m[2][0] = sinf(yaw);
+    view.m[2][2] = cosf(yaw);
+
+    memset(&projection, 0, sizeof(projection));
+    projection.m[0][0] = yScale;
+    projection.m[1][1] = yScale;
+    projection.m[2][2] = farClip / (farClip - nearClip);
+    projection.m[2][3] = 1.0f;
+    projection.m[3][2] = -nearClip * farClip / (farClip - nearClip);
+
+    MatrixMultiply(viewProj, view, projection);
+}
+
+
+// Meshes with distinct buffers, sharing a few textures, with a different scale and offset each.
+class MeshSet
+{
+public:
+    explicit MeshSet(uint32_t count)
+        : handles(count * 3), meshes(count)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            DrawMesh& mesh = meshes[i];
+
+            mesh.vertexBuffer = reinterpret_cast<RenderBuffer*>(&handles[i * 3]);
+            mesh.vertexStride = 32;
+            mesh.indexBuffer = reinterpret_cast<RenderBuffer*>(&handles[i * 3 + 1]);
+            mesh.indexFormat = (i & 1) ? INDEX_32 : INDEX_16;
+            mesh.indexCount = 36 + i * 3;
+            mesh.texture = reinterpret_cast<RenderView*>(&handles[(i % TexturesPerMesh) * 3 + 2]);
+            mesh.positionScale = 1.0f + (i & 3);
+            mesh.positionOffset[0] = (float)(i & 7);
+            mesh.positionOffset[1] = -(float)(i % 5);
+            mesh.positionOffset[2] = 0.5f * (i % 3);
+        }
+    }
+
+    uint32_t Count() const { return (uint32_t)meshes.size(); }
+    DrawMesh const* Mesh(uint32_t i) const { return &meshes[i]; }
+
+    // Returns the mesh whose vertex buffer is bound, or -1 for none.
+    int Find(void const* vertexBuffer) const
+    {
+        for (uint32_t i = 0; i < meshes.size(); i++)
+        {
+            if (meshes[i].vertexBuffer == vertexBuffer)
+            {
+                return (int)i;
+            }
+        }
+        return -1;
+    }
+
+private:
+    vector<char> handles;
+    vector<DrawMesh> meshes;
+};
+
+
+// Stands in for a DXUT mesh: one draw, using whatever transforms the batcher bound. It passes
+// the object as the start index, so the check can tell which object it was asked to draw.
+class FakeCustomDraw : public CustomDraw
+{
+public:
+    uint32_t Draw(CommandList& commands, uint32_t object)
+    {
+        commands.DrawIndexed(36, object, 0);
+        return 1;
+    }
+};
+
+
+// Objects of radius 1 on a grid of whole numbers around the camera, so their positions can
+// be recovered exactly from the transforms in the ring.
+static void BuildScene(SceneStore* store, uint32_t objects, vector<SceneHandle>* handles)
+{
+    BoundingSphere bounds = {0.0f, 0.0f, 0.0f, 1.0f};
+    Matrix4 local;
+
+    for (uint32_t i = 0; i < objects; i++)
+    {
+        float x = (float)((i % 128) * 4) - 256.0f;
+        float y = (float)(((i / 128) % 128) * 4) - 256.0f;
+        float z = (float)((i / 16384) * 4) + 2.0f;
+
+        MatrixTranslation(&local, x, y, z);
+        handles->push_back(store->Create(local));
+        store->SetLocalBounds(handles->back(), bounds);
+    }
+    store->UpdateTransforms();
+}
+
+
+// Nudges every object a little, as the physics would.
+static void MoveScene(SceneStore* store, vector<SceneHandle> const& handles, int frame)
+{
+    for (uint32_t i = 0; i < handles.size(); i++)
+    {
+        Matrix4 local = store->GetLocal(handles[i]);
+
+        local.m[3][1] += ((i + frame) & 1) ? 0.5f : -0.5f;
+        store->SetLocal(handles[i], local);
+    }
+    store->UpdateTransforms();
+}
+
+
+// Adds the visible objects, by dense index, to the batcher.
+static void AddObjects(DrawBatcher* batcher, SceneStore const& store, MeshSet const& meshes,
+    CustomDraw* custom, vector<uint32_t> const& visible)
+{
+    batcher->Clear();
+
+    for (size_t i = 0; i < visible.size(); i++)
+    {
+        uint32_t object = store.HandleAt(visible[i]).index;
+
+        if (object % CustomEvery == 0)
+        {
+            batcher->Add(custom, custom, visible[i]);
+        }
+        else
+        {
+            batcher->Add(meshes.Mesh(object % meshes.Count()), visible[i]);
+        }
+    }
+}
+
+
+static void MakePass(DrawPass* pass, Matrix4 const& view, Matrix4 const& viewProj)
+{
+    pass->view = view;
+    pass->viewProj = viewProj;
+    pass->meshLayout = FakeLayout();
+    pass->meshVertexShader = FakeShader();
+    pass->diffuseSlot = DiffuseSlot;
+    pass->objectSlot = ObjectSlot;
+}
+
+
+static void BenchRecord(char const* name, uint32_t objects, uint32_t meshCount, int frames, bool batching, unsigned int threads)
+{
+    SceneStore store;
+    SceneCuller culler;
+    MeshSet meshes(meshCount);
+    FakeCustomDraw custom;
+    NullRenderDevice device;
+    NullCommandList commands;
+    unique_ptr<WorkerPool> pool;
+    vector<unique_ptr<CommandList>> lists;
+    vector<CommandList*> deferred;
+    vector<SceneHandle> handles;
+    vector<uint32_t> visible;
+    Matrix4 view, viewProj;
+    double cullSeconds = 0.0, recordSeconds = 0.0;
+    uint64_t drawn = 0;
+
+    BuildScene(&store, objects, &handles);
+    MatrixIdentity(&view);
+
+    // One deferred list per thread.
+    if (threads)
+    {
+        pool.reset(new WorkerPool(threads));
+        for (unsigned int i = 0; i < max(2u, pool->ThreadCount()); i++)
+        {
+            lists.push_back(unique_ptr<CommandList>(device.CreateDeferredCommandList()));
+            deferred.push_back(lists.back().get());
+        }
+    }
+
+    {
+        DrawBatcher batcher(device);
+
+        batcher.SetBatching(batching);
+
+        for (int frame = 0; frame < frames; frame++)
+        {
+            MoveScene(&store, handles, frame);
+            MakeViewProj(&viewProj, frame * 0.02f);
+
+            Clock::time_point start = Clock::now();
+            culler.Cull(store, viewProj, &visible);
+            cullSeconds += Seconds(start);
+
+            DrawPass pass;
+
+            MakePass(&pass, view, viewProj);
+
+            start = Clock::now();
+            AddObjects(&batcher, store, meshes, &custom, visible);
+            batcher.Record(commands, store.WorldTransforms(), pass, pool.get(), deferred);
+            recordSeconds += Seconds(start);
+
+            drawn += visible.size();
+        }
+
+        CommandStats stats = commands.Stats();
+
+        for (size_t i = 0; i < lists.size(); i++)
+        {
+            stats.commands += lists[i]->Stats().commands;
+            stats.draws += lists[i]->Stats().draws;
+        }
+
+        Report(name, recordSeconds, frames, (uint32_t)(drawn / frames));
+        printf("%-34s %9.0f commands %6.0f draws %6.0f maps %9.1f KB uploaded per frame\n", "",
+            (double)stats.commands / frames, (double)stats.draws / frames, (double)stats.maps / frames, stats.bytesUploaded / 1024.0 / frames);
+    }
+
+    if (!batching)
+    {
+        Report("culling", cullSeconds, frames, objects);
+        printf("%-34s %9u visible\n", "", (uint32_t)visible.size());
+    }
+}
+
+
+static int Bench(uint32_t objects, uint32_t meshes, int frames, unsigned int threads)
+{
+    char name[64];
+
+    printf("%u objects of %u meshes, %d frames\n", objects, meshes, frames);
+
+    BenchRecord("one draw per object", objects, meshes, frames, false, 0);
+    BenchRecord("batched", objects, meshes, frames, true, 0);
+
+    if (!threads)
+    {
+        threads = max(1u, thread::hardware_concurrency());
+    }
+    sprintf(name, "batched, %u threads", threads);
+    BenchRecord(name, objects, meshes, frames, true, threads);
+
+    return 0;
+}
+
+
+static bool Near(double value, double expected)
+{
+    return fabs(value - expected) <= 1e-4 * (1.0 + fabs(expected));
+}
+
+
+// Checks the state and transforms behind each draw as it is recorded.
+class CheckingCommandList : public NullCommandList
+{
+public:
+    CheckingCommandList(SceneStore const& store, MeshSet const& meshes, Matrix4 const& viewProj)
+        : store(store), meshes(meshes), viewProj(viewProj), drawCount(0),
+          vertexBuffer(0), indexBuffer(0), indexFormat(INDEX_16), texture(0), objectBuffer(0), objectOffset(0), objectStride(0)
+    {
+        for (uint32_t i = 0; i < store.Size(); i++)
+        {
+            Matrix4 const& world = store.WorldTransforms()[i];
+
+            positions[Key(world.m[3][0], world.m[3][1], world.m[3][2])] = i;
+        }
+    }
+
+    // Objects drawn since the last call, by dense index.
+    void TakeDrawn(vector<uint32_t>* objects)
+    {
+        objects->swap(drawn);
+        drawn.clear();
+    }
+
+    uint32_t DrawCount() const { return drawCount; }
+    string const& Failure() const { return failure; }
+
+protected:
+    void DoSetVertexBuffers(uint32_t slot, uint32_t count, RenderBuffer* const* buffers, uint32_t const* strides, uint32_t const* offsets)
+    {
+        NullCommandList::DoSetVertexBuffers(slot, count, buffers, strides, offsets);
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (slot + i == 0)
+            {
+                vertexBuffer = buffers[i];
+            }
+            else if (slot + i == ObjectSlot)
+            {
+                objectBuffer = buffers[i];
+                objectStride = strides[i];
+                objectOffset = offsets[i];
+            }
+        }
+    }
+
+    void DoSetIndexBuffer(RenderBuffer* buffer, IndexFormat format, uint32_t offset)
+    {
+        NullCommandList::DoSetIndexBuffer(buffer, format, offset);
+        indexBuffer = buffer;
+        indexFormat = format;
+    }
+
+    void DoSetShaderResources(ShaderStage stage, uint32_t slot, uint32_t count, RenderView* const* views)
+    {
+        NullCommandList::DoSetShaderResources(stage, slot, count, views);
+        if (stage == STAGE_PIXEL && slot == DiffuseSlot && count)
+        {
+            texture = views[0];
+        }
+    }
+
+    void DoDrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex)
+    {
+        NullCommandList::DoDrawIndexed(indexCount, startIndex, baseVertex);
+        drawCount++;
+        CheckObject(0, -1, startIndex);
+    }
+
+    void DoDrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance)
+    {
+        NullCommandList::DoDrawIndexedInstanced(indexCount, instanceCount, startIndex, baseVertex, startInstance);
+        drawCount++;
+
+        int mesh = meshes.Find(vertexBuffer);
+
+        if (mesh < 0)
+        {
+            Fail("a mesh was drawn without its vertex buffer bound");
+            return;
+        }
+
+        DrawMesh const& bound = *meshes.Mesh(mesh);
+
+        if (indexBuffer != bound.indexBuffer || indexFormat != bound.indexFormat || texture != bound.texture || indexCount != bound.indexCount)
+        {
+            Fail("a mesh was drawn with another mesh's index buffer or texture bound");
+            return;
+        }
+        for (uint32_t i = 0; i < instanceCount; i++)
+        {
+            CheckObject(startInstance + i, mesh, ~0u);
+        }
+    }
+
+private:
+    // Counts in halves, which is as fine as the positions and offsets go.
+    static uint16_t Half(float value)
+    {
+        return (uint16_t)(int)floorf(2.0f * value + 0.5f);
+    }
+
+    static uint64_t Key(float x, float y, float z)
+    {
+        return ((uint64_t)Half(x) << 32) | ((uint64_t)Half(y) << 16) | Half(z);
+    }
+
+    void Fail(char const* message)
+    {
+        if (failure.empty())
+        {
+            failure = message;
+        }
+    }
+
+    // Finds the object from the position in the transforms the draw reads, and checks them.
+    // Custom draws have mesh -1, and know which object they were asked to draw.
+    void CheckObject(uint32_t instance, int mesh, uint32_t expectedObject)
+    {
+        if (!objectBuffer || objectStride != sizeof(ObjectConstants) || objectOffset % objectStride)
+        {
+            Fail("a draw was recorded without the object transforms bound");
+            return;
+        }
+
+        uint32_t element = objectOffset / objectStride + instance;
+
+        if ((element + 1) * objectStride > NullRenderDevice::Size(objectBuffer))
+        {
+            Fail("a draw read past the end of the ring");
+            return;
+        }
+
+        ObjectConstants const& constants = reinterpret_cast<ObjectConstants const*>(NullRenderDevice::Contents(objectBuffer))[element];
+        float scale = mesh < 0 ? 1.0f : meshes.Mesh(mesh)->positionScale;
+        float const zero[3] = {0.0f, 0.0f, 0.0f};
+        float const* offset = mesh < 0 ? zero : meshes.Mesh(mesh)->positionOffset;
+
+        // The view is the identity, so worldView is the mesh's world matrix, whose last row is
+        // the object's position plus the mesh's offset, which are both whole numbers or halves.
+        map<uint64_t, uint32_t>::const_iterator found = positions.find(Key(constants.worldView.m[3][0] - offset[0],
+            constants.worldView.m[3][1] - offset[1], constants.worldView.m[3][2] - offset[2]));
+
+        if (found == positions.end())
+        {
+            Fail("a draw's transforms are not at any object's position");
+            return;
+        }
+
+        uint32_t object = found->second;
+        uint32_t slot = store.HandleAt(object).index;
+
+        if (expectedObject != ~0u && object != expectedObject)
+        {
+            Fail("a custom draw read another object's transforms");
+            return;
+        }
+        if (mesh < 0 ? slot % CustomEvery != 0 : (slot % CustomEvery == 0 || slot % meshes.Count() != (uint32_t)mesh))
+        {
+            Fail("an object was drawn with the wrong mesh");
+            return;
+        }
+
+        // Compare with the mesh's scale and offset, then the object's world and the view
+        // projection, applied in double precision.
+        Matrix4 const& world = store.WorldTransforms()[object];
+        double meshWorld[4][4];
+
+        for (int i = 0; i < 4; i++)
+        {
+            for (int j = 0; j < 4; j++)
+            {
+                meshWorld[i][j] = i < 3 ? scale * world.m[i][j] : world.m[3][j] + offset[0] * world.m[0][j] + offset[1] * world.m[1][j] + offset[2] * world.m[2][j];
+            }
+        }
+        for (int i = 0; i < 4; i++)
+        {
+            for (int j = 0; j < 4; j++)
+            {
+                double expected = 0.0;
+
+                for (int k = 0; k < 4; k++)
+                {
+                    expected += meshWorld[i][k] * viewProj.m[k][j];
+                }
+                if (!Near(constants.worldViewProj.m[i][j], expected) || !Near(constants.worldView.m[i][j], meshWorld[i][j]))
+                {
+                    Fail("an object's transforms in the ring are wrong");
+                    return;
+                }
+            }
+        }
+
+        drawn.push_back(object);
+    }
+
+    SceneStore const& store;
+    MeshSet const& meshes;
+    Matrix4 viewProj;
+    map<uint64_t, uint32_t> positions;
+    vector<uint32_t> drawn;
+    uint32_t drawCount;
+    string failure;
+
+    RenderBuffer* vertexBuffer;
+    RenderBuffer* indexBuffer;
+    IndexFormat indexFormat;
+    RenderView* texture;
+    RenderBuffer* objectBuffer;
+    uint32_t objectOffset;
+    uint32_t objectStride;
+};
+
+
+// How CheckMode records.
+enum RecordMode
+{
+    RECORD_EACH,        // One draw per object.
+    RECORD_BATCHED,
+    RECORD_PARALLEL     // Batched, on deferred lists.
+};
+
+
+// Records enough passes for the ring to wrap, checking every draw. In parallel, each deferred
+// list checks the draws recorded on it, and the immediate list only maps and executes.
+static int CheckMode(uint32_t objects, uint32_t meshCount, RecordMode recordMode, unsigned int threads)
+{
+    static char const* const modeNames[] = { "one draw per object", "batched", "batched on deferred lists" };
+
+    SceneStore store;
+    SceneCuller culler;
+    MeshSet meshes(meshCount);
+    FakeCustomDraw custom;
+    NullRenderDevice device;
+    WorkerPool pool(threads);
+    vector<SceneHandle> handles;
+    vector<uint32_t> visible, drawn, listDrawn;
+    Matrix4 view, viewProj;
+    char const* mode = modeNames[recordMode];
+    bool batching = recordMode != RECORD_EACH;
+    // Uneven, so chunks don't line up with meshes.
+    uint32_t listCount = max(2u, pool.ThreadCount()) + 1;
+
+    BuildScene(&store, objects, &handles);
+    MatrixIdentity(&view);
+
+    {
+        DrawBatcher batcher(device);
+
+        batcher.SetBatching(batching);
+
+        for (int pass = 0; pass < 10; pass++)
+        {
+            MakeViewProj(&viewProj, pass * 0.3f);
+            culler.Cull(store, viewProj, &visible);
+
+            CheckingCommandList commands(store, meshes, viewProj);
+            vector<unique_ptr<CheckingCommandList>> lists;
+            vector<CommandList*> deferred;
+            DrawPass drawPass;
+            uint32_t drawCount = 0;
+
+            if (recordMode == RECORD_PARALLEL)
+            {
+                for (uint32_t i = 0; i < listCount; i++)
+                {
+                    lists.push_back(unique_ptr<CheckingCommandList>(new CheckingCommandList(store, meshes, viewProj)));
+                    deferred.push_back(lists.back().get());
+                }
+            }
+
+            MakePass(&drawPass, view, viewProj);
+            AddObjects(&batcher, store, meshes, &custom, visible);
+            batcher.ResetStats();
+            batcher.Record(commands, store.WorldTransforms(), drawPass, &pool, deferred);
+            commands.TakeDrawn(&drawn);
+            drawCount = commands.DrawCount();
+
+            string failure = commands.Failure();
+            uint32_t chunks = 0;
+
+            for (size_t i = 0; i < lists.size(); i++)
+            {
+                if (failure.empty())
+                {
+                    failure = lists[i]->Failure();
+                }
+                lists[i]->TakeDrawn(&listDrawn);
+                drawn.insert(drawn.end(), listDrawn.begin(), listDrawn.end());
+                drawCount += lists[i]->DrawCount();
+                chunks += lists[i]->Stats().commands != 0;
+            }
+            if (!failure.empty())
+            {
+                printf("FAILED: %s, pass %d: %s\n", mode, pass, failure.c_str());
+                return 1;
+            }
+
+            sort(visible.begin(), visible.end());
+            sort(drawn.begin(), drawn.end());
+
+            if (drawn != visible)
+            {
+                printf("FAILED: %s, pass %d: drew %u objects rather than the %u visible, once each\n", mode, pass, (uint32_t)drawn.size(), (uint32_t)visible.size());
+                return 1;
+            }
+
+            // Batched, every mesh's objects are one draw, with one map for the lot.
+            uint32_t expectedDraws = 0, expectedMaps = 0;
+            uint32_t instances = commands.Stats().instances;
+
+            for (size_t i = 0; i < lists.size(); i++)
+            {
+                instances += lists[i]->Stats().instances;
+            }
+
+            if (batching)
+            {
+                vector<bool> meshDrawn(meshes.Count());
+
+                for (size_t i = 0; i < visible.size(); i++)
+                {
+                    uint32_t slot = store.HandleAt(visible[i]).index;
+
+                    if (slot % CustomEvery == 0)
+                    {
+                        expectedDraws++;
+                    }
+                    else if (!meshDrawn[slot % meshes.Count()])
+                    {
+                        meshDrawn[slot % meshes.Count()] = true;
+                        expectedDraws++;
+                    }
+                }
+                expectedMaps = visible.empty() ? 0 : 1;
+            }
+            else
+            {
+                expectedDraws = expectedMaps = (uint32_t)visible.size();
+            }
+
+            // In parallel, the draws are split across as many lists as there are draws to share out.
+            if (recordMode == RECORD_PARALLEL &&
+                (commands.DrawCount() != 0 || commands.Stats().executes != chunks || chunks != min(expectedDraws, listCount)))
+            {
+                printf("FAILED: %s, pass %d: %u draws on the immediate list and %u executes of %u chunks\n", mode, pass,
+                    commands.DrawCount(), commands.Stats().executes, chunks);
+                return 1;
+            }
+            if (drawCount != expectedDraws || batcher.Stats().draws != expectedDraws || commands.Stats().maps != expectedMaps)
+            {
+                printf("FAILED: %s, pass %d: %u draws and %u maps rather than %u and %u\n", mode, pass,
+                    drawCount, commands.Stats().maps, expectedDraws, expectedMaps);
+                return 1;
+            }
+            if (batcher.Stats().objects != visible.size() || instances != visible.size())
+            {
+                printf("FAILED: %s, pass %d: counted %u objects rather than %u\n", mode, pass, batcher.Stats().objects, (uint32_t)visible.size());
+                return 1;
+            }
+        }
+    }
+
+    if (device.LiveBuffers() != 0)
+    {
+        printf("FAILED: %s: %u buffers were not released\n", mode, device.LiveBuffers());
+        return 1;
+    }
+
+    printf("%s: %u objects of %u meshes over 10 passes: ok\n", mode, objects, meshCount);
+
+    return 0;
+}
+
+
+static int Check(uint32_t objects, uint32_t meshes, unsigned int threads)
+{
+    if (CheckMode(objects, meshes, RECORD_EACH, threads) || CheckMode(objects, meshes, RECORD_BATCHED, threads) ||
+        CheckMode(objects, meshes, RECORD_PARALLEL, threads))
+    {
+        return 1;
+    }
+
+    return 0;
+}
+
+
+static int Usage()
+{
+    printf("Usage: renderbench bench|check [-n frames] [-c objects] [-m meshes] [-t threads]\n");
+
+    return 2;
+}
+
+
+int main(int argc, char* argv[])
+{
+    uint32_t objects = 100000;
+    uint32_t meshes = 64;
+    int frames = 200;
+    unsigned int threads = 0;
+    int i;
+
+    if (argc < 2)
+    {
+        return Usage();
+    }
+
+    string command = argv[1];
+
+    for (i = 2; i < argc; i++)
+    {
+        string option = argv[i];
+
+        if (i + 1 >= argc)
+        {
+            return Usage();
+        }
+
+        if (option == "-n")
+        {
+            frames = max(1, atoi(argv[++i]));
+        }
+        else if (option == "-c")
+        {
+            objects = (uint32_t)max(1, atoi(argv[++i]));
+        }
+        else if (option == "-m")
+        {
+            meshes = (uint32_t)max(1, atoi(argv[++i]));
+        }
+        else if (option == "-t")
+        {
+            threads = (unsigned int)max(1, atoi(argv[++i]));
+        }
+        else
+        {
+            return Usage();
+        }
+    }
+
+    if (command == "bench")
+    {
+        return Bench(objects, meshes, frames, threads);
+    }
+
+    if (command == "check")
+    {
+        return Check(objects, meshes, threads);
+    }
+
+    return Usage();
+}
@@ -0,0 +1,59 @@
+#include "UploadRing.h"
+
+#include <stdexcept>
+
+using namespace std;
+
+
+UploadRing::UploadRing(RenderDevice& device, uint32_t elementSize, uint32_t elements, BufferBinding binding)
+    : device(device), buffer(0), elementSize(elementSize), elements(elements), next(elements)
+{
+    buffer = device.CreateDynamicBuffer(elementSize * elements, binding);
+    if (!buffer)
+    {
+        throw runtime_error("Failed to create an upload ring buffer.");
+    }
+}
+
+UploadRing::~UploadRing()
+{
+    device.ReleaseBuffer(buffer);
+}
+
+void* UploadRing::Map(CommandList& commands, uint32_t count, uint32_t* first)
+{
+    // Wrap around once the rest of the buffer is too small. The first map always lands here.
+    if (next + count > elements)
+    {
+        return Map(commands, MAP_WRITE_DISCARD, count, first);
+    }
+    return Map(commands, MAP_WRITE_NO_OVERWRITE, count, first);
+}
+
+void* UploadRing::MapDiscard(CommandList& commands, uint32_t count, uint32_t* first)
+{
+    return Map(commands, MAP_WRITE_DISCARD, count, first);
+}
+
+void* UploadRing::Map(CommandList& commands, MapType type, uint32_t count, uint32_t* first)
+{
+    if (type == MAP_WRITE_DISCARD)
+    {
+        next = 0;
+    }
+
+    uint8_t* data = static_cast<uint8_t*>(commands.Map(buffer, type, count * elementSize));
+
+    if (!data)
+    {
+        return 0;
+    }
+    *first = next;
+    next += count;
+    return data + *first * elementSize;
+}
+
+void UploadRing::Unmap(CommandList& commands)
+{
+    commands.Unmap(buffer);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "CommandList.h"
+
+
+// Dynamic buffer written a range at a time with MAP_WRITE_NO_OVERWRITE, so the GPU can keep
+// reading earlier ranges while later ones are filled. It is only discarded when it wraps.
+// Element i starts at byte i * ElementSize(), e.g. to bind as a vertex buffer offset.
+class UploadRing
+{
+public:
+    // Throws runtime_error if the buffer can't be created.
+    UploadRing(RenderDevice& device, uint32_t elementSize, uint32_t elements, BufferBinding binding = BIND_VERTEX_BUFFER);
+    ~UploadRing();
+
+    RenderBuffer* Buffer() const { return buffer; }
+    uint32_t ElementSize() const { return elementSize; }
+    uint32_t Elements() const { return elements; }
+
+    // Maps count elements the GPU may not be reading, and sets first to the index of the first.
+    // Returns a pointer to that element, or null if the map failed. count must be at most Elements().
+    void* Map(CommandList& commands, uint32_t count, uint32_t* first);
+    // As Map, but always discards, starting over at element 0.
+    void* MapDiscard(CommandList& commands, uint32_t count, uint32_t* first);
+    void Unmap(CommandList& commands);
+
+private:
+    // Not implemented
+    UploadRing(UploadRing const&);
+    UploadRing& operator=(UploadRing const&);
+
+    void* Map(CommandList& commands, MapType type, uint32_t count, uint32_t* first);
+
+    RenderDevice& device;
+    RenderBuffer* buffer;
+    uint32_t elementSize;
+    uint32_t elements;
+    uint32_t next;          // Elements before this may be in use by the GPU.
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <new>
+
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+
+// Standard allocator returning memory aligned to Alignment bytes, so vectors of SSE types
+// are safe even where malloc only guarantees 8 byte alignment (32 bit Windows).
+template<typename T, size_t Alignment>
+class AlignedAllocator
+{
+public:
+    typedef T value_type;
+    typedef T* pointer;
+    typedef T const* const_pointer;
+    typedef T& reference;
+    typedef T const& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    template<typename U>
+    struct rebind
+    {
+        typedef AlignedAllocator<U, Alignment> other;
+    };
+
+    AlignedAllocator() { }
+
+    template<typename U>
+    AlignedAllocator(AlignedAllocator<U, Alignment> const&) { }
+
+    pointer address(reference value) const { return &value; }
+    const_pointer address(const_reference value) const { return &value; }
+
+    size_type max_size() const { return size_type(-1) / sizeof(T); }
+
+    pointer allocate(size_type count, void const* = 0)
+    {
+        void* result;
+
+#ifdef _MSC_VER
+        result = _aligned_malloc(count * sizeof(T), Alignment);
+#else
+        if (posix_memalign(&result, Alignment, count * sizeof(T)))
+        {
+            result = 0;
+        }
+#endif
+
+        if (!result)
+        {
+            throw std::bad_alloc();
+        }
+
+        return static_cast<pointer>(result);
+    }
+
+    void deallocate(pointer memory, size_type)
+    {
+#ifdef _MSC_VER
+        _aligned_free(memory);
+#else
+        free(memory);
+#endif
+    }
+
+    void construct(pointer memory, const_reference value) { new (memory) T(value); }
+    void destroy(pointer memory) { memory->~T(); }
+
+    bool operator==(AlignedAllocator const&) const { return true; }
+    bool operator!=(AlignedAllocator const&) const { return false; }
+};
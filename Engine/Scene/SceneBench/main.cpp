@@ -0,0 +1,772 @@
+// Command line benchmark for the scene transform store, with no dependency on Direct3D or
+// Windows, so it can run on a headless build machine.
+//
+// Usage:
+//   scenebench bench [-n frames] [-c objects]  Times per frame transform updates for several scene shapes,
+//                                              against the old layout of one heap allocated matrix per object.
+//   scenebench cull [-n frames] [-c objects]   Times frustum culling of moving objects scattered through a
+//                                              large volume: testing every sphere in turn, then the culler
+//                                              on one thread and on every core.
+//   scenebench check [-c objects]              Compares the store's world transforms against a straightforward
+//                                              recursive evaluation, and checks handles across destroy and
+//                                              reuse, and compares culling against testing every sphere.
+//                                              Exits with 1 on failure.
+//
+// The default is 100000 objects and 200 frames.
+
+#include "../SceneCuller.h"
+#include "../SceneStore.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+
+// Small deterministic generator, so runs are repeatable.
+static uint32_t Random(uint32_t* state)
+{
+    *state = *state * 1664525 + 1013904223;
+
+    return *state >> 8;
+}
+
+
+static float RandomFloat(uint32_t* state, float range)
+{
+    return (Random(state) & 0xFFFF) * (range / 65535.0f) - range * 0.5f;
+}
+
+
+static void MatrixRotationY(Matrix4* result, float angle, float x, float y, float z)
+{
+    MatrixTranslation(result, x, y, z);
+
+    result->m[0][0] = cosf(angle);
+    result->m[0][2] = -sinf(angle);
+    result->m[2][0] = sinf(angle);
+    result->m[2][2] = cosf(angle);
+}
+
+
+static double Seconds(Clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::duration<double>>(Clock::now() - start).count();
+}
+
+
+static void Report(char const* name, double seconds, int frames, uint32_t objects)
+{
+    double perFrame = seconds / frames;
+
+    printf("%-34s %9.3f ms/frame %8.2f ns/object\n", name, perFrame * 1e3, perFrame * 1e9 / objects);
+}
+
+
+// Builds a forest of roots, each with childrenPerRoot children, each of which has grandchildren.
+static void BuildHierarchy(SceneStore* store, uint32_t objects, uint32_t childrenPerRoot, uint32_t grandchildrenPerChild, vector<SceneHandle>* roots, vector<SceneHandle>* all)
+{
+    uint32_t state = 1;
+    Matrix4 local;
+
+    while (all->size() < objects)
+    {
+        MatrixTranslation(&local, RandomFloat(&state, 1000.0f), 0.0f, RandomFloat(&state, 1000.0f));
+        SceneHandle root = store->Create(local);
+
+        roots->push_back(root);
+        all->push_back(root);
+
+        for (uint32_t i = 0; i < childrenPerRoot && all->size() < objects; i++)
+        {
+            MatrixRotationY(&local, RandomFloat(&state, 6.0f), RandomFloat(&state, 10.0f), 1.0f, RandomFloat(&state, 10.0f));
+            SceneHandle child = store->Create(local, root);
+
+            all->push_back(child);
+
+            for (uint32_t j = 0; j < grandchildrenPerChild && all->size() < objects; j++)
+            {
+                MatrixTranslation(&local, RandomFloat(&state, 2.0f), 0.5f, RandomFloat(&state, 2.0f));
+                all->push_back(store->Create(local, child));
+            }
+        }
+    }
+}
+
+
+// Every object is a root, moved every frame: the PhysX cubes.
+static void BenchFlat(uint32_t objects, int frames)
+{
+    SceneStore store;
+    vector<SceneHandle> handles;
+    Matrix4 local;
+    uint32_t state = 1;
+
+    for (uint32_t i = 0; i < objects; i++)
+    {
+        MatrixTranslation(&local, RandomFloat(&state, 1000.0f), RandomFloat(&state, 1000.0f), RandomFloat(&state, 1000.0f));
+        handles.push_back(store.Create(local));
+    }
+
+    store.UpdateTransforms();
+
+    Clock::time_point start = Clock::now();
+
+    for (int frame = 0; frame < frames; frame++)
+    {
+        for (uint32_t i = 0; i < objects; i++)
+        {
+            MatrixTranslation(&local, (float)i, (float)frame, 0.0f);
+            store.SetLocal(handles[i], local);
+        }
+
+        store.UpdateTransforms();
+    }
+
+    Report("flat, all moving", Seconds(start), frames, objects);
+}
+
+
+// The same, with the old layout: a separately allocated matrix per object, reached through a
+// vector of pointers, with the world transform worked out per object from the scene's.
+static void BenchHeap(uint32_t objects, int frames)
+{
+    vector<Matrix4*> locals, worlds;
+    Matrix4 scene, local;
+    uint32_t state = 1;
+
+    MatrixIdentity(&scene);
+
+    for (uint32_t i = 0; i < objects; i++)
+    {
+        MatrixTranslation(&local, RandomFloat(&state, 1000.0f), RandomFloat(&state, 1000.0f), RandomFloat(&state, 1000.0f));
+        locals.push_back(new Matrix4(local));
+        worlds.push_back(new Matrix4(local));
+    }
+
+    // Objects in a real scene are created over time, interleaved with other allocations, so
+    // shuffle the pointers rather than leaving them in the order the allocator handed them out.
+    for (uint32_t i = objects - 1; i > 0; i--)
+    {
+        uint32_t j = Random(&state) % (i + 1);
+
+        swap(locals[i], locals[j]);
+        swap(worlds[i], worlds[j]);
+    }
+
+    Clock::time_point start = Clock::now();
+
+    for (int frame = 0; frame < frames; frame++)
+    {
+        for (uint32_t i = 0; i < objects; i++)
+        {
+            MatrixTranslation(locals[i], (float)i, (float)frame, 0.0f);
+        }
+
+        for (uint32_t i = 0; i < objects; i++)
+        {
+            MatrixMultiply(worlds[i], *locals[i], scene);
+        }
+    }
+
+    Report("flat, all moving (heap matrices)", Seconds(start), frames, objects);
+
+    for (uint32_t i = 0; i < objects; i++)
+    {
+        delete locals[i];
+        delete worlds[i];
+    }
+}
+
+
+// A hierarchy where only some objects move each frame, leaving the dirty flags to decide
+// how much of it gets recomputed.
+static void BenchHierarchy(char const* name, uint32_t objects, int frames, bool moveRoots, uint32_t movingLeaves)
+{
+    SceneStore store;
+    vector<SceneHandle> roots, all;
+    Matrix4 local;
+    uint32_t state = 2;
+
+    BuildHierarchy(&store, objects, 10, 9, &roots, &all);
+    store.UpdateTransforms();
+
+    Clock::time_point start = Clock::now();
+
+    for (int frame = 0; frame < frames; frame++)
+    {
+        if (moveRoots)
+        {
+            for (uint32_t i = 0; i < roots.size(); i++)
+            {
+                MatrixRotationY(&local, frame * 0.01f, (float)i, 0.0f, (float)frame);
+                store.SetLocal(roots[i], local);
+            }
+        }
+
+        for (uint32_t i = 0; i < movingLeaves; i++)
+        {
+            SceneHandle handle = all[Random(&state) % all.size()];
+
+            local = store.GetLocal(handle);
+            local.m[3][1] += 0.01f;
+            store.SetLocal(handle, local);
+        }
+
+        store.UpdateTransforms();
+    }
+
+    Report(name, Seconds(start), frames, objects);
+}
+
+
+static int Bench(uint32_t objects, int frames)
+{
+    printf("%u objects, %d frames\n", objects, frames);
+
+    BenchFlat(objects, frames);
+    BenchHeap(objects, frames);
+    BenchHierarchy("hierarchy, roots moving", objects, frames, true, 0);
+    BenchHierarchy("hierarchy, 1% moving", objects, frames, false, objects / 100);
+    BenchHierarchy("hierarchy, static", objects, frames, false, 0);
+
+    return 0;
+}
+
+
+// A perspective projection looking down +z from the origin, with a 60 degree field of view.
+static void MakeViewProj(Matrix4* viewProj, float yaw)
+{
+    Matrix4 view, projection;
+    float nearClip = 1.0f, farClip = 1000.0f;
+    float yScale = 1.0f / tanf(3.14159265f / 6.0f);
+
+    MatrixRotationY(&view, yaw, 0.0f, 0.0f, 0.0f);
+
+    memset(&projection, 0, sizeof(projection));
+    projection.m[0][0] = yScale;
+    projection.m[1][1] = yScale;
+    projection.m[2][2] = farClip / (farClip - nearClip);
+    projection.m[2][3] = 1.0f;
+    projection.m[3][2] = -nearClip * farClip / (farClip - nearClip);
+
+    MatrixMultiply(viewProj, view, projection);
+}
+
+
+// The straightforward way: every sphere against every plane.
+static void CullEverything(SceneStore const& store, Matrix4 const& viewProj, vector<uint32_t>* visible)
+{
+    Frustum frustum;
+
+    ExtractFrustum(viewProj, &frustum);
+    visible->clear();
+
+    for (uint32_t i = 0; i < store.Size(); i++)
+    {
+        bool isOutside = false;
+
+        for (int p = 0; p < 6 && !isOutside; p++)
+        {
+            float const* plane = frustum.planes[p];
+
+            isOutside = plane[0] * store.WorldBoundsX()[i] + plane[1] * store.WorldBoundsY()[i] + plane[2] * store.WorldBoundsZ()[i] + plane[3] < -store.WorldBoundsRadius()[i];
+        }
+
+        if (!isOutside)
+        {
+            visible->push_back(i);
+        }
+    }
+}
+
+
+// Objects of radius 1 scattered through a 2000 unit cube around the camera, with every tenth
+// one unbounded.
+static void BuildCullScene(SceneStore* store, uint32_t objects, vector<SceneHandle>* handles)
+{
+    BoundingSphere bounds = {0.0f, 0.0f, 0.0f, 1.0f};
+    uint32_t state = 4;
+    Matrix4 local;
+
+    for (uint32_t i = 0; i < objects; i++)
+    {
+        MatrixTranslation(&local, RandomFloat(&state, 2000.0f), RandomFloat(&state, 2000.0f), RandomFloat(&state, 2000.0f));
+        handles->push_back(store->Create(local));
+
+        if (i % 10)
+        {
+            store->SetLocalBounds(handles->back(), bounds);
+        }
+    }
+}
+
+
+// Nudges every object a little, as the physics would.
+static void MoveCullScene(SceneStore* store, vector<SceneHandle> const& handles, int frame)
+{
+    for (uint32_t i = 0; i < handles.size(); i++)
+    {
+        Matrix4 local = store->GetLocal(handles[i]);
+
+        local.m[3][1] += ((i + frame) & 1) ? 0.5f : -0.5f;
+        store->SetLocal(handles[i], local);
+    }
+
+    store->UpdateTransforms();
+}
+
+
+static void BenchCuller(char const* name, uint32_t objects, int frames, WorkerPool* pool)
+{
+    SceneStore store;
+    SceneCuller culler(pool);
+    vector<SceneHandle> handles;
+    vector<uint32_t> visible;
+    Matrix4 viewProj;
+    double seconds = 0.0;
+
+    BuildCullScene(&store, objects, &handles);
+    store.UpdateTransforms();
+
+    for (int frame = 0; frame < frames; frame++)
+    {
+        MoveCullScene(&store, handles, frame);
+        MakeViewProj(&viewProj, frame * 0.02f);
+
+        Clock::time_point start = Clock::now();
+
+        culler.Cull(store, viewProj, &visible);
+
+        seconds += Seconds(start);
+    }
+
+    Report(name, seconds, frames, objects);
+    printf("%-34s %9u visible\n", "", (uint32_t)visible.size());
+}
+
+
+static int BenchCull(uint32_t objects, int frames)
+{
+    SceneStore store;
+    vector<SceneHandle> handles;
+    vector<uint32_t> visible;
+    Matrix4 viewProj;
+    double seconds = 0.0;
+
+    printf("%u objects, %d frames\n", objects, frames);
+
+    BuildCullScene(&store, objects, &handles);
+
+    for (int frame = 0; frame < frames; frame++)
+    {
+        MoveCullScene(&store, handles, frame);
+        MakeViewProj(&viewProj, frame * 0.02f);
+
+        Clock::time_point start = Clock::now();
+        CullEverything(store, viewProj, &visible);
+        seconds += Seconds(start);
+    }
+
+    Report("every sphere, 1 thread", seconds, frames, objects);
+    printf("%-34s %9u visible\n", "", (uint32_t)visible.size());
+
+    BenchCuller("culler, 1 thread", objects, frames, 0);
+
+    WorkerPool pool;
+    char name[64];
+
+    sprintf(name, "culler, %u threads", pool.ThreadCount());
+    BenchCuller(name, objects, frames, &pool);
+
+    return 0;
+}
+
+
+static bool Equal(Matrix4 const& a, Matrix4 const& b)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        for (int j = 0; j < 4; j++)
+        {
+            if (fabsf(a.m[i][j] - b.m[i][j]) > 1e-3f * max(1.0f, fabsf(b.m[i][j])))
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+
+// The world transform worked out the slow way, from the handle's ancestors.
+static Matrix4 ReferenceWorld(SceneStore const& store, vector<SceneHandle> const& parentOf, SceneHandle handle)
+{
+    Matrix4 result = store.GetLocal(handle);
+    SceneHandle parent = parentOf[handle.index];
+
+    while (!parent.IsNull())
+    {
+        Matrix4 product;
+
+        MatrixMultiply(&product, result, store.GetLocal(parent));
+        result = product;
+        parent = parentOf[parent.index];
+    }
+
+    return result;
+}
+
+
+static bool CheckWorlds(SceneStore const& store, vector<SceneHandle> const& parentOf)
+{
+    for (uint32_t i = 0; i < store.Size(); i++)
+    {
+        SceneHandle handle = store.HandleAt(i);
+
+        if (!Equal(store.WorldTransforms()[i], ReferenceWorld(store, parentOf, handle)) || store.DenseIndex(handle) != i)
+        {
+            printf("FAILED: world transform of object %u\n", handle.index);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+// The culler must find exactly what testing every sphere finds, as objects move and come and go.
+static int CheckCull(uint32_t objects)
+{
+    SceneStore store;
+    WorkerPool pool;
+    SceneCuller culler(&pool);
+    vector<SceneHandle> handles;
+    vector<uint32_t> expected, visible;
+    BoundingSphere bounds = {0.0f, 0.0f, 0.0f, 1.0f};
+    Matrix4 viewProj;
+
+    BuildCullScene(&store, objects, &handles);
+
+    for (int frame = 0; frame < 20; frame++)
+    {
+        // Now and then destroy an object, or give an unbounded one some bounds.
+        if (frame % 5 == 4)
+        {
+            SceneHandle destroy = handles[frame % handles.size()];
+            SceneHandle bound = handles[(frame * 10) % handles.size()];
+
+            if (store.IsValid(destroy))
+            {
+                store.Destroy(destroy);
+            }
+
+            if (store.IsValid(bound))
+            {
+                store.SetLocalBounds(bound, bounds);
+            }
+        }
+
+        // Move far enough to force the occasional rebuild.
+        for (uint32_t i = 0; i < handles.size(); i++)
+        {
+            if (store.IsValid(handles[i]))
+            {
+                Matrix4 local = store.GetLocal(handles[i]);
+
+                local.m[3][i % 3] += (i & 1) ? frame * 5.0f : -frame * 5.0f;
+                store.SetLocal(handles[i], local);
+            }
+        }
+
+        store.UpdateTransforms();
+        MakeViewProj(&viewProj, frame * 0.3f);
+
+        CullEverything(store, viewProj, &expected);
+        culler.Cull(store, viewProj, &visible);
+        sort(visible.begin(), visible.end());
+
+        if (visible != expected)
+        {
+            printf("FAILED: frame %d, culler found %u visible objects rather than %u\n", frame, (uint32_t)visible.size(), (uint32_t)expected.size());
+            return 1;
+        }
+    }
+
+    printf("%u objects culled over 20 frames: ok\n", objects);
+
+    return 0;
+}
+
+
+// Pose matrices rotate as the quaternion does, and edits in place are picked up like SetLocal.
+static int CheckPoses(uint32_t objects)
+{
+    SceneStore store;
+    vector<SceneHandle> handles;
+    vector<Matrix4> expected;
+    Matrix4 local;
+    uint32_t state = 5;
+
+    MatrixIdentity(&local);
+
+    for (uint32_t i = 0; i < objects; i++)
+    {
+        handles.push_back(store.Create(local));
+    }
+
+    store.UpdateTransforms();
+
+    for (uint32_t i = 0; i < objects; i++)
+    {
+        float angle = RandomFloat(&state, 6.0f);
+        RigidPose pose = { { 0.0f, sinf(angle * 0.5f), 0.0f, cosf(angle * 0.5f) }, { RandomFloat(&state, 100.0f), 2.0f, 3.0f } };
+
+        MatrixRotationY(&local, angle, pose.position[0], pose.position[1], pose.position[2]);
+        expected.push_back(local);
+
+        // Only every other object is moved.
+        if (i % 2 == 0)
+        {
+            MatrixFromPose(&store.EditLocal(handles[i]), pose);
+        }
+    }
+
+    store.UpdateTransforms();
+
+    for (uint32_t i = 0; i < objects; i++)
+    {
+        if (i % 2 == 0 ? !Equal(store.GetWorld(handles[i]), expected[i]) : !Equal(store.GetWorld(handles[i]), store.GetLocal(handles[i])))
+        {
+            printf("FAILED: posed object %u has the wrong world transform\n", i);
+            return 1;
+        }
+    }
+
+    // Any unit quaternion: v * matrix should be q v q*, its vector part v + 2w(u x v) + 2u x (u x v).
+    for (uint32_t i = 0; i < 1000; i++)
+    {
+        float q[4] = { RandomFloat(&state, 2.0f), RandomFloat(&state, 2.0f), RandomFloat(&state, 2.0f), RandomFloat(&state, 2.0f) };
+        float length = sqrtf(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+        RigidPose pose = { { q[0] / length, q[1] / length, q[2] / length, q[3] / length }, { 0.0f, 0.0f, 0.0f } };
+        float v[3] = { RandomFloat(&state, 2.0f), RandomFloat(&state, 2.0f), RandomFloat(&state, 2.0f) };
+        float const* u = pose.rotation;
+        float w = pose.rotation[3];
+        float t[3] = { 2.0f * (u[1] * v[2] - u[2] * v[1]), 2.0f * (u[2] * v[0] - u[0] * v[2]), 2.0f * (u[0] * v[1] - u[1] * v[0]) };
+        float rotated[3] =
+        {
+            v[0] + w * t[0] + (u[1] * t[2] - u[2] * t[1]),
+            v[1] + w * t[1] + (u[2] * t[0] - u[0] * t[2]),
+            v[2] + w * t[2] + (u[0] * t[1] - u[1] * t[0]),
+        };
+
+        MatrixFromPose(&local, pose);
+
+        for (int j = 0; j < 3; j++)
+        {
+            float transformed = v[0] * local.m[0][j] + v[1] * local.m[1][j] + v[2] * local.m[2][j];
+
+            if (fabsf(transformed - rotated[j]) > 1e-4f)
+            {
+                printf("FAILED: pose %u rotates component %d to %f rather than %f\n", i, j, transformed, rotated[j]);
+                return 1;
+            }
+        }
+    }
+
+    printf("%u objects posed in place: ok\n", objects);
+
+    return 0;
+}
+
+
+static int Check(uint32_t objects)
+{
+    SceneStore store;
+    vector<SceneHandle> roots, all;
+    vector<SceneHandle> parentOf;
+    Matrix4 local;
+    uint32_t state = 3;
+
+    // Record each object's parent by rebuilding the same hierarchy shape.
+    BuildHierarchy(&store, objects, 4, 3, &roots, &all);
+    parentOf.resize(store.SlotCount());
+
+    for (uint32_t i = 0, next = 0; i < roots.size(); i++)
+    {
+        uint32_t root = next++;
+
+        for (uint32_t c = 0; c < 4 && next < all.size(); c++)
+        {
+            uint32_t child = next++;
+
+            parentOf[all[child].index] = all[root];
+
+            for (uint32_t g = 0; g < 3 && next < all.size(); g++)
+            {
+                parentOf[all[next++].index] = all[child];
+            }
+        }
+    }
+
+    store.UpdateTransforms();
+
+    if (!CheckWorlds(store, parentOf))
+    {
+        return 1;
+    }
+
+    // Move a few objects, then destroy a few subtrees.
+    for (uint32_t i = 0; i < objects / 10; i++)
+    {
+        SceneHandle handle = all[Random(&state) % all.size()];
+
+        MatrixRotationY(&local, RandomFloat(&state, 6.0f), 1.0f, 2.0f, 3.0f);
+        store.SetLocal(handle, local);
+    }
+
+    store.UpdateTransforms();
+
+    if (!CheckWorlds(store, parentOf))
+    {
+        return 1;
+    }
+
+    vector<SceneHandle> destroyed;
+
+    for (uint32_t i = 0; i < 20 && i < roots.size(); i++)
+    {
+        SceneHandle root = roots[Random(&state) % roots.size()];
+
+        if (store.IsValid(root))
+        {
+            store.Destroy(root);
+            destroyed.push_back(root);
+        }
+    }
+
+    for (uint32_t i = 0; i < all.size(); i++)
+    {
+        SceneHandle ancestor = all[i];
+
+        // Anything under a destroyed root has gone with it.
+        while (!parentOf[ancestor.index].IsNull())
+        {
+            ancestor = parentOf[ancestor.index];
+        }
+
+        if (store.IsValid(all[i]) == (find(destroyed.begin(), destroyed.end(), ancestor) != destroyed.end()))
+        {
+            printf("FAILED: object %u should %s\n", all[i].index, store.IsValid(all[i]) ? "have been destroyed" : "still exist");
+            return 1;
+        }
+    }
+
+    // Freed slots are reused with a new generation, so the old handles stay invalid.
+    MatrixIdentity(&local);
+
+    for (uint32_t i = 0; i < destroyed.size(); i++)
+    {
+        SceneHandle handle = store.Create(local);
+
+        if (handle.index >= parentOf.size())
+        {
+            parentOf.resize(handle.index + 1);
+        }
+
+        parentOf[handle.index] = SceneHandle();
+    }
+
+    for (uint32_t i = 0; i < destroyed.size(); i++)
+    {
+        if (store.IsValid(destroyed[i]))
+        {
+            printf("FAILED: destroyed handle %u is valid again\n", destroyed[i].index);
+            return 1;
+        }
+    }
+
+    store.UpdateTransforms();
+
+    if (!CheckWorlds(store, parentOf))
+    {
+        return 1;
+    }
+
+    printf("%u objects, %u after destroying %u subtrees: ok\n", objects, store.Size(), (uint32_t)destroyed.size());
+
+    if (CheckCull(objects))
+    {
+        return 1;
+    }
+
+    return CheckPoses(objects);
+}
+
+
+static int Usage()
+{
+    printf("Usage: scenebench bench|cull|check [-n frames] [-c objects]\n");
+
+    return 2;
+}
+
+
+int main(int argc, char* argv[])
+{
+    uint32_t objects = 100000;
+    int frames = 200;
+    int i;
+
+    if (argc < 2)
+    {
+        return Usage();
+    }
+
+    string command = argv[1];
+
+    for (i = 2; i < argc; i++)
+    {
+        string option = argv[i];
+
+        if (i + 1 >= argc)
+        {
+            return Usage();
+        }
+
+        if (option == "-n")
+        {
+            frames = max(1, atoi(argv[++i]));
+        }
+        else if (option == "-c")
+        {
+            objects = (uint32_t)max(1, atoi(argv[++i]));
+        }
+        else
+        {
+            return Usage();
+        }
+    }
+
+    if (command == "bench")
+    {
+        return Bench(objects, frames);
+    }
+
+    if (command == "cull")
+    {
+        return BenchCull(objects, frames);
+    }
+
+    if (command == "check")
+    {
+        return Check(objects);
+    }
+
+    return Usage();
+}
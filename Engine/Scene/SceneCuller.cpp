@@ -0,0 +1,522 @@
+#include "SceneCuller.h"
+
+#include <algorithm>
+#include <limits>
+
+#ifdef SCENE_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+
+// Objects with no bounds are given a radius that is huge, but small enough that the box
+// arithmetic stays finite.
+static float const UnboundedRadius = 1e30f;
+
+// The leaves are refit in batches of this many per task.
+static uint32_t const LeavesPerTask = 64;
+
+
+void ExtractFrustum(Matrix4 const& viewProj, Frustum* frustum)
+{
+    float const (*m)[4] = viewProj.m;
+    int i, j;
+
+    // Each plane is a sum or difference of the matrix's columns: w + x, w - x, w + y, w - y, z and w - z.
+    for (i = 0; i < 4; i++)
+    {
+        frustum->planes[0][i] = m[i][3] + m[i][0];
+        frustum->planes[1][i] = m[i][3] - m[i][0];
+        frustum->planes[2][i] = m[i][3] + m[i][1];
+        frustum->planes[3][i] = m[i][3] - m[i][1];
+        frustum->planes[4][i] = m[i][2];
+        frustum->planes[5][i] = m[i][3] - m[i][2];
+    }
+
+    for (j = 0; j < 6; j++)
+    {
+        float* plane = frustum->planes[j];
+        float length = sqrtf(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+
+        if (length > 0.0f)
+        {
+            for (i = 0; i < 4; i++)
+            {
+                plane[i] /= length;
+            }
+        }
+    }
+}
+
+
+// Spreads the low 10 bits of value out to every third bit.
+static uint32_t SpreadBits(uint32_t value)
+{
+    value &= 0x3FF;
+    value = (value | (value << 16)) & 0x030000FF;
+    value = (value | (value << 8)) & 0x0300F00F;
+    value = (value | (value << 4)) & 0x030C30C3;
+    value = (value | (value << 2)) & 0x09249249;
+
+    return value;
+}
+
+
+SceneCuller::SceneCuller(WorkerPool* pool)
+    : pool(pool), builtVersion(~0u), refitUpdateNumber(0), objectCount(0), unboundedCount(0), builtLeafArea(0.0f), leafBase(1)
+{
+}
+
+
+void SceneCuller::Cull(SceneStore const& store, Matrix4 const& viewProj, vector<uint32_t>* visible)
+{
+    bool isRebuilt = false;
+    Frustum frustum;
+    uint32_t i;
+
+    visible->clear();
+
+    if (store.Version() != builtVersion)
+    {
+        Build(store);
+        isRebuilt = true;
+    }
+
+    if (!objectCount)
+    {
+        return;
+    }
+
+    // Refit the leaves to where their objects are now, if anything has moved. Objects that have
+    // gained or lost their bounds, or leaves that have spread out well beyond their size when
+    // built, mean the Morton order no longer fits, so start again.
+    if (isRebuilt || store.UpdateNumber() != refitUpdateNumber)
+    {
+        RefitAllLeaves(store);
+
+        if (!isRebuilt && (CountUnbounded() != unboundedCount || LeafArea() > 2.0f * builtLeafArea))
+        {
+            Build(store);
+            RefitAllLeaves(store);
+            isRebuilt = true;
+        }
+
+        if (isRebuilt)
+        {
+            builtLeafArea = LeafArea();
+        }
+
+        RefitNodes();
+        refitUpdateNumber = store.UpdateNumber();
+    }
+
+    // Search the subtrees a few levels down in parallel, enough of them to keep every thread busy.
+    uint32_t firstNode = 1;
+    uint32_t threadCount = pool ? pool->ThreadCount() : 1;
+
+    ExtractFrustum(viewProj, &frustum);
+
+    while (firstNode < leafBase && firstNode < threadCount * 4)
+    {
+        firstNode *= 2;
+    }
+
+    taskResults.resize(firstNode);
+
+    RunTasks(firstNode, [&](uint32_t task)
+    {
+        taskResults[task].clear();
+        Search(frustum, firstNode + task, &taskResults[task]);
+    });
+
+    for (i = 0; i < firstNode; i++)
+    {
+        visible->insert(visible->end(), taskResults[i].begin(), taskResults[i].end());
+    }
+}
+
+
+void SceneCuller::RunTasks(uint32_t taskCount, function<void(uint32_t)> const& task)
+{
+    if (pool)
+    {
+        pool->Run(taskCount, task);
+        return;
+    }
+
+    for (uint32_t i = 0; i < taskCount; i++)
+    {
+        task(i);
+    }
+}
+
+
+void SceneCuller::RefitAllLeaves(SceneStore const& store)
+{
+    uint32_t leafCount = (objectCount + LeafSize - 1) / LeafSize;
+
+    RunTasks((leafCount + LeavesPerTask - 1) / LeavesPerTask, [&](uint32_t task)
+    {
+        RefitLeaves(store, task * LeavesPerTask, min(LeavesPerTask, leafCount - task * LeavesPerTask));
+    });
+}
+
+
+uint32_t SceneCuller::CountUnbounded() const
+{
+    uint32_t count = 0;
+
+    for (uint32_t i = 0; i < objectCount; i++)
+    {
+        if (sphereRadius[i] >= UnboundedRadius)
+        {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+
+// Total surface area of the leaves (halved), ignoring those holding unbounded objects.
+float SceneCuller::LeafArea() const
+{
+    uint32_t leafCount = (objectCount + LeafSize - 1) / LeafSize;
+    float area = 0.0f;
+
+    for (uint32_t i = leafBase; i < leafBase + leafCount; i++)
+    {
+        float x = boxMax[0][i] - boxMin[0][i];
+        float y = boxMax[1][i] - boxMin[1][i];
+        float z = boxMax[2][i] - boxMin[2][i];
+
+        if (x < UnboundedRadius && y < UnboundedRadius && z < UnboundedRadius)
+        {
+            area += x * y + y * z + z * x;
+        }
+    }
+
+    return area;
+}
+
+
+void SceneCuller::Build(SceneStore const& store)
+{
+    float const* x = store.WorldBoundsX();
+    float const* y = store.WorldBoundsY();
+    float const* z = store.WorldBoundsZ();
+    float const* radius = store.WorldBoundsRadius();
+    float minimum[3], maximum[3], scale[3];
+    vector<uint64_t> keys;
+    uint32_t leafCount, paddedCount;
+    uint32_t i;
+    int axis;
+
+    objectCount = store.Size();
+    builtVersion = store.Version();
+    unboundedCount = 0;
+
+    // Find the extent of the bounded objects, to quantize their positions within.
+    for (axis = 0; axis < 3; axis++)
+    {
+        minimum[axis] = numeric_limits<float>::max();
+        maximum[axis] = -numeric_limits<float>::max();
+    }
+
+    for (i = 0; i < objectCount; i++)
+    {
+        float center[3] = {x[i], y[i], z[i]};
+
+        if (!(radius[i] < UnboundedRadius))
+        {
+            unboundedCount++;
+            continue;
+        }
+
+        for (axis = 0; axis < 3; axis++)
+        {
+            minimum[axis] = min(minimum[axis], center[axis]);
+            maximum[axis] = max(maximum[axis], center[axis]);
+        }
+    }
+
+    for (axis = 0; axis < 3; axis++)
+    {
+        scale[axis] = (maximum[axis] > minimum[axis]) ? 1023.0f / (maximum[axis] - minimum[axis]) : 0.0f;
+    }
+
+    // Sort by Morton code, with the dense index in the low bits to keep the order stable.
+    // Unbounded objects go at the end, so they share as few leaves as possible.
+    keys.resize(objectCount);
+
+    for (i = 0; i < objectCount; i++)
+    {
+        uint32_t code = 0xFFFFFFFF;
+
+        if (radius[i] < UnboundedRadius)
+        {
+            code = SpreadBits((uint32_t)((x[i] - minimum[0]) * scale[0])) |
+                (SpreadBits((uint32_t)((y[i] - minimum[1]) * scale[1])) << 1) |
+                (SpreadBits((uint32_t)((z[i] - minimum[2]) * scale[2])) << 2);
+        }
+
+        keys[i] = ((uint64_t)code << 32) | i;
+    }
+
+    sort(keys.begin(), keys.end());
+
+    order.resize(objectCount);
+
+    for (i = 0; i < objectCount; i++)
+    {
+        order[i] = (uint32_t)keys[i];
+    }
+
+    // Size the tree for a power of two number of leaves.
+    leafCount = (objectCount + LeafSize - 1) / LeafSize;
+    leafBase = 1;
+
+    while (leafBase < leafCount)
+    {
+        leafBase *= 2;
+    }
+
+    for (axis = 0; axis < 3; axis++)
+    {
+        boxMin[axis].assign(2 * leafBase, numeric_limits<float>::max());
+        boxMax[axis].assign(2 * leafBase, -numeric_limits<float>::max());
+    }
+
+    // Padding spheres have a radius of minus infinity, so fail every plane test.
+    paddedCount = (objectCount + 3) & ~3u;
+
+    sphereX.assign(paddedCount, 0.0f);
+    sphereY.assign(paddedCount, 0.0f);
+    sphereZ.assign(paddedCount, 0.0f);
+    sphereRadius.assign(paddedCount, -numeric_limits<float>::infinity());
+}
+
+
+void SceneCuller::RefitLeaves(SceneStore const& store, uint32_t firstLeaf, uint32_t leafCount)
+{
+    float const* x = store.WorldBoundsX();
+    float const* y = store.WorldBoundsY();
+    float const* z = store.WorldBoundsZ();
+    float const* radius = store.WorldBoundsRadius();
+    uint32_t leaf, i;
+
+    for (leaf = firstLeaf; leaf < firstLeaf + leafCount; leaf++)
+    {
+        uint32_t start = leaf * LeafSize;
+        uint32_t end = min(start + LeafSize, objectCount);
+        float minimum[3], maximum[3];
+        int axis;
+
+        for (axis = 0; axis < 3; axis++)
+        {
+            minimum[axis] = numeric_limits<float>::max();
+            maximum[axis] = -numeric_limits<float>::max();
+        }
+
+        // Gather each sphere into tree order, growing the leaf's box around it.
+        for (i = start; i < end; i++)
+        {
+            uint32_t object = order[i];
+            float r = min(radius[object], UnboundedRadius);
+
+            sphereX[i] = x[object];
+            sphereY[i] = y[object];
+            sphereZ[i] = z[object];
+            sphereRadius[i] = r;
+
+            minimum[0] = min(minimum[0], x[object] - r);
+            minimum[1] = min(minimum[1], y[object] - r);
+            minimum[2] = min(minimum[2], z[object] - r);
+            maximum[0] = max(maximum[0], x[object] + r);
+            maximum[1] = max(maximum[1], y[object] + r);
+            maximum[2] = max(maximum[2], z[object] + r);
+        }
+
+        for (axis = 0; axis < 3; axis++)
+        {
+            boxMin[axis][leafBase + leaf] = minimum[axis];
+            boxMax[axis][leafBase + leaf] = maximum[axis];
+        }
+    }
+}
+
+
+void SceneCuller::RefitNodes()
+{
+    uint32_t node;
+    int axis;
+
+    for (node = leafBase - 1; node >= 1; node--)
+    {
+        for (axis = 0; axis < 3; axis++)
+        {
+            boxMin[axis][node] = min(boxMin[axis][2 * node], boxMin[axis][2 * node + 1]);
+            boxMax[axis][node] = max(boxMax[axis][2 * node], boxMax[axis][2 * node + 1]);
+        }
+    }
+}
+
+
+void SceneCuller::Search(Frustum const& frustum, uint32_t node, vector<uint32_t>* visible) const
+{
+    bool isInside = true;
+    int i;
+
+    // Empty subtree.
+    if (boxMin[0][node] > boxMax[0][node])
+    {
+        return;
+    }
+
+    // For each plane, test the corner of the box furthest along the plane's normal (if that is
+    // outside, the whole box is) and the nearest corner (if that is inside, so is the box).
+    for (i = 0; i < 6; i++)
+    {
+        float const* plane = frustum.planes[i];
+        float furthest = plane[3], nearest = plane[3];
+        int axis;
+
+        for (axis = 0; axis < 3; axis++)
+        {
+            if (plane[axis] >= 0.0f)
+            {
+                furthest += plane[axis] * boxMax[axis][node];
+                nearest += plane[axis] * boxMin[axis][node];
+            }
+            else
+            {
+                furthest += plane[axis] * boxMin[axis][node];
+                nearest += plane[axis] * boxMax[axis][node];
+            }
+        }
+
+        if (furthest < 0.0f)
+        {
+            return;
+        }
+
+        if (nearest < 0.0f)
+        {
+            isInside = false;
+        }
+    }
+
+    if (node >= leafBase)
+    {
+        if (isInside)
+        {
+            AddLeafObjects(node - leafBase, visible);
+        }
+        else
+        {
+            TestLeafObjects(frustum, node - leafBase, visible);
+        }
+
+        return;
+    }
+
+    if (isInside)
+    {
+        // Take every leaf under the node without testing anything further.
+        uint32_t first = node, count = 1;
+
+        while (first < leafBase)
+        {
+            first *= 2;
+            count *= 2;
+        }
+
+        for (uint32_t leaf = first; leaf < first + count; leaf++)
+        {
+            if (boxMin[0][leaf] <= boxMax[0][leaf])
+            {
+                AddLeafObjects(leaf - leafBase, visible);
+            }
+        }
+
+        return;
+    }
+
+    Search(frustum, 2 * node, visible);
+    Search(frustum, 2 * node + 1, visible);
+}
+
+
+void SceneCuller::AddLeafObjects(uint32_t leaf, vector<uint32_t>* visible) const
+{
+    uint32_t start = leaf * LeafSize;
+    uint32_t end = min(start + LeafSize, objectCount);
+
+    visible->insert(visible->end(), order.begin() + start, order.begin() + end);
+}
+
+
+void SceneCuller::TestLeafObjects(Frustum const& frustum, uint32_t leaf, vector<uint32_t>* visible) const
+{
+    uint32_t start = leaf * LeafSize;
+    uint32_t end = min(start + LeafSize, objectCount);
+    uint32_t i;
+
+#ifdef SCENE_USE_SSE
+    __m128 planes[6][4];
+    int p, lane;
+
+    for (p = 0; p < 6; p++)
+    {
+        for (lane = 0; lane < 4; lane++)
+        {
+            planes[p][lane] = _mm_set1_ps(frustum.planes[p][lane]);
+        }
+    }
+
+    // Four spheres at a time; a sphere is outside if it is entirely behind any one plane.
+    for (i = start; i < end; i += 4)
+    {
+        __m128 x = _mm_load_ps(&sphereX[i]);
+        __m128 y = _mm_load_ps(&sphereY[i]);
+        __m128 z = _mm_load_ps(&sphereZ[i]);
+        __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_load_ps(&sphereRadius[i]));
+        __m128 outside = _mm_setzero_ps();
+
+        for (p = 0; p < 6; p++)
+        {
+            __m128 distance = _mm_add_ps(_mm_mul_ps(planes[p][0], x), planes[p][3]);
+
+            distance = _mm_add_ps(distance, _mm_mul_ps(planes[p][1], y));
+            distance = _mm_add_ps(distance, _mm_mul_ps(planes[p][2], z));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negativeRadius));
+        }
+
+        int mask = _mm_movemask_ps(outside);
+
+        for (lane = 0; lane < 4; lane++)
+        {
+            if (!(mask & (1 << lane)) && i + lane < end)
+            {
+                visible->push_back(order[i + lane]);
+            }
+        }
+    }
+#else
+    for (i = start; i < end; i++)
+    {
+        bool isOutside = false;
+
+        for (int p = 0; p < 6 && !isOutside; p++)
+        {
+            float const* plane = frustum.planes[p];
+
+            isOutside = plane[0] * sphereX[i] + plane[1] * sphereY[i] + plane[2] * sphereZ[i] + plane[3] < -sphereRadius[i];
+        }
+
+        if (!isOutside)
+        {
+            visible->push_back(order[i]);
+        }
+    }
+#endif
+}
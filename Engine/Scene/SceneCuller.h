@@ -0,0 +1,83 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "SceneStore.h"
+#include "WorkerPool.h"
+
+using namespace std;
+
+
+// The six planes of a view frustum, normalized, with a, b, c, d such that points inside
+// satisfy ax + by + cz + d >= 0.
+struct Frustum
+{
+    float planes[6][4];
+};
+
+
+// Planes of the frustum of a D3D style view projection matrix (row vectors, 0 <= z <= w).
+void ExtractFrustum(Matrix4 const& viewProj, Frustum* frustum);
+
+
+// Finds the objects in a SceneStore whose world bounds touch a view frustum. The bounds are
+// kept in a bounding volume hierarchy: a complete binary tree over leaves of a few dozen
+// objects, in Morton order so each leaf covers a compact region of space. Each frame the
+// tree is refit to where the objects have moved, and only rebuilt when objects come or go
+// or the leaves have spread too far. Whole subtrees outside the frustum are skipped, whole
+// subtrees inside are accepted, and objects in the leaves in between are tested four at a
+// time. Both the refit and the search are split across a WorkerPool, if one is given.
+class SceneCuller
+{
+public:
+    explicit SceneCuller(WorkerPool* pool = 0);
+
+    // Fills visible with the dense index of every visible object, in no particular order.
+    // The store's transforms must be up to date.
+    void Cull(SceneStore const& store, Matrix4 const& viewProj, vector<uint32_t>* visible);
+
+    // Forces the next Cull to rebuild the hierarchy.
+    void Invalidate() { builtVersion = ~0u; }
+
+private:
+    static uint32_t const LeafSize = 32;
+
+    typedef SceneStore::FloatArray FloatArray;
+
+    void RunTasks(uint32_t taskCount, function<void(uint32_t)> const& task);
+    void Build(SceneStore const& store);
+    void RefitAllLeaves(SceneStore const& store);
+    void RefitLeaves(SceneStore const& store, uint32_t firstLeaf, uint32_t leafCount);
+    void RefitNodes();
+    uint32_t CountUnbounded() const;
+    float LeafArea() const;
+    void Search(Frustum const& frustum, uint32_t node, vector<uint32_t>* visible) const;
+    void AddLeafObjects(uint32_t leaf, vector<uint32_t>* visible) const;
+    void TestLeafObjects(Frustum const& frustum, uint32_t leaf, vector<uint32_t>* visible) const;
+
+    WorkerPool* pool;
+
+    // The store as of the last build.
+    uint32_t builtVersion;
+    uint32_t refitUpdateNumber;
+    uint32_t objectCount;
+    uint32_t unboundedCount;
+    float builtLeafArea;
+
+    // Dense indices in Morton order; leaf i holds objects [i * LeafSize, (i + 1) * LeafSize).
+    vector<uint32_t> order;
+
+    // Bounding spheres gathered into that order, padded to a multiple of four with spheres
+    // that are outside everything.
+    FloatArray sphereX, sphereY, sphereZ, sphereRadius;
+
+    // Node boxes. Node 1 is the root, node i has children 2i and 2i + 1, and the leaves are
+    // nodes leafBase to 2 * leafBase - 1. Unused leaves have empty (inverted) boxes.
+    uint32_t leafBase;
+    vector<float> boxMin[3];
+    vector<float> boxMax[3];
+
+    // Filled in by the search tasks, then joined.
+    vector<vector<uint32_t>> taskResults;
+};
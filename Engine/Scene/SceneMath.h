@@ -0,0 +1,138 @@
+#pragma once
+
+#include <math.h>
+#include <string.h>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1) || defined(__SSE__)
+#define SCENE_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#define SCENE_ALIGN16 __declspec(align(16))
+#else
+#define SCENE_ALIGN16 __attribute__((aligned(16)))
+#endif
+
+
+// Row major 4x4 matrix for row vectors, laid out exactly like D3DXMATRIX so the engine can
+// use the two interchangeably.
+struct SCENE_ALIGN16 Matrix4
+{
+    float m[4][4];
+};
+
+
+// Sphere bounding an object. A negative radius means the object has no bounds, so is never culled.
+struct BoundingSphere
+{
+    float x, y, z;
+    float radius;
+};
+
+
+// Where a rigid body is: a unit quaternion (x, y, z, w) then a position, laid out as PhysX's
+// PxTransform.
+struct RigidPose
+{
+    float rotation[4];
+    float position[3];
+};
+
+
+inline void MatrixIdentity(Matrix4* result)
+{
+    memset(result, 0, sizeof(*result));
+
+    result->m[0][0] = result->m[1][1] = result->m[2][2] = result->m[3][3] = 1.0f;
+}
+
+
+inline void MatrixTranslation(Matrix4* result, float x, float y, float z)
+{
+    MatrixIdentity(result);
+
+    result->m[3][0] = x;
+    result->m[3][1] = y;
+    result->m[3][2] = z;
+}
+
+
+// The rotation then the translation of a pose, as D3DXMatrixAffineTransformation with no
+// scaling or center.
+inline void MatrixFromPose(Matrix4* result, RigidPose const& pose)
+{
+    float x = pose.rotation[0], y = pose.rotation[1], z = pose.rotation[2], w = pose.rotation[3];
+
+    result->m[0][0] = 1.0f - 2.0f * (y * y + z * z);
+    result->m[0][1] = 2.0f * (x * y + w * z);
+    result->m[0][2] = 2.0f * (x * z - w * y);
+    result->m[0][3] = 0.0f;
+    result->m[1][0] = 2.0f * (x * y - w * z);
+    result->m[1][1] = 1.0f - 2.0f * (x * x + z * z);
+    result->m[1][2] = 2.0f * (y * z + w * x);
+    result->m[1][3] = 0.0f;
+    result->m[2][0] = 2.0f * (x * z + w * y);
+    result->m[2][1] = 2.0f * (y * z - w * x);
+    result->m[2][2] = 1.0f - 2.0f * (x * x + y * y);
+    result->m[2][3] = 0.0f;
+    result->m[3][0] = pose.position[0];
+    result->m[3][1] = pose.position[1];
+    result->m[3][2] = pose.position[2];
+    result->m[3][3] = 1.0f;
+}
+
+
+// result = a * b, so a is applied first. result may not alias a or b.
+inline void MatrixMultiply(Matrix4* result, Matrix4 const& a, Matrix4 const& b)
+{
+#ifdef SCENE_USE_SSE
+    __m128 b0 = _mm_load_ps(b.m[0]);
+    __m128 b1 = _mm_load_ps(b.m[1]);
+    __m128 b2 = _mm_load_ps(b.m[2]);
+    __m128 b3 = _mm_load_ps(b.m[3]);
+
+    // Each row of the result is a's row weighting the rows of b.
+    for (int i = 0; i < 4; i++)
+    {
+        __m128 row = _mm_mul_ps(_mm_set1_ps(a.m[i][0]), b0);
+
+        row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a.m[i][1]), b1));
+        row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a.m[i][2]), b2));
+        row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a.m[i][3]), b3));
+
+        _mm_store_ps(result->m[i], row);
+    }
+#else
+    for (int i = 0; i < 4; i++)
+    {
+        for (int j = 0; j < 4; j++)
+        {
+            result->m[i][j] = a.m[i][0] * b.m[0][j] + a.m[i][1] * b.m[1][j] + a.m[i][2] * b.m[2][j] + a.m[i][3] * b.m[3][j];
+        }
+    }
+#endif
+}
+
+
+// Sphere bounding the transformed sphere. Scales along each axis can differ, so the radius
+// grows by the largest of them.
+inline void TransformBoundingSphere(BoundingSphere* result, BoundingSphere const& sphere, Matrix4 const& matrix)
+{
+    float scale = 0.0f;
+
+    for (int i = 0; i < 3; i++)
+    {
+        float lengthSquared = matrix.m[i][0] * matrix.m[i][0] + matrix.m[i][1] * matrix.m[i][1] + matrix.m[i][2] * matrix.m[i][2];
+
+        if (lengthSquared > scale)
+        {
+            scale = lengthSquared;
+        }
+    }
+
+    result->x = sphere.x * matrix.m[0][0] + sphere.y * matrix.m[1][0] + sphere.z * matrix.m[2][0] + matrix.m[3][0];
+    result->y = sphere.x * matrix.m[0][1] + sphere.y * matrix.m[1][1] + sphere.z * matrix.m[2][1] + matrix.m[3][1];
+    result->z = sphere.x * matrix.m[0][2] + sphere.y * matrix.m[1][2] + sphere.z * matrix.m[2][2] + matrix.m[3][2];
+    result->radius = sphere.radius * sqrtf(scale);
+}
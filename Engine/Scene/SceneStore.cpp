@@ -0,0 +1,288 @@
+#include "SceneStore.h"
+
+#include <limits>
+#include <stdexcept>
+
+
+SceneStore::SceneStore()
+    : firstFreeSlot(NoSlot), hasDirty(false), version(0), updateNumber(0)
+{
+}
+
+
+SceneHandle SceneStore::Create(Matrix4 const& local, SceneHandle parent)
+{
+    uint32_t parentIndex = NoParent;
+    uint32_t denseIndex = (uint32_t)handles.size();
+    uint32_t slot;
+
+    if (!parent.IsNull())
+    {
+        parentIndex = DenseIndex(parent);
+    }
+
+    // Reuse a free slot if there is one.
+    if (firstFreeSlot != NoSlot)
+    {
+        slot = firstFreeSlot;
+        firstFreeSlot = slotDense[slot];
+        slotDense[slot] = denseIndex;
+    }
+    else
+    {
+        slot = (uint32_t)slotDense.size();
+        slotDense.push_back(denseIndex);
+        slotGeneration.push_back(1);
+    }
+
+    // New objects go on the end, after their parent.
+    handles.push_back(SceneHandle(slot, slotGeneration[slot]));
+    parents.push_back(parentIndex);
+    flags.push_back(FlagDirty);
+    BoundingSphere noBounds = {0.0f, 0.0f, 0.0f, -1.0f};
+
+    locals.push_back(local);
+    worlds.push_back(local);
+    localBounds.push_back(noBounds);
+    boundsX.push_back(0.0f);
+    boundsY.push_back(0.0f);
+    boundsZ.push_back(0.0f);
+    boundsRadius.push_back(numeric_limits<float>::infinity());
+
+    hasDirty = true;
+    version++;
+
+    return handles.back();
+}
+
+
+void SceneStore::Destroy(SceneHandle handle)
+{
+    uint32_t denseIndex = DenseIndex(handle);
+    uint32_t i;
+
+    // Descendants all come after the object, and after their own parents, so one pass forward finds them all.
+    flags[denseIndex] |= FlagDestroyed;
+
+    for (i = denseIndex + 1; i < handles.size(); i++)
+    {
+        if (parents[i] != NoParent && (flags[parents[i]] & FlagDestroyed))
+        {
+            flags[i] |= FlagDestroyed;
+        }
+    }
+
+    Compact();
+}
+
+
+void SceneStore::Clear()
+{
+    uint32_t i;
+
+    for (i = 0; i < handles.size(); i++)
+    {
+        ReleaseSlot(i);
+    }
+
+    handles.clear();
+    parents.clear();
+    flags.clear();
+    locals.clear();
+    worlds.clear();
+    localBounds.clear();
+    boundsX.clear();
+    boundsY.clear();
+    boundsZ.clear();
+    boundsRadius.clear();
+
+    hasDirty = false;
+    version++;
+}
+
+
+bool SceneStore::IsValid(SceneHandle handle) const
+{
+    return !handle.IsNull() && handle.index < slotGeneration.size() && slotGeneration[handle.index] == handle.generation;
+}
+
+
+uint32_t SceneStore::DenseIndex(SceneHandle handle) const
+{
+    if (!IsValid(handle))
+    {
+        throw invalid_argument("SceneStore: handle is not in the scene");
+    }
+
+    return slotDense[handle.index];
+}
+
+
+void SceneStore::SetLocal(SceneHandle handle, Matrix4 const& local)
+{
+    uint32_t denseIndex = DenseIndex(handle);
+
+    locals[denseIndex] = local;
+    flags[denseIndex] |= FlagDirty;
+
+    hasDirty = true;
+}
+
+
+Matrix4& SceneStore::EditLocal(SceneHandle handle)
+{
+    uint32_t denseIndex = DenseIndex(handle);
+
+    flags[denseIndex] |= FlagDirty;
+    hasDirty = true;
+
+    return locals[denseIndex];
+}
+
+
+Matrix4 const& SceneStore::GetLocal(SceneHandle handle) const
+{
+    return locals[DenseIndex(handle)];
+}
+
+
+Matrix4 const& SceneStore::GetWorld(SceneHandle handle) const
+{
+    return worlds[DenseIndex(handle)];
+}
+
+
+void SceneStore::SetLocalBounds(SceneHandle handle, BoundingSphere const& bounds)
+{
+    uint32_t denseIndex = DenseIndex(handle);
+
+    localBounds[denseIndex] = bounds;
+    flags[denseIndex] |= FlagDirty;
+
+    hasDirty = true;
+}
+
+
+void SceneStore::UpdateTransforms()
+{
+    uint32_t count = (uint32_t)handles.size();
+    uint8_t* flag = flags.data();
+    uint32_t const* parent = parents.data();
+    Matrix4 const* local = locals.data();
+    Matrix4* world = worlds.data();
+    uint32_t i;
+
+    if (!hasDirty)
+    {
+        return;
+    }
+
+    // Parents come first, so by the time an object is reached its parent's world transform
+    // is already up to date, and its Changed flag says whether the object needs redoing.
+    for (i = 0; i < count; i++)
+    {
+        uint32_t p = parent[i];
+        bool changed = (flag[i] & FlagDirty) || (p != NoParent && (flag[p] & FlagChanged));
+
+        if (changed)
+        {
+            if (p == NoParent)
+            {
+                world[i] = local[i];
+            }
+            else
+            {
+                MatrixMultiply(&world[i], local[i], world[p]);
+            }
+
+            UpdateBounds(i);
+        }
+
+        flag[i] = changed ? FlagChanged : 0;
+    }
+
+    hasDirty = false;
+    updateNumber++;
+}
+
+
+void SceneStore::UpdateBounds(uint32_t denseIndex)
+{
+    BoundingSphere bounds;
+
+    if (localBounds[denseIndex].radius < 0.0f)
+    {
+        boundsRadius[denseIndex] = numeric_limits<float>::infinity();
+        return;
+    }
+
+    TransformBoundingSphere(&bounds, localBounds[denseIndex], worlds[denseIndex]);
+
+    boundsX[denseIndex] = bounds.x;
+    boundsY[denseIndex] = bounds.y;
+    boundsZ[denseIndex] = bounds.z;
+    boundsRadius[denseIndex] = bounds.radius;
+}
+
+
+void SceneStore::ReleaseSlot(uint32_t denseIndex)
+{
+    uint32_t slot = handles[denseIndex].index;
+
+    // Skip generation 0, so a null handle never matches.
+    if (++slotGeneration[slot] == 0)
+    {
+        slotGeneration[slot] = 1;
+    }
+
+    slotDense[slot] = firstFreeSlot;
+    firstFreeSlot = slot;
+}
+
+
+// Removes destroyed objects from the arrays, keeping the rest in order so parents still come first.
+void SceneStore::Compact()
+{
+    uint32_t count = (uint32_t)handles.size();
+    vector<uint32_t> newIndex(count);
+    uint32_t remaining = 0;
+    uint32_t i;
+
+    for (i = 0; i < count; i++)
+    {
+        if (flags[i] & FlagDestroyed)
+        {
+            ReleaseSlot(i);
+            continue;
+        }
+
+        newIndex[i] = remaining;
+
+        handles[remaining] = handles[i];
+        parents[remaining] = (parents[i] == NoParent) ? NoParent : newIndex[parents[i]];
+        flags[remaining] = flags[i];
+        locals[remaining] = locals[i];
+        worlds[remaining] = worlds[i];
+        localBounds[remaining] = localBounds[i];
+        boundsX[remaining] = boundsX[i];
+        boundsY[remaining] = boundsY[i];
+        boundsZ[remaining] = boundsZ[i];
+        boundsRadius[remaining] = boundsRadius[i];
+
+        slotDense[handles[remaining].index] = remaining;
+        remaining++;
+    }
+
+    handles.resize(remaining);
+    parents.resize(remaining);
+    flags.resize(remaining);
+    locals.resize(remaining);
+    worlds.resize(remaining);
+    localBounds.resize(remaining);
+    boundsX.resize(remaining);
+    boundsY.resize(remaining);
+    boundsZ.resize(remaining);
+    boundsRadius.resize(remaining);
+
+    version++;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "AlignedAllocator.h"
+#include "SceneMath.h"
+
+using namespace std;
+
+
+// Refers to an object in a SceneStore. The generation changes each time a slot is reused, so
+// a handle to a destroyed object stays invalid even once something else takes its place.
+struct SceneHandle
+{
+    SceneHandle() : index(0), generation(0) { }
+    SceneHandle(uint32_t index, uint32_t generation) : index(index), generation(generation) { }
+
+    bool IsNull() const { return generation == 0; }
+
+    bool operator==(SceneHandle const& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(SceneHandle const& other) const { return !(*this == other); }
+
+    uint32_t index;         // Slot, which never moves while the object is alive.
+    uint32_t generation;    // Never 0 for a live object.
+};
+
+
+// Transforms for every object in a scene, stored as parallel arrays rather than one heap
+// allocation per object. Objects are kept in the arrays in creation order, so a parent always
+// comes before its children and UpdateTransforms can resolve the hierarchy in a single linear
+// pass. The arrays are dense, and an object's position in them (its dense index) can change
+// when another object is destroyed; handles stay valid throughout.
+class SceneStore
+{
+public:
+    typedef vector<Matrix4, AlignedAllocator<Matrix4, 16>> MatrixArray;
+    typedef vector<float, AlignedAllocator<float, 16>> FloatArray;
+
+    static uint32_t const NoParent = 0xFFFFFFFF;
+
+    SceneStore();
+
+    // Adds an object with the given local transform, relative to parent's world transform if
+    // there is a parent. Its world transform is filled in by the next UpdateTransforms.
+    SceneHandle Create(Matrix4 const& local, SceneHandle parent = SceneHandle());
+
+    // Removes an object along with all of its descendants. This is linear in the number of
+    // objects, so is meant for occasional use rather than every frame.
+    void Destroy(SceneHandle handle);
+
+    // Removes everything, invalidating all handles.
+    void Clear();
+
+    bool IsValid(SceneHandle handle) const;
+
+    void SetLocal(SceneHandle handle, Matrix4 const& local);
+    // For writing a local transform in place, rather than building it elsewhere and copying it
+    // in. Counts as setting it.
+    Matrix4& EditLocal(SceneHandle handle);
+    Matrix4 const& GetLocal(SceneHandle handle) const;
+
+    // As of the last UpdateTransforms.
+    Matrix4 const& GetWorld(SceneHandle handle) const;
+
+    // Bounds in the object's own space. Objects start out with none, so are never culled.
+    void SetLocalBounds(SceneHandle handle, BoundingSphere const& bounds);
+
+    // Recomputes the world transform and bounds of every object whose local transform or bounds
+    // have been set, and everything below it. Returns straight away if nothing has changed.
+    void UpdateTransforms();
+
+    // Dense access, for sweeping over every object.
+    uint32_t Size() const { return (uint32_t)handles.size(); }
+    uint32_t DenseIndex(SceneHandle handle) const;
+    SceneHandle HandleAt(uint32_t denseIndex) const { return handles[denseIndex]; }
+    Matrix4 const* WorldTransforms() const { return worlds.data(); }
+
+    // World space bounding spheres, one array per component so they can be tested four at a
+    // time. Objects without bounds have an infinite radius.
+    float const* WorldBoundsX() const { return boundsX.data(); }
+    float const* WorldBoundsY() const { return boundsY.data(); }
+    float const* WorldBoundsZ() const { return boundsZ.data(); }
+    float const* WorldBoundsRadius() const { return boundsRadius.data(); }
+
+    // Changes whenever objects are created or destroyed, as either can change dense indices.
+    uint32_t Version() const { return version; }
+
+    // Changes whenever UpdateTransforms moves anything.
+    uint32_t UpdateNumber() const { return updateNumber; }
+
+    // One more than the highest slot index handed out, for sizing arrays indexed by SceneHandle::index.
+    uint32_t SlotCount() const { return (uint32_t)slotDense.size(); }
+
+private:
+    static uint32_t const NoSlot = 0xFFFFFFFF;
+
+    enum
+    {
+        FlagDirty = 1,      // The local transform was set since the last update.
+        FlagChanged = 2,    // The world transform changed in the last update.
+        FlagDestroyed = 4,
+    };
+
+    void UpdateBounds(uint32_t denseIndex);
+    void ReleaseSlot(uint32_t denseIndex);
+    void Compact();
+
+    // Per slot, indexed by SceneHandle::index. Free slots form a list through slotDense.
+    vector<uint32_t> slotDense;
+    vector<uint32_t> slotGeneration;
+    uint32_t firstFreeSlot;         // NoSlot if there are none.
+
+    // Per object, indexed by dense index.
+    vector<SceneHandle> handles;
+    vector<uint32_t> parents;       // Dense index of the parent, always lower than the object's own.
+    vector<uint8_t> flags;
+    MatrixArray locals;
+    MatrixArray worlds;
+    vector<BoundingSphere> localBounds;
+    FloatArray boundsX, boundsY, boundsZ, boundsRadius;
+
+    bool hasDirty;
+    uint32_t version;
+    uint32_t updateNumber;
+};
@@ -0,0 +1,127 @@
+#include "WorkerPool.h"
+
+
+WorkerPool::WorkerPool(unsigned int threadCount)
+    : task(0), taskCount(0), jobNumber(0), busyWorkers(0), shuttingDown(false)
+{
+    if (!threadCount)
+    {
+        threadCount = thread::hardware_concurrency();
+    }
+
+    nextTask = 0;
+
+    for (unsigned int i = 1; i < threadCount; i++)
+    {
+        threads.push_back(thread(&WorkerPool::WorkerMain, this));
+    }
+}
+
+
+WorkerPool::~WorkerPool()
+{
+    {
+        lock_guard<mutex> guard(lock);
+
+        shuttingDown = true;
+    }
+
+    workAvailable.notify_all();
+
+    for (size_t i = 0; i < threads.size(); i++)
+    {
+        threads[i].join();
+    }
+}
+
+
+void WorkerPool::Run(uint32_t count, function<void(uint32_t)> const& function)
+{
+    // Not worth waking anyone for a single task.
+    if (threads.empty() || count <= 1)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            function(i);
+        }
+
+        return;
+    }
+
+    {
+        lock_guard<mutex> guard(lock);
+
+        task = &function;
+        taskCount = count;
+        nextTask = 0;
+        busyWorkers = (unsigned int)threads.size();
+        jobNumber++;
+    }
+
+    workAvailable.notify_all();
+
+    RunTasks();
+
+    // Every worker checks in, even if the others took all the tasks, so none is left looking
+    // at this job once Run returns.
+    unique_lock<mutex> guard(lock);
+
+    while (busyWorkers)
+    {
+        workDone.wait(guard);
+    }
+
+    task = 0;
+}
+
+
+void WorkerPool::WorkerMain()
+{
+    uint64_t lastJob = 0;
+
+    for (;;)
+    {
+        {
+            unique_lock<mutex> guard(lock);
+
+            while (!shuttingDown && jobNumber == lastJob)
+            {
+                workAvailable.wait(guard);
+            }
+
+            if (shuttingDown)
+            {
+                return;
+            }
+
+            lastJob = jobNumber;
+        }
+
+        RunTasks();
+
+        {
+            lock_guard<mutex> guard(lock);
+
+            if (--busyWorkers == 0)
+            {
+                workDone.notify_one();
+            }
+        }
+    }
+}
+
+
+void WorkerPool::RunTasks()
+{
+    for (;;)
+    {
+        uint32_t i = nextTask++;
+
+        if (i >= taskCount)
+        {
+            return;
+        }
+
+        (*task)(i);
+    }
+}
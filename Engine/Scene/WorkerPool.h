@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+
+// A fixed set of threads for splitting one job across the cores. Run hands out the tasks
+// to the workers and the calling thread alike, and returns once they are all done.
+class WorkerPool
+{
+public:
+    // With no thread count, uses one thread per core, counting the calling thread.
+    explicit WorkerPool(unsigned int threadCount = 0);
+    ~WorkerPool();
+
+    // Including the calling thread.
+    unsigned int ThreadCount() const { return (unsigned int)threads.size() + 1; }
+
+    // Calls task(i) for every i below taskCount, in no particular order, spread across the threads.
+    void Run(uint32_t taskCount, function<void(uint32_t)> const& task);
+
+private:
+    WorkerPool(WorkerPool const&);
+    WorkerPool& operator=(WorkerPool const&);
+
+    void WorkerMain();
+    void RunTasks();
+
+    vector<thread> threads;
+
+    mutex lock;
+    condition_variable workAvailable;
+    condition_variable workDone;
+
+    // The job in progress. Workers notice a new one by its number changing.
+    function<void(uint32_t)> const* task;
+    uint32_t taskCount;
+    atomic<uint32_t> nextTask;
+    uint64_t jobNumber;
+    unsigned int busyWorkers;
+    bool shuttingDown;
+};
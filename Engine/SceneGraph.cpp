@@ -2,28 +2,36 @@
 #include "modelclass.h"
 using std::tr1::shared_ptr;
 
-// NOTE: Must match layout of shader constant buffers
 using namespace std;
-__declspec(align(16))
 
-struct PerFrameConstants
+// The store keeps matrices in D3DX's layout, so they can be used in place.
+static const D3DXMATRIXA16& ToD3DX(const Matrix4& matrix)
 {
-    D3DXMATRIX mCameraWorldViewProj;
-    D3DXMATRIX mCameraWorldView;
-    D3DXMATRIX mCameraViewProj;
-    D3DXMATRIX mCameraProj;
-    D3DXVECTOR4 mCameraNearFar;
+	return *reinterpret_cast<const D3DXMATRIXA16*>(&matrix);
+}
 
-    unsigned int mFramebufferDimensionsX;
-    unsigned int mFramebufferDimensionsY;
-    unsigned int mFramebufferDimensionsZ;
-    unsigned int mFramebufferDimensionsW;
+static const Matrix4& FromD3DX(const D3DXMATRIXA16& matrix)
+{
+	return *reinterpret_cast<const Matrix4*>(&matrix);
+}
+
+static BoundingSphere GetModelBounds(ModelClass* model)
+{
+	D3DXVECTOR3 center;
+	BoundingSphere bounds;
 
-    UIConstants mUI;
-};
+	model->GetBoundingSphere(&center, &bounds.radius);
+	bounds.x = center.x;
+	bounds.y = center.y;
+	bounds.z = center.z;
+	return bounds;
+}
 
 SceneGraph::SceneGraph()
+	: visibleVersion(0), hasVisibleList(false), batchDraws(true), parallelRecording(true)
 {
+	meshDraw.scene = this;
+	ResetRenderStats();
 }
 
 SceneGraph::~SceneGraph()
@@ -32,14 +40,14 @@ SceneGraph::~SceneGraph()
 
 bool SceneGraph::IsLoaded()
 {
-	if(meshList.empty())
+	if(IsEmpty() || !pendingModels.empty())
 	{
 		return false;
 	}
 
-	for(int i=0;i<meshList.size();i++)
+	for(unsigned int i=0;i<transforms.Size();i++)
 	{
-		if(!meshList[i]->IsLoaded())
+		if(!meshList[transforms.HandleAt(i).index]->IsLoaded())
 		{
 			return false;
 		}
@@ -47,13 +55,61 @@ bool SceneGraph::IsLoaded()
 	return true;
 }
 
+bool SceneGraph::IsLoaded(SceneHandle id)
+{
+	if(!transforms.IsValid(id))
+	{
+		invalid_argument ia("In: IsLoaded(SceneHandle id): ID is not in the SceneGraph");
+		throw ia;
+	}
+	return meshList[id.index]->IsLoaded();
+}
+
+bool SceneGraph::IsEmpty()
+{
+	return transforms.Size() == 0;
+}
+
+void SceneGraph::Update(ID3D11Device* device)
+{
+	// Create GPU resources for models whose files have finished loading, a batch at a time
+	// so a large scene doesn't stall any one frame.
+	int uploads = 0;
+	size_t remaining = 0;
+
+	for(size_t i=0;i<pendingModels.size();i++)
+	{
+		PendingModel& pending = pendingModels[i];
+
+		if(uploads<maxModelUploadsPerFrame && pending.request->IsDone())
+		{
+			if(!pending.request->Succeeded() || !pending.mesh->CreateFromData(device, *pending.request->data))
+			{
+				printf("Error: failed to load '%s'.\n", pending.request->fileName.c_str());
+			}
+			else
+			{
+				// Now the objects showing it can be culled.
+				SetModelBounds(pending.mesh);
+			}
+			uploads++;
+		}
+		else
+		{
+			pendingModels[remaining++] = pending;
+		}
+	}
+
+	pendingModels.resize(remaining);
+}
+
 void SceneGraph::StartScene(D3DXMATRIXA16& worldMatrix, float sceneScaling)
 {
 	_worldMatrix = worldMatrix;
 	_sceneScaling=sceneScaling;
 }
 
-int SceneGraph::Add(ID3D11Device* device, LPCTSTR szFileName, int x, int y, int z, float xScale, float yScale, float zScale)
+SceneHandle SceneGraph::Add(ID3D11Device* device, LPCTSTR szFileName, int x, int y, int z, float xScale, float yScale, float zScale)
 {
 	D3DXMATRIXA16 t,s, final;
 	D3DXMatrixScaling(&s,xScale,yScale,zScale);
@@ -62,7 +118,7 @@ int SceneGraph::Add(ID3D11Device* device, LPCTSTR szFileName, int x, int y, int
 	return Add(device,szFileName,final);
 }
 
-int SceneGraph::AddXnb(ID3D11Device* device, string szFileName, int x, int y, int z, float xScale, float yScale, float zScale)
+SceneHandle SceneGraph::AddXnb(ID3D11Device* device, string szFileName, int x, int y, int z, float xScale, float yScale, float zScale)
 {
 	D3DXMATRIXA16 t,s, final;
 	D3DXMatrixScaling(&s,xScale,yScale,zScale);
@@ -71,62 +127,127 @@ int SceneGraph::AddXnb(ID3D11Device* device, string szFileName, int x, int y, in
 	return AddXnb(device,szFileName,final);
 }
 
-int SceneGraph::Add(ID3D11Device* device, LPCTSTR szFileName, int x, int y, int z, float scale)
+SceneHandle SceneGraph::Add(ID3D11Device* device, LPCTSTR szFileName, int x, int y, int z, float scale)
 {
 	return Add(device,szFileName,x,y,z,scale,scale,scale);
 }
 
-int SceneGraph::Add(ID3D11Device* device, LPCTSTR szFileName)
+SceneHandle SceneGraph::Add(ID3D11Device* device, LPCTSTR szFileName)
 {
 	D3DXMATRIXA16 t;
 	D3DXMatrixTranslation(&t,0,0,0);
 	return Add(device,szFileName,t);
 }
 
-int SceneGraph::AddXnb(ID3D11Device* device, string szFileName)
+SceneHandle SceneGraph::AddXnb(ID3D11Device* device, string szFileName)
 {
 	D3DXMATRIXA16 t;
 	D3DXMatrixTranslation(&t,0,0,0);
 	return AddXnb(device,szFileName,t);
 }
 
-int SceneGraph::Add(ID3D11Device* device, LPCTSTR szFileName, D3DXMATRIXA16& position)
+SceneHandle SceneGraph::Add(ID3D11Device* device, LPCTSTR szFileName, D3DXMATRIXA16& position)
 {
 	CDXUTSDKMesh* newMesh = new CDXUTSDKMesh();
 
-	D3DXMATRIXA16* newPosition = new D3DXMATRIXA16((_worldMatrix*position));
 	newMesh->Create(device, szFileName);
-	meshList.push_back(newMesh);
-	unsigned int x = meshList.size();
-	positionList.push_back(newPosition);
-	return meshList.size();
+	SceneHandle id = AddMesh(newMesh, position);
+
+	// Bound the whole file with a sphere around the boxes of its meshes.
+	if(newMesh->GetNumMeshes() > 0)
+	{
+		D3DXVECTOR3 minimum(FLT_MAX, FLT_MAX, FLT_MAX), maximum(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		BoundingSphere bounds;
+
+		for(UINT i=0;i<newMesh->GetNumMeshes();i++)
+		{
+			D3DXVECTOR3 center = newMesh->GetMeshBBoxCenter(i);
+			D3DXVECTOR3 extents = newMesh->GetMeshBBoxExtents(i);
+			D3DXVECTOR3 low = center - extents, high = center + extents;
+
+			D3DXVec3Minimize(&minimum, &minimum, &low);
+			D3DXVec3Maximize(&maximum, &maximum, &high);
+		}
+
+		D3DXVECTOR3 center = (minimum + maximum) * 0.5f;
+		D3DXVECTOR3 halfSize = (maximum - minimum) * 0.5f;
+
+		bounds.x = center.x;
+		bounds.y = center.y;
+		bounds.z = center.z;
+		bounds.radius = D3DXVec3Length(&halfSize);
+		transforms.SetLocalBounds(id, bounds);
+	}
+	return id;
 }
 
-int SceneGraph::AddXnb(ID3D11Device* device, string szFileName, D3DXMATRIXA16& position)
+SceneHandle SceneGraph::AddXnb(ID3D11Device* device, string szFileName, D3DXMATRIXA16& position)
 {
-	CDXUTSDKMesh* newMesh = new ModelClass();
+	map<string, ModelClass*>::iterator found = models.find(szFileName);
 
-	D3DXMATRIXA16* newPosition = new D3DXMATRIXA16((_worldMatrix*position));
-	newMesh->CreateXnb(device, szFileName);
-	meshList.push_back(newMesh);
-	unsigned int x = meshList.size();
-	positionList.push_back(newPosition);
-	return meshList.size();
+	// Another object already shows this file, so share its model.
+	if(found != models.end())
+	{
+		SceneHandle id = AddMesh(found->second, position);
+
+		if(found->second->IsLoaded())
+		{
+			transforms.SetLocalBounds(id, GetModelBounds(found->second));
+		}
+		return id;
+	}
+
+	PendingModel pending;
+	pending.mesh = new ModelClass();
+	models[szFileName] = pending.mesh;
+
+	// The file is parsed on a loader thread, and the mesh filled in by Update once it is ready.
+	// Until then it has no bounds, so isn't culled.
+	pending.request = modelLoader.Load(szFileName);
+	pendingModels.push_back(pending);
+	return AddMesh(pending.mesh, position);
+}
+
+SceneHandle SceneGraph::AddMesh(CDXUTSDKMesh* mesh, D3DXMATRIXA16& position)
+{
+	D3DXMATRIXA16 local = _worldMatrix*position;
+	SceneHandle id = transforms.Create(FromD3DX(local));
+
+	if(meshList.size() < transforms.SlotCount())
+	{
+		meshList.resize(transforms.SlotCount());
+	}
+	meshList[id.index] = mesh;
+	return id;
+}
+
+void SceneGraph::SetModelBounds(ModelClass* model)
+{
+	BoundingSphere bounds = GetModelBounds(model);
+
+	for(unsigned int i=0;i<transforms.Size();i++)
+	{
+		SceneHandle id = transforms.HandleAt(i);
+
+		if(meshList[id.index] == model)
+		{
+			transforms.SetLocalBounds(id, bounds);
+		}
+	}
 }
 
-void SceneGraph::TranslateMesh(int id, D3DXMATRIXA16& translationMatrix)
+void SceneGraph::TranslateMesh(SceneHandle id, D3DXMATRIXA16& translationMatrix)
 {
-	if(id>=positionList.size())
+	if(!transforms.IsValid(id))
 	{
-		invalid_argument ia("In: TranslateMesh(int id,D3DXMATRIXA16& translationMatrix): ID is not in the SceneGraph");
+		invalid_argument ia("In: TranslateMesh(SceneHandle id,D3DXMATRIXA16& translationMatrix): ID is not in the SceneGraph");
 		throw ia;
 	}
-	D3DXMATRIXA16 target = *positionList[id];
-	target = translationMatrix * target;
-	positionList[id]= &target;
+	D3DXMATRIXA16 target = translationMatrix * ToD3DX(transforms.GetLocal(id));
+	transforms.SetLocal(id, FromD3DX(target));
 }
 
-void SceneGraph::SetMeshPosition(int id, int x,int y,int z)
+void SceneGraph::SetMeshPosition(SceneHandle id, int x,int y,int z)
 {
 	D3DXMATRIXA16 trans,target;
 	D3DXMatrixTranslation(&trans,x,y,z);
@@ -134,57 +255,268 @@ void SceneGraph::SetMeshPosition(int id, int x,int y,int z)
 	SetMeshPosition(id,target);
 }
 
-void SceneGraph::SetMeshPosition(int id, D3DXMATRIXA16& newPositionMatrix)
+void SceneGraph::SetMeshPosition(SceneHandle id, D3DXMATRIXA16& newPositionMatrix)
 {
-	if(id>positionList.size())
+	if(!transforms.IsValid(id))
 	{
-		invalid_argument ia("In: SetMeshPosition(int id,D3DXMATRIXA16& translationMatrix): ID is not in the SceneGraph");
+		invalid_argument ia("In: SetMeshPosition(SceneHandle id,D3DXMATRIXA16& translationMatrix): ID is not in the SceneGraph");
 		throw ia;
 	}
-	positionList[id - 1]= new D3DXMATRIXA16(newPositionMatrix);
+	transforms.SetLocal(id, FromD3DX(newPositionMatrix));
+}
+
+void SceneGraph::SetMeshPose(SceneHandle id, const D3DXQUATERNION& rotation, const D3DXVECTOR3& position)
+{
+	D3DXMATRIXA16 pose;
+
+	D3DXMatrixAffineTransformation(&pose, 1.0f, 0, &rotation, &position);
+	pose = _worldMatrix*pose;
+	SetMeshPosition(id, pose);
+}
+
+void SceneGraph::SetMeshPoses(const SceneHandle* ids, const RigidPose* poses, unsigned int count)
+{
+	const Matrix4& world = FromD3DX(_worldMatrix);
+	Matrix4 pose;
+
+	for(unsigned int i = 0; i < count; i++)
+	{
+		if(!transforms.IsValid(ids[i]))
+		{
+			invalid_argument ia("In: SetMeshPoses(const SceneHandle* ids, const RigidPose* poses, unsigned int count): ID is not in the SceneGraph");
+			throw ia;
+		}
+		MatrixFromPose(&pose, poses[i]);
+		MatrixMultiply(&transforms.EditLocal(ids[i]), world, pose);
+	}
 }
 
 void SceneGraph::ComputeInFrustumFlags(const D3DXMATRIXA16 &cameraViewProj)
 {
-	for(int i =0;i<meshList.size();i++)
+	// Pick up any objects moved since the last pass.
+	transforms.UpdateTransforms();
+
+	StartWorkers();
+
+	// The meshes' own subset culling is left to RenderMesh, for just the meshes that pass this.
+	culler->Cull(transforms, FromD3DX(cameraViewProj), &visibleList);
+	visibleVersion = transforms.Version();
+	hasVisibleList = true;
+}
+
+void SceneGraph::StartWorkers()
+{
+	if(!culler)
 	{
-		meshList[i]->ComputeInFrustumFlags((*positionList[i])*cameraViewProj);
+		cullWorkers.reset(new WorkerPool());
+		culler.reset(new SceneCuller(cullWorkers.get()));
 	}
 }
 
-void SceneGraph::Render(ID3D11DeviceContext* deviceContext,ID3D11Buffer* mPerFrameConstants,D3DXMATRIXA16& cameraView, D3DXMATRIXA16& cameraProj)
+bool SceneGraph::HasVisibleList()
+{
+	return hasVisibleList && visibleVersion == transforms.Version();
+}
+
+void SceneGraph::Render(D3D11CommandList& commands, D3DXMATRIXA16& cameraView, D3DXMATRIXA16& cameraProj,
+	ID3D11InputLayout* packedLayout, ID3D11VertexShader* packedVS)
 {
-	D3D11_MAPPED_SUBRESOURCE mappedResource;
+	LARGE_INTEGER startTime, endTime, frequency;
+	QueryPerformanceCounter(&startTime);
+
 	D3DXMATRIXA16 cameraViewProj = cameraView * cameraProj;
-	PerFrameConstants *constants;
-	for(int i=0;i<meshList.size();i++)
+
+	// Pick up any objects moved since the last pass.
+	transforms.UpdateTransforms();
+
+	if(!batcher)
+	{
+		ID3D11Device* device;
+
+		commands.Context()->GetDevice(&device);
+		renderDevice.reset(new D3D11RenderDevice(device));
+		batcher.reset(new DrawBatcher(*renderDevice));
+		SAFE_RELEASE(device);
+	}
+
+	// Even with a single core, two lists are recorded, so the path is the same everywhere.
+	if(parallelRecording && deferredLists.empty())
+	{
+		StartWorkers();
+		for(unsigned int i=0;i<max(2u, cullWorkers->ThreadCount());i++)
+		{
+			deferredLists.push_back(renderDevice->CreateDeferredCommandList());
+		}
+	}
+
+	// Draw what was found to be visible, or everything if culling hasn't been run.
+	bool isCulled = HasVisibleList();
+	unsigned int objectCount = isCulled ? (unsigned int)visibleList.size() : transforms.Size();
+
+	batcher->SetBatching(batchDraws);
+	batcher->Clear();
+	for(unsigned int j=0;j<objectCount;j++)
+	{
+		unsigned int object = isCulled ? visibleList[j] : j;
+		CDXUTSDKMesh* mesh = meshList[transforms.HandleAt(object).index];
+
+		if(!mesh->IsLoaded())
+		{
+			continue;
+		}
+
+		ModelClass* model = dynamic_cast<ModelClass*>(mesh);
+		if(model)
+		{
+			batcher->Add(model->GetDrawMesh(), object);
+		}
+		else
+		{
+			batcher->Add(&meshDraw, mesh, object);
+		}
+	}
+
+	// .sdkmesh meshes are drawn first, with whatever the caller bound, then the .xnb models.
+	DrawPass pass;
+	pass.view = FromD3DX(cameraView);
+	pass.viewProj = FromD3DX(cameraViewProj);
+	pass.meshLayout = ToRender(packedLayout);
+	pass.meshVertexShader = ToRender(packedVS);
+	pass.diffuseSlot = 0;
+	pass.objectSlot = 1;
+	meshDraw.cameraViewProj = cameraViewProj;
+
+	ID3D11InputLayout* previousLayout = 0;
+	ID3D11VertexShader* previousVS = 0;
+	CommandStats commandsBefore = commands.Stats();
+	BatchStats batchBefore = batcher->Stats();
+
+	commands.Context()->IAGetInputLayout(&previousLayout);
+	commands.Context()->VSGetShader(&previousVS, 0, 0);
+
+	for(size_t i=0;i<deferredLists.size();i++)
+	{
+		deferredLists[i]->ResetStats();
+	}
+
+	// The transforms are written through commands, then the deferred lists draw from them.
+	if(parallelRecording)
+	{
+		batcher->Record(commands, transforms.WorldTransforms(), pass, cullWorkers.get(), deferredLists);
+	}
+	else
+	{
+		batcher->Record(commands, transforms.WorldTransforms(), pass);
+	}
+
+	// Put back what the caller bound, for any later passes over the scene.
+	commands.SetInputLayout(ToRender(previousLayout));
+	commands.SetShader(STAGE_VERTEX, ToRender(previousVS));
+	SAFE_RELEASE(previousLayout);
+	SAFE_RELEASE(previousVS);
+
+	renderStats.drawCalls += batcher->Stats().draws - batchBefore.draws;
+	renderStats.objects += batcher->Stats().objects - batchBefore.objects;
+	renderStats.maps += commands.Stats().maps - commandsBefore.maps;
+	renderStats.commands += commands.Stats().commands - commandsBefore.commands;
+	renderStats.bytesUploaded += commands.Stats().bytesUploaded - commandsBefore.bytesUploaded;
+	renderStats.commandLists += commands.Stats().executes - commandsBefore.executes;
+	for(size_t i=0;i<deferredLists.size();i++)
+	{
+		renderStats.commands += deferredLists[i]->Stats().commands;
+	}
+
+	QueryPerformanceCounter(&endTime);
+	QueryPerformanceFrequency(&frequency);
+	renderStats.passes++;
+	renderStats.cpuMilliseconds += (endTime.QuadPart - startTime.QuadPart) * 1000.0 / frequency.QuadPart;
+}
+
+uint32_t SceneGraph::SDKMeshDraw::Draw(CommandList& commands, uint32_t object)
+{
+	CDXUTSDKMesh* mesh = scene->meshList[scene->transforms.HandleAt(object).index];
+	uint32_t draws = 0;
+
+	// Skip the subsets outside the frustum. The mesh draws straight to the context.
+	D3DXMATRIXA16 worldViewProj = ToD3DX(scene->transforms.WorldTransforms()[object]) * cameraViewProj;
+
+	mesh->ComputeInFrustumFlags(worldViewProj, 0);
+	mesh->Render(static_cast<D3D11CommandList&>(commands).Context(), 0);
+	for(UINT m=0;m<mesh->GetNumMeshes();m++)
 	{
-		deviceContext->Map(mPerFrameConstants, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-		constants = static_cast<PerFrameConstants *>(mappedResource.pData);
-		constants->mCameraWorldViewProj=(*positionList[i])*cameraViewProj;
-		constants->mCameraWorldView=(*positionList[i])*cameraView;
-		deviceContext->Unmap(mPerFrameConstants, 0);
-		meshList[i]->ComputeInFrustumFlags((*positionList[i])*cameraViewProj,0);
-		meshList[i]->Render(deviceContext,0);
+		draws += mesh->GetNumSubsets(m);
 	}
+	return draws;
+}
+
+void SceneGraph::SetBatching(bool enabled)
+{
+	batchDraws = enabled;
+}
+
+bool SceneGraph::GetBatching()
+{
+	return batchDraws;
+}
+
+void SceneGraph::SetParallelRecording(bool enabled)
+{
+	parallelRecording = enabled;
+}
+
+bool SceneGraph::GetParallelRecording()
+{
+	return parallelRecording;
+}
+
+const SceneGraph::RenderStats& SceneGraph::GetRenderStats()
+{
+	return renderStats;
+}
+
+void SceneGraph::ResetRenderStats()
+{
+	renderStats.passes = 0;
+	renderStats.drawCalls = 0;
+	renderStats.objects = 0;
+	renderStats.maps = 0;
+	renderStats.commands = 0;
+	renderStats.commandLists = 0;
+	renderStats.bytesUploaded = 0;
+	renderStats.cpuMilliseconds = 0.0;
 }
 
 void SceneGraph::Destroy()
 {
+	// Stop loading before the meshes waiting on it go away.
+	modelLoader.Shutdown();
+	pendingModels.clear();
+
 	if(!meshList.empty())
 	{
 		for(int i=meshList.size()-1; i>=0; i--)
 		{
-			SAFE_DELETE(meshList[i]);
+			// Models are shared, so are deleted below.
+			if(!dynamic_cast<ModelClass*>(meshList[i]))
+			{
+				SAFE_DELETE(meshList[i]);
+			}
 		}
 		meshList.clear();
 	}
-	if(!positionList.empty())
+	for(map<string, ModelClass*>::iterator i=models.begin(); i!=models.end(); ++i)
 	{
-		for(int i=positionList.size()-1; i>=0; i--)
-		{
-			SAFE_DELETE(positionList[i]);
-		}
-		positionList.clear();
+		SAFE_DELETE(i->second);
+	}
+	models.clear();
+	transforms.Clear();
+	visibleList.clear();
+	hasVisibleList = false;
+	for(size_t i=0;i<deferredLists.size();i++)
+	{
+		SAFE_DELETE(deferredLists[i]);
 	}
+	deferredLists.clear();
+	batcher.reset();
+	renderDevice.reset();
 }
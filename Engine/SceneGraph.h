@@ -7,6 +7,12 @@
 #include "Texture2D.h"
 #include "Shader.h"
 #include "Buffer.h"
+#include "AsyncModelLoader.h"
+#include "Rendering/D3D11CommandList.h"
+#include "Rendering/DrawBatcher.h"
+#include "Scene/SceneCuller.h"
+#include "Scene/SceneStore.h"
+#include <map>
 #include <vector>
 #include <memory>
 
@@ -14,26 +20,113 @@ using namespace std;
 class SceneGraph
 {
 public:
+	// What Render has cost since the last ResetRenderStats, over every pass.
+	struct RenderStats
+	{
+		unsigned int passes;
+		unsigned int drawCalls;		// Counting every subset of .sdkmesh meshes, some of which may be skipped.
+		unsigned int objects;		// Drawn, whether on their own or as instances.
+		unsigned int maps;
+		unsigned int commands;		// Recorded through the command lists, which .sdkmesh meshes bypass.
+		unsigned int commandLists;	// Recorded on worker threads, then executed.
+		unsigned long long bytesUploaded;
+		double cpuMilliseconds;
+	};
+
 	SceneGraph();
 	~SceneGraph();
 	void Destroy();
-	void Render(ID3D11DeviceContext* deviceContext,ID3D11Buffer* mPerFrameConstants, D3DXMATRIXA16& cameraView, D3DXMATRIXA16& cameraProj);
+	// .sdkmesh meshes are drawn with the input layout and vertex shader already bound; .xnb
+	// models have packed vertices, so are drawn afterwards with packedLayout and packedVS.
+	// Both layouts take each object's transforms from input slot 1 (see ObjectConstants in
+	// Rendering/DrawBatcher.h).
+	void Render(D3D11CommandList& commands, D3DXMATRIXA16& cameraView, D3DXMATRIXA16& cameraProj,
+		ID3D11InputLayout* packedLayout, ID3D11VertexShader* packedVS);
+	// Batching sorts draws by vertex layout, material and vertex buffer, and writes every object's
+	// transforms with a single map. Objects sharing a model are then drawn with one instanced draw.
+	// Without it, each draw maps and binds everything for itself.
+	void SetBatching(bool enabled);
+	bool GetBatching();
+	// With batching, records the draws in chunks on deferred contexts, one per worker thread,
+	// and executes them on the caller's context in order.
+	void SetParallelRecording(bool enabled);
+	bool GetParallelRecording();
+	const RenderStats& GetRenderStats();
+	void ResetRenderStats();
 	bool IsLoaded();
+	bool IsLoaded(SceneHandle id);
+	bool IsEmpty();
+	void Update(ID3D11Device* device);
+	// Finds the objects inside the camera's frustum. Render then draws just those, until the
+	// next call, or until objects are added or removed.
 	void ComputeInFrustumFlags(const D3DXMATRIXA16 &cameraViewProj);
-	int Add(ID3D11Device* device, LPCTSTR szFileName,D3DXMATRIXA16& position);
-	int Add(ID3D11Device* device, LPCTSTR szFileName);
-	int Add(ID3D11Device* device, LPCTSTR szFileName, int x, int y, int z, float scale);
-	int Add(ID3D11Device* device, LPCTSTR szFileName, int x, int y, int z, float xScale, float yScale, float zScale);
-	int AddXnb(ID3D11Device* device, string szFileName);
-	int AddXnb(ID3D11Device* device, string szFileName, int x, int y, int z, float xScale, float yScale, float zScale);
-	int AddXnb(ID3D11Device* device, string szFileName, D3DXMATRIXA16& position);
-	void TranslateMesh(int id, D3DXMATRIXA16& TranslationMatrix);
-	void SetMeshPosition(int id, D3DXMATRIXA16& newPositionMatrix);
-	void SetMeshPosition(int id, int x,int y,int z);
+	SceneHandle Add(ID3D11Device* device, LPCTSTR szFileName,D3DXMATRIXA16& position);
+	SceneHandle Add(ID3D11Device* device, LPCTSTR szFileName);
+	SceneHandle Add(ID3D11Device* device, LPCTSTR szFileName, int x, int y, int z, float scale);
+	SceneHandle Add(ID3D11Device* device, LPCTSTR szFileName, int x, int y, int z, float xScale, float yScale, float zScale);
+	SceneHandle AddXnb(ID3D11Device* device, string szFileName);
+	SceneHandle AddXnb(ID3D11Device* device, string szFileName, int x, int y, int z, float xScale, float yScale, float zScale);
+	SceneHandle AddXnb(ID3D11Device* device, string szFileName, D3DXMATRIXA16& position);
+	void TranslateMesh(SceneHandle id, D3DXMATRIXA16& TranslationMatrix);
+	void SetMeshPosition(SceneHandle id, D3DXMATRIXA16& newPositionMatrix);
+	void SetMeshPosition(SceneHandle id, int x,int y,int z);
+	// Places the mesh as a physics body is posed, e.g. from a PxTransform.
+	void SetMeshPose(SceneHandle id, const D3DXQUATERNION& rotation, const D3DXVECTOR3& position);
+	// Places many meshes at once, building each transform straight into the scene's storage.
+	void SetMeshPoses(const SceneHandle* ids, const RigidPose* poses, unsigned int count);
 	void StartScene(D3DXMATRIXA16& worldMatrix,float sceneScaling);
 private:
+	// An .xnb model waiting for its loader thread to finish.
+	struct PendingModel
+	{
+		ModelClass* mesh;
+		ModelLoadRequestPtr request;
+	};
+
+	// Draws .sdkmesh meshes for the batcher, which bind their own buffers and materials.
+	class SDKMeshDraw : public CustomDraw
+	{
+	public:
+		uint32_t Draw(CommandList& commands, uint32_t object);
+
+		SceneGraph* scene;
+		D3DXMATRIX cameraViewProj;
+	};
+
+	SceneHandle AddMesh(CDXUTSDKMesh* mesh, D3DXMATRIXA16& position);
+	void StartWorkers();
+	void SetModelBounds(ModelClass* model);
+	bool HasVisibleList();
+
+	// Maximum number of loaded models whose GPU resources are created each frame.
+	static const int maxModelUploadsPerFrame = 64;
+
+	AsyncModelLoader modelLoader;
+	vector<PendingModel> pendingModels;
+	// Mesh for each object, indexed by SceneHandle::index; world transforms live in the store.
+	SceneStore transforms;
 	vector<CDXUTSDKMesh*> meshList;
-	vector<D3DXMATRIXA16*> positionList;
+	// Models are loaded once per file, and shared by every object showing that file, so they can be
+	// drawn instanced. The scene graph owns them here rather than through meshList.
+	map<string, ModelClass*> models;
+
+	// Culling and parallel recording share threads, started on first use. visibleList holds dense
+	// indices into transforms, so is only good while transforms.Version() matches visibleVersion.
+	unique_ptr<WorkerPool> cullWorkers;
+	unique_ptr<SceneCuller> culler;
+	vector<uint32_t> visibleList;
+	uint32_t visibleVersion;
+	bool hasVisibleList;
+
+	// Sorts and records the draws, writing per-object transforms to its ring. Created on first use.
+	unique_ptr<D3D11RenderDevice> renderDevice;
+	unique_ptr<DrawBatcher> batcher;
+	// A deferred context for each worker thread, when recording in parallel.
+	vector<CommandList*> deferredLists;
+	SDKMeshDraw meshDraw;
+	bool batchDraws;
+	bool parallelRecording;
+	RenderStats renderStats;
 	float _sceneScaling;
 	D3DXMATRIXA16 _worldMatrix;
 };
\ No newline at end of file
@@ -15,12 +15,30 @@
 #ifndef SHADER_DEFINES_H
 #define SHADER_DEFINES_H
 
-#define MAX_LIGHTS_POWER 10
+#define MAX_LIGHTS_POWER 14
 #define MAX_LIGHTS (1<<MAX_LIGHTS_POWER)
+// Where the lights slider starts
+#define DEFAULT_LIGHTS_POWER 10
 
 // This determines the tile size for light binning and associated tradeoffs
 #define COMPUTE_SHADER_TILE_GROUP_DIM 16
 #define COMPUTE_SHADER_TILE_GROUP_SIZE (COMPUTE_SHADER_TILE_GROUP_DIM*COMPUTE_SHADER_TILE_GROUP_DIM)
+// Lights a single tile can hold in shared memory; any more are dropped, so the lights
+// slider stops here while the tiled technique is selected
+#define COMPUTE_SHADER_TILE_MAX_LIGHTS_POWER 10
+#define COMPUTE_SHADER_TILE_MAX_LIGHTS (1<<COMPUTE_SHADER_TILE_MAX_LIGHTS_POWER)
+
+// Clustered shading splits the view frustum into screen tiles of this many pixels...
+#define CLUSTER_TILE_DIM 64
+// ...and this many depth slices, spaced exponentially from CLUSTER_NEAR_Z to the far plane.
+// Everything nearer than CLUSTER_NEAR_Z falls into the first slice.
+#define CLUSTER_SLICES 32
+#define CLUSTER_NEAR_Z 1.0f
+// Threads assigning lights to one column of clusters
+#define CLUSTER_GROUP_SIZE 64
+// Room in the cluster light index list, on average, per cluster. 16384 of the demo's lights
+// need about 140 from the starting camera; past this, clusters are cut short.
+#define CLUSTER_AVERAGE_LIGHTS 256
 
 // If enabled, defers scheduling of per-sample-shaded pixels until after sample 0
 // has been shaded across the whole tile. This allows better SIMD packing and scheduling.
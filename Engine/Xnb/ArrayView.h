@@ -0,0 +1,34 @@
+#pragma once
+
+
+// Non-owning view of a contiguous run of values, such as a range of bytes inside a
+// memory mapped file. The underlying storage must outlive the view.
+template<typename T> class ArrayView
+{
+public:
+    ArrayView()
+      : items(nullptr),
+        count(0)
+    {
+    }
+
+    ArrayView(T const* items, uint32_t count)
+      : items(items),
+        count(count)
+    {
+    }
+
+    // Container style accessors, so views work with range-based loops and <algorithm>.
+    T const* data() const { return items; }
+    uint32_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    T const* begin() const { return items; }
+    T const* end() const { return items + count; }
+
+    T const& operator[](uint32_t i) const { return items[i]; }
+
+private:
+    T const* items;
+    uint32_t count;
+};
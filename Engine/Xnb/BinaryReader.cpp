@@ -0,0 +1,273 @@
+#include "stdafx.h"
+#include "BinaryReader.h"
+#include "ByteSwap.h"
+
+
+BinaryReader::BinaryReader(uint8_t const* data, uint32_t size)
+  : data(data),
+    size(size),
+    position(0)
+{
+}
+
+
+BinaryReader::BinaryReader(FILE* file)
+  : data(nullptr),
+    size(0),
+    position(0)
+{
+    long startPosition = ftell(file);
+
+    // Measure how much of the file is left.
+    if (startPosition < 0 || fseek(file, 0, SEEK_END) != 0)
+    {
+        throw runtime_error("Seek failed.");
+    }
+
+    long endPosition = ftell(file);
+
+    if (endPosition < startPosition || fseek(file, startPosition, SEEK_SET) != 0)
+    {
+        throw runtime_error("Seek failed.");
+    }
+
+    // Pull it all in with a single read.
+    ownedData.resize(endPosition - startPosition);
+
+    if (!ownedData.empty() && fread(&ownedData[0], 1, ownedData.size(), file) != ownedData.size())
+    {
+        throw runtime_error("Error reading file.");
+    }
+
+    data = ownedData.empty() ? nullptr : &ownedData[0];
+    size = (uint32_t)ownedData.size();
+}
+
+
+void BinaryReader::ReplaceData(vector<uint8_t>& newData)
+{
+    ownedData.swap(newData);
+
+    data = ownedData.empty() ? nullptr : &ownedData[0];
+    size = (uint32_t)ownedData.size();
+    position = 0;
+}
+
+
+uint8_t const* BinaryReader::Consume(uint32_t count)
+{
+    if (count > size - position)
+    {
+        throw runtime_error("Error reading file.");
+    }
+
+    uint8_t const* result = data + position;
+
+    position += count;
+
+    return result;
+}
+
+
+uint8_t BinaryReader::ReadByte()
+{
+    return *Consume(1);
+}
+
+
+uint16_t BinaryReader::ReadUInt16()
+{
+    uint8_t const* b = Consume(2);
+
+    return uint16_t(b[0]) |
+           uint16_t(b[1]) << 8;
+}
+
+
+uint32_t BinaryReader::ReadUInt32()
+{
+    uint8_t const* b = Consume(4);
+
+    return uint32_t(b[0])       |
+           uint32_t(b[1]) << 8  |
+           uint32_t(b[2]) << 16 |
+           uint32_t(b[3]) << 24;
+}
+
+
+uint64_t BinaryReader::ReadUInt64()
+{
+    uint8_t const* b = Consume(8);
+
+    return uint64_t(b[0])       |
+           uint64_t(b[1]) << 8  |
+           uint64_t(b[2]) << 16 |
+           uint64_t(b[3]) << 24 |
+           uint64_t(b[4]) << 32 |
+           uint64_t(b[5]) << 40 |
+           uint64_t(b[6]) << 48 |
+           uint64_t(b[7]) << 56;
+}
+
+
+int8_t BinaryReader::ReadSByte()
+{
+    return (int8_t)ReadByte();
+}
+
+
+int16_t BinaryReader::ReadInt16()
+{
+    return (int16_t)ReadUInt16();
+}
+
+
+int32_t BinaryReader::ReadInt32()
+{
+    return (int32_t)ReadUInt32();
+}
+
+
+int64_t BinaryReader::ReadInt64()
+{
+    return (int64_t)ReadUInt64();
+}
+
+
+float BinaryReader::ReadSingle()
+{
+    uint32_t value = ReadUInt32();
+    float result;
+
+    memcpy(&result, &value, sizeof(result));
+
+    return result;
+}
+
+
+double BinaryReader::ReadDouble()
+{
+    uint64_t value = ReadUInt64();
+    double result;
+
+    memcpy(&result, &value, sizeof(result));
+
+    return result;
+}
+
+
+bool BinaryReader::ReadBoolean()
+{
+    return ReadByte() ? true : false;
+}
+
+
+wchar_t BinaryReader::ReadChar()
+{
+   wchar_t result = ReadByte();
+
+    // Decode UTF-8.
+   if (result & 0x80)
+   {
+       int byteCount = 1;
+
+       while (result & (0x80 >> byteCount))
+       {
+           byteCount++;
+       }
+
+       result &= (1 << (8 - byteCount)) - 1;
+
+       while (--byteCount)
+       {
+           result <<= 6;
+           result |= ReadByte() & 0x3F;
+       }
+   }
+
+   return result;
+}
+
+
+wstring BinaryReader::ReadString()
+{
+    uint32_t stringLength = Read7BitEncodedInt();
+
+    // The length comes from the file, so is checked before anything is sized from it.
+    if (stringLength > FileSize() - FilePosition())
+    {
+        throw runtime_error("Error reading file.");
+    }
+
+    uint32_t endOfString = FilePosition() + stringLength;
+
+    wstring result;
+
+    result.reserve(stringLength);
+
+    while (FilePosition() < endOfString)
+    {
+        result += ReadChar();
+    }
+
+    return result;
+}
+
+
+uint32_t BinaryReader::Read7BitEncodedInt()
+{
+    uint32_t result = 0;
+    uint32_t bitsRead = 0;
+    uint32_t value;
+
+    do
+    {
+        value = ReadByte();
+        result |= (value & 0x7f) << bitsRead;
+        bitsRead += 7;
+    }
+    while (value & 0x80);
+
+    return result;
+}
+
+
+ArrayView<uint8_t> BinaryReader::ReadBytes(uint32_t count)
+{
+    return ArrayView<uint8_t>(Consume(count), count);
+}
+
+
+void BinaryReader::ReadArray16(void* values, uint32_t count, bool isBigEndian)
+{
+    if (count > (size - position) / sizeof(uint16_t))
+    {
+        throw runtime_error("Error reading file.");
+    }
+
+    // Every platform we run on is little-endian, so only big-endian data needs swapping.
+    CopyValues16(values, Consume(count * sizeof(uint16_t)), count, isBigEndian);
+}
+
+
+void BinaryReader::ReadArray32(void* values, uint32_t count, bool isBigEndian)
+{
+    if (count > (size - position) / sizeof(uint32_t))
+    {
+        throw runtime_error("Error reading file.");
+    }
+
+    CopyValues32(values, Consume(count * sizeof(uint32_t)), count, isBigEndian);
+}
+
+
+uint32_t BinaryReader::FilePosition()
+{
+    return position;
+}
+
+
+uint32_t BinaryReader::FileSize()
+{
+    return size;
+}
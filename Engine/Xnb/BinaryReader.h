@@ -0,0 +1,68 @@
+#pragma once
+
+#include "ArrayView.h"
+
+
+// Helper for reading strongly typed binary data from an in-memory buffer,
+// typically a memory mapped file.
+class BinaryReader
+{
+public:
+    // Reads from existing memory, which must outlive the reader.
+    BinaryReader(uint8_t const* data, uint32_t size);
+
+    // Reads the rest of a stdio file into a buffer owned by the reader.
+    BinaryReader(FILE* file);
+
+    virtual ~BinaryReader() { }
+
+    uint8_t ReadByte();
+    uint16_t ReadUInt16();
+    uint32_t ReadUInt32();
+    uint64_t ReadUInt64();
+
+    int8_t ReadSByte();
+    int16_t ReadInt16();
+    int32_t ReadInt32();
+    int64_t ReadInt64();
+
+    float ReadSingle();
+    double ReadDouble();
+
+    bool ReadBoolean();
+
+    wchar_t ReadChar();
+    wstring ReadString();
+
+    uint32_t Read7BitEncodedInt();
+
+    // Bulk reads return views straight into the underlying data, so are only
+    // valid for as long as the reader (or the memory it was created over) is.
+    ArrayView<uint8_t> ReadBytes(uint32_t count);
+
+    // Bulk reads of count 16 or 32 bit values, copied straight into values.
+    // Big-endian data is byte swapped on the way.
+    void ReadArray16(void* values, uint32_t count, bool isBigEndian);
+    void ReadArray32(void* values, uint32_t count, bool isBigEndian);
+
+    uint32_t FilePosition();
+    uint32_t FileSize();
+
+protected:
+    // Switches to reading from a new buffer (eg. after decompression), taking ownership of its contents.
+    void ReplaceData(vector<uint8_t>& newData);
+
+private:
+    // Not implemented: copies would point at the original's data.
+    BinaryReader(BinaryReader const&);
+    BinaryReader& operator=(BinaryReader const&);
+
+    // Bounds checks a read of count bytes, then advances past them.
+    uint8_t const* Consume(uint32_t count);
+
+    vector<uint8_t> ownedData;
+
+    uint8_t const* data;
+    uint32_t size;
+    uint32_t position;
+};
@@ -0,0 +1,89 @@
+#include "stdafx.h"
+#include "ByteSwap.h"
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define XNB_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+
+#ifdef XNB_USE_SSE2
+
+// Swaps the bytes of each 16 bit lane.
+static inline __m128i Swap16(__m128i value)
+{
+    return _mm_or_si128(_mm_slli_epi16(value, 8), _mm_srli_epi16(value, 8));
+}
+
+
+// Swaps the bytes of each 32 bit lane: swap within the 16 bit halves, then swap the halves.
+static inline __m128i Swap32(__m128i value)
+{
+    value = Swap16(value);
+    value = _mm_shufflelo_epi16(value, _MM_SHUFFLE(2, 3, 0, 1));
+    value = _mm_shufflehi_epi16(value, _MM_SHUFFLE(2, 3, 0, 1));
+
+    return value;
+}
+
+#endif
+
+
+void CopyValues16(void* output, void const* input, uint32_t count, bool swapBytes)
+{
+    if (!swapBytes)
+    {
+        memcpy(output, input, count * sizeof(uint16_t));
+        return;
+    }
+
+    uint8_t* out = (uint8_t*)output;
+    uint8_t const* in = (uint8_t const*)input;
+    uint32_t i = 0;
+
+#ifdef XNB_USE_SSE2
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i value = _mm_loadu_si128((__m128i const*)(in + i * 2));
+
+        _mm_storeu_si128((__m128i*)(out + i * 2), Swap16(value));
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        out[i * 2]     = in[i * 2 + 1];
+        out[i * 2 + 1] = in[i * 2];
+    }
+}
+
+
+void CopyValues32(void* output, void const* input, uint32_t count, bool swapBytes)
+{
+    if (!swapBytes)
+    {
+        memcpy(output, input, count * sizeof(uint32_t));
+        return;
+    }
+
+    uint8_t* out = (uint8_t*)output;
+    uint8_t const* in = (uint8_t const*)input;
+    uint32_t i = 0;
+
+#ifdef XNB_USE_SSE2
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i value = _mm_loadu_si128((__m128i const*)(in + i * 4));
+
+        _mm_storeu_si128((__m128i*)(out + i * 4), Swap32(value));
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        out[i * 4]     = in[i * 4 + 3];
+        out[i * 4 + 1] = in[i * 4 + 2];
+        out[i * 4 + 2] = in[i * 4 + 1];
+        out[i * 4 + 3] = in[i * 4];
+    }
+}
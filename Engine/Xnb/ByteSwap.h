@@ -0,0 +1,8 @@
+#pragma once
+
+
+// Bulk copies of 16 and 32 bit values from file data into their final buffer, optionally
+// reversing the byte order of each value (Xbox 360 XNB files store graphics data big-endian).
+// Neither pointer needs to be aligned.
+void CopyValues16(void* output, void const* input, uint32_t count, bool swapBytes);
+void CopyValues32(void* output, void const* input, uint32_t count, bool swapBytes);
@@ -0,0 +1,334 @@
+#include "stdafx.h"
+#include "ContentReader.h"
+#include "LzxDecoder.h"
+#include "Lz4Decoder.h"
+
+
+// Limits on what a compressed XNB header may claim. The largest XNA assets are tens of
+// megabytes, and LZ4 tops out at about 255:1, LZX at about 2000:1.
+static uint32_t const MaxDecompressedSize = 512 * 1024 * 1024;
+static uint32_t const MaxCompressionRatio = 4096;
+
+
+ContentReader::ContentReader(FILE* file, TypeReaderManager* typeReaderManager)
+  : BinaryReader(file),
+    typeReaderManager(typeReaderManager),
+    isBigEndianGraphicsData(false)
+{
+}
+
+
+ContentReader::ContentReader(uint8_t const* data, uint32_t size, TypeReaderManager* typeReaderManager)
+  : BinaryReader(data, size),
+    typeReaderManager(typeReaderManager),
+    isBigEndianGraphicsData(false)
+{
+}
+
+
+// Parses the entire contents of an XNB file, returning the primary asset.
+XnbObjectPtr ContentReader::ReadXnb()
+{
+    // Read the XNB header.
+    uint32_t endPosition = ReadHeader();
+
+    ReadTypeManifest();
+
+    uint32_t sharedResourceCount = Read7BitEncodedInt();
+
+    sharedResourceFixups.clear();
+
+    // Read the primary asset data.
+    XNB_LOG(this, LogSummary).WriteLine("Asset:");
+
+    XnbObjectPtr asset = ReadObject();
+
+    // Read any shared resource instances.
+    vector<XnbObjectPtr> sharedResources;
+
+    // The count comes from the file, so is checked before it is reserved. Each resource takes at
+    // least a byte, for its type.
+    if (sharedResourceCount > FileSize() - FilePosition())
+    {
+        throw runtime_error("Invalid XNB file: shared resource count is past the end of the file.");
+    }
+
+    sharedResources.reserve(sharedResourceCount);
+
+    for (uint32_t i = 0 ; i < sharedResourceCount; i++)
+    {
+        XNB_LOG(this, LogSummary).WriteLine("Shared resource %d:", i);
+        
+        sharedResources.push_back(ReadObject());
+    }
+
+    // Make sure we read the amount of data that the file header said we should.
+    if (FilePosition() != endPosition)
+    {
+        throw runtime_error("End position does not match XNB header: unexpected amount of data was read.");
+    }
+
+    // Now they have been read, hook up all the references to shared resources.
+    for (SharedResourceFixup const& fixup : sharedResourceFixups)
+    {
+        if (fixup.resourceId >= sharedResources.size())
+        {
+            throw runtime_error("Invalid XNB file: shared resource ID is out of range.");
+        }
+
+        fixup.apply(sharedResources[fixup.resourceId]);
+    }
+
+    sharedResourceFixups.clear();
+
+    return asset;
+}
+
+
+// Reads the XNB file header (version number, size, etc.).
+uint32_t ContentReader::ReadHeader()
+{
+    uint32_t startPosition = FilePosition();
+
+    // Magic number.
+    uint8_t magic1 = ReadByte();
+    uint8_t magic2 = ReadByte();
+    uint8_t magic3 = ReadByte();
+
+    if (magic1 != 'X' ||
+        magic2 != 'N' ||
+        magic3 != 'B')
+    {
+        throw runtime_error("Not an XNB file.");
+    }
+
+    // Target platform.
+    uint8_t targetPlatform = ReadByte();
+
+    isBigEndianGraphicsData = (targetPlatform == 'x');
+
+    switch (targetPlatform)
+    {
+        case 'w': XNB_LOG(this, LogSummary).WriteLine("Target platform: Windows");                   break;
+        case 'm': XNB_LOG(this, LogSummary).WriteLine("Target platform: Windows Phone");             break;
+        case 'x': XNB_LOG(this, LogSummary).WriteLine("Target platform: Xbox 360");                  break;
+        default:  XNB_LOG(this, LogSummary).WriteLine("Unknown target platform %d", targetPlatform); break;
+    }
+
+    // Format version.
+    uint8_t formatVersion = ReadByte();
+
+    if (formatVersion != 5)
+    {
+        XNB_LOG(this, LogSummary).WriteLine("Warning: not an XNA Game Studio version 4.0 XNB file. Parsing may fail unexpectedly.");
+    }
+
+    // Flags.
+    uint8_t flags = ReadByte();
+
+    if (flags & 1)
+    {
+        XNB_LOG(this, LogSummary).WriteLine("Graphics profile: HiDef");
+    }
+    else
+    {
+        XNB_LOG(this, LogSummary).WriteLine("Graphics profile: Reach");
+    }
+
+    bool isCompressedLzx = (flags & 0x80) != 0;
+    bool isCompressedLz4 = (flags & 0x40) != 0;
+
+    // File size.
+    uint32_t sizeOnDisk = ReadUInt32();
+
+    // In 64 bits, so a huge size can't wrap around and pass.
+    if ((uint64_t)startPosition + sizeOnDisk > FileSize())
+    {
+        throw runtime_error("XNB file has been truncated.");
+    }
+
+    if (isCompressedLzx || isCompressedLz4)
+    {
+        uint32_t decompressedSize = ReadUInt32();
+
+        if (FilePosition() > startPosition + sizeOnDisk)
+        {
+            throw runtime_error("XNB file is too small to hold its header.");
+        }
+
+        uint32_t compressedSize = startPosition + sizeOnDisk - FilePosition();
+
+        // The size comes from the file, so is checked before it is allocated. Neither format gets
+        // anywhere near this ratio, even on runs of zeros.
+        if (decompressedSize > MaxDecompressedSize || decompressedSize > (uint64_t)compressedSize * MaxCompressionRatio)
+        {
+            throw runtime_error("Invalid XNB file: decompressed size is implausibly large.");
+        }
+
+        XNB_LOG(this, LogSummary).WriteLine("%d bytes of asset data are %s compressed into %d", decompressedSize, isCompressedLzx ? "LZX" : "LZ4", compressedSize);
+
+        // Decompress the rest of the file, then carry on reading from the decompressed data.
+        ArrayView<uint8_t> compressedData = ReadBytes(compressedSize);
+
+        vector<uint8_t> decompressedData(decompressedSize);
+
+        if (decompressedSize)
+        {
+            if (isCompressedLzx)
+            {
+                LzxDecoder decoder;
+
+                decoder.Decompress(compressedData.data(), compressedSize, &decompressedData[0], decompressedSize);
+            }
+            else
+            {
+                DecompressLz4(compressedData.data(), compressedSize, &decompressedData[0], decompressedSize);
+            }
+        }
+
+        ReplaceData(decompressedData);
+
+        return decompressedSize;
+    }
+
+    return startPosition + sizeOnDisk;
+}
+
+
+// Reads the manifest of what types are contained in this XNB file.
+void ContentReader::ReadTypeManifest()
+{
+    XNB_LOG(this, LogSummary).WriteLine("Type readers:");
+    Log.Indent();
+
+    // How many type readers does this .xnb use?
+    uint32_t typeReaderCount = Read7BitEncodedInt();
+
+    typeReaders.clear();
+
+    for (uint32_t i = 0; i < typeReaderCount; i++)
+    {
+        // Read the type reader metadata.
+        wstring readerName = ReadString();
+        int32_t readerVersion = ReadInt32();
+
+        XNB_LOG(this, LogSummary).WriteLine("%S (version %d)", readerName.c_str(), readerVersion);
+
+        // Look up and store this type reader implementation class.
+        TypeReader* reader = typeReaderManager->GetByReaderName(readerName);
+
+        typeReaders.push_back(reader);
+    }
+
+    // Initialize the readers in a separate pass after they are all registered, in case there are
+    // circular dependencies between them (eg. an array of classes which themselves contain arrays).
+    // Readers are shared between files, so this only does work the first time each one is seen.
+    typeReaderManager->InitializeTypeReaders(typeReaders);
+
+    Log.Unindent();
+}
+
+
+// Reads a single polymorphic object from the current location.
+XnbObjectPtr ContentReader::ReadObject()
+{
+    XnbObjectPtr result;
+
+    Log.Indent();
+
+    // What type of object is this?
+    TypeReader* typeReader = ReadTypeId();
+    
+    if (typeReader)
+    {
+        XNB_LOG(this, LogInspect).WriteLine("Type: %S", typeReader->TargetType().c_str());
+
+        // Call into the appropriate TypeReader to parse the object data.
+        result = typeReader->Read(this);
+    }
+    else
+    {
+        XNB_LOG(this, LogInspect).WriteLine("null");
+    }
+
+    Log.Unindent();
+
+    return result;
+}
+
+
+// Reads either a raw value or polymorphic object, depending on whether the specified typeReader represents a value type.
+XnbObjectPtr ContentReader::ReadValueOrObject(TypeReader* typeReader)
+{
+    if (typeReader->IsValueType())
+    {
+        // Read a value type.
+        Log.Indent();
+
+        XnbObjectPtr result = typeReader->Read(this);
+
+        Log.Unindent();
+
+        return result;
+    }
+    else
+    {
+        // Read a reference type.
+        return ReadObject();
+    }
+}
+
+
+// Reads the typeId from the start of a polymorphic object, and looks up the appropriate TypeReader implementation.
+TypeReader* ContentReader::ReadTypeId()
+{
+    uint32_t typeId = Read7BitEncodedInt();
+
+    if (typeId > 0)
+    {
+        // Look up the reader for this type of object.
+        typeId--;
+
+        if (typeId >= typeReaders.size())
+        {
+            throw runtime_error("Invalid XNB file: typeId is out of range.");
+        }
+
+        return typeReaders[typeId];
+    }
+    else
+    {
+        // A zero typeId indicates a null object.
+        return nullptr;
+    }
+}
+
+
+// Reads a typeId, and validates that it is the expected type.
+void ContentReader::ValidateTypeId(wstring const& expectedType)
+{
+    TypeReader* reader = ReadTypeId();
+
+    if (!reader || reader->TargetType() != expectedType)
+    {
+        throw runtime_error("Invalid XNB file: got an unexpected typeId.");
+    }
+}
+
+
+// Reads the (one based, zero for null) index of a shared resource.
+uint32_t ContentReader::ReadSharedResourceId()
+{
+    uint32_t resourceId = Read7BitEncodedInt();
+
+    if (resourceId)
+    {
+        XNB_LOG(this, LogInspect).WriteLine("shared resource #%u", resourceId - 1);
+    }
+    else
+    {
+        XNB_LOG(this, LogInspect).WriteLine("null");
+    }
+
+    return resourceId;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "Logger.h"
+#include "BinaryReader.h"
+#include "TypeReaderManager.h"
+#include "stdafx.h"
+
+// Parses an XNB file, calling into the appropriate TypeReader
+// helper to read whatever type(s) of object it contains.
+class ContentReader : public BinaryReader
+{
+public:
+	ContentReader(FILE* file, TypeReaderManager* typeReaderManager);
+
+    // Parses XNB data that is already in memory (eg. a MappedFile), which must outlive the reader.
+    ContentReader(uint8_t const* data, uint32_t size, TypeReaderManager* typeReaderManager);
+
+    // Helper for printing out the file contents.
+    Logger Log;
+
+    // Xbox 360 files store bulk graphics data (vertices and indices) big-endian.
+    bool IsBigEndianGraphicsData() const { return isBigEndianGraphicsData; }
+
+    // Parses the entire contents of an XNB file, returning the primary asset.
+    XnbObjectPtr ReadXnb();
+
+    // Reads a single polymorphic object from the current location.
+    XnbObjectPtr ReadObject();
+
+    // Reads a polymorphic object that is expected to be of type T (or null).
+    template<typename T> shared_ptr<T> ReadObjectAs()
+    {
+        XnbObjectPtr object = ReadObject();
+
+        shared_ptr<T> result = dynamic_pointer_cast<T>(object);
+
+        if (object && !result)
+        {
+            throw runtime_error("Invalid XNB file: got an unexpected object type.");
+        }
+
+        return result;
+    }
+
+    // Reads either a raw value or polymorphic object, depending on whether the specified typeReader represents a value type.
+    XnbObjectPtr ReadValueOrObject(TypeReader* typeReader);
+
+    // Reads the typeId from the start of a polymorphic object, and looks up the appropriate TypeReader implementation.
+    TypeReader* ReadTypeId();
+
+    // Reads a typeId, and validates that it is the expected type.
+    void ValidateTypeId(wstring const& expectedType);
+
+    // Reads a shared resource ID, which indexes into the table of shared object instances that come after the primary asset.
+    // Those haven't been read yet, so target is filled in at the end of ReadXnb, and must stay valid until then.
+    template<typename T> void ReadSharedResource(shared_ptr<T>* target)
+    {
+        uint32_t resourceId = ReadSharedResourceId();
+
+        if (resourceId)
+        {
+            SharedResourceFixup fixup;
+
+            fixup.resourceId = resourceId - 1;
+
+            fixup.apply = [target](XnbObjectPtr const& resource)
+            {
+                *target = dynamic_pointer_cast<T>(resource);
+
+                if (resource && !*target)
+                {
+                    throw runtime_error("Invalid XNB file: shared resource has an unexpected type.");
+                }
+            };
+
+            sharedResourceFixups.push_back(fixup);
+        }
+    }
+
+private:
+    // Reads the XNB file header (version number, size, etc.), decompressing the asset data if necessary.
+    // Returns the position at which the asset data should end.
+    uint32_t ReadHeader();
+
+    // Reads the manifest of what types are contained in this XNB file.
+    void ReadTypeManifest();
+
+    // Reads the (one based, zero for null) index of a shared resource.
+    uint32_t ReadSharedResourceId();
+
+    // Records where a shared resource reference should be stored once it has been read.
+    struct SharedResourceFixup
+    {
+        uint32_t resourceId;
+        function<void (XnbObjectPtr const&)> apply;
+    };
+
+    vector<SharedResourceFixup> sharedResourceFixups;
+
+    // Manager provides reader implementations for all supported data types.
+    TypeReaderManager* typeReaderManager;
+
+    // Table of the readers used by this particular .xnb file.
+    vector<TypeReader*> typeReaders;
+
+    bool isBigEndianGraphicsData;
+};
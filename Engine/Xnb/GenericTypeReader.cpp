@@ -10,16 +10,24 @@ void GenericTypeReader::Specialize(wstring const& targetType, wstring const& rea
 }
 
 
-GenericTypeReader* GenericTypeReaderFactory::CreateTypeReader(vector<wstring> const& genericArguments)
+wstring GenericTypeReader::GenericArgument(int i) const
 {
-    // Build up a .NET format generic type name suffix, eg. "Foo`2[[ArgType1],[ArgType2]]".
-    wchar_t genericArgumentCount[16];
+    // The arguments come from a type name in the file, which may have fewer than the reader needs.
+    if (i < 0 || (size_t)i >= genericArguments.size())
+    {
+        throw runtime_error("Invalid XNB file: generic type is missing type arguments.");
+    }
 
-    swprintf_s(genericArgumentCount, L"`%d[[", genericArguments.size());
+    return genericArguments[i];
+}
 
-    wstring genericSuffix = genericArgumentCount;
 
-    for each (wstring const& genericArgument in genericArguments)
+GenericTypeReader* GenericTypeReaderFactory::CreateTypeReader(vector<wstring> const& genericArguments)
+{
+    // Build up a .NET format generic type name suffix, eg. "Foo`2[[ArgType1],[ArgType2]]".
+    wstring genericSuffix = L"`" + to_wstring((unsigned long long)genericArguments.size()) + L"[[";
+
+    for (wstring const& genericArgument : genericArguments)
     {
         genericSuffix += genericArgument;
 
@@ -12,7 +12,7 @@ public:
     virtual wstring TargetType() const { return targetType; }
     virtual wstring ReaderName() const { return readerName; }
 
-    virtual wstring GenericArgument(int i) const { return genericArguments[i]; }
+    virtual wstring GenericArgument(int i) const;
 
 private:
     wstring targetType;
@@ -0,0 +1,790 @@
+#include "stdafx.h"
+#include "ContentReader.h"
+#include "GraphicsTypeReaders.h"
+#include "MathTypeReaders.h"
+#include "XnbVertexFormat.h"
+
+
+static char const* SurfaceFormatEnumValues[] =
+{
+    "Color",
+    "Bgr565",
+    "Bgra5551",
+    "Bgra4444",
+    "Dxt1",
+    "Dxt3",
+    "Dxt5",
+    "NormalizedByte2",
+    "NormalizedByte4",
+    "Rgba1010102",
+    "Rg32",
+    "Rgba64",
+    "Alpha8",
+    "Single",
+    "Vector2",
+    "Vector4",
+    "HalfSingle",
+    "HalfVector2",
+    "HalfVector4",
+    "HdrBlendable",
+    nullptr
+};
+
+
+static char const* VertexElementFormatEnumValues[] =
+{
+    "Single",
+    "Vector2",
+    "Vector3",
+    "Vector4",
+    "Color",
+    "Byte4",
+    "Short2",
+    "Short4",
+    "NormalizedShort2",
+    "NormalizedShort4",
+    "HalfVector2",
+    "HalfVector4",
+    nullptr
+};
+
+
+static char const* VertexElementUsageEnumValues[] =
+{
+    "Position",
+    "Color",
+    "TextureCoordinate",
+    "Normal",
+    "Binormal",
+    "Tangent",
+    "BlendIndices",
+    "BlendWeight",
+    "Depth",
+    "Fog",
+    "PointSize",
+    "Sample",
+    "TessellateFactor",
+    nullptr
+};
+
+
+static char const* CompareFunctionEnumValues[] =
+{
+    "Always",
+    "Never",
+    "Less",
+    "LessEqual",
+    "Equal",
+    "GreaterEqual",
+    "Greater",
+    "NotEqual",
+    nullptr
+};
+
+
+// Reads rows of floats (eg. a vector or matrix) into values, printing one row per line.
+static void ReadFloats(ContentReader* reader, float* values, int rows, int columns)
+{
+    for (int row = 0; row < rows; row++)
+    {
+        float* rowValues = values + row * columns;
+
+        for (int column = 0; column < columns; column++)
+        {
+            rowValues[column] = reader->ReadSingle();
+        }
+
+        switch (columns)
+        {
+            case 3:  XNB_LOG(reader, LogInspect).WriteLine("{ %g, %g, %g }", rowValues[0], rowValues[1], rowValues[2]);                 break;
+            case 4:  XNB_LOG(reader, LogInspect).WriteLine("{ %g, %g, %g, %g }", rowValues[0], rowValues[1], rowValues[2], rowValues[3]); break;
+            default: assert(false); break;
+        }
+    }
+}
+
+
+// Counts come from the file, so are checked before anything is sized from them. Every item
+// takes at least a byte, so there can't be more than there are bytes left.
+static void CheckCount(ContentReader* reader, uint32_t count)
+{
+    if (count > reader->FileSize() - reader->FilePosition())
+    {
+        throw runtime_error("Error reading file.");
+    }
+}
+
+
+XnbObjectPtr TextureReader::Read(ContentReader*)
+{
+    throw runtime_error("TextureReader should never be invoked directly.");
+}
+
+
+// Reads the size prefixed data of the next subresource onto the end of the texture's data.
+static void ReadSubresource(ContentReader* reader, XnbTexture* texture)
+{
+    uint32_t dataSize = reader->ReadUInt32();
+    ArrayView<uint8_t> data = reader->ReadBytes(dataSize);
+
+    XNB_LOG(reader, LogInspect).WriteBytes("", data);
+
+    // Mips shrink by at least 4x, so the first one gives a good guess at the total size.
+    if (texture->subresources.empty())
+    {
+        texture->data.reserve(((size_t)dataSize + dataSize / 3 + 16) * texture->faceCount);
+    }
+
+    XnbTextureSubresource subresource;
+
+    subresource.offset = (uint32_t)texture->data.size();
+    subresource.size = dataSize;
+
+    texture->subresources.push_back(subresource);
+    texture->data.insert(texture->data.end(), data.begin(), data.end());
+}
+
+
+XnbObjectPtr Texture2DReader::Read(ContentReader* reader)
+{
+    shared_ptr<XnbTexture2D> texture(new XnbTexture2D);
+
+    texture->format = reader->ReadInt32();
+    texture->width = reader->ReadUInt32();
+    texture->height = reader->ReadUInt32();
+    texture->mipCount = reader->ReadUInt32();
+
+    XNB_LOG(reader, LogInspect).WriteEnum("Format", texture->format, SurfaceFormatEnumValues);
+    XNB_LOG(reader, LogInspect).WriteLine("Width: %u", texture->width);
+    XNB_LOG(reader, LogInspect).WriteLine("Height: %u", texture->height);
+    XNB_LOG(reader, LogInspect).WriteLine("Mip count: %u", texture->mipCount);
+
+    for (uint32_t i = 0; i < texture->mipCount; i++)
+    {
+        XNB_LOG(reader, LogInspect).Write("Mip %u", i);
+
+        ReadSubresource(reader, texture.get());
+    }
+
+    return texture;
+}
+
+
+XnbObjectPtr Texture3DReader::Read(ContentReader* reader)
+{
+    shared_ptr<XnbTexture3D> texture(new XnbTexture3D);
+
+    texture->format = reader->ReadInt32();
+    XNB_LOG(reader, LogInspect).WriteEnum("Format", texture->format, SurfaceFormatEnumValues);
+    texture->width = reader->ReadUInt32();
+    XNB_LOG(reader, LogInspect).WriteLine("Width: %u", texture->width);
+    texture->height = reader->ReadUInt32();
+    XNB_LOG(reader, LogInspect).WriteLine("Height: %u", texture->height);
+    texture->depth = reader->ReadUInt32();
+    XNB_LOG(reader, LogInspect).WriteLine("Depth: %u", texture->depth);
+
+    texture->mipCount = reader->ReadUInt32();
+    XNB_LOG(reader, LogInspect).WriteLine("Mip count: %u", texture->mipCount);
+
+    for (uint32_t i = 0; i < texture->mipCount; i++)
+    {
+        XNB_LOG(reader, LogInspect).Write("Mip %u", i);
+
+        ReadSubresource(reader, texture.get());
+    }
+
+    return texture;
+}
+
+
+XnbObjectPtr TextureCubeReader::Read(ContentReader* reader)
+{
+    shared_ptr<XnbTextureCube> texture(new XnbTextureCube);
+
+    texture->format = reader->ReadInt32();
+    XNB_LOG(reader, LogInspect).WriteEnum("Format", texture->format, SurfaceFormatEnumValues);
+    texture->width = texture->height = reader->ReadUInt32();
+    XNB_LOG(reader, LogInspect).WriteLine("Size: %u", texture->width);
+
+    texture->mipCount = reader->ReadUInt32();
+    XNB_LOG(reader, LogInspect).WriteLine("Mip count: %u", texture->mipCount);
+
+    texture->faceCount = 6;
+
+    for (int face = 0; face < 6; face++)
+    {
+        for (uint32_t i = 0; i < texture->mipCount; i++)
+        {
+            XNB_LOG(reader, LogInspect).Write("Face %d mip %u", face, i);
+
+            ReadSubresource(reader, texture.get());
+        }
+    }
+
+    return texture;
+}
+
+
+XnbObjectPtr IndexBufferReader::Read(ContentReader* reader)
+{
+    shared_ptr<XnbIndexBuffer> indexBuffer(new XnbIndexBuffer);
+
+    bool is16Bit = reader->ReadBoolean();
+
+    XNB_LOG(reader, LogInspect).WriteLine("Index format: %s", is16Bit ? "16 bit" : "32 bit");
+
+    uint32_t dataSize = reader->ReadUInt32();
+    uint32_t count = dataSize / (is16Bit ? 2 : 4);
+
+    CheckCount(reader, dataSize);
+
+    indexBuffer->is16Bit = is16Bit;
+
+    if (is16Bit)
+    {
+        indexBuffer->indexData16.resize(count);
+
+        if (count)
+        {
+            reader->ReadArray16(&indexBuffer->indexData16[0], count, reader->IsBigEndianGraphicsData());
+        }
+    }
+    else
+    {
+        indexBuffer->indexData32.resize(count);
+
+        if (count)
+        {
+            reader->ReadArray32(&indexBuffer->indexData32[0], count, reader->IsBigEndianGraphicsData());
+        }
+    }
+
+    return indexBuffer;
+}
+
+
+static void ReadVertexDeclaration(ContentReader* reader, XnbVertexDeclaration* declaration)
+{
+    declaration->stride = reader->ReadUInt32();
+    XNB_LOG(reader, LogInspect).WriteLine("Vertex stride: %u", declaration->stride);
+
+    uint32_t elementCount = reader->ReadUInt32();
+    XNB_LOG(reader, LogInspect).WriteLine("Element count: %u", elementCount);
+
+    CheckCount(reader, elementCount);
+
+    declaration->elements.resize(elementCount);
+
+    for (uint32_t i = 0; i < elementCount; i++)
+    {
+        XnbVertexElement& element = declaration->elements[i];
+
+        element.offset = reader->ReadUInt32();
+        element.format = reader->ReadInt32();
+        element.usage = reader->ReadInt32();
+        element.usageIndex = reader->ReadUInt32();
+
+        XNB_LOG(reader, LogInspect).WriteLine("Element %u:", i);
+        reader->Log.Indent();
+
+        XNB_LOG(reader, LogInspect).WriteLine("Offset: %u", element.offset);
+        XNB_LOG(reader, LogInspect).WriteEnum("Element format", element.format, VertexElementFormatEnumValues);
+        XNB_LOG(reader, LogInspect).WriteEnum("Element usage", element.usage, VertexElementUsageEnumValues);
+        XNB_LOG(reader, LogInspect).WriteLine("Usage index: %u", element.usageIndex);
+
+        reader->Log.Unindent();
+
+        // Everything that decodes vertices relies on the elements being valid and inside the vertex.
+        uint32_t elementSize = VertexElementSize(element.format);
+
+        if (!elementSize)
+        {
+            throw runtime_error("Unknown vertex element format.");
+        }
+
+        if (element.offset > declaration->stride || elementSize > declaration->stride - element.offset)
+        {
+            throw runtime_error("Vertex element does not fit in the vertex stride.");
+        }
+    }
+}
+
+
+// Xbox vertex data is byte swapped one element component at a time, but it is read as
+// 32 bit words, which leaves the two halves of each word in 16 bit formats (Short2,
+// NormalizedShort4, HalfVector2, etc.) the wrong way round.
+static void FixSwapped16BitElements(XnbVertexBuffer* vertexBuffer)
+{
+    uint32_t stride = vertexBuffer->declaration.stride;
+    uint8_t* vertexData = (uint8_t*)&vertexBuffer->vertexData[0];
+
+    if (stride % 4)
+    {
+        throw runtime_error("Vertex stride is not a whole number of 32 bit words.");
+    }
+
+    for (XnbVertexElement const& element : vertexBuffer->declaration.elements)
+    {
+        uint32_t wordCount;
+
+        switch (element.format)
+        {
+            case ElementFormatShort2:
+            case ElementFormatNormalizedShort2:
+            case ElementFormatHalfVector2:
+                wordCount = 1;
+                break;
+
+            case ElementFormatShort4:
+            case ElementFormatNormalizedShort4:
+            case ElementFormatHalfVector4:
+                wordCount = 2;
+                break;
+
+            default:
+                continue;
+        }
+
+        for (uint32_t i = 0; i < vertexBuffer->vertexCount; i++)
+        {
+            uint8_t* elementData = vertexData + i * stride + element.offset;
+
+            for (uint32_t j = 0; j < wordCount; j++)
+            {
+                uint32_t word;
+
+                memcpy(&word, elementData + j * 4, sizeof(word));
+                word = (word << 16) | (word >> 16);
+                memcpy(elementData + j * 4, &word, sizeof(word));
+            }
+        }
+    }
+}
+
+
+XnbObjectPtr VertexBufferReader::Read(ContentReader* reader)
+{
+    shared_ptr<XnbVertexBuffer> vertexBuffer(new XnbVertexBuffer);
+
+    XNB_LOG(reader, LogInspect).WriteLine("Vertex declaration:");
+    reader->Log.Indent();
+
+    ReadVertexDeclaration(reader, &vertexBuffer->declaration);
+
+    reader->Log.Unindent();
+
+    vertexBuffer->vertexCount = reader->ReadUInt32();
+    XNB_LOG(reader, LogInspect).WriteLine("Vertex count: %u", vertexBuffer->vertexCount);
+
+    uint64_t floatCount = (uint64_t)vertexBuffer->vertexCount * vertexBuffer->declaration.stride / 4; //#bytes / 4 = #float
+
+    // Reject sizes that can't possibly be in the file before allocating anything.
+    if (floatCount > reader->FileSize() - reader->FilePosition())
+    {
+        throw runtime_error("Error reading file.");
+    }
+
+    vertexBuffer->vertexData.resize((size_t)floatCount);
+
+    if (floatCount)
+    {
+        bool isBigEndian = reader->IsBigEndianGraphicsData();
+
+        reader->ReadArray32(&vertexBuffer->vertexData[0], (uint32_t)floatCount, isBigEndian);
+
+        if (isBigEndian)
+        {
+            FixSwapped16BitElements(vertexBuffer.get());
+        }
+    }
+
+    return vertexBuffer;
+}
+
+
+XnbObjectPtr VertexDeclarationReader::Read(ContentReader* reader)
+{
+    shared_ptr<XnbVertexDeclaration> declaration(new XnbVertexDeclaration);
+
+    ReadVertexDeclaration(reader, declaration.get());
+
+    return declaration;
+}
+
+
+XnbObjectPtr EffectReader::Read(ContentReader* reader)
+{
+    uint32_t size = reader->ReadUInt32();
+
+    ArrayView<uint8_t> effectBytecode = reader->ReadBytes(size);
+    XNB_LOG(reader, LogInspect).WriteBytes("Effect bytecode", effectBytecode);
+
+    return nullptr;
+}
+
+
+XnbObjectPtr EffectMaterialReader::Read(ContentReader* reader)
+{
+    wstring ref = reader->ReadString();
+
+    XNB_LOG(reader, LogInspect).WriteLine("Effect reference: '%S'", ref.c_str());
+    
+    XNB_LOG(reader, LogInspect).WriteLine("Parameters:");
+    reader->ReadObject();
+
+    return nullptr;
+}
+
+
+XnbObjectPtr BasicEffectReader::Read(ContentReader* reader)
+{
+    shared_ptr<XnbBasicEffect> effect(new XnbBasicEffect);
+
+    effect->textureReference = reader->ReadString();
+    XNB_LOG(reader, LogInspect).WriteLine("Texture reference: '%S'", effect->textureReference.c_str());
+
+    XNB_LOG(reader, LogInspect).Write("Diffuse color: ");
+    ReadFloats(reader, effect->diffuseColor, 1, 3);
+
+    XNB_LOG(reader, LogInspect).Write("Emissive color: ");
+    ReadFloats(reader, effect->emissiveColor, 1, 3);
+
+    XNB_LOG(reader, LogInspect).Write("Specular color: ");
+    ReadFloats(reader, effect->specularColor, 1, 3);
+
+    effect->specularPower = reader->ReadSingle();
+    effect->alpha = reader->ReadSingle();
+    effect->vertexColorEnabled = reader->ReadBoolean();
+
+    XNB_LOG(reader, LogInspect).WriteLine("Specular power: %g", effect->specularPower);
+    XNB_LOG(reader, LogInspect).WriteLine("Alpha: %g", effect->alpha);
+    XNB_LOG(reader, LogInspect).WriteLine("Vertex color enabled: %s", effect->vertexColorEnabled ? "true" : "false");
+
+    return effect;
+}
+
+
+XnbObjectPtr AlphaTestEffectReader::Read(ContentReader* reader)
+{
+    wstring textureReference = reader->ReadString();
+    XNB_LOG(reader, LogInspect).WriteLine("Texture reference: '%S'", textureReference.c_str());
+
+    int32_t compareFunction = reader->ReadInt32();
+    XNB_LOG(reader, LogInspect).WriteEnum("Compare function", compareFunction, CompareFunctionEnumValues);
+    uint32_t referenceAlpha = reader->ReadUInt32();
+    XNB_LOG(reader, LogInspect).WriteLine("Reference alpha: %u", referenceAlpha);
+
+    XNB_LOG(reader, LogInspect).Write("Diffuse color: ");
+    Vector3Reader().Read(reader);
+
+    float alpha = reader->ReadSingle();
+    XNB_LOG(reader, LogInspect).WriteLine("Alpha: %g", alpha);
+    bool vertexColorEnabled = reader->ReadBoolean();
+    XNB_LOG(reader, LogInspect).WriteLine("Vertex color enabled: %s", vertexColorEnabled ? "true" : "false");
+
+    return nullptr;
+}
+
+
+XnbObjectPtr DualTextureEffectReader::Read(ContentReader* reader)
+{
+    wstring texture1Reference = reader->ReadString();
+    XNB_LOG(reader, LogInspect).WriteLine("Texture 1 reference: '%S'", texture1Reference.c_str());
+    wstring texture2Reference = reader->ReadString();
+    XNB_LOG(reader, LogInspect).WriteLine("Texture 2 reference: '%S'", texture2Reference.c_str());
+
+    XNB_LOG(reader, LogInspect).Write("Diffuse color: ");
+    Vector3Reader().Read(reader);
+
+    float alpha = reader->ReadSingle();
+    XNB_LOG(reader, LogInspect).WriteLine("Alpha: %g", alpha);
+    bool vertexColorEnabled = reader->ReadBoolean();
+    XNB_LOG(reader, LogInspect).WriteLine("Vertex color enabled: %s", vertexColorEnabled ? "true" : "false");
+
+    return nullptr;
+}
+
+
+XnbObjectPtr EnvironmentMapEffectReader::Read(ContentReader* reader)
+{
+    wstring textureReference = reader->ReadString();
+    XNB_LOG(reader, LogInspect).WriteLine("Texture reference: '%S'", textureReference.c_str());
+    wstring environmentMapReference = reader->ReadString();
+    XNB_LOG(reader, LogInspect).WriteLine("Environment map reference: '%S'", environmentMapReference.c_str());
+
+    float environmentMapAmount = reader->ReadSingle();
+    XNB_LOG(reader, LogInspect).WriteLine("Environment map amount: %g", environmentMapAmount);
+
+    XNB_LOG(reader, LogInspect).Write("Environment map specular: ");
+    Vector3Reader().Read(reader);
+
+    float fresnelFactor = reader->ReadSingle();
+    XNB_LOG(reader, LogInspect).WriteLine("Fresnel factor: %g", fresnelFactor);
+
+    XNB_LOG(reader, LogInspect).Write("Diffuse color: ");
+    Vector3Reader().Read(reader);
+
+    XNB_LOG(reader, LogInspect).Write("Emissive color: ");
+    Vector3Reader().Read(reader);
+
+    float alpha = reader->ReadSingle();
+    XNB_LOG(reader, LogInspect).WriteLine("Alpha: %g", alpha);
+
+    return nullptr;
+}
+
+
+XnbObjectPtr SkinnedEffectReader::Read(ContentReader* reader)
+{
+    wstring textureReference = reader->ReadString();
+    XNB_LOG(reader, LogInspect).WriteLine("Texture reference: '%S'", textureReference.c_str());
+
+    uint32_t weightsPerVertex = reader->ReadUInt32();
+    XNB_LOG(reader, LogInspect).WriteLine("Weights per vertex: %u", weightsPerVertex);
+
+    XNB_LOG(reader, LogInspect).Write("Diffuse color: ");
+    Vector3Reader().Read(reader);
+
+    XNB_LOG(reader, LogInspect).Write("Emissive color: ");
+    Vector3Reader().Read(reader);
+
+    XNB_LOG(reader, LogInspect).Write("Specular color: ");
+    Vector3Reader().Read(reader);
+
+    float specularPower = reader->ReadSingle();
+    XNB_LOG(reader, LogInspect).WriteLine("Specular power: %g", specularPower);
+    float alpha = reader->ReadSingle();
+    XNB_LOG(reader, LogInspect).WriteLine("Alpha: %g", alpha);
+
+    return nullptr;
+}
+
+
+XnbObjectPtr SpriteFontReader::Read(ContentReader* reader)
+{
+    XNB_LOG(reader, LogInspect).WriteLine("Texture:");
+    reader->ReadObject();
+
+    XNB_LOG(reader, LogInspect).WriteLine("Glyphs:");
+    reader->ReadObject();
+
+    XNB_LOG(reader, LogInspect).WriteLine("Cropping:");
+    reader->ReadObject();
+
+    XNB_LOG(reader, LogInspect).WriteLine("Character map:");
+    reader->ReadObject();
+
+    int32_t verticalLineSpacing = reader->ReadInt32();
+    XNB_LOG(reader, LogInspect).WriteLine("Vertical line spacing: %d", verticalLineSpacing);
+    float horizontalSpacing = reader->ReadSingle();
+    XNB_LOG(reader, LogInspect).WriteLine("Horizontal spacing: %g", horizontalSpacing);
+
+    XNB_LOG(reader, LogInspect).WriteLine("Kerning:");
+    reader->ReadObject();
+
+    XNB_LOG(reader, LogInspect).Write("Default character: ");
+
+    if (reader->ReadBoolean())
+    {
+        wchar_t value = reader->ReadChar();
+        XNB_LOG(reader, LogInspect).WriteLine("U+%04hX", value);
+    }
+    else
+    {
+        XNB_LOG(reader, LogInspect).WriteLine("null");
+    }
+
+    return nullptr;
+}
+
+
+// Reads a bone ID, which may be encoded as either an 8 or 32 bit value. Returns -1 for null.
+static int32_t ReadBoneReference(ContentReader* reader, uint32_t boneCount)
+{
+    uint32_t boneId;
+
+    if (boneCount < 255)
+    {
+        boneId = reader->ReadByte();
+    }
+    else
+    {
+        boneId = reader->ReadUInt32();
+    }
+
+    if (boneId > boneCount)
+    {
+        throw runtime_error("Invalid XNB file: bone reference is out of range.");
+    }
+
+    // Print out the bone ID.
+    if (boneId)
+    {
+        XNB_LOG(reader, LogInspect).WriteLine("bone #%u", boneId - 1);
+    }
+    else
+    {
+        XNB_LOG(reader, LogInspect).WriteLine("null");
+    }
+
+    return (int32_t)boneId - 1;
+}
+
+
+XnbObjectPtr ModelReader::Read(ContentReader* reader)
+{
+    shared_ptr<XnbModel> model(new XnbModel);
+
+    // Read the bone names and transforms.
+    uint32_t boneCount = reader->ReadUInt32();
+    XNB_LOG(reader, LogInspect).WriteLine("Bone count: %u", boneCount);
+
+    CheckCount(reader, boneCount);
+
+    model->bones.resize(boneCount);
+
+    for (uint32_t i = 0; i < boneCount; i++)
+    {
+        XnbBone& bone = model->bones[i];
+
+        XNB_LOG(reader, LogInspect).WriteLine("Bone %u:", i);
+        reader->Log.Indent();
+
+        XNB_LOG(reader, LogInspect).WriteLine("Name:");
+        shared_ptr<XnbString> name = reader->ReadObjectAs<XnbString>();
+
+        if (name)
+        {
+            bone.name = name->value;
+        }
+
+        XNB_LOG(reader, LogInspect).WriteLine("Transform:");
+        reader->Log.Indent();
+        ReadFloats(reader, bone.transform, 4, 4);
+        reader->Log.Unindent();
+
+        reader->Log.Unindent();
+    }
+
+    // Read the bone hierarchy.
+    for (uint32_t i = 0; i < boneCount; i++)
+    {
+        XnbBone& bone = model->bones[i];
+
+        XNB_LOG(reader, LogInspect).WriteLine("Bone %u hierarchy:", i);
+        reader->Log.Indent();
+
+        // Read the parent bone reference.
+        XNB_LOG(reader, LogInspect).Write("Parent: ");
+        bone.parent = ReadBoneReference(reader, boneCount);
+
+        // Read the child bone references.
+        uint32_t childCount = reader->ReadUInt32();
+
+        if (childCount)
+        {
+            XNB_LOG(reader, LogInspect).WriteLine("Children:");
+            reader->Log.Indent();
+
+            CheckCount(reader, childCount);
+
+            bone.children.resize(childCount);
+
+            for (uint32_t j = 0; j < childCount; j++)
+            {
+                bone.children[j] = ReadBoneReference(reader, boneCount);
+            }
+
+            reader->Log.Unindent();
+        }
+
+        reader->Log.Unindent();
+    }
+
+    // Read the mesh data. The meshes and parts are sized up front, as pending shared
+    // resource fixups hold pointers into them.
+    uint32_t meshCount = reader->ReadUInt32();
+    XNB_LOG(reader, LogInspect).WriteLine("Mesh count: %u", meshCount);
+
+    CheckCount(reader, meshCount);
+
+    model->meshes.resize(meshCount);
+
+    for (uint32_t i = 0; i < meshCount; i++)
+    {
+        XnbMesh& mesh = model->meshes[i];
+
+        XNB_LOG(reader, LogInspect).WriteLine("Mesh %u", i);
+        reader->Log.Indent();
+
+        XNB_LOG(reader, LogInspect).WriteLine("Mesh name:");
+        shared_ptr<XnbString> name = reader->ReadObjectAs<XnbString>();
+
+        if (name)
+        {
+            mesh.name = name->value;
+        }
+
+        XNB_LOG(reader, LogInspect).Write("Mesh parent: ");
+        mesh.parentBone = ReadBoneReference(reader, boneCount);
+
+        XNB_LOG(reader, LogInspect).WriteLine("Mesh bounds:");
+        reader->Log.Indent();
+        ReadFloats(reader, mesh.boundingSphere, 1, 4);
+        reader->Log.Unindent();
+
+        XNB_LOG(reader, LogInspect).WriteLine("Mesh tag:");
+        reader->ReadObject();
+
+        // Read the mesh part data.
+        uint32_t partCount = reader->ReadUInt32();
+        XNB_LOG(reader, LogInspect).WriteLine("Mesh part count: %u", partCount);
+
+        CheckCount(reader, partCount);
+
+        mesh.parts.resize(partCount);
+
+        for (uint32_t j = 0; j < partCount; j++)
+        {
+            XnbMeshPart& part = mesh.parts[j];
+
+            XNB_LOG(reader, LogInspect).WriteLine("Mesh part %u", j);
+            reader->Log.Indent();
+
+            part.vertexOffset = reader->ReadInt32();
+            part.numVertices = reader->ReadInt32();
+            part.startIndex = reader->ReadInt32();
+            part.primitiveCount = reader->ReadInt32();
+
+            XNB_LOG(reader, LogInspect).WriteLine("Vertex offset: %d", part.vertexOffset);
+            XNB_LOG(reader, LogInspect).WriteLine("Num vertices: %d", part.numVertices);
+            XNB_LOG(reader, LogInspect).WriteLine("Start index: %d", part.startIndex);
+            XNB_LOG(reader, LogInspect).WriteLine("Primitive count: %d", part.primitiveCount);
+
+            XNB_LOG(reader, LogInspect).WriteLine("Mesh part tag:");
+            reader->ReadObject();
+
+            XNB_LOG(reader, LogInspect).Write("Vertex buffer: ");
+            reader->ReadSharedResource(&part.vertexBuffer);
+
+            XNB_LOG(reader, LogInspect).Write("Index buffer: ");
+            reader->ReadSharedResource(&part.indexBuffer);
+
+            XNB_LOG(reader, LogInspect).Write("Effect: ");
+            reader->ReadSharedResource(&part.effect);
+            
+            reader->Log.Unindent();
+        }
+
+        reader->Log.Unindent();
+    }
+
+    // Read the final pieces of model data.
+    XNB_LOG(reader, LogInspect).Write("Model root: ");
+    model->rootBone = ReadBoneReference(reader, boneCount);
+
+    XNB_LOG(reader, LogInspect).WriteLine("Model tag:");
+    reader->ReadObject();
+
+    return model;
+}
@@ -9,7 +9,7 @@ public:
     virtual wstring TargetType() const { return L"Microsoft.Xna.Framework.Graphics.Texture"; }
     virtual wstring ReaderName() const { return L"Microsoft.Xna.Framework.Content.TextureReader"; }
 
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
 
 
@@ -19,7 +19,7 @@ public:
     virtual wstring TargetType() const { return L"Microsoft.Xna.Framework.Graphics.Texture2D"; }
     virtual wstring ReaderName() const { return L"Microsoft.Xna.Framework.Content.Texture2DReader"; }
 
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
 
 
@@ -29,7 +29,7 @@ public:
     virtual wstring TargetType() const { return L"Microsoft.Xna.Framework.Graphics.Texture3D"; }
     virtual wstring ReaderName() const { return L"Microsoft.Xna.Framework.Content.Texture3DReader"; }
 
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
 
 
@@ -39,7 +39,7 @@ public:
     virtual wstring TargetType() const { return L"Microsoft.Xna.Framework.Graphics.TextureCube"; }
     virtual wstring ReaderName() const { return L"Microsoft.Xna.Framework.Content.TextureCubeReader"; }
 
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
 
 
@@ -49,7 +49,7 @@ public:
     virtual wstring TargetType() const { return L"Microsoft.Xna.Framework.Graphics.IndexBuffer"; }
     virtual wstring ReaderName() const { return L"Microsoft.Xna.Framework.Content.IndexBufferReader"; }
 
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
 
 
@@ -59,7 +59,7 @@ public:
     virtual wstring TargetType() const { return L"Microsoft.Xna.Framework.Graphics.VertexBuffer"; }
     virtual wstring ReaderName() const { return L"Microsoft.Xna.Framework.Content.VertexBufferReader"; }
 
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
 
 
@@ -69,7 +69,7 @@ public:
     virtual wstring TargetType() const { return L"Microsoft.Xna.Framework.Graphics.VertexDeclaration"; }
     virtual wstring ReaderName() const { return L"Microsoft.Xna.Framework.Content.VertexDeclarationReader"; }
 
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
 
 
@@ -79,7 +79,7 @@ public:
     virtual wstring TargetType() const { return L"Microsoft.Xna.Framework.Graphics.Effect"; }
     virtual wstring ReaderName() const { return L"Microsoft.Xna.Framework.Content.EffectReader"; }
 
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
 
 
@@ -89,7 +89,7 @@ public:
     virtual wstring TargetType() const { return L"Microsoft.Xna.Framework.Graphics.EffectMaterial"; }
     virtual wstring ReaderName() const { return L"Microsoft.Xna.Framework.Content.EffectMaterialReader"; }
 
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
 
 
@@ -99,7 +99,7 @@ public:
     virtual wstring TargetType() const { return L"Microsoft.Xna.Framework.Graphics.BasicEffect"; }
     virtual wstring ReaderName() const { return L"Microsoft.Xna.Framework.Content.BasicEffectReader"; }
 
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
 
 
@@ -109,7 +109,7 @@ public:
     virtual wstring TargetType() const { return L"Microsoft.Xna.Framework.Graphics.AlphaTestEffect"; }
     virtual wstring ReaderName() const { return L"Microsoft.Xna.Framework.Content.AlphaTestEffectReader"; }
 
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
 
 
@@ -119,7 +119,7 @@ public:
     virtual wstring TargetType() const { return L"Microsoft.Xna.Framework.Graphics.DualTextureEffect"; }
     virtual wstring ReaderName() const { return L"Microsoft.Xna.Framework.Content.DualTextureEffectReader"; }
 
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
 
 
@@ -129,7 +129,7 @@ public:
     virtual wstring TargetType() const { return L"Microsoft.Xna.Framework.Graphics.EnvironmentMapEffect"; }
     virtual wstring ReaderName() const { return L"Microsoft.Xna.Framework.Content.EnvironmentMapEffectReader"; }
 
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
 
 
@@ -139,7 +139,7 @@ public:
     virtual wstring TargetType() const { return L"Microsoft.Xna.Framework.Graphics.SkinnedEffect"; }
     virtual wstring ReaderName() const { return L"Microsoft.Xna.Framework.Content.SkinnedEffectReader"; }
 
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
 
 
@@ -149,7 +149,7 @@ public:
     virtual wstring TargetType() const { return L"Microsoft.Xna.Framework.Graphics.SpriteFont"; }
     virtual wstring ReaderName() const { return L"Microsoft.Xna.Framework.Content.SpriteFontReader"; }
 
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
 
 
@@ -159,5 +159,5 @@ public:
     virtual wstring TargetType() const { return L"Microsoft.Xna.Framework.Graphics.Model"; }
     virtual wstring ReaderName() const { return L"Microsoft.Xna.Framework.Content.ModelReader"; }
 
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
@@ -7,6 +7,10 @@ Logger::Logger()
     indentation = 0;
 
     isNewLine = false;
+
+    output = nullptr;
+
+    level = LogNone;
 }
 
 
@@ -33,7 +37,10 @@ void Logger::WriteLine(char const* format, ...)
     va_end(args);
 
     // Write the carriage return.
-    //printf("\n");
+    if (output)
+    {
+        fputs("\n", output);
+    }
 
     isNewLine = true;
 }
@@ -41,6 +48,11 @@ void Logger::WriteLine(char const* format, ...)
 
 void Logger::Write(char const* format, va_list args)
 {
+    if (!output)
+    {
+        return;
+    }
+
     // Indent if this is the first text on a new line.
     if (isNewLine)
     {
@@ -48,18 +60,18 @@ void Logger::Write(char const* format, va_list args)
 
         for (int i = 0; i < indentation; i++)
         {
-            //printf("    ");
+            fputs("    ", output);
         }
     }
 
     // Write the string.
-    //vprintf(format, args);
+    vfprintf(output, format, args);
 }
 
 
-void Logger::WriteBytes(_In_z_ char const* name, vector<uint8_t> const& bytes)
+void Logger::WriteBytes(_In_z_ char const* name, ArrayView<uint8_t> bytes)
 {
-    WriteLine("%s: %u bytes", name, bytes.size());
+    WriteLine("%s: %u bytes", name, (uint32_t)bytes.size());
     
     Indent();
 
@@ -71,7 +83,7 @@ void Logger::WriteBytes(_In_z_ char const* name, vector<uint8_t> const& bytes)
 
             if (i >= 1024 && bytes.size() > 2048)
             {
-                WriteLine("{snip: not bothering to print the remaining %d bytes}", bytes.size() - i);
+                WriteLine("{snip: not bothering to print the remaining %u bytes}", (uint32_t)(bytes.size() - i));
                 break;
             }
         }
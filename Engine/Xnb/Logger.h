@@ -0,0 +1,61 @@
+#pragma once
+
+#include "ArrayView.h"
+
+
+// How much detail to log while parsing.
+enum LogLevel
+{
+    LogNone,        // Nothing: normal loading.
+    LogSummary,     // File header, type readers, and top level asset structure.
+    LogInspect,     // Every value that is read, for dumping files with tools.
+};
+
+
+// The most detailed level compiled into the build. Defining this as LogNone
+// strips all logging out of the parser.
+#ifndef XNB_LOG_LEVEL
+#define XNB_LOG_LEVEL LogInspect
+#endif
+
+
+// Logs through reader->Log if the given level is enabled, eg.
+//
+//     XNB_LOG(reader, LogInspect).WriteLine("Width: %u", width);
+//
+// When the level is disabled, neither the call nor its arguments are evaluated,
+// so anything that must always happen (such as reading the value) has to be done
+// outside the logging statement.
+#define XNB_LOG(reader, level) \
+    if ((level) > XNB_LOG_LEVEL || !(reader)->Log.IsEnabled(level)) { } else (reader)->Log
+
+
+// Helper for writing formatted text to the console output.
+// Nothing is logged unless a level and destination have been set.
+class Logger
+{
+public:
+    Logger();
+
+    void SetOutput(FILE* file, LogLevel level = LogInspect) { output = file; this->level = level; }
+    void SetLevel(LogLevel level) { this->level = level; }
+
+    bool IsEnabled(LogLevel level) const { return level <= this->level; }
+
+    void Indent()   { indentation++; }
+    void Unindent() { indentation--; }
+
+    void Write(_In_z_ _Printf_format_string_ char const* format, ...);
+    void WriteLine(_In_z_ _Printf_format_string_ char const* format, ...);
+    void WriteBytes(_In_z_ char const* name, ArrayView<uint8_t> bytes);
+    void WriteEnum(_In_z_ char const* name, int32_t value, _In_z_ _Deref_pre_z_ char const* const* enumValues);
+
+private:
+    void Write(_In_z_ _Printf_format_string_ char const* format, va_list args);
+
+    FILE* output;
+    LogLevel level;
+
+    int indentation;
+    bool isNewLine;
+};
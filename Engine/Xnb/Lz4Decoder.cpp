@@ -0,0 +1,100 @@
+#include "stdafx.h"
+#include "Lz4Decoder.h"
+
+
+// LZ4 lengths are stored as a 4 bit field, extended by extra bytes while they are 255.
+static uint32_t ReadLength(uint32_t length, uint8_t const*& input, uint8_t const* inputEnd)
+{
+    if (length == 15)
+    {
+        uint8_t value;
+
+        do
+        {
+            if (input >= inputEnd)
+            {
+                throw runtime_error("LZ4 data has been truncated.");
+            }
+
+            value = *input++;
+            length += value;
+        }
+        while (value == 255);
+    }
+
+    return length;
+}
+
+
+void DecompressLz4(uint8_t const* input, uint32_t inputSize, uint8_t* output, uint32_t outputSize)
+{
+    uint8_t const* inputEnd = input + inputSize;
+
+    uint8_t* outputStart = output;
+    uint8_t* outputEnd = output + outputSize;
+
+    while (input < inputEnd)
+    {
+        // Each sequence is a token, a run of literals, then a match.
+        uint8_t token = *input++;
+
+        uint32_t literalLength = ReadLength(token >> 4, input, inputEnd);
+
+        if (literalLength > (uint32_t)(inputEnd - input) ||
+            literalLength > (uint32_t)(outputEnd - output))
+        {
+            throw runtime_error("Bad LZ4 literal run.");
+        }
+
+        memcpy(output, input, literalLength);
+
+        input += literalLength;
+        output += literalLength;
+
+        // The last sequence has literals only.
+        if (input == inputEnd)
+        {
+            break;
+        }
+
+        if (inputEnd - input < 2)
+        {
+            throw runtime_error("LZ4 data has been truncated.");
+        }
+
+        uint32_t offset = input[0] | (input[1] << 8);
+
+        input += 2;
+
+        uint32_t matchLength = ReadLength(token & 15, input, inputEnd) + 4;
+
+        if (!offset ||
+            offset > (uint32_t)(output - outputStart) ||
+            matchLength > (uint32_t)(outputEnd - output))
+        {
+            throw runtime_error("Bad LZ4 match.");
+        }
+
+        uint8_t const* source = output - offset;
+
+        if (offset >= matchLength)
+        {
+            memcpy(output, source, matchLength);
+        }
+        else
+        {
+            // Overlapping matches repeat the most recent bytes, so must be copied front to back.
+            for (uint32_t i = 0; i < matchLength; i++)
+            {
+                output[i] = source[i];
+            }
+        }
+
+        output += matchLength;
+    }
+
+    if (output != outputEnd)
+    {
+        throw runtime_error("LZ4 data decompressed to the wrong size.");
+    }
+}
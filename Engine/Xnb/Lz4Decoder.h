@@ -0,0 +1,6 @@
+#pragma once
+
+
+// Decompresses a raw LZ4 block (as written by MonoGame for .xnb files with the 0x40 flag set)
+// into a caller provided buffer, which must be exactly the expected decompressed size.
+void DecompressLz4(uint8_t const* input, uint32_t inputSize, uint8_t* output, uint32_t outputSize);
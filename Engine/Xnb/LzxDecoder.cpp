@@ -0,0 +1,590 @@
+#include "stdafx.h"
+#include "LzxDecoder.h"
+
+
+// How many extra bits follow each match position slot.
+uint8_t const LzxDecoder::extraBits[PositionSlots] =
+{
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13, 14, 14,
+};
+
+
+// Smallest match offset represented by each position slot.
+uint32_t const LzxDecoder::positionBase[PositionSlots] =
+{
+    0, 1, 2, 3, 4, 6, 8, 12, 16, 24, 32, 48, 64, 96, 128, 192,
+    256, 384, 512, 768, 1024, 1536, 2048, 3072, 4096, 6144, 8192, 12288, 16384, 24576, 32768, 49152,
+};
+
+
+LzxDecoder::LzxDecoder()
+  : input(nullptr),
+    inputEnd(nullptr),
+    bitBuffer(0),
+    bitsLeft(0),
+    output(nullptr),
+    outputSize(0),
+    outputPosition(0),
+    R0(1),
+    R1(1),
+    R2(1),
+    headerRead(false),
+    blockType(BlockInvalid),
+    blockLength(0),
+    blockRemaining(0)
+{
+    memset(mainTreeLengths, 0, sizeof(mainTreeLengths));
+    memset(lengthLengths, 0, sizeof(lengthLengths));
+}
+
+
+// Decompresses an entire XNB payload into a caller provided buffer of the expected size.
+void LzxDecoder::Decompress(uint8_t const* data, uint32_t dataSize, uint8_t* outputData, uint32_t outputDataSize)
+{
+    uint8_t const* dataEnd = data + dataSize;
+
+    output = outputData;
+    outputSize = outputDataSize;
+    outputPosition = 0;
+
+    while (outputPosition < outputSize)
+    {
+        // Each frame starts with its compressed size, optionally preceded by 0xFF and a
+        // non-default decompressed size (which only happens for the final frame).
+        if (dataEnd - data < 2)
+        {
+            throw runtime_error("LZX data has been truncated.");
+        }
+
+        uint32_t frameSize = 0x8000;
+        uint32_t blockSize = (data[0] << 8) | data[1];
+
+        if (data[0] == 0xFF)
+        {
+            if (dataEnd - data < 5)
+            {
+                throw runtime_error("LZX data has been truncated.");
+            }
+
+            frameSize = (data[1] << 8) | data[2];
+            blockSize = (data[3] << 8) | data[4];
+            data += 5;
+        }
+        else
+        {
+            data += 2;
+        }
+
+        if (!blockSize || !frameSize || blockSize > (uint32_t)(dataEnd - data))
+        {
+            throw runtime_error("Bad LZX frame header.");
+        }
+
+        frameSize = min(frameSize, outputSize - outputPosition);
+
+        input = data;
+        inputEnd = data + blockSize;
+
+        DecodeFrame(frameSize);
+
+        data += blockSize;
+    }
+}
+
+
+// Decodes one XNA frame worth of data.
+void LzxDecoder::DecodeFrame(uint32_t frameSize)
+{
+    // Every frame starts on a fresh byte aligned bitstream.
+    ResetBits();
+
+    // The very first frame begins with the Intel E8 call translation header.
+    if (!headerRead)
+    {
+        if (ReadBits(1))
+        {
+            throw runtime_error("LZX Intel E8 call translation is not supported.");
+        }
+
+        headerRead = true;
+    }
+
+    uint32_t frameEnd = outputPosition + frameSize;
+
+    while (outputPosition < frameEnd)
+    {
+        if (!blockRemaining)
+        {
+            ReadBlockHeader();
+        }
+
+        uint32_t runLength = min(blockRemaining, frameEnd - outputPosition);
+
+        switch (blockType)
+        {
+            case BlockVerbatim:
+                DecodeMatches(runLength, false);
+                break;
+
+            case BlockAligned:
+                DecodeMatches(runLength, true);
+                break;
+
+            case BlockUncompressed:
+                if (runLength > (uint32_t)(inputEnd - input))
+                {
+                    throw runtime_error("LZX data has been truncated.");
+                }
+
+                memcpy(output + outputPosition, input, runLength);
+
+                input += runLength;
+                outputPosition += runLength;
+                blockRemaining -= runLength;
+                break;
+
+            default:
+                throw runtime_error("Bad LZX block type.");
+        }
+    }
+
+    if (outputPosition != frameEnd)
+    {
+        throw runtime_error("LZX frame decoded to the wrong size.");
+    }
+}
+
+
+void LzxDecoder::ReadBlockHeader()
+{
+    // Uncompressed blocks are padded to a 16 bit boundary, after which the bitstream restarts.
+    if (blockType == BlockUncompressed)
+    {
+        if ((blockLength & 1) && input < inputEnd)
+        {
+            input++;
+        }
+
+        ResetBits();
+    }
+
+    blockType = (BlockType)ReadBits(3);
+
+    uint32_t hi = ReadBits(16);
+    uint32_t lo = ReadBits(8);
+
+    blockLength = blockRemaining = (hi << 8) | lo;
+
+    switch (blockType)
+    {
+        case BlockAligned:
+            for (uint32_t i = 0; i < AlignedSymbols; i++)
+            {
+                alignedLengths[i] = (uint8_t)ReadBits(3);
+            }
+
+            MakeDecodeTable(AlignedSymbols, AlignedTableBits, alignedLengths, alignedTable);
+
+            // The rest of the aligned header is the same as verbatim.
+            /* fall through */
+        case BlockVerbatim:
+            ReadLengths(mainTreeLengths, 0, NumChars);
+            ReadLengths(mainTreeLengths, NumChars, MainTreeSymbols);
+            MakeDecodeTable(MainTreeSymbols, MainTreeTableBits, mainTreeLengths, mainTreeTable);
+
+            ReadLengths(lengthLengths, 0, NumSecondaryLengths);
+            MakeDecodeTable(LengthSymbols, LengthTableBits, lengthLengths, lengthTable);
+            break;
+
+        case BlockUncompressed:
+            {
+                // Realign to the next 16 bit boundary, discarding any buffered bits that came from past it.
+                EnsureBits(16);
+
+                if (bitsLeft > 16)
+                {
+                    input -= 2;
+                }
+
+                if (inputEnd - input < 12)
+                {
+                    throw runtime_error("LZX data has been truncated.");
+                }
+
+                // Repeated match offsets are stored raw.
+                uint32_t* offsets[] = { &R0, &R1, &R2 };
+
+                for (int i = 0; i < 3; i++)
+                {
+                    *offsets[i] = uint32_t(input[0])       |
+                                  uint32_t(input[1]) << 8  |
+                                  uint32_t(input[2]) << 16 |
+                                  uint32_t(input[3]) << 24;
+
+                    input += 4;
+                }
+            }
+            break;
+
+        default:
+            throw runtime_error("Bad LZX block type.");
+    }
+}
+
+
+// Decodes literals and matches from a verbatim or aligned offset block.
+void LzxDecoder::DecodeMatches(uint32_t runLength, bool aligned)
+{
+    uint32_t runEnd = outputPosition + runLength;
+
+    while (outputPosition < runEnd)
+    {
+        uint32_t mainElement = ReadHuffmanSymbol(mainTreeTable, mainTreeLengths, MainTreeSymbols, MainTreeTableBits);
+
+        if (mainElement < NumChars)
+        {
+            // Literal byte.
+            output[outputPosition++] = (uint8_t)mainElement;
+            continue;
+        }
+
+        // Match: the main element packs a 3 bit length header with the position slot.
+        mainElement -= NumChars;
+
+        uint32_t matchLength = mainElement & NumPrimaryLengths;
+
+        if (matchLength == NumPrimaryLengths)
+        {
+            matchLength += ReadHuffmanSymbol(lengthTable, lengthLengths, LengthSymbols, LengthTableBits);
+        }
+
+        matchLength += MinMatch;
+
+        uint32_t positionSlot = mainElement >> 3;
+        uint32_t matchOffset;
+
+        switch (positionSlot)
+        {
+            case 0:
+                // Most recent offset.
+                matchOffset = R0;
+                break;
+
+            case 1:
+                matchOffset = R1;
+                R1 = R0;
+                R0 = matchOffset;
+                break;
+
+            case 2:
+                matchOffset = R2;
+                R2 = R0;
+                R0 = matchOffset;
+                break;
+
+            default:
+                {
+                    uint32_t extra = extraBits[positionSlot];
+
+                    matchOffset = positionBase[positionSlot] - 2;
+
+                    if (aligned && extra >= 3)
+                    {
+                        // The bottom three bits come from the aligned offset tree.
+                        matchOffset += ReadBits(extra - 3) << 3;
+                        matchOffset += ReadHuffmanSymbol(alignedTable, alignedLengths, AlignedSymbols, AlignedTableBits);
+                    }
+                    else if (extra)
+                    {
+                        matchOffset += ReadBits(extra);
+                    }
+                    else
+                    {
+                        matchOffset = 1;
+                    }
+
+                    R2 = R1;
+                    R1 = R0;
+                    R0 = matchOffset;
+                }
+                break;
+        }
+
+        // Matches can't reach back before the start of the file or past the end of it,
+        // but may overlap their own output (which is how runs are encoded).
+        if (!matchOffset || matchOffset > outputPosition || matchLength > outputSize - outputPosition)
+        {
+            throw runtime_error("Bad LZX match.");
+        }
+
+        uint8_t* dest = output + outputPosition;
+        uint8_t const* source = dest - matchOffset;
+
+        for (uint32_t i = 0; i < matchLength; i++)
+        {
+            dest[i] = source[i];
+        }
+
+        outputPosition += matchLength;
+    }
+
+    // The final match can overrun the requested run, in which case it eats into the rest of the block.
+    uint32_t decoded = outputPosition - (runEnd - runLength);
+
+    if (decoded > blockRemaining)
+    {
+        throw runtime_error("LZX match overran its block.");
+    }
+
+    blockRemaining -= decoded;
+}
+
+
+// Reads a set of Huffman code lengths, which are themselves delta encoded using the pretree.
+void LzxDecoder::ReadLengths(uint8_t* lengths, uint32_t first, uint32_t last)
+{
+    for (uint32_t i = 0; i < PretreeSymbols; i++)
+    {
+        pretreeLengths[i] = (uint8_t)ReadBits(4);
+    }
+
+    MakeDecodeTable(PretreeSymbols, PretreeTableBits, pretreeLengths, pretreeTable);
+
+    uint32_t i = first;
+
+    while (i < last)
+    {
+        uint32_t code = ReadHuffmanSymbol(pretreeTable, pretreeLengths, PretreeSymbols, PretreeTableBits);
+        uint32_t runLength;
+        uint32_t value;
+
+        switch (code)
+        {
+            case 17:
+                // Short run of zeros.
+                runLength = ReadBits(4) + 4;
+                value = 0;
+                break;
+
+            case 18:
+                // Long run of zeros.
+                runLength = ReadBits(5) + 20;
+                value = 0;
+                break;
+
+            case 19:
+                // Short run of a single delta.
+                runLength = ReadBits(1) + 4;
+                code = ReadHuffmanSymbol(pretreeTable, pretreeLengths, PretreeSymbols, PretreeTableBits);
+                value = (lengths[i] + 17 - code) % 17;
+                break;
+
+            default:
+                runLength = 1;
+                value = (lengths[i] + 17 - code) % 17;
+                break;
+        }
+
+        if (i + runLength > last + LengthTableSafety)
+        {
+            throw runtime_error("Bad LZX length table.");
+        }
+
+        memset(lengths + i, value, runLength);
+
+        i += runLength;
+    }
+}
+
+
+// Builds a fast lookup table for a canonical Huffman code. Codes up to tableBits long are
+// decoded with a single lookup. Longer ones continue through a binary tree stored after
+// the direct mapped part of the table.
+void LzxDecoder::MakeDecodeTable(uint32_t symbolCount, uint32_t tableBits, uint8_t const* lengths, uint16_t* table)
+{
+    uint32_t position = 0;
+    uint32_t tableMask = 1 << tableBits;
+    uint32_t bitMask = tableMask >> 1;
+    uint32_t nextSymbol = bitMask;
+    uint32_t bitCount = 1;
+
+    // Fill entries for codes short enough for a direct mapping.
+    for (; bitCount <= tableBits; bitCount++)
+    {
+        for (uint32_t symbol = 0; symbol < symbolCount; symbol++)
+        {
+            if (lengths[symbol] == bitCount)
+            {
+                uint32_t leaf = position;
+
+                if ((position += bitMask) > tableMask)
+                {
+                    throw runtime_error("Bad LZX Huffman table.");
+                }
+
+                for (uint32_t fill = 0; fill < bitMask; fill++)
+                {
+                    table[leaf++] = (uint16_t)symbol;
+                }
+            }
+        }
+
+        bitMask >>= 1;
+    }
+
+    // Are there any codes longer than tableBits?
+    if (position != tableMask)
+    {
+        for (uint32_t i = position; i < tableMask; i++)
+        {
+            table[i] = 0;
+        }
+
+        // Give ourselves room for codes to grow by up to 16 more bits.
+        position <<= 16;
+        tableMask <<= 16;
+        bitMask = 1 << 15;
+
+        for (; bitCount <= 16; bitCount++)
+        {
+            for (uint32_t symbol = 0; symbol < symbolCount; symbol++)
+            {
+                if (lengths[symbol] == bitCount)
+                {
+                    uint32_t leaf = position >> 16;
+
+                    for (uint32_t fill = 0; fill < bitCount - tableBits; fill++)
+                    {
+                        // If this path hasn't been taken yet, allocate two entries for it.
+                        if (!table[leaf])
+                        {
+                            table[nextSymbol << 1] = 0;
+                            table[(nextSymbol << 1) + 1] = 0;
+                            table[leaf] = (uint16_t)nextSymbol++;
+                        }
+
+                        // Follow the path, selecting left or right for the next bit.
+                        leaf = table[leaf] << 1;
+
+                        if ((position >> (15 - fill)) & 1)
+                        {
+                            leaf++;
+                        }
+                    }
+
+                    table[leaf] = (uint16_t)symbol;
+
+                    if ((position += bitMask) > tableMask)
+                    {
+                        throw runtime_error("Bad LZX Huffman table.");
+                    }
+                }
+            }
+
+            bitMask >>= 1;
+        }
+    }
+
+    // An incomplete table is only valid if it contains no codes at all.
+    if (position != tableMask)
+    {
+        for (uint32_t symbol = 0; symbol < symbolCount; symbol++)
+        {
+            if (lengths[symbol])
+            {
+                throw runtime_error("Bad LZX Huffman table.");
+            }
+        }
+    }
+}
+
+
+uint32_t LzxDecoder::ReadHuffmanSymbol(uint16_t const* table, uint8_t const* lengths, uint32_t symbolCount, uint32_t tableBits)
+{
+    EnsureBits(16);
+
+    uint32_t symbol = table[PeekBits(tableBits)];
+
+    // Codes longer than the direct mapped table walk the tree one bit at a time.
+    if (symbol >= symbolCount)
+    {
+        uint32_t bit = 1 << (32 - tableBits);
+
+        do
+        {
+            bit >>= 1;
+
+            if (!bit)
+            {
+                throw runtime_error("Bad LZX Huffman code.");
+            }
+
+            symbol <<= 1;
+            symbol |= (bitBuffer & bit) ? 1 : 0;
+            symbol = table[symbol];
+        }
+        while (symbol >= symbolCount);
+    }
+
+    RemoveBits(lengths[symbol]);
+
+    return symbol;
+}
+
+
+void LzxDecoder::ResetBits()
+{
+    bitBuffer = 0;
+    bitsLeft = 0;
+}
+
+
+void LzxDecoder::EnsureBits(uint32_t count)
+{
+    while (bitsLeft < count)
+    {
+        uint32_t lo = ReadInputByte();
+        uint32_t hi = ReadInputByte();
+
+        bitBuffer |= ((hi << 8) | lo) << (16 - bitsLeft);
+        bitsLeft += 16;
+    }
+}
+
+
+uint32_t LzxDecoder::ReadBits(uint32_t count)
+{
+    if (!count)
+    {
+        return 0;
+    }
+
+    EnsureBits(count);
+
+    uint32_t result = PeekBits(count);
+
+    RemoveBits(count);
+
+    return result;
+}
+
+
+uint8_t LzxDecoder::ReadInputByte()
+{
+    // Huffman lookahead can run a couple of bytes past the end of a frame. Those bits
+    // are never actually consumed, so pad with zeros rather than reading out of bounds.
+    if (input >= inputEnd)
+    {
+        input++;
+
+        if (input > inputEnd + 4)
+        {
+            throw runtime_error("LZX data has been truncated.");
+        }
+
+        return 0;
+    }
+
+    return *input++;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+
+// Decoder for the LZX compression used by XNA Game Studio when building compressed .xnb files.
+// This follows the LZX format as documented for Microsoft cabinet files, with the XNA specific
+// framing (a 64k window, and a small size header in front of each 32k output frame).
+class LzxDecoder
+{
+public:
+    LzxDecoder();
+
+    // Decompresses an entire XNB payload into a caller provided buffer of the expected size.
+    void Decompress(uint8_t const* input, uint32_t inputSize, uint8_t* output, uint32_t outputSize);
+
+private:
+    enum
+    {
+        MinMatch = 2,
+        NumChars = 256,
+        NumPrimaryLengths = 7,
+        NumSecondaryLengths = 249,
+        PositionSlots = 32,     // For a 64k window.
+
+        PretreeSymbols = 20,
+        PretreeTableBits = 6,
+        MainTreeSymbols = NumChars + PositionSlots * 8,
+        MainTreeTableBits = 12,
+        LengthSymbols = NumSecondaryLengths + 1,
+        LengthTableBits = 12,
+        AlignedSymbols = 8,
+        AlignedTableBits = 7,
+
+        // Run length codes may write a few entries past the end of a length table.
+        LengthTableSafety = 64,
+    };
+
+    enum BlockType
+    {
+        BlockInvalid = 0,
+        BlockVerbatim = 1,
+        BlockAligned = 2,
+        BlockUncompressed = 3,
+    };
+
+    // Decodes one XNA frame worth of data.
+    void DecodeFrame(uint32_t frameSize);
+
+    void ReadBlockHeader();
+    void DecodeMatches(uint32_t runLength, bool aligned);
+
+    void ReadLengths(uint8_t* lengths, uint32_t first, uint32_t last);
+
+    static void MakeDecodeTable(uint32_t symbolCount, uint32_t tableBits, uint8_t const* lengths, uint16_t* table);
+
+    uint32_t ReadHuffmanSymbol(uint16_t const* table, uint8_t const* lengths, uint32_t symbolCount, uint32_t tableBits);
+
+    // Bitstream helpers. LZX packs bits MSB first into little-endian 16 bit words.
+    void ResetBits();
+    void EnsureBits(uint32_t count);
+    uint32_t PeekBits(uint32_t count) const { return bitBuffer >> (32 - count); }
+    void RemoveBits(uint32_t count) { bitBuffer <<= count; bitsLeft -= count; }
+    uint32_t ReadBits(uint32_t count);
+    uint8_t ReadInputByte();
+
+    // Input for the frame currently being decoded.
+    uint8_t const* input;
+    uint8_t const* inputEnd;
+
+    uint32_t bitBuffer;
+    uint32_t bitsLeft;
+
+    // The output buffer doubles as the LZX window, since it holds the entire decompressed file.
+    uint8_t* output;
+    uint32_t outputSize;
+    uint32_t outputPosition;
+
+    // State that persists from one frame to the next.
+    uint32_t R0, R1, R2;
+
+    bool headerRead;
+
+    BlockType blockType;
+    uint32_t blockLength;
+    uint32_t blockRemaining;
+
+    uint8_t pretreeLengths[PretreeSymbols + LengthTableSafety];
+    uint16_t pretreeTable[(1 << PretreeTableBits) + (PretreeSymbols * 2)];
+
+    uint8_t mainTreeLengths[MainTreeSymbols + LengthTableSafety];
+    uint16_t mainTreeTable[(1 << MainTreeTableBits) + (MainTreeSymbols * 2)];
+
+    uint8_t lengthLengths[LengthSymbols + LengthTableSafety];
+    uint16_t lengthTable[(1 << LengthTableBits) + (LengthSymbols * 2)];
+
+    uint8_t alignedLengths[AlignedSymbols];
+    uint16_t alignedTable[(1 << AlignedTableBits) + (AlignedSymbols * 2)];
+
+    static uint8_t const extraBits[PositionSlots];
+    static uint32_t const positionBase[PositionSlots];
+};
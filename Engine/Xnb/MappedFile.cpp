@@ -0,0 +1,131 @@
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "stdafx.h"
+#include "MappedFile.h"
+
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(char const* fileName)
+  : data(nullptr),
+    size(0),
+    fileHandle(INVALID_HANDLE_VALUE),
+    mappingHandle(nullptr)
+{
+    fileHandle = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+    if (fileHandle == INVALID_HANDLE_VALUE)
+    {
+        throw runtime_error("Can't open file.");
+    }
+
+    LARGE_INTEGER fileSize;
+
+    if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.HighPart)
+    {
+        CloseHandle(fileHandle);
+        throw runtime_error("Can't query file size.");
+    }
+
+    size = fileSize.LowPart;
+
+    // Zero length files cannot be mapped, but are still valid (if useless) input.
+    if (size)
+    {
+        mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+        if (mappingHandle)
+        {
+            data = (uint8_t const*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+        }
+
+        if (!data)
+        {
+            if (mappingHandle)
+            {
+                CloseHandle(mappingHandle);
+            }
+
+            CloseHandle(fileHandle);
+            throw runtime_error("Can't map file.");
+        }
+    }
+}
+
+
+MappedFile::~MappedFile()
+{
+    if (data)
+    {
+        UnmapViewOfFile(data);
+    }
+
+    if (mappingHandle)
+    {
+        CloseHandle(mappingHandle);
+    }
+
+    CloseHandle(fileHandle);
+}
+
+#else
+
+MappedFile::MappedFile(char const* fileName)
+  : data(nullptr),
+    size(0)
+{
+    int fd = open(fileName, O_RDONLY);
+
+    if (fd < 0)
+    {
+        throw runtime_error("Can't open file.");
+    }
+
+    struct stat info;
+
+    if (fstat(fd, &info) != 0 || (uint64_t)info.st_size > UINT32_MAX)
+    {
+        close(fd);
+        throw runtime_error("Can't query file size.");
+    }
+
+    size = (uint32_t)info.st_size;
+
+    // Zero length files cannot be mapped, but are still valid (if useless) input.
+    if (size)
+    {
+        void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (mapping == MAP_FAILED)
+        {
+            close(fd);
+            throw runtime_error("Can't map file.");
+        }
+
+        // We parse front to back, so let the kernel read ahead aggressively.
+        madvise(mapping, size, MADV_SEQUENTIAL);
+
+        data = (uint8_t const*)mapping;
+    }
+
+    // The mapping keeps its own reference to the file.
+    close(fd);
+}
+
+
+MappedFile::~MappedFile()
+{
+    if (data)
+    {
+        munmap((void*)data, size);
+    }
+}
+
+#endif
@@ -0,0 +1,29 @@
+#pragma once
+
+
+// Read-only memory mapping of an entire file, so loaders can parse it in place
+// without copying the contents through stdio buffers.
+class MappedFile
+{
+public:
+    // Maps the named file, throwing if it cannot be opened.
+    explicit MappedFile(char const* fileName);
+
+    ~MappedFile();
+
+    uint8_t const* Data() const { return data; }
+    uint32_t Size() const { return size; }
+
+private:
+    // Not implemented
+    MappedFile(MappedFile const&);
+    MappedFile& operator=(MappedFile const&);
+
+    uint8_t const* data;
+    uint32_t size;
+
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+};
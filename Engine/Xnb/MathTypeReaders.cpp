@@ -0,0 +1,221 @@
+#include "stdafx.h"
+#include "ContentReader.h"
+#include "MathTypeReaders.h"
+
+
+XnbObjectPtr Vector2Reader::Read(ContentReader* reader)
+{
+    float x = reader->ReadSingle();
+    float y = reader->ReadSingle();
+
+    XNB_LOG(reader, LogInspect).WriteLine("{ %g, %g }", x, y);
+
+    return nullptr;
+}
+
+
+XnbObjectPtr Vector3Reader::Read(ContentReader* reader)
+{
+    float x = reader->ReadSingle();
+    float y = reader->ReadSingle();
+    float z = reader->ReadSingle();
+
+    XNB_LOG(reader, LogInspect).WriteLine("{ %g, %g, %g }", x, y, z);
+
+    return nullptr;
+}
+
+
+XnbObjectPtr Vector4Reader::Read(ContentReader* reader)
+{
+    float x = reader->ReadSingle();
+    float y = reader->ReadSingle();
+    float z = reader->ReadSingle();
+    float w = reader->ReadSingle();
+
+    XNB_LOG(reader, LogInspect).WriteLine("{ %g, %g, %g, %g }", x, y, z, w);
+
+    return nullptr;
+}
+
+
+XnbObjectPtr MatrixReader::Read(ContentReader* reader)
+{
+    float m[16];
+
+    for (int i = 0; i < 16; i++)
+    {
+        m[i] = reader->ReadSingle();
+    }
+
+    XNB_LOG(reader, LogInspect).WriteLine("{ %g, %g, %g, %g }", m[0],  m[1],  m[2],  m[3]);
+    XNB_LOG(reader, LogInspect).WriteLine("{ %g, %g, %g, %g }", m[4],  m[5],  m[6],  m[7]);
+    XNB_LOG(reader, LogInspect).WriteLine("{ %g, %g, %g, %g }", m[8],  m[9],  m[10], m[11]);
+    XNB_LOG(reader, LogInspect).WriteLine("{ %g, %g, %g, %g }", m[12], m[13], m[14], m[15]);
+
+    return nullptr;
+}
+
+
+XnbObjectPtr QuaternionReader::Read(ContentReader* reader)
+{
+    float x = reader->ReadSingle();
+    float y = reader->ReadSingle();
+    float z = reader->ReadSingle();
+    float w = reader->ReadSingle();
+
+    XNB_LOG(reader, LogInspect).WriteLine("{ %g, %g, %g, %g }", x, y, z, w);
+
+    return nullptr;
+}
+
+
+XnbObjectPtr ColorReader::Read(ContentReader* reader)
+{
+    int r = reader->ReadByte();
+    int g = reader->ReadByte();
+    int b = reader->ReadByte();
+    int a = reader->ReadByte();
+
+    XNB_LOG(reader, LogInspect).WriteLine("{ R:%d, G:%d, B:%d, A:%d }", r, g, b, a);
+
+    return nullptr;
+}
+
+
+XnbObjectPtr PlaneReader::Read(ContentReader* reader)
+{
+    XNB_LOG(reader, LogInspect).Write("Normal: ");
+    Vector3Reader().Read(reader);
+
+    float d = reader->ReadSingle();
+    XNB_LOG(reader, LogInspect).WriteLine("D: %g", d);
+
+    return nullptr;
+}
+
+
+XnbObjectPtr PointReader::Read(ContentReader* reader)
+{
+    int32_t x = reader->ReadInt32();
+    XNB_LOG(reader, LogInspect).WriteLine("X: %d", x);
+    int32_t y = reader->ReadInt32();
+    XNB_LOG(reader, LogInspect).WriteLine("Y: %d", y);
+
+    return nullptr;
+}
+
+
+XnbObjectPtr RectangleReader::Read(ContentReader* reader)
+{
+    int32_t x = reader->ReadInt32();
+    XNB_LOG(reader, LogInspect).WriteLine("X: %d", x);
+    int32_t y = reader->ReadInt32();
+    XNB_LOG(reader, LogInspect).WriteLine("Y: %d", y);
+    int32_t width = reader->ReadInt32();
+    XNB_LOG(reader, LogInspect).WriteLine("Width: %d", width);
+    int32_t height = reader->ReadInt32();
+    XNB_LOG(reader, LogInspect).WriteLine("Height: %d", height);
+
+    return nullptr;
+}
+
+
+XnbObjectPtr BoundingBoxReader::Read(ContentReader* reader)
+{
+    XNB_LOG(reader, LogInspect).Write("Min: ");
+    Vector3Reader().Read(reader);
+
+    XNB_LOG(reader, LogInspect).Write("Max: ");
+    Vector3Reader().Read(reader);
+
+    return nullptr;
+}
+
+
+XnbObjectPtr BoundingSphereReader::Read(ContentReader* reader)
+{
+    XNB_LOG(reader, LogInspect).Write("Center: ");
+    Vector3Reader().Read(reader);
+
+    float radius = reader->ReadSingle();
+    XNB_LOG(reader, LogInspect).WriteLine("Radius: %g", radius);
+
+    return nullptr;
+}
+
+
+XnbObjectPtr BoundingFrustumReader::Read(ContentReader* reader)
+{
+    XNB_LOG(reader, LogInspect).WriteLine("Bounding frustum matrix:");
+    reader->Log.Indent();
+
+    MatrixReader().Read(reader);
+
+    reader->Log.Unindent();
+
+    return nullptr;
+}
+
+
+XnbObjectPtr RayReader::Read(ContentReader* reader)
+{
+    XNB_LOG(reader, LogInspect).Write("Position: ");
+    Vector3Reader().Read(reader);
+
+    XNB_LOG(reader, LogInspect).Write("Direction: ");
+    Vector3Reader().Read(reader);
+
+    return nullptr;
+}
+
+
+XnbObjectPtr CurveReader::Read(ContentReader* reader)
+{
+    static char const* LoopEnumValues[] =
+    {
+        "Constant",
+        "Cycle",
+        "Cycle Offset",
+        "Oscillate",
+        "Linear",
+        nullptr
+    };
+
+    static char const* ContinuityEnumValues[] =
+    {
+        "Smooth",
+        "Step",
+        nullptr
+    };
+    
+    int32_t preLoop = reader->ReadInt32();
+    XNB_LOG(reader, LogInspect).WriteEnum("Pre loop", preLoop, LoopEnumValues);
+    int32_t postLoop = reader->ReadInt32();
+    XNB_LOG(reader, LogInspect).WriteEnum("Post loop", postLoop, LoopEnumValues);
+
+    uint32_t keyCount = reader->ReadUInt32();
+
+    XNB_LOG(reader, LogInspect).WriteLine("Key count: %u", keyCount);
+
+    for (uint32_t i = 0; i < keyCount; i++)
+    {
+        XNB_LOG(reader, LogInspect).WriteLine("Key %u:", i);
+        reader->Log.Indent();
+
+        float position = reader->ReadSingle();
+        XNB_LOG(reader, LogInspect).WriteLine("Position: %g", position);
+        float value = reader->ReadSingle();
+        XNB_LOG(reader, LogInspect).WriteLine("Value: %g", value);
+        float tangentIn = reader->ReadSingle();
+        XNB_LOG(reader, LogInspect).WriteLine("Tangent in: %g", tangentIn);
+        float tangentOut = reader->ReadSingle();
+        XNB_LOG(reader, LogInspect).WriteLine("Tangent out: %g", tangentOut);
+        int32_t continuity = reader->ReadInt32();
+        XNB_LOG(reader, LogInspect).WriteEnum("Continuity", continuity, ContinuityEnumValues);
+
+        reader->Log.Unindent();
+    }
+
+    return nullptr;
+}
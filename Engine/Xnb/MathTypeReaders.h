@@ -11,7 +11,7 @@ public:
     
     virtual bool IsValueType() const { return true; }
 
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
 
 
@@ -23,7 +23,7 @@ public:
     
     virtual bool IsValueType() const { return true; }
 
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
 
 
@@ -35,7 +35,7 @@ public:
     
     virtual bool IsValueType() const { return true; }
 
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
 
 
@@ -47,7 +47,7 @@ public:
     
     virtual bool IsValueType() const { return true; }
 
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
 
 
@@ -59,7 +59,7 @@ public:
     
     virtual bool IsValueType() const { return true; }
 
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
 
 
@@ -71,7 +71,7 @@ public:
     
     virtual bool IsValueType() const { return true; }
 
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
 
 
@@ -83,7 +83,7 @@ public:
     
     virtual bool IsValueType() const { return true; }
 
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
 
 
@@ -95,7 +95,7 @@ public:
     
     virtual bool IsValueType() const { return true; }
 
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
 
 
@@ -107,7 +107,7 @@ public:
     
     virtual bool IsValueType() const { return true; }
 
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
 
 
@@ -119,7 +119,7 @@ public:
     
     virtual bool IsValueType() const { return true; }
 
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
 
 
@@ -131,7 +131,7 @@ public:
     
     virtual bool IsValueType() const { return true; }
 
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
 
 
@@ -141,7 +141,7 @@ public:
     virtual wstring TargetType() const { return L"Microsoft.Xna.Framework.BoundingFrustum"; }
     virtual wstring ReaderName() const { return L"Microsoft.Xna.Framework.Content.BoundingFrustumReader"; }
     
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
 
 
@@ -153,7 +153,7 @@ public:
     
     virtual bool IsValueType() const { return true; }
 
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
 
 
@@ -163,5 +163,5 @@ public:
     virtual wstring TargetType() const { return L"Microsoft.Xna.Framework.Curve"; }
     virtual wstring ReaderName() const { return L"Microsoft.Xna.Framework.Content.CurveReader"; }
     
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
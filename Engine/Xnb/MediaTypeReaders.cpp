@@ -0,0 +1,75 @@
+#include "stdafx.h"
+#include "ContentReader.h"
+#include "MediaTypeReaders.h"
+
+
+XnbObjectPtr SoundEffectReader::Read(ContentReader* reader)
+{
+    uint32_t formatSize = reader->ReadUInt32();
+    ArrayView<uint8_t> format = reader->ReadBytes(formatSize);
+    XNB_LOG(reader, LogInspect).WriteBytes("Format", format);
+
+    uint32_t dataSize = reader->ReadUInt32();
+    ArrayView<uint8_t> data = reader->ReadBytes(dataSize);
+    XNB_LOG(reader, LogInspect).WriteBytes("Data", data);
+
+    int32_t loopStart = reader->ReadInt32();
+    XNB_LOG(reader, LogInspect).WriteLine("Loop start: %d", loopStart);
+    int32_t loopLength = reader->ReadInt32();
+    XNB_LOG(reader, LogInspect).WriteLine("Loop length: %d", loopLength);
+    int32_t duration = reader->ReadInt32();
+    XNB_LOG(reader, LogInspect).WriteLine("Duration: %d ms", duration);
+
+    return nullptr;
+}
+
+
+XnbObjectPtr SongReader::Read(ContentReader* reader)
+{
+    wstring streamingFilename = reader->ReadString();
+    XNB_LOG(reader, LogInspect).WriteLine("Streaming filename: '%S'", streamingFilename.c_str());
+    
+    reader->ValidateTypeId(L"System.Int32");
+    int32_t duration = reader->ReadInt32();
+    XNB_LOG(reader, LogInspect).WriteLine("Duration: %d ms", duration);
+
+    return nullptr;
+}
+
+
+XnbObjectPtr VideoReader::Read(ContentReader* reader)
+{
+    static char const* SoundtrackTypeEnumValues[] =
+    {
+        "Music",
+        "Dialog",
+        "Music and Dialog",
+        nullptr
+    };
+
+    reader->ValidateTypeId(L"System.String");
+    wstring streamingFilename = reader->ReadString();
+    XNB_LOG(reader, LogInspect).WriteLine("Streaming filename: '%S'", streamingFilename.c_str());
+
+    reader->ValidateTypeId(L"System.Int32");
+    int32_t duration = reader->ReadInt32();
+    XNB_LOG(reader, LogInspect).WriteLine("Duration: %d ms", duration);
+
+    reader->ValidateTypeId(L"System.Int32");
+    int32_t width = reader->ReadInt32();
+    XNB_LOG(reader, LogInspect).WriteLine("Width: %d ms", width);
+
+    reader->ValidateTypeId(L"System.Int32");
+    int32_t height = reader->ReadInt32();
+    XNB_LOG(reader, LogInspect).WriteLine("Height: %d ms", height);
+
+    reader->ValidateTypeId(L"System.Single");
+    float framesPerSecond = reader->ReadSingle();
+    XNB_LOG(reader, LogInspect).WriteLine("Frames per second: %g ms", framesPerSecond);
+
+    reader->ValidateTypeId(L"System.Int32");
+    int32_t soundtrackType = reader->ReadInt32();
+    XNB_LOG(reader, LogInspect).WriteEnum("Soundtrack type", soundtrackType, SoundtrackTypeEnumValues);
+
+    return nullptr;
+}
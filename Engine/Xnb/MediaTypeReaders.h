@@ -9,7 +9,7 @@ public:
     virtual wstring TargetType() const { return L"Microsoft.Xna.Framework.Audio.SoundEffect"; }
     virtual wstring ReaderName() const { return L"Microsoft.Xna.Framework.Content.SoundEffectReader"; }
     
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
 
 
@@ -19,7 +19,7 @@ public:
     virtual wstring TargetType() const { return L"Microsoft.Xna.Framework.Media.Song"; }
     virtual wstring ReaderName() const { return L"Microsoft.Xna.Framework.Content.SongReader"; }
     
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
 
 
@@ -29,5 +29,5 @@ public:
     virtual wstring TargetType() const { return L"Microsoft.Xna.Framework.Media.Video"; }
     virtual wstring ReaderName() const { return L"Microsoft.Xna.Framework.Content.VideoReader"; }
     
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
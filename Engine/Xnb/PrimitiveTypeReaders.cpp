@@ -0,0 +1,155 @@
+#include "stdafx.h"
+#include "ContentReader.h"
+#include "PrimitiveTypeReaders.h"
+
+
+XnbObjectPtr ByteReader::Read(ContentReader* reader)
+{
+    uint8_t value = reader->ReadByte();
+    XNB_LOG(reader, LogInspect).WriteLine("%u", (uint32_t)value);
+
+    return nullptr;
+}
+
+
+XnbObjectPtr SByteReader::Read(ContentReader* reader)
+{
+    int8_t value = reader->ReadSByte();
+    XNB_LOG(reader, LogInspect).WriteLine("%d", (int32_t)value);
+
+    return nullptr;
+}
+
+
+XnbObjectPtr Int16Reader::Read(ContentReader* reader)
+{
+    int16_t value = reader->ReadInt16();
+    XNB_LOG(reader, LogInspect).WriteLine("%hd", value);
+
+    return nullptr;
+}
+
+
+XnbObjectPtr UInt16Reader::Read(ContentReader* reader)
+{
+    uint16_t value = reader->ReadUInt16();
+    XNB_LOG(reader, LogInspect).WriteLine("%hu", value);
+
+    return nullptr;
+}
+
+
+XnbObjectPtr Int32Reader::Read(ContentReader* reader)
+{
+    int32_t value = reader->ReadInt32();
+    XNB_LOG(reader, LogInspect).WriteLine("%d", value);
+
+    return nullptr;
+}
+
+
+XnbObjectPtr UInt32Reader::Read(ContentReader* reader)
+{
+    uint32_t value = reader->ReadUInt32();
+    XNB_LOG(reader, LogInspect).WriteLine("%u", value);
+
+    return nullptr;
+}
+
+
+XnbObjectPtr Int64Reader::Read(ContentReader* reader)
+{
+    int64_t value = reader->ReadInt64();
+    XNB_LOG(reader, LogInspect).WriteLine("%lld", value);
+
+    return nullptr;
+}
+
+
+XnbObjectPtr UInt64Reader::Read(ContentReader* reader)
+{
+    uint64_t value = reader->ReadUInt64();
+    XNB_LOG(reader, LogInspect).WriteLine("%llu", value);
+
+    return nullptr;
+}
+
+
+XnbObjectPtr SingleReader::Read(ContentReader* reader)
+{
+    float value = reader->ReadSingle();
+    XNB_LOG(reader, LogInspect).WriteLine("%g", value);
+
+    return nullptr;
+}
+
+
+XnbObjectPtr DoubleReader::Read(ContentReader* reader)
+{
+    double value = reader->ReadDouble();
+    XNB_LOG(reader, LogInspect).WriteLine("%g", value);
+
+    return nullptr;
+}
+
+
+XnbObjectPtr BooleanReader::Read(ContentReader* reader)
+{
+    bool value = reader->ReadBoolean();
+    XNB_LOG(reader, LogInspect).WriteLine(value ? "true" : "false");
+
+    return nullptr;
+}
+
+
+XnbObjectPtr CharReader::Read(ContentReader* reader)
+{
+    wchar_t value = reader->ReadChar();
+
+    // Take care not to accidentally print out control character codes!
+    if (iswprint(value))
+    {
+        XNB_LOG(reader, LogInspect).WriteLine("U+%04hX '%C'", value, value);
+    }
+    else
+    {
+        XNB_LOG(reader, LogInspect).WriteLine("U+%04hX", value);
+    }
+
+    return nullptr;
+}
+
+
+XnbObjectPtr StringReader::Read(ContentReader* reader)
+{
+    shared_ptr<XnbString> result(new XnbString);
+
+    wstring& value = result->value;
+
+    value = reader->ReadString();
+
+    XNB_LOG(reader, LogInspect).Write("'");
+
+    for (wchar_t ch : value)
+    {
+        // Take care not to accidentally print out control character codes!
+        if (iswprint(ch))
+        {
+            XNB_LOG(reader, LogInspect).Write("%C", ch);
+        }
+        else
+        {
+            XNB_LOG(reader, LogInspect).Write("\\U+%04hX", ch);
+        }
+    }
+
+    XNB_LOG(reader, LogInspect).WriteLine("'");
+
+    return result;
+}
+
+
+XnbObjectPtr ObjectReader::Read(ContentReader*)
+{
+    throw runtime_error("ObjectReader should never be invoked directly.");
+}
@@ -3,9 +3,12 @@
 #include "SystemTypeReaders.h"
 
 
-void EnumReader::Read(ContentReader* reader)
+XnbObjectPtr EnumReader::Read(ContentReader* reader)
 {
-    reader->Log.WriteLine("Enum value: %d", reader->ReadInt32());
+    int32_t enumValue = reader->ReadInt32();
+    XNB_LOG(reader, LogInspect).WriteLine("Enum value: %d", enumValue);
+
+    return nullptr;
 }
 
 
@@ -16,7 +19,7 @@ void NullableReader::Initialize(TypeReaderManager* typeReaderManager)
 }
 
 
-void NullableReader::Read(ContentReader* reader)
+XnbObjectPtr NullableReader::Read(ContentReader* reader)
 {
     if (reader->ReadBoolean())
     {
@@ -24,8 +27,10 @@ void NullableReader::Read(ContentReader* reader)
     }
     else
     {
-        reader->Log.WriteLine("null");
+        XNB_LOG(reader, LogInspect).WriteLine("null");
     }
+
+    return nullptr;
 }
 
 
@@ -36,18 +41,20 @@ void ArrayReader::Initialize(TypeReaderManager* typeReaderManager)
 }
 
 
-void ArrayReader::Read(ContentReader* reader)
+XnbObjectPtr ArrayReader::Read(ContentReader* reader)
 {
     uint32_t elementCount = reader->ReadUInt32();
 
-    reader->Log.WriteLine("Element count: %u", elementCount);
+    XNB_LOG(reader, LogInspect).WriteLine("Element count: %u", elementCount);
 
     for (uint32_t i = 0; i < elementCount; i++)
     {
-        reader->Log.WriteLine("Element %u:", i);
+        XNB_LOG(reader, LogInspect).WriteLine("Element %u:", i);
 
         reader->ReadValueOrObject(elementReader);
     }
+
+    return nullptr;
 }
 
 
@@ -58,18 +65,20 @@ void ListReader::Initialize(TypeReaderManager* typeReaderManager)
 }
 
 
-void ListReader::Read(ContentReader* reader)
+XnbObjectPtr ListReader::Read(ContentReader* reader)
 {
     uint32_t elementCount = reader->ReadUInt32();
 
-    reader->Log.WriteLine("Element count: %u", elementCount);
+    XNB_LOG(reader, LogInspect).WriteLine("Element count: %u", elementCount);
 
     for (uint32_t i = 0; i < elementCount; i++)
     {
-        reader->Log.WriteLine("Element %u:", i);
+        XNB_LOG(reader, LogInspect).WriteLine("Element %u:", i);
 
         reader->ReadValueOrObject(elementReader);
     }
+
+    return nullptr;
 }
 
 
@@ -81,29 +90,31 @@ void DictionaryReader::Initialize(TypeReaderManager* typeReaderManager)
 }
 
 
-void DictionaryReader::Read(ContentReader* reader)
+XnbObjectPtr DictionaryReader::Read(ContentReader* reader)
 {
     uint32_t elementCount = reader->ReadUInt32();
 
-    reader->Log.WriteLine("Element count: %u", elementCount);
+    XNB_LOG(reader, LogInspect).WriteLine("Element count: %u", elementCount);
 
     for (uint32_t i = 0; i < elementCount; i++)
     {
-        reader->Log.WriteLine("Element %u:", i);
+        XNB_LOG(reader, LogInspect).WriteLine("Element %u:", i);
         reader->Log.Indent();
 
-        reader->Log.WriteLine("Key:");
+        XNB_LOG(reader, LogInspect).WriteLine("Key:");
         reader->ReadValueOrObject(keyReader);
         
-        reader->Log.WriteLine("Value:");
+        XNB_LOG(reader, LogInspect).WriteLine("Value:");
         reader->ReadValueOrObject(valueReader);
 
         reader->Log.Unindent();
     }
+
+    return nullptr;
 }
 
 
-void TimeSpanReader::Read(ContentReader* reader)
+XnbObjectPtr TimeSpanReader::Read(ContentReader* reader)
 {
     int64_t ticks = reader->ReadInt64();
 
@@ -111,7 +122,7 @@ void TimeSpanReader::Read(ContentReader* reader)
     if (ticks < 0)
     {
         ticks = -ticks;
-        reader->Log.Write("-");
+        XNB_LOG(reader, LogInspect).Write("-");
     }
 
     // Split into days, hours, minutes, seconds, and remaining fractional ticks.
@@ -129,56 +140,61 @@ void TimeSpanReader::Read(ContentReader* reader)
     // Only write the day count if non-zero.
     if (days)
     {
-        reader->Log.Write("%lld.", days);
+        XNB_LOG(reader, LogInspect).Write("%lld.", days);
     }
 
     // Write hours, minutes, and seconds.
-    reader->Log.Write("%d:%d:%d", hours, minutes, seconds);
+    XNB_LOG(reader, LogInspect).Write("%d:%d:%d", hours, minutes, seconds);
 
     // Only write the fractional ticks if non-zero.
     if (ticks)
     {
-        char formattedTicks[16];
-
-        sprintf_s(formattedTicks, "%.7f", (double)ticks / ticksPerSecond);
-
-        reader->Log.Write(strchr(formattedTicks, '.'));
+        XNB_LOG(reader, LogInspect).Write(".%07d", (int32_t)ticks);
     }
 
-    reader->Log.WriteLine("");
+    XNB_LOG(reader, LogInspect).WriteLine("");
+
+    return nullptr;
 }
 
 
-void DateTimeReader::Read(ContentReader* reader)
+XnbObjectPtr DateTimeReader::Read(ContentReader* reader)
 {
     uint64_t value = reader->ReadUInt64();
 
     int32_t kind = value >> 62;
     uint64_t ticks = value & ~(3LL << 62);
 
-    reader->Log.WriteLine("DateTimeKind: %d", kind);
-    reader->Log.WriteLine("Ticks: %llu", ticks);
+    XNB_LOG(reader, LogInspect).WriteLine("DateTimeKind: %d", kind);
+    XNB_LOG(reader, LogInspect).WriteLine("Ticks: %llu", ticks);
+
+    return nullptr;
 }
 
 
-void DecimalReader::Read(ContentReader* reader)
+XnbObjectPtr DecimalReader::Read(ContentReader* reader)
 {
     uint32_t a = reader->ReadUInt32();
     uint32_t b = reader->ReadUInt32();
     uint32_t c = reader->ReadUInt32();
     uint32_t d = reader->ReadUInt32();
 
-    reader->Log.WriteLine("%08X:%08X.%08X.%08X", d, c, b, a);
+    XNB_LOG(reader, LogInspect).WriteLine("%08X:%08X.%08X.%08X", d, c, b, a);
+
+    return nullptr;
 }
 
 
-void ExternalReferenceReader::Read(ContentReader* reader)
+XnbObjectPtr ExternalReferenceReader::Read(ContentReader* reader)
 {
-    reader->Log.WriteLine("'%S'", reader->ReadString().c_str());
+    wstring value = reader->ReadString();
+    XNB_LOG(reader, LogInspect).WriteLine("'%S'", value.c_str());
+
+    return nullptr;
 }
 
 
-void ReflectiveReader::Read(ContentReader*)
+XnbObjectPtr ReflectiveReader::Read(ContentReader*)
 {
     printf("\n");
     printf("This C++ XNB loader implementation does not support ReflectiveReader.\n");
@@ -193,5 +209,5 @@ void ReflectiveReader::Read(ContentReader*)
     printf("    ReaderName = '%S'\n", ReaderName().c_str());
     printf("\n");
 
-    throw exception("Cannot parse XNB files that use automatic serialization.");
+    throw runtime_error("Cannot parse XNB files that use automatic serialization.");
 }
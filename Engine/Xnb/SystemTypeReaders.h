@@ -13,7 +13,7 @@ public:
 
     virtual bool IsValueType() const { return true; }
     
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
 
 
@@ -26,7 +26,7 @@ public:
     virtual bool IsValueType() const { return true; }
     
     virtual void Initialize(TypeReaderManager* typeReaderManager);
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 
 private:
     TypeReader* valueReader;
@@ -42,7 +42,7 @@ public:
     virtual wstring TargetType() const { return GenericArgument(0) + L"[]"; }
     
     virtual void Initialize(TypeReaderManager* typeReaderManager);
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 
 private:
     TypeReader* elementReader;
@@ -56,7 +56,7 @@ public:
     static wstring GenericReaderName() { return L"Microsoft.Xna.Framework.Content.ListReader"; }
     
     virtual void Initialize(TypeReaderManager* typeReaderManager);
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 
 private:
     TypeReader* elementReader;
@@ -70,7 +70,7 @@ public:
     static wstring GenericReaderName() { return L"Microsoft.Xna.Framework.Content.DictionaryReader"; }
     
     virtual void Initialize(TypeReaderManager* typeReaderManager);
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 
 private:
     TypeReader* keyReader;
@@ -86,7 +86,7 @@ public:
     
     virtual bool IsValueType() const { return true; }
 
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
 
 
@@ -98,7 +98,7 @@ public:
     
     virtual bool IsValueType() const { return true; }
 
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
 
 
@@ -110,7 +110,7 @@ public:
     
     virtual bool IsValueType() const { return true; }
 
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
 
 
@@ -120,7 +120,7 @@ public:
     virtual wstring TargetType() const { return L"ExternalReference"; }
     virtual wstring ReaderName() const { return L"Microsoft.Xna.Framework.Content.ExternalReferenceReader"; }
     
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
 
 
@@ -132,5 +132,5 @@ public:
 
     virtual wstring TargetType() const { return GenericArgument(0); }
 
-    virtual void Read(ContentReader* reader);
+    virtual XnbObjectPtr Read(ContentReader* reader);
 };
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "XnbObjects.h"
+
 
 // Each TypeReader subclass is responsible for reading a specific type of object from XNB format.
 class TypeReader
@@ -14,5 +16,6 @@ public:
 
     virtual void Initialize(class TypeReaderManager*) { }
 
-    virtual void Read(class ContentReader* reader) = 0;
+    // Reads an object, returning what was read (or null for types we only log, rather than load).
+    virtual XnbObjectPtr Read(class ContentReader* reader) = 0;
 };
@@ -9,12 +9,12 @@
 
 TypeReaderManager::~TypeReaderManager()
 {
-    for each (TypeReader* reader in typeReaders)
+    for (TypeReader* reader : typeReaders)
     {
         delete reader;
     }
 
-    for each (GenericTypeReaderFactory* factory in genericReaders)
+    for (GenericTypeReaderFactory* factory : genericReaders)
     {
         delete factory;
     }
@@ -92,70 +92,143 @@ void TypeReaderManager::RegisterStandardTypes()
 }
 
 
+void TypeReaderManager::AddTypeReader(TypeReader* reader)
+{
+    typeReaders.push_back(reader);
+
+    // If more than one reader claims the same name, the first one registered wins.
+    readersByName.insert(make_pair(reader->ReaderName(), reader));
+    readersByTargetType.insert(make_pair(reader->TargetType(), reader));
+}
+
+
+void TypeReaderManager::AddGenericReader(GenericTypeReaderFactory* factory)
+{
+    genericReaders.push_back(factory);
+
+    genericReadersByName.insert(make_pair(factory->GenericReaderName(), factory));
+}
+
+
 TypeReader* TypeReaderManager::GetByReaderName(wstring const& readerName)
 {
+    lock_guard<recursive_mutex> guard(lock);
+
+    // Have we already looked up this exact name?
+    TypeReaderMap::const_iterator cached = readerNameCache.find(readerName);
+
+    if (cached != readerNameCache.end())
+    {
+        return cached->second;
+    }
+
     wstring wanted = StripAssemblyVersion(readerName);
 
-    // Look for a type reader with this name.
-    for each (TypeReader* reader in typeReaders)
+    TypeReader* reader = FindByReaderName(wanted);
+
+    if (!reader)
+    {
+        // Fatal error if we cannot find a suitable reader.
+        throw runtime_error("Can't find type reader '" + NarrowString(wanted) + "'.");
+    }
+
+    readerNameCache.insert(make_pair(readerName, reader));
+
+    return reader;
+}
+
+
+TypeReader* TypeReaderManager::GetByTargetType(wstring const& targetType)
+{
+    lock_guard<recursive_mutex> guard(lock);
+
+    // Have we already looked up this exact name?
+    TypeReaderMap::const_iterator cached = targetTypeCache.find(targetType);
+
+    if (cached != targetTypeCache.end())
     {
-        if (reader->ReaderName() == wanted)
+        return cached->second;
+    }
+
+    wstring wanted = StripAssemblyVersion(targetType);
+
+    TypeReader* reader = FindByTargetType(wanted);
+
+    if (!reader)
+    {
+        // Fatal error if we cannot find a suitable reader.
+        throw runtime_error("Can't find reader for target type '" + NarrowString(wanted) + "'.");
+    }
+
+    targetTypeCache.insert(make_pair(targetType, reader));
+
+    return reader;
+}
+
+
+void TypeReaderManager::InitializeTypeReaders(vector<TypeReader*> const& readers)
+{
+    lock_guard<recursive_mutex> guard(lock);
+
+    for (TypeReader* reader : readers)
+    {
+        // Mark the reader before initializing it, in case there are circular dependencies.
+        if (initializedReaders.insert(reader).second)
         {
-            return reader;
+            reader->Initialize(this);
         }
     }
+}
+
+
+TypeReader* TypeReaderManager::FindByReaderName(wstring const& readerName)
+{
+    // Look for a type reader with this name.
+    TypeReaderMap::const_iterator it = readersByName.find(readerName);
+
+    if (it != readersByName.end())
+    {
+        return it->second;
+    }
 
     // Could this be a specialization of a generic reader?
     wstring genericReaderName;
     vector<wstring> genericArguments;
 
-    if (SplitGenericTypeName(wanted, &genericReaderName, &genericArguments))
+    if (SplitGenericTypeName(readerName, &genericReaderName, &genericArguments))
     {
         // Look for a generic reader factory with this name.
-        for each (GenericTypeReaderFactory* factory in genericReaders)
+        GenericReaderMap::const_iterator factory = genericReadersByName.find(genericReaderName);
+
+        if (factory != genericReadersByName.end())
         {
-            if (factory->GenericReaderName() == genericReaderName)
-            {
-                // Create a specialized generic reader instance.
-                GenericTypeReader* reader = factory->CreateTypeReader(genericArguments);
+            // Create a specialized generic reader instance. This is indexed along with
+            // the other readers, so later requests for the same specialization reuse it.
+            GenericTypeReader* reader = factory->second->CreateTypeReader(genericArguments);
 
-                assert(reader->ReaderName() == wanted);
+            assert(reader->ReaderName() == readerName);
 
-                typeReaders.push_back(reader);
+            AddTypeReader(reader);
 
-                return reader;
-            }
+            return reader;
         }
     }
 
-    // Fatal error if we cannot find a suitable reader.
-    char message[256];
-
-    sprintf_s(message, "Can't find type reader '%S'.", wanted.c_str());
-
-    throw exception(message);
+    return nullptr;
 }
 
 
-TypeReader* TypeReaderManager::GetByTargetType(wstring const& targetType)
+TypeReader* TypeReaderManager::FindByTargetType(wstring const& targetType)
 {
-    wstring wanted = StripAssemblyVersion(targetType);
-
     // Look for a reader with this target type name.
-    for each (TypeReader* reader in typeReaders)
+    TypeReaderMap::const_iterator it = readersByTargetType.find(targetType);
+
+    if (it != readersByTargetType.end())
     {
-        if (reader->TargetType() == wanted)
-        {
-            return reader;
-        }
+        return it->second;
     }
 
-    // Fatal error if we cannot find a suitable reader.
-    char message[256];
-
-    sprintf_s(message, "Can't find reader for target type '%S'.", wanted.c_str());
-
-    throw exception(message);
+    return nullptr;
 }
 
 
@@ -193,6 +266,20 @@ wstring TypeReaderManager::StripAssemblyVersion(wstring typeName)
 }
 
 
+// Type names are plain ASCII, so this is just for error messages.
+string TypeReaderManager::NarrowString(wstring const& value)
+{
+    string result;
+
+    for (wchar_t ch : value)
+    {
+        result += (ch < 0x80) ? (char)ch : '?';
+    }
+
+    return result;
+}
+
+
 bool TypeReaderManager::SplitGenericTypeName(wstring const& typeName, wstring* genericName, vector<wstring>* genericArguments)
 {
     // Splits "foo`2[[bar],[baz]]" into genericName = "foo", genericArguments = { "bar", "baz" }
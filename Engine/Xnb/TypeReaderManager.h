@@ -0,0 +1,70 @@
+#pragma once
+
+#include "TypeReader.h"
+#include "GenericTypeReader.h"
+
+
+// Keeps track of all the available TypeReader implementations.
+// Lookups are thread safe, so one manager can be shared by parsers running on several threads.
+class TypeReaderManager
+{
+public:
+    virtual ~TypeReaderManager();
+
+    void RegisterStandardTypes();
+
+    TypeReader* GetByReaderName(wstring const& readerName);
+    TypeReader* GetByTargetType(wstring const& targetType);
+
+    // Initializes any of these readers that have not already been initialized.
+    void InitializeTypeReaders(vector<TypeReader*> const& readers);
+
+
+    template<typename T> void RegisterTypeReader()
+    {
+        static_assert(!is_base_of<GenericTypeReader, T>::value, "Generic reader types should use RegisterGenericTypeReader.");
+
+        AddTypeReader(new T);
+    }
+
+
+    template<typename T> void RegisterGenericReader()
+    {
+        AddGenericReader(new GenericTypeReaderFactoryT<T>);
+    }
+
+
+private:
+    typedef unordered_map<wstring, TypeReader*> TypeReaderMap;
+    typedef unordered_map<wstring, GenericTypeReaderFactory*> GenericReaderMap;
+
+    void AddTypeReader(TypeReader* reader);
+    void AddGenericReader(GenericTypeReaderFactory* factory);
+
+    // Lookups by canonical name, ie. with assembly version information already stripped.
+    TypeReader* FindByReaderName(wstring const& readerName);
+    TypeReader* FindByTargetType(wstring const& targetType);
+
+    static wstring StripAssemblyVersion(wstring typeName);
+    static string NarrowString(wstring const& value);
+    static bool SplitGenericTypeName(wstring const& typeName, wstring* genericName, vector<wstring>* genericArguments);
+
+    vector<TypeReader*> typeReaders;
+    vector<GenericTypeReaderFactory*> genericReaders;
+
+    // Hash indexes of the above, keyed by canonical name. Generic specializations are
+    // added to these as they are created, so each one is only ever built once.
+    TypeReaderMap readersByName;
+    TypeReaderMap readersByTargetType;
+    GenericReaderMap genericReadersByName;
+
+    // Lookups keyed by names exactly as they appear in XNB files, so repeated loads skip
+    // the assembly version stripping and hit a single hash lookup.
+    TypeReaderMap readerNameCache;
+    TypeReaderMap targetTypeCache;
+
+    unordered_set<TypeReader*> initializedReaders;
+
+    // Guards all of the above. Recursive because initializing a reader looks up other readers.
+    recursive_mutex lock;
+};
@@ -0,0 +1,206 @@
+#include "stdafx.h"
+#include "XnbParser.h"
+#include "ContentReader.h"
+#include "XnbModelData.h"
+#include "XnbVertexFormat.h"
+
+// Appends count indices from start, offset by baseVertex, converting to the output index width.
+// Every index must land on one of the vertexCount vertices.
+template<typename TInput, typename TOutput>
+static void appendIndices(vector<TInput> const& indices, uint32_t start, uint32_t count, uint64_t baseVertex, uint32_t vertexCount, vector<TOutput>* output) {
+	if (start > indices.size() || count > indices.size() - start)
+		throw runtime_error("Model mesh part indices are out of range.");
+
+	for (uint32_t i = 0; i < count; i++) {
+		uint64_t index = indices[start + i] + baseVertex;
+
+		if (index >= vertexCount)
+			throw runtime_error("Model mesh part index is past the end of its vertices.");
+
+		output->push_back((TOutput)index);
+	}
+}
+
+// Decodes one attribute of every vertex in a buffer onto the end of a stream, if the buffer has it.
+static bool appendStream(XnbVertexBuffer const& vertexBuffer, int32_t usage, int componentCount, vector<float>* stream) {
+	XnbVertexElement const* element = vertexBuffer.declaration.FindElement(usage);
+
+	if (!element)
+		return false;
+
+	uint8_t const* vertex = (uint8_t const*)vertexBuffer.vertexData.data();
+	float value[4];
+
+	for (uint32_t i = 0; i < vertexBuffer.vertexCount; i++) {
+		DecodeVertexElement(vertex + element->offset, element->format, value);
+		stream->insert(stream->end(), value, value + componentCount);
+		vertex += vertexBuffer.declaration.stride;
+	}
+
+	return true;
+}
+
+// Grows sphere (center x, y, z, then radius) just enough to enclose other.
+static void mergeBoundingSphere(float* sphere, float const* other) {
+	float offset[3] = {other[0] - sphere[0], other[1] - sphere[1], other[2] - sphere[2]};
+	float distance = sqrtf(offset[0] * offset[0] + offset[1] * offset[1] + offset[2] * offset[2]);
+
+	if (distance + other[3] <= sphere[3])
+		return;
+
+	if (distance + sphere[3] <= other[3]) {
+		memcpy(sphere, other, 4 * sizeof(float));
+		return;
+	}
+
+	float radius = (distance + sphere[3] + other[3]) * 0.5f;
+	float shift = (radius - sphere[3]) / distance;
+
+	for (int i = 0; i < 3; i++)
+		sphere[i] += offset[i] * shift;
+
+	sphere[3] = radius;
+}
+
+void XnbModelData::loadFromFile(char* fileName) {
+	XnbParser parser;
+
+	this->model = dynamic_pointer_cast<XnbModel>(parser.parse(fileName));
+	this->vertexCount = 0;
+	memset(this->boundingSphere, 0, sizeof(this->boundingSphere));
+
+	if (!this->model) {
+		printf("Error: '%s' is not a model.\n", fileName);
+		return;
+	}
+
+	this->flattenMeshParts();
+}
+
+void XnbModelData::flattenMeshParts() {
+	// Gather the distinct vertex and index buffers used by the model.
+	vector<XnbVertexBuffer*> vertexBuffers;
+	vector<XnbIndexBuffer*> indexBuffers;
+
+	for (XnbMesh const& mesh : model->meshes) {
+		for (XnbMeshPart const& part : mesh.parts) {
+			if (!part.vertexBuffer || !part.indexBuffer)
+				continue;
+
+			// Checked here, in 64 bits, so a corrupt part can't overflow the sizes worked out below.
+			if (part.startIndex < 0 || part.primitiveCount < 0 || part.vertexOffset < 0)
+				throw runtime_error("Model mesh part has a negative index range.");
+
+			if ((uint64_t)part.startIndex + (uint64_t)part.primitiveCount * 3 > part.indexBuffer->IndexCount())
+				throw runtime_error("Model mesh part indices are out of range.");
+
+			if (find(vertexBuffers.begin(), vertexBuffers.end(), part.vertexBuffer.get()) == vertexBuffers.end())
+				vertexBuffers.push_back(part.vertexBuffer.get());
+
+			if (find(indexBuffers.begin(), indexBuffers.end(), part.indexBuffer.get()) == indexBuffers.end())
+				indexBuffers.push_back(part.indexBuffer.get());
+		}
+	}
+
+	if (vertexBuffers.empty())
+		return;
+
+	// Pick up the texture from the first part that has one.
+	for (XnbMesh const& mesh : model->meshes) {
+		for (XnbMeshPart const& part : mesh.parts) {
+			XnbBasicEffect* effect = dynamic_cast<XnbBasicEffect*>(part.effect.get());
+
+			if (effect && !effect->textureReference.empty() && this->textureReference.empty())
+				this->textureReference.assign(effect->textureReference.begin(), effect->textureReference.end());
+		}
+	}
+
+	// Combine the meshes' bounding spheres. Like the vertices, these ignore the bone transforms.
+	for (size_t i = 0; i < model->meshes.size(); i++) {
+		if (i == 0)
+			memcpy(this->boundingSphere, model->meshes[i].boundingSphere, sizeof(this->boundingSphere));
+		else
+			mergeBoundingSphere(this->boundingSphere, model->meshes[i].boundingSphere);
+	}
+
+	// Decode each vertex buffer in turn onto the end of the streams. Buffers can have different
+	// layouts, but an attribute is only kept if every buffer has it, so the streams stay in step.
+	vector<uint32_t> baseVertices;
+	bool hasNormals = true;
+	bool hasTexCoords = true;
+
+	for (XnbVertexBuffer* vertexBuffer : vertexBuffers) {
+		baseVertices.push_back(this->vertexCount);
+		this->vertexCount += vertexBuffer->vertexCount;
+	}
+
+	this->positions.reserve(this->vertexCount * 3);
+	this->normals.reserve(this->vertexCount * 3);
+	this->texCoords.reserve(this->vertexCount * 2);
+
+	for (XnbVertexBuffer* vertexBuffer : vertexBuffers) {
+		if (!appendStream(*vertexBuffer, ElementUsagePosition, 3, &this->positions))
+			throw runtime_error("Model vertices have no position.");
+
+		hasNormals = hasNormals && appendStream(*vertexBuffer, ElementUsageNormal, 3, &this->normals);
+		hasTexCoords = hasTexCoords && appendStream(*vertexBuffer, ElementUsageTextureCoordinate, 2, &this->texCoords);
+	}
+
+	if (!hasNormals)
+		this->normals.clear();
+
+	if (!hasTexCoords)
+		this->texCoords.clear();
+
+	// Copy each part's own range of indices, rebased onto the combined vertices. The model keeps
+	// its index buffers, and a part need not use all of one.
+	uint64_t totalIndices = 0;
+
+	for (XnbMesh const& mesh : model->meshes) {
+		for (XnbMeshPart const& part : mesh.parts) {
+			if (part.vertexBuffer && part.indexBuffer)
+				totalIndices += (uint64_t)part.primitiveCount * 3;
+		}
+	}
+
+	bool is16Bit = this->vertexCount <= 0x10000;
+
+	if (is16Bit)
+		this->indexData16.reserve((size_t)totalIndices);
+	else
+		this->indexData32.reserve((size_t)totalIndices);
+
+	for (XnbMesh const& mesh : model->meshes) {
+		for (XnbMeshPart const& part : mesh.parts) {
+			if (!part.vertexBuffer || !part.indexBuffer)
+				continue;
+
+			size_t bufferIndex = find(vertexBuffers.begin(), vertexBuffers.end(), part.vertexBuffer.get()) - vertexBuffers.begin();
+			uint64_t baseVertex = (uint64_t)baseVertices[bufferIndex] + part.vertexOffset;
+
+			XnbIndexBuffer const& indices = *part.indexBuffer;
+
+			uint32_t start = (uint32_t)part.startIndex;
+			uint32_t count = (uint32_t)part.primitiveCount * 3;
+
+			if (indices.is16Bit && is16Bit)
+				appendIndices(indices.indexData16, start, count, baseVertex, this->vertexCount, &this->indexData16);
+			else if (indices.is16Bit)
+				appendIndices(indices.indexData16, start, count, baseVertex, this->vertexCount, &this->indexData32);
+			else if (is16Bit)
+				appendIndices(indices.indexData32, start, count, baseVertex, this->vertexCount, &this->indexData16);
+			else
+				appendIndices(indices.indexData32, start, count, baseVertex, this->vertexCount, &this->indexData32);
+		}
+	}
+}
+
+XnbModelData::XnbModelData()
+  : vertexCount(0) {
+	memset(this->boundingSphere, 0, sizeof(this->boundingSphere));
+
+}
+
+XnbModelData::XnbModelData(char* fileName) {
+	this->loadFromFile(fileName);
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "stdafx.h"
+#include "XnbObjects.h"
+
+class XnbModelData {
+public:
+	// The complete model, as loaded.
+	shared_ptr<XnbModel> model;
+
+	// Every mesh part flattened into a single set of vertex streams and index buffer, for simple
+	// renderers. Vertices are decoded from whatever layout the model was built with, and streams
+	// for attributes that aren't in the model's vertex declaration are left empty.
+	uint32_t vertexCount;
+	vector<float> positions;	// x, y, z per vertex.
+	vector<float> normals;		// x, y, z per vertex.
+	vector<float> texCoords;	// u, v per vertex.
+	// Indices stay 16 bit whenever every vertex can be addressed with them, so only one of these is filled in.
+	vector<uint16_t> indexData16;
+	vector<uint32_t> indexData32;
+	string textureReference;
+	// Bounds of every mesh together, from the spheres stored with them: center x, y, z, then radius.
+	float boundingSphere[4];
+
+	XnbModelData();
+	XnbModelData(char*);
+	void loadFromFile(char*);
+
+private:
+	void flattenMeshParts();
+};
\ No newline at end of file
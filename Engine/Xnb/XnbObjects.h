@@ -0,0 +1,233 @@
+#pragma once
+
+
+// Base class for the objects produced by TypeReader::Read. Types that we only log
+// rather than load (eg. most effect parameters) are read as null.
+class XnbObject
+{
+public:
+    virtual ~XnbObject() { }
+};
+
+typedef shared_ptr<XnbObject> XnbObjectPtr;
+
+
+// Boxed string, used for things like bone and mesh names.
+class XnbString : public XnbObject
+{
+public:
+    wstring value;
+};
+
+
+// XNA Microsoft.Xna.Framework.Graphics.VertexElementFormat.
+enum VertexElementFormat
+{
+    ElementFormatSingle,
+    ElementFormatVector2,
+    ElementFormatVector3,
+    ElementFormatVector4,
+    ElementFormatColor,
+    ElementFormatByte4,
+    ElementFormatShort2,
+    ElementFormatShort4,
+    ElementFormatNormalizedShort2,
+    ElementFormatNormalizedShort4,
+    ElementFormatHalfVector2,
+    ElementFormatHalfVector4,
+};
+
+
+// XNA Microsoft.Xna.Framework.Graphics.VertexElementUsage.
+enum VertexElementUsage
+{
+    ElementUsagePosition,
+    ElementUsageColor,
+    ElementUsageTextureCoordinate,
+    ElementUsageNormal,
+    ElementUsageBinormal,
+    ElementUsageTangent,
+    ElementUsageBlendIndices,
+    ElementUsageBlendWeight,
+    ElementUsageDepth,
+    ElementUsageFog,
+    ElementUsagePointSize,
+    ElementUsageSample,
+    ElementUsageTessellateFactor,
+};
+
+
+struct XnbVertexElement
+{
+    uint32_t offset;
+    int32_t format;         // VertexElementFormat
+    int32_t usage;          // VertexElementUsage
+    uint32_t usageIndex;
+};
+
+
+class XnbVertexDeclaration : public XnbObject
+{
+public:
+    XnbVertexDeclaration() : stride(0) { }
+
+    // Returns null if the declaration has no such element.
+    XnbVertexElement const* FindElement(int32_t usage, uint32_t usageIndex = 0) const
+    {
+        for (XnbVertexElement const& element : elements)
+        {
+            if (element.usage == usage && element.usageIndex == usageIndex)
+            {
+                return &element;
+            }
+        }
+
+        return nullptr;
+    }
+
+    uint32_t stride;
+    vector<XnbVertexElement> elements;
+};
+
+
+class XnbVertexBuffer : public XnbObject
+{
+public:
+    XnbVertexBuffer() : vertexCount(0) { }
+
+    XnbVertexDeclaration declaration;
+    uint32_t vertexCount;
+    vector<float> vertexData;
+};
+
+
+class XnbIndexBuffer : public XnbObject
+{
+public:
+    XnbIndexBuffer() : is16Bit(false) { }
+
+    uint32_t IndexCount() const { return (uint32_t)(is16Bit ? indexData16.size() : indexData32.size()); }
+
+    // Indices keep the width they were stored with, so only one of these is filled in.
+    bool is16Bit;
+    vector<uint16_t> indexData16;
+    vector<uint32_t> indexData32;
+};
+
+
+// XNA Microsoft.Xna.Framework.Graphics.SurfaceFormat.
+enum SurfaceFormat
+{
+    SurfaceFormatColor,
+    SurfaceFormatBgr565,
+    SurfaceFormatBgra5551,
+    SurfaceFormatBgra4444,
+    SurfaceFormatDxt1,
+    SurfaceFormatDxt3,
+    SurfaceFormatDxt5,
+    SurfaceFormatNormalizedByte2,
+    SurfaceFormatNormalizedByte4,
+    SurfaceFormatRgba1010102,
+    SurfaceFormatRg32,
+    SurfaceFormatRgba64,
+    SurfaceFormatAlpha8,
+    SurfaceFormatSingle,
+    SurfaceFormatVector2,
+    SurfaceFormatVector4,
+    SurfaceFormatHalfSingle,
+    SurfaceFormatHalfVector2,
+    SurfaceFormatHalfVector4,
+    SurfaceFormatHdrBlendable,
+};
+
+
+struct XnbTextureSubresource
+{
+    uint32_t offset;        // Into XnbTexture::data.
+    uint32_t size;
+};
+
+
+// Common to all the texture types. Pixel data is kept exactly as it was stored, so
+// block compressed (Dxt) formats stay compressed, ready to hand straight to the GPU.
+class XnbTexture : public XnbObject
+{
+public:
+    XnbTexture() : format(0), width(0), height(0), depth(1), mipCount(0), faceCount(1) { }
+
+    uint8_t const* SubresourceData(uint32_t index) const { return data.data() + subresources[index].offset; }
+
+    int32_t format;         // SurfaceFormat
+    uint32_t width;
+    uint32_t height;
+    uint32_t depth;         // Slices, for volume textures.
+    uint32_t mipCount;
+    uint32_t faceCount;     // 6 for cube maps.
+
+    // Every subresource, back to back in a single allocation. These are in Direct3D
+    // subresource order (the whole mip chain of each face in turn), and each mip of a
+    // volume texture holds all of its slices.
+    vector<uint8_t> data;
+    vector<XnbTextureSubresource> subresources;
+};
+
+
+class XnbTexture2D : public XnbTexture { };
+class XnbTexture3D : public XnbTexture { };
+class XnbTextureCube : public XnbTexture { };
+
+
+class XnbBasicEffect : public XnbObject
+{
+public:
+    wstring textureReference;
+    float diffuseColor[3];
+    float emissiveColor[3];
+    float specularColor[3];
+    float specularPower;
+    float alpha;
+    bool vertexColorEnabled;
+};
+
+
+struct XnbBone
+{
+    wstring name;
+    float transform[16];
+    int32_t parent;         // -1 if this is a root bone.
+    vector<int32_t> children;
+};
+
+
+struct XnbMeshPart
+{
+    int32_t vertexOffset;
+    int32_t numVertices;
+    int32_t startIndex;
+    int32_t primitiveCount;
+
+    // These are shared resources, so may be referenced by more than one part.
+    shared_ptr<XnbVertexBuffer> vertexBuffer;
+    shared_ptr<XnbIndexBuffer> indexBuffer;
+    XnbObjectPtr effect;
+};
+
+
+struct XnbMesh
+{
+    wstring name;
+    int32_t parentBone;
+    float boundingSphere[4];    // Center x, y, z, then radius.
+    vector<XnbMeshPart> parts;
+};
+
+
+class XnbModel : public XnbObject
+{
+public:
+    XnbModel() : rootBone(-1) { }
+
+    vector<XnbBone> bones;
+    vector<XnbMesh> meshes;
+    int32_t rootBone;
+};
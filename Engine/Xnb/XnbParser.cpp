@@ -0,0 +1,78 @@
+#include "stdafx.h"
+#include "ContentReader.h"
+#include "MappedFile.h"
+#include "XnbParser.h"
+
+/* INSTRUCTIONS *********************************************************
+
+To load data from a .xnb model:
+------
+#include "XnbModelData.h"
+...
+XnbModelData data("C:\\block.xnb");
+vector<float> blockPositions = data.positions;
+------
+
+The full model (bones, meshes, and parts referencing their vertex/index
+buffers and effects) is also available as data.model. XnbParser::parse
+returns the typed object for any other kind of asset.
+
+To load data from a .xnb texture2d (every mip is available through data.texture):
+------
+#include "XnbTexture2dData.h"
+...
+XnbTexture2dData data(C:\\CatTexture.xnb);
+vector<uint8_t> mip = data.mip0;
+------
+
+Texture3D and TextureCube assets parse to XnbTexture3D and XnbTextureCube. All the
+texture types keep every mip (and face, for cube maps) in data.texture->data, in
+Direct3D subresource order, with Dxt formats left compressed.
+
+Tell me if you need me to add extra fields to the data classes (Samuel Fike sfike@ksu.edu)
+
+*/
+
+XnbObjectPtr XnbParser::parse(char* fileName)
+{
+    // Map the file, so it can be parsed in place.
+    try
+    {
+        MappedFile file(fileName);
+
+        ContentReader reader(file.Data(), file.Size(), StandardTypeReaders());
+
+        // Parse the XNB data. The returned objects own copies of everything they need,
+        // so stay valid after the file is closed.
+        try
+        {
+            return reader.ReadXnb();
+        }
+        catch (exception& e)
+        {
+            printf("Error: %s\n", e.what());
+        }
+    }
+    catch (exception&)
+    {
+        printf("Error: can't open '%s'.\n", fileName);
+    }
+
+    return nullptr;
+}
+
+
+// Type readers are shared by every parse, so the work of looking them up
+// and specializing generic readers only happens once. This is a file scope
+// static rather than a function local one, since parses may run on several
+// threads and local statics are not initialized in a thread safe way.
+static TypeReaderManager standardTypeReaders;
+static once_flag standardTypesRegistered;
+
+
+TypeReaderManager* XnbParser::StandardTypeReaders()
+{
+    call_once(standardTypesRegistered, [] { standardTypeReaders.RegisterStandardTypes(); });
+
+    return &standardTypeReaders;
+}
@@ -0,0 +1,13 @@
+#include "ContentReader.h"
+#include "XnbModelData.h"
+#include "stdafx.h"
+
+class XnbParser
+{
+public: 
+	// Loads an XNB file, returning its primary asset (or null on failure).
+	XnbObjectPtr parse(char*);
+
+	// Manager holding the standard XNA type readers, shared by all parsers.
+	static TypeReaderManager* StandardTypeReaders();
+};
\ No newline at end of file
@@ -0,0 +1,33 @@
+#include "stdafx.h"
+#include "XnbParser.h"
+#include "ContentReader.h"
+#include "XnbTexture2dData.h"
+
+void XnbTexture2dData::loadFromFile(char* fileName) {
+	XnbParser parser;
+
+	this->texture = dynamic_pointer_cast<XnbTexture2D>(parser.parse(fileName));
+
+	if (!this->texture) {
+		printf("Error: '%s' is not a 2D texture.\n", fileName);
+		this->width = this->height = this->mipCount = 0;
+		return;
+	}
+
+	//retrieve data from the texture here
+	this->height = this->texture->height;
+	this->width = this->texture->width;
+	this->mipCount = this->texture->mipCount;
+
+	if (this->mipCount)
+		this->mip0.assign(this->texture->SubresourceData(0), this->texture->SubresourceData(0) + this->texture->subresources[0].size);
+}
+
+XnbTexture2dData::XnbTexture2dData()
+  : width(0), height(0), mipCount(0) {
+
+}
+
+XnbTexture2dData::XnbTexture2dData(char* fileName) {
+	this->loadFromFile(fileName);
+}
\ No newline at end of file
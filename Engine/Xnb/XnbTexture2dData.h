@@ -1,5 +1,7 @@
 #pragma once
 
+#include "XnbObjects.h"
+
 class XnbTexture2dData {
 public:
 	uint32_t width;
@@ -7,6 +9,9 @@ public:
 	uint32_t mipCount;
 	vector<uint8_t> mip0;
 
+	// The complete texture: every mip, still block compressed if it was stored that way.
+	shared_ptr<XnbTexture2D> texture;
+
 	XnbTexture2dData();
 	XnbTexture2dData(char*);
 	void loadFromFile(char*);
@@ -0,0 +1,462 @@
+#include "../stdafx.h"
+#include "LzxCompressor.h"
+
+#include <queue>
+
+
+namespace
+{
+    enum
+    {
+        FrameSize = 0x8000,
+        MinMatch = 3,               // LZX allows 2, but those rarely pay for themselves.
+        MaxMatch = 257,
+        MaxOffset = 0x8000 - 1,
+        HashBits = 15,
+        MaxChain = 32,
+
+        NumChars = 256,
+        NumPrimaryLengths = 7,
+        NumSecondaryLengths = 249,
+        PositionSlots = 32,
+        MainTreeSymbols = NumChars + PositionSlots * 8,
+        PretreeSymbols = 20,
+
+        MaxCodeBits = 16,
+        MaxPretreeBits = 15,        // Pretree lengths are stored in four bits.
+    };
+
+
+    // Smallest formatted offset (the match offset plus two) of each position slot, as LzxDecoder.
+    uint32_t const positionBase[PositionSlots + 1] =
+    {
+        0, 1, 2, 3, 4, 6, 8, 12, 16, 24, 32, 48, 64, 96, 128, 192,
+        256, 384, 512, 768, 1024, 1536, 2048, 3072, 4096, 6144, 8192, 12288, 16384, 24576, 32768, 49152,
+        65536,
+    };
+
+    uint8_t const extraBits[PositionSlots] =
+    {
+        0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+        7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13, 14, 14,
+    };
+
+
+    // A literal or match, as it will be written.
+    struct Symbol
+    {
+        uint16_t main;
+        int16_t length;             // Length tree symbol, or -1 if there isn't one.
+        uint8_t footerBits;
+        uint32_t footer;
+    };
+
+
+    // Packs bits MSB first into little-endian 16 bit words, as LZX wants.
+    class BitWriter
+    {
+    public:
+        explicit BitWriter(vector<uint8_t>* output) : output(output), word(0), used(0) {}
+
+        void Write(uint32_t value, uint32_t count)
+        {
+            while (count--)
+            {
+                word = (word << 1) | ((value >> count) & 1);
+
+                if (++used == 16)
+                {
+                    output->push_back((uint8_t)word);
+                    output->push_back((uint8_t)(word >> 8));
+                    word = 0;
+                    used = 0;
+                }
+            }
+        }
+
+        // Pads to the end of the current word.
+        void Flush()
+        {
+            if (used)
+            {
+                Write(0, 16 - used);
+            }
+        }
+
+    private:
+        vector<uint8_t>* output;
+        uint32_t word;
+        uint32_t used;
+    };
+
+
+    // Huffman code lengths for the frequencies, none longer than maxBits. Codes that come out
+    // too long are fixed by flattening the frequencies and trying again. A tree of one code
+    // isn't complete, so LZX can't read it: a second symbol is given a code alongside it.
+    void BuildLengths(vector<uint32_t> frequencies, uint32_t maxBits, uint8_t* lengths)
+    {
+        size_t count = frequencies.size();
+        size_t used = 0;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            used += frequencies[i] ? 1 : 0;
+        }
+
+        memset(lengths, 0, count);
+
+        if (!used)
+        {
+            return;
+        }
+
+        if (used == 1)
+        {
+            frequencies[frequencies[0] ? 1 : 0] = 1;
+        }
+
+        for (;;)
+        {
+            typedef pair<uint64_t, uint32_t> Node;
+
+            priority_queue<Node, vector<Node>, greater<Node>> queue;
+            vector<uint32_t> parent(count * 2, UINT32_MAX);
+            uint32_t next = (uint32_t)count;
+
+            for (uint32_t i = 0; i < count; i++)
+            {
+                if (frequencies[i])
+                {
+                    queue.push(Node(frequencies[i], i));
+                }
+            }
+
+            while (queue.size() > 1)
+            {
+                Node a = queue.top();
+                queue.pop();
+                Node b = queue.top();
+                queue.pop();
+
+                parent[a.second] = next;
+                parent[b.second] = next;
+                queue.push(Node(a.first + b.first, next++));
+            }
+
+            uint32_t longest = 0;
+
+            for (uint32_t i = 0; i < count; i++)
+            {
+                uint32_t depth = 0;
+
+                for (uint32_t node = i; frequencies[i] && parent[node] != UINT32_MAX; node = parent[node])
+                {
+                    depth++;
+                }
+
+                lengths[i] = (uint8_t)min(depth, 255u);
+                longest = max(longest, depth);
+            }
+
+            if (longest <= maxBits)
+            {
+                return;
+            }
+
+            for (size_t i = 0; i < count; i++)
+            {
+                if (frequencies[i])
+                {
+                    frequencies[i] = (frequencies[i] + 1) / 2;
+                }
+            }
+        }
+    }
+
+
+    // Canonical codes for a set of lengths: shorter codes first, then by symbol, as the decoder
+    // builds its tables.
+    void BuildCodes(uint8_t const* lengths, uint32_t count, uint32_t* codes)
+    {
+        uint32_t code = 0;
+
+        for (uint32_t bits = 1; bits <= MaxCodeBits; bits++)
+        {
+            for (uint32_t symbol = 0; symbol < count; symbol++)
+            {
+                if (lengths[symbol] == bits)
+                {
+                    codes[symbol] = code++;
+                }
+            }
+
+            code <<= 1;
+        }
+    }
+
+
+    // Writes lengths[first, last) as the decoder's ReadLengths reads them: a pretree, then each
+    // length as a change from what the table held before, with runs of zeros shortened.
+    void WriteLengths(BitWriter* bits, uint8_t const* lengths, uint8_t* previous, uint32_t first, uint32_t last)
+    {
+        struct Code
+        {
+            uint8_t symbol;
+            uint8_t extraBits;
+            uint8_t extra;
+        };
+
+        vector<Code> codes;
+
+        for (uint32_t i = first; i < last;)
+        {
+            uint32_t zeros = 0;
+
+            while (i + zeros < last && !lengths[i + zeros] && zeros < 51)
+            {
+                zeros++;
+            }
+
+            Code code;
+
+            if (zeros >= 20)
+            {
+                code.symbol = 18;
+                code.extraBits = 5;
+                code.extra = (uint8_t)(zeros - 20);
+                i += zeros;
+            }
+            else if (zeros >= 4)
+            {
+                code.symbol = 17;
+                code.extraBits = 4;
+                code.extra = (uint8_t)(min(zeros, 19u) - 4);
+                i += min(zeros, 19u);
+            }
+            else
+            {
+                code.symbol = (uint8_t)((previous[i] + 17 - lengths[i]) % 17);
+                code.extraBits = 0;
+                code.extra = 0;
+                i++;
+            }
+
+            codes.push_back(code);
+        }
+
+        vector<uint32_t> frequencies(PretreeSymbols, 0);
+
+        for (size_t i = 0; i < codes.size(); i++)
+        {
+            frequencies[codes[i].symbol]++;
+        }
+
+        uint8_t pretreeLengths[PretreeSymbols];
+        uint32_t pretreeCodes[PretreeSymbols];
+
+        BuildLengths(frequencies, MaxPretreeBits, pretreeLengths);
+        BuildCodes(pretreeLengths, PretreeSymbols, pretreeCodes);
+
+        for (uint32_t i = 0; i < PretreeSymbols; i++)
+        {
+            bits->Write(pretreeLengths[i], 4);
+        }
+
+        for (size_t i = 0; i < codes.size(); i++)
+        {
+            bits->Write(pretreeCodes[codes[i].symbol], pretreeLengths[codes[i].symbol]);
+            bits->Write(codes[i].extra, codes[i].extraBits);
+        }
+
+        memcpy(previous + first, lengths + first, last - first);
+    }
+
+
+    uint32_t Hash(uint8_t const* data)
+    {
+        return ((data[0] << 16 | data[1] << 8 | data[2]) * 2654435761u) >> (32 - HashBits);
+    }
+}
+
+
+vector<uint8_t> CompressLzx(uint8_t const* input, uint32_t inputSize)
+{
+    vector<uint8_t> output;
+
+    // Hash chains over the last 32k, for finding matches.
+    vector<uint32_t> head(1 << HashBits, UINT32_MAX);
+    vector<uint32_t> chain(FrameSize, UINT32_MAX);
+
+    // Tree lengths carry over from one block to the next, as changes are all that is stored.
+    uint8_t previousMain[MainTreeSymbols] = { 0 };
+    uint8_t previousLength[NumSecondaryLengths] = { 0 };
+
+    uint32_t recentOffset = 1;
+
+    for (uint32_t frameStart = 0; frameStart < inputSize; frameStart += FrameSize)
+    {
+        uint32_t frameEnd = min(frameStart + (uint32_t)FrameSize, inputSize);
+        vector<Symbol> symbols;
+
+        // Greedy matching. Matches may reach back into earlier frames, but not run past this one.
+        for (uint32_t position = frameStart; position < frameEnd;)
+        {
+            uint32_t bestLength = 0;
+            uint32_t bestOffset = 0;
+            uint32_t limit = min((uint32_t)MaxMatch, frameEnd - position);
+
+            if (limit >= MinMatch)
+            {
+                uint32_t hash = Hash(input + position);
+                uint32_t candidate = head[hash];
+
+                for (int tries = 0; tries < MaxChain && candidate != UINT32_MAX && position - candidate <= MaxOffset; tries++)
+                {
+                    uint32_t length = 0;
+
+                    while (length < limit && input[candidate + length] == input[position + length])
+                    {
+                        length++;
+                    }
+
+                    if (length > bestLength)
+                    {
+                        bestLength = length;
+                        bestOffset = position - candidate;
+                    }
+
+                    uint32_t older = chain[candidate % FrameSize];
+
+                    if (older == UINT32_MAX || older >= candidate)
+                    {
+                        break;
+                    }
+
+                    candidate = older;
+                }
+            }
+
+            uint32_t advance = bestLength >= MinMatch ? bestLength : 1;
+
+            // Every position covered goes into the chains, so later matches can find it.
+            for (uint32_t i = position; i < position + advance && i + MinMatch <= inputSize; i++)
+            {
+                uint32_t hash = Hash(input + i);
+
+                chain[i % FrameSize] = head[hash];
+                head[hash] = i;
+            }
+
+            Symbol symbol;
+
+            if (advance == 1)
+            {
+                symbol.main = input[position];
+                symbol.length = -1;
+                symbol.footerBits = 0;
+                symbol.footer = 0;
+            }
+            else
+            {
+                uint32_t slot = 0;
+                uint32_t lengthHeader = min(bestLength - 2, (uint32_t)NumPrimaryLengths);
+
+                symbol.footerBits = 0;
+                symbol.footer = 0;
+
+                // The last offset used again needs no footer.
+                if (bestOffset != recentOffset)
+                {
+                    uint32_t formatted = bestOffset + 2;
+
+                    for (slot = 3; positionBase[slot + 1] <= formatted; slot++)
+                    {
+                    }
+
+                    symbol.footerBits = extraBits[slot];
+                    symbol.footer = formatted - positionBase[slot];
+                    recentOffset = bestOffset;
+                }
+
+                symbol.main = (uint16_t)(NumChars + slot * 8 + lengthHeader);
+                symbol.length = lengthHeader == NumPrimaryLengths ? (int16_t)(bestLength - 2 - NumPrimaryLengths) : -1;
+            }
+
+            symbols.push_back(symbol);
+            position += advance;
+        }
+
+        vector<uint32_t> mainFrequencies(MainTreeSymbols, 0);
+        vector<uint32_t> lengthFrequencies(NumSecondaryLengths, 0);
+
+        for (size_t i = 0; i < symbols.size(); i++)
+        {
+            mainFrequencies[symbols[i].main]++;
+
+            if (symbols[i].length >= 0)
+            {
+                lengthFrequencies[symbols[i].length]++;
+            }
+        }
+
+        uint8_t mainLengths[MainTreeSymbols];
+        uint8_t lengthLengths[NumSecondaryLengths];
+        uint32_t mainCodes[MainTreeSymbols];
+        uint32_t lengthCodes[NumSecondaryLengths];
+
+        BuildLengths(mainFrequencies, MaxCodeBits, mainLengths);
+        BuildLengths(lengthFrequencies, MaxCodeBits, lengthLengths);
+        BuildCodes(mainLengths, MainTreeSymbols, mainCodes);
+        BuildCodes(lengthLengths, NumSecondaryLengths, lengthCodes);
+
+        vector<uint8_t> frame;
+        BitWriter bits(&frame);
+
+        // No Intel E8 call translation.
+        if (frameStart == 0)
+        {
+            bits.Write(0, 1);
+        }
+
+        // A verbatim block covering the frame.
+        uint32_t blockSize = frameEnd - frameStart;
+
+        bits.Write(1, 3);
+        bits.Write(blockSize >> 8, 16);
+        bits.Write(blockSize & 0xFF, 8);
+
+        WriteLengths(&bits, mainLengths, previousMain, 0, NumChars);
+        WriteLengths(&bits, mainLengths, previousMain, NumChars, MainTreeSymbols);
+        WriteLengths(&bits, lengthLengths, previousLength, 0, NumSecondaryLengths);
+
+        for (size_t i = 0; i < symbols.size(); i++)
+        {
+            Symbol const& symbol = symbols[i];
+
+            bits.Write(mainCodes[symbol.main], mainLengths[symbol.main]);
+
+            if (symbol.length >= 0)
+            {
+                bits.Write(lengthCodes[symbol.length], lengthLengths[symbol.length]);
+            }
+
+            bits.Write(symbol.footer, symbol.footerBits);
+        }
+
+        bits.Flush();
+
+        // Full frames give just their compressed size; a short last frame gives its own size first.
+        if (blockSize != FrameSize)
+        {
+            output.push_back(0xFF);
+            output.push_back((uint8_t)(blockSize >> 8));
+            output.push_back((uint8_t)blockSize);
+        }
+
+        output.push_back((uint8_t)(frame.size() >> 8));
+        output.push_back((uint8_t)frame.size());
+        output.insert(output.end(), frame.begin(), frame.end());
+    }
+
+    return output;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+using namespace std;
+
+
+// Compresses data into the LZX stream XNA Game Studio puts in compressed .xnb files: a 64k
+// window, cut into 32k frames that each start with a small size header. Matching is greedy
+// and each frame is a single verbatim block, so the output is bigger than XNA's own, but it
+// only uses what XNA's does and reads back through the same decoder.
+vector<uint8_t> CompressLzx(uint8_t const* input, uint32_t inputSize);
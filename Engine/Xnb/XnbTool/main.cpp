@@ -0,0 +1,923 @@
+// Command line tool for checking and measuring XNB content, with no dependency on
+// Direct3D or Windows, so it can run on a headless build machine.
+//
+// Usage:
+//   xnbtool dump [-l level] <paths...>         Parses each file, printing everything that is read, or just the
+//                                              header and type readers with -l summary.
+//   xnbtool validate <paths...>                Parses each file, listing any that fail. Exits with 1 on failure.
+//   xnbtool bench [-n iterations] [-l level] <paths...>
+//                                              Measures parse throughput (MB/s, files/s) and allocations per file.
+//                                              -l summary|inspect measures the cost of logging with no output.
+//   xnbtool compare [-n iterations] [files...] Compares the old per-byte stdio path against the buffered and
+//                                              memory mapped BinaryReader paths, then compares parsing raw
+//                                              XNB files against LZ4 and LZX compressed copies of them.
+//   xnbtool check [files...]                   Checks that the LZX sample in TestData decodes to exactly the XNB it
+//                                              was made from, then that each XNB file survives LZ4 and LZX
+//                                              compression unchanged and still parses. Exits with 1 on failure.
+//
+// Directories are searched recursively for .xnb files. With no files, compare runs over the
+// XNB models plus the Sponza and powerplant textures, and check over the XNB models, using paths
+// relative to this project directory.
+// Other files passed to compare (eg. .dds) have no XNB reader, so just have their contents
+// pulled through the reader with bulk reads.
+
+#include "../stdafx.h"
+#include "../ContentReader.h"
+#include "../Lz4Decoder.h"
+#include "../LzxDecoder.h"
+#include "../MappedFile.h"
+#include "../XnbParser.h"
+#include "LzxCompressor.h"
+
+#include <atomic>
+#include <chrono>
+#include <new>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <dirent.h>
+#endif
+
+
+// Every allocation made by the process is counted, so bench can report allocations per file.
+static atomic<uint64_t> allocationCount(0);
+
+// The replacement new and deletes are kept out of line. Inlined, GCC sees malloc paired with
+// operator delete, or operator new with free, and warns that they don't match.
+#ifdef _MSC_VER
+#define ALLOCATOR_NOINLINE __declspec(noinline)
+#else
+#define ALLOCATOR_NOINLINE __attribute__((noinline))
+#endif
+
+
+ALLOCATOR_NOINLINE void* operator new(size_t size)
+{
+    allocationCount++;
+
+    void* result = malloc(size ? size : 1);
+
+    if (!result)
+    {
+        throw bad_alloc();
+    }
+
+    return result;
+}
+
+
+ALLOCATOR_NOINLINE void operator delete(void* pointer) throw()
+{
+    free(pointer);
+}
+
+
+// C++14 compilers free through this when they know the size.
+ALLOCATOR_NOINLINE void operator delete(void* pointer, size_t) throw()
+{
+    free(pointer);
+}
+
+
+static char const* defaultFiles[] =
+{
+    "../../../media/cube/Cats.xnb",
+    "../../../media/cube/Cylinder.xnb",
+    "../../../media/cube/Sphere.xnb",
+    "../../../media/cube/SpaceShip.xnb",
+    "../../../media/cube/android.xnb",
+    "../../../media/cube/seafloor.dds",
+    "../../../media/Sponza/background.dds",
+    "../../../media/Sponza/chain_texture.dds",
+    "../../../media/Sponza/sponza_arch_diff.dds",
+    "../../../media/Sponza/sponza_floor_a_diff.dds",
+    "../../../media/Sponza/sponza_roof_diff.dds",
+    "../../../media/powerplant/basket_map.dds",
+    "../../../media/powerplant/command_a.dds",
+    "../../../media/powerplant/container_grn_num.dds",
+    "../../../media/powerplant/crane_wheel.dds",
+};
+
+
+// Compressed XNB files made with CompressLzx, each with the uncompressed file it was made from.
+static char const* checkFixtures[][2] =
+{
+    { "TestData/Sphere.lzx.xnb", "../../../media/cube/Sphere.xnb" },
+};
+
+
+static bool IsXnb(string const& fileName)
+{
+    return fileName.size() > 4 && fileName.compare(fileName.size() - 4, 4, ".xnb") == 0;
+}
+
+
+// Runs the parser (or a plain bulk read for non-XNB files) over a reader.
+static uint32_t Consume(ContentReader& reader, bool isXnb)
+{
+    if (isXnb)
+    {
+        reader.ReadXnb();
+        return reader.FilePosition();
+    }
+
+    ArrayView<uint8_t> bytes = reader.ReadBytes(reader.FileSize() - reader.FilePosition());
+
+    // Touch every byte, so the mapped path has to actually page the data in.
+    uint32_t sum = 0;
+
+    for (uint32_t i = 0; i < bytes.size(); i++)
+    {
+        sum += bytes[i];
+    }
+
+    return sum;
+}
+
+
+// Old behavior: every byte fetched with its own fgetc call. This only counts the I/O,
+// so is a lower bound on what the old reader cost.
+static uint32_t LoadPerByte(char const* fileName, TypeReaderManager*)
+{
+    FILE* file = fopen(fileName, "rb");
+
+    if (!file)
+    {
+        throw runtime_error("Can't open file.");
+    }
+
+    uint32_t sum = 0;
+    int value;
+
+    while ((value = fgetc(file)) != EOF)
+    {
+        sum += (uint8_t)value;
+    }
+
+    fclose(file);
+
+    return sum;
+}
+
+
+// Whole file read into an owned buffer with a single fread.
+static uint32_t LoadBuffered(char const* fileName, TypeReaderManager* typeReaderManager)
+{
+    FILE* file = fopen(fileName, "rb");
+
+    if (!file)
+    {
+        throw runtime_error("Can't open file.");
+    }
+
+    uint32_t result;
+
+    try
+    {
+        ContentReader reader(file, typeReaderManager);
+
+        result = Consume(reader, IsXnb(fileName));
+    }
+    catch (...)
+    {
+        fclose(file);
+        throw;
+    }
+
+    fclose(file);
+
+    return result;
+}
+
+
+// File memory mapped and parsed in place.
+static uint32_t LoadMapped(char const* fileName, TypeReaderManager* typeReaderManager, LogLevel logLevel)
+{
+    MappedFile file(fileName);
+
+    ContentReader reader(file.Data(), file.Size(), typeReaderManager);
+
+    reader.Log.SetLevel(logLevel);
+
+    return Consume(reader, IsXnb(fileName));
+}
+
+
+static uint32_t LoadMapped(char const* fileName, TypeReaderManager* typeReaderManager)
+{
+    return LoadMapped(fileName, typeReaderManager, LogNone);
+}
+
+
+// Greedy LZ4 block compressor, good enough to produce test content for the decoder.
+static vector<uint8_t> CompressLz4(uint8_t const* input, uint32_t inputSize)
+{
+    vector<uint8_t> output;
+
+    output.reserve(inputSize + inputSize / 255 + 16);
+
+    vector<uint32_t> hashTable(1 << 16, UINT32_MAX);
+
+    uint32_t position = 0;
+    uint32_t literalStart = 0;
+
+    // The format requires the last match to start at least 12 bytes from the end, and the final 5 bytes to be literals.
+    uint32_t matchLimit = (inputSize > 12) ? inputSize - 12 : 0;
+
+    while (position < matchLimit)
+    {
+        uint32_t sequence;
+
+        memcpy(&sequence, input + position, sizeof(sequence));
+
+        uint32_t hash = (sequence * 2654435761u) >> 16;
+        uint32_t candidate = hashTable[hash];
+
+        hashTable[hash] = position;
+
+        if (candidate == UINT32_MAX ||
+            position - candidate > 65535 ||
+            memcmp(input + candidate, input + position, 4) != 0)
+        {
+            position++;
+            continue;
+        }
+
+        uint32_t matchLength = 4;
+
+        while (position + matchLength < inputSize - 5 && input[candidate + matchLength] == input[position + matchLength])
+        {
+            matchLength++;
+        }
+
+        // Token, then literal length, literals, offset and match length.
+        uint32_t literalLength = position - literalStart;
+
+        output.push_back((uint8_t)((min(literalLength, 15u) << 4) | min(matchLength - 4, 15u)));
+
+        if (literalLength >= 15)
+        {
+            uint32_t remaining = literalLength - 15;
+
+            for (; remaining >= 255; remaining -= 255)
+            {
+                output.push_back(255);
+            }
+
+            output.push_back((uint8_t)remaining);
+        }
+
+        output.insert(output.end(), input + literalStart, input + position);
+
+        uint32_t offset = position - candidate;
+
+        output.push_back((uint8_t)offset);
+        output.push_back((uint8_t)(offset >> 8));
+
+        if (matchLength - 4 >= 15)
+        {
+            uint32_t remaining = matchLength - 4 - 15;
+
+            for (; remaining >= 255; remaining -= 255)
+            {
+                output.push_back(255);
+            }
+
+            output.push_back((uint8_t)remaining);
+        }
+
+        position += matchLength;
+        literalStart = position;
+    }
+
+    // Final literal run.
+    uint32_t literalLength = inputSize - literalStart;
+
+    output.push_back((uint8_t)(min(literalLength, 15u) << 4));
+
+    if (literalLength >= 15)
+    {
+        uint32_t remaining = literalLength - 15;
+
+        for (; remaining >= 255; remaining -= 255)
+        {
+            output.push_back(255);
+        }
+
+        output.push_back((uint8_t)remaining);
+    }
+
+    output.insert(output.end(), input + literalStart, input + inputSize);
+
+    return output;
+}
+
+
+// XNB header flags for each kind of compression.
+static const uint8_t CompressedLzx = 0x80;
+static const uint8_t CompressedLz4 = 0x40;
+
+
+// Builds an LZ4 or LZX compressed version of an uncompressed XNB file.
+static vector<uint8_t> MakeCompressedXnb(uint8_t const* xnb, uint32_t xnbSize, uint8_t compression)
+{
+    const uint32_t headerSize = 10;
+
+    vector<uint8_t> payload = (compression == CompressedLzx) ? CompressLzx(xnb + headerSize, xnbSize - headerSize)
+                                                             : CompressLz4(xnb + headerSize, xnbSize - headerSize);
+
+    uint32_t compressedFileSize = headerSize + 4 + (uint32_t)payload.size();
+    uint32_t decompressedSize = xnbSize - headerSize;
+
+    vector<uint8_t> result(xnb, xnb + 6);
+
+    result[5] |= compression;
+
+    for (int i = 0; i < 4; i++)
+    {
+        result.push_back((uint8_t)(compressedFileSize >> (i * 8)));
+    }
+
+    for (int i = 0; i < 4; i++)
+    {
+        result.push_back((uint8_t)(decompressedSize >> (i * 8)));
+    }
+
+    result.insert(result.end(), payload.begin(), payload.end());
+
+    return result;
+}
+
+
+// Times parsing a set of XNB files that are already in memory, so only decode cost is measured.
+static void MeasureInMemory(char const* name, vector<vector<uint8_t>> const& images, uint64_t decompressedBytes, int iterations, TypeReaderManager* typeReaderManager)
+{
+    typedef std::chrono::high_resolution_clock Clock;
+
+    uint64_t diskBytes = 0;
+
+    for (size_t i = 0; i < images.size(); i++)
+    {
+        diskBytes += images[i].size();
+    }
+
+    Clock::time_point start = Clock::now();
+
+    for (int iteration = 0; iteration < iterations; iteration++)
+    {
+        for (size_t i = 0; i < images.size(); i++)
+        {
+            ContentReader reader(&images[i][0], (uint32_t)images[i].size(), typeReaderManager);
+
+            reader.ReadXnb();
+        }
+    }
+
+    double seconds = std::chrono::duration_cast<std::chrono::duration<double>>(Clock::now() - start).count();
+
+    double megabytes = (double)decompressedBytes * iterations / (1024.0 * 1024.0);
+
+    printf("%-10s %10.3f ms %10.1f MB/s %10.1f files/s   (%.2f MB on disk)\n",
+           name,
+           seconds * 1000.0,
+           megabytes / seconds,
+           images.size() * iterations / seconds,
+           diskBytes / (1024.0 * 1024.0));
+}
+
+
+typedef uint32_t (*LoadFunction)(char const* fileName, TypeReaderManager* typeReaderManager);
+
+
+static void Measure(char const* name, LoadFunction load, vector<string> const& files, uint64_t totalBytes, int iterations, TypeReaderManager* typeReaderManager)
+{
+    typedef std::chrono::high_resolution_clock Clock;
+
+    uint32_t checksum = 0;
+
+    // Warm the OS file cache so every path is measured against the same state.
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        checksum += load(files[i].c_str(), typeReaderManager);
+    }
+
+    Clock::time_point start = Clock::now();
+
+    for (int iteration = 0; iteration < iterations; iteration++)
+    {
+        for (size_t i = 0; i < files.size(); i++)
+        {
+            checksum += load(files[i].c_str(), typeReaderManager);
+        }
+    }
+
+    double seconds = std::chrono::duration_cast<std::chrono::duration<double>>(Clock::now() - start).count();
+
+    double megabytes = (double)totalBytes * iterations / (1024.0 * 1024.0);
+
+    printf("%-10s %10.3f ms %10.1f MB/s %10.1f files/s   (checksum %08X)\n",
+           name,
+           seconds * 1000.0,
+           megabytes / seconds,
+           files.size() * iterations / seconds,
+           checksum);
+}
+
+
+// Lists the contents of a directory, returning false if the path is not a directory.
+static bool ListDirectory(string const& path, vector<string>* entries)
+{
+#ifdef _WIN32
+    WIN32_FIND_DATAA findData;
+    HANDLE find = FindFirstFileA((path + "\\*").c_str(), &findData);
+
+    if (find == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    do
+    {
+        entries->push_back(findData.cFileName);
+    }
+    while (FindNextFileA(find, &findData));
+
+    FindClose(find);
+#else
+    DIR* directory = opendir(path.c_str());
+
+    if (!directory)
+    {
+        return false;
+    }
+
+    while (dirent* entry = readdir(directory))
+    {
+        entries->push_back(entry->d_name);
+    }
+
+    closedir(directory);
+#endif
+
+    // Sort so the order (and so the output) doesn't depend on the file system.
+    sort(entries->begin(), entries->end());
+
+    return true;
+}
+
+
+// Adds a file, or every .xnb file found under a directory. Files named
+// explicitly on the command line are added whatever their extension.
+static void AddPath(string const& path, bool isExplicit, vector<string>* files)
+{
+    vector<string> entries;
+
+    if (!ListDirectory(path, &entries))
+    {
+        if (isExplicit || IsXnb(path))
+        {
+            files->push_back(path);
+        }
+
+        return;
+    }
+
+    for (string const& entry : entries)
+    {
+        if (entry != "." && entry != "..")
+        {
+            AddPath(path + "/" + entry, false, files);
+        }
+    }
+}
+
+
+static int Dump(vector<string> const& files, LogLevel logLevel)
+{
+    int failures = 0;
+
+    for (string const& fileName : files)
+    {
+        printf("%s\n", fileName.c_str());
+
+        try
+        {
+            MappedFile file(fileName.c_str());
+
+            ContentReader reader(file.Data(), file.Size(), XnbParser::StandardTypeReaders());
+
+            reader.Log.SetOutput(stdout, logLevel);
+            reader.ReadXnb();
+        }
+        catch (exception& e)
+        {
+            printf("\nError: %s\n", e.what());
+            failures++;
+        }
+
+        printf("\n");
+    }
+
+    return failures ? 1 : 0;
+}
+
+
+static int Validate(vector<string> const& files)
+{
+    int failures = 0;
+
+    for (string const& fileName : files)
+    {
+        try
+        {
+            MappedFile file(fileName.c_str());
+
+            ContentReader reader(file.Data(), file.Size(), XnbParser::StandardTypeReaders());
+
+            reader.ReadXnb();
+        }
+        catch (exception& e)
+        {
+            printf("FAIL %s: %s\n", fileName.c_str(), e.what());
+            failures++;
+        }
+    }
+
+    printf("%u files, %d failed\n", (uint32_t)files.size(), failures);
+
+    return failures ? 1 : 0;
+}
+
+
+static int Bench(vector<string> const& files, int iterations, LogLevel logLevel)
+{
+    typedef std::chrono::high_resolution_clock Clock;
+
+    TypeReaderManager* typeReaderManager = XnbParser::StandardTypeReaders();
+
+    // Drop anything that is missing or does not parse. This also warms the OS file cache,
+    // and the type reader lookups, so only steady state loading is measured.
+    vector<string> validFiles;
+    uint64_t totalBytes = 0;
+
+    for (string const& fileName : files)
+    {
+        try
+        {
+            LoadMapped(fileName.c_str(), typeReaderManager);
+
+            validFiles.push_back(fileName);
+            totalBytes += MappedFile(fileName.c_str()).Size();
+        }
+        catch (exception& e)
+        {
+            printf("Skipping '%s': %s\n", fileName.c_str(), e.what());
+        }
+    }
+
+    if (validFiles.empty())
+    {
+        printf("Error: no files to load.\n");
+        return 1;
+    }
+
+    uint64_t startAllocations = allocationCount;
+
+    Clock::time_point start = Clock::now();
+
+    for (int iteration = 0; iteration < iterations; iteration++)
+    {
+        for (string const& fileName : validFiles)
+        {
+            LoadMapped(fileName.c_str(), typeReaderManager, logLevel);
+        }
+    }
+
+    double seconds = std::chrono::duration_cast<std::chrono::duration<double>>(Clock::now() - start).count();
+
+    uint64_t allocations = allocationCount - startAllocations;
+    double loads = (double)validFiles.size() * iterations;
+
+    printf("%u files, %.2f MB, %d iterations\n", (uint32_t)validFiles.size(), totalBytes / (1024.0 * 1024.0), iterations);
+    printf("%10.3f ms %10.1f MB/s %10.1f files/s %10.1f allocations/file\n",
+           seconds * 1000.0,
+           totalBytes * iterations / (1024.0 * 1024.0) / seconds,
+           loads / seconds,
+           allocations / loads);
+
+    return 0;
+}
+
+
+static int Compare(vector<string> const& files, int iterations)
+{
+    TypeReaderManager typeReaderManager;
+
+    typeReaderManager.RegisterStandardTypes();
+
+    // Drop anything that is missing or does not parse, so all paths see the same set.
+    vector<string> validFiles;
+    uint64_t totalBytes = 0;
+
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        try
+        {
+            LoadMapped(files[i].c_str(), &typeReaderManager);
+
+            validFiles.push_back(files[i]);
+            totalBytes += MappedFile(files[i].c_str()).Size();
+        }
+        catch (exception& e)
+        {
+            printf("Skipping '%s': %s\n", files[i].c_str(), e.what());
+        }
+    }
+    if (validFiles.empty())
+    {
+        printf("Error: no files to load.\n");
+        return 1;
+    }
+
+    printf("%u files, %.2f MB, %d iterations\n\n", (uint32_t)validFiles.size(), totalBytes / (1024.0 * 1024.0), iterations);
+
+    Measure("fgetc", LoadPerByte, validFiles, totalBytes, iterations, &typeReaderManager);
+    Measure("fread", LoadBuffered, validFiles, totalBytes, iterations, &typeReaderManager);
+    Measure("mmap", LoadMapped, validFiles, totalBytes, iterations, &typeReaderManager);
+
+    // Compare raw against compressed loads of the uncompressed XNB files.
+    vector<vector<uint8_t>> rawImages;
+    vector<vector<uint8_t>> lz4Images;
+    vector<vector<uint8_t>> lzxImages;
+    uint64_t rawBytes = 0;
+
+    for (size_t i = 0; i < validFiles.size(); i++)
+    {
+        if (!IsXnb(validFiles[i]))
+        {
+            continue;
+        }
+
+        MappedFile file(validFiles[i].c_str());
+
+        if (file.Size() < 10 || (file.Data()[5] & 0xC0))
+        {
+            continue;
+        }
+
+        rawImages.push_back(vector<uint8_t>(file.Data(), file.Data() + file.Size()));
+        lz4Images.push_back(MakeCompressedXnb(file.Data(), file.Size(), CompressedLz4));
+        lzxImages.push_back(MakeCompressedXnb(file.Data(), file.Size(), CompressedLzx));
+
+        rawBytes += file.Size();
+    }
+
+    if (!rawImages.empty())
+    {
+        printf("\n%u uncompressed XNB files, parsed from memory\n\n", (uint32_t)rawImages.size());
+
+        MeasureInMemory("raw", rawImages, rawBytes, iterations, &typeReaderManager);
+        MeasureInMemory("lz4", lz4Images, rawBytes, iterations, &typeReaderManager);
+        MeasureInMemory("lzx", lzxImages, rawBytes, iterations, &typeReaderManager);
+    }
+
+    return 0;
+}
+
+
+// Decompresses a compressed XNB file back into the uncompressed file it was made from.
+static vector<uint8_t> DecompressXnb(vector<uint8_t> const& xnb)
+{
+    const uint32_t headerSize = 10;
+
+    if (xnb.size() < headerSize + 4 || !(xnb[5] & (CompressedLzx | CompressedLz4)))
+    {
+        throw runtime_error("Not a compressed XNB file.");
+    }
+
+    uint32_t decompressedSize = xnb[10] | (xnb[11] << 8) | (xnb[12] << 16) | ((uint32_t)xnb[13] << 24);
+    uint32_t fileSize = headerSize + decompressedSize;
+
+    vector<uint8_t> result(xnb.begin(), xnb.begin() + 6);
+
+    result[5] &= ~(CompressedLzx | CompressedLz4);
+
+    for (int i = 0; i < 4; i++)
+    {
+        result.push_back((uint8_t)(fileSize >> (i * 8)));
+    }
+
+    result.resize(fileSize);
+
+    uint8_t const* payload = &xnb[headerSize + 4];
+    uint32_t payloadSize = (uint32_t)xnb.size() - headerSize - 4;
+
+    if (decompressedSize)
+    {
+        if (xnb[5] & CompressedLzx)
+        {
+            LzxDecoder decoder;
+
+            decoder.Decompress(payload, payloadSize, &result[headerSize], decompressedSize);
+        }
+        else
+        {
+            DecompressLz4(payload, payloadSize, &result[headerSize], decompressedSize);
+        }
+    }
+
+    return result;
+}
+
+
+// Throws unless a compressed XNB file decompresses to exactly the original, and parses.
+static void CheckCompressed(vector<uint8_t> const& compressed, vector<uint8_t> const& original, TypeReaderManager* typeReaderManager)
+{
+    if (DecompressXnb(compressed) != original)
+    {
+        throw runtime_error("decompressed data differs from the original.");
+    }
+
+    ContentReader reader(&compressed[0], (uint32_t)compressed.size(), typeReaderManager);
+
+    reader.ReadXnb();
+}
+
+
+static vector<uint8_t> ReadFile(string const& fileName)
+{
+    MappedFile file(fileName.c_str());
+
+    return vector<uint8_t>(file.Data(), file.Data() + file.Size());
+}
+
+
+static int Check(vector<string> const& files)
+{
+    TypeReaderManager* typeReaderManager = XnbParser::StandardTypeReaders();
+
+    int checks = 0;
+    int failures = 0;
+
+    // Samples compressed ahead of time, which catch the compressor and decoder changing in step.
+    for (size_t i = 0; files.empty() && i < sizeof(checkFixtures) / sizeof(checkFixtures[0]); i++)
+    {
+        checks++;
+
+        try
+        {
+            CheckCompressed(ReadFile(checkFixtures[i][0]), ReadFile(checkFixtures[i][1]), typeReaderManager);
+        }
+        catch (exception& e)
+        {
+            printf("FAIL %s: %s\n", checkFixtures[i][0], e.what());
+            failures++;
+        }
+    }
+
+    vector<string> roundTripFiles = files;
+
+    if (roundTripFiles.empty())
+    {
+        for (size_t i = 0; i < sizeof(defaultFiles) / sizeof(defaultFiles[0]); i++)
+        {
+            if (IsXnb(defaultFiles[i]))
+            {
+                roundTripFiles.push_back(defaultFiles[i]);
+            }
+        }
+    }
+
+    uint8_t const compressions[] = { CompressedLz4, CompressedLzx };
+    char const* compressionNames[] = { "LZ4", "LZX" };
+
+    for (string const& fileName : roundTripFiles)
+    {
+        for (int i = 0; i < 2; i++)
+        {
+            checks++;
+
+            try
+            {
+                vector<uint8_t> original = ReadFile(fileName);
+
+                if (original.size() < 10 || (original[5] & (CompressedLzx | CompressedLz4)))
+                {
+                    throw runtime_error("not an uncompressed XNB file.");
+                }
+
+                CheckCompressed(MakeCompressedXnb(&original[0], (uint32_t)original.size(), compressions[i]), original, typeReaderManager);
+            }
+            catch (exception& e)
+            {
+                printf("FAIL %s (%s): %s\n", fileName.c_str(), compressionNames[i], e.what());
+                failures++;
+            }
+        }
+    }
+
+    printf("%d checks, %d failed\n", checks, failures);
+
+    return failures ? 1 : 0;
+}
+
+
+static int Usage()
+{
+    printf("Usage: xnbtool dump|validate|bench|compare|check [-n iterations] [-l none|summary|inspect] [files or directories...]\n");
+
+    return 2;
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        return Usage();
+    }
+
+    string command = argv[1];
+
+    int iterations = 20;
+    int firstPath = 2;
+
+    LogLevel logLevel = (command == "dump") ? LogInspect : LogNone;
+
+    while (firstPath + 1 < argc && argv[firstPath][0] == '-')
+    {
+        string option = argv[firstPath];
+        string value = argv[firstPath + 1];
+
+        if (option == "-n")
+        {
+            iterations = max(atoi(value.c_str()), 1);
+        }
+        else if (option == "-l" && value == "none")
+        {
+            logLevel = LogNone;
+        }
+        else if (option == "-l" && value == "summary")
+        {
+            logLevel = LogSummary;
+        }
+        else if (option == "-l" && value == "inspect")
+        {
+            logLevel = LogInspect;
+        }
+        else
+        {
+            return Usage();
+        }
+
+        firstPath += 2;
+    }
+
+    if (logLevel > XNB_LOG_LEVEL)
+    {
+        printf("Warning: logging above level %d is compiled out of this build.\n", XNB_LOG_LEVEL);
+    }
+
+    vector<string> files;
+
+    for (int i = firstPath; i < argc; i++)
+    {
+        AddPath(argv[i], true, &files);
+    }
+
+    if (command == "compare")
+    {
+        if (files.empty())
+        {
+            files.assign(defaultFiles, defaultFiles + sizeof(defaultFiles) / sizeof(defaultFiles[0]));
+        }
+
+        return Compare(files, iterations);
+    }
+
+    if (command == "check")
+    {
+        return Check(files);
+    }
+
+    if (files.empty())
+    {
+        return Usage();
+    }
+
+    if (command == "dump")
+    {
+        return Dump(files, logLevel);
+    }
+    else if (command == "validate")
+    {
+        return Validate(files);
+    }
+    else if (command == "bench")
+    {
+        return Bench(files, iterations, logLevel);
+    }
+
+    return Usage();
+}
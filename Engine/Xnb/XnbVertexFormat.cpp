@@ -0,0 +1,137 @@
+#include "stdafx.h"
+#include "XnbVertexFormat.h"
+
+
+uint32_t VertexElementSize(int32_t format)
+{
+    switch (format)
+    {
+        case ElementFormatSingle:           return 4;
+        case ElementFormatVector2:          return 8;
+        case ElementFormatVector3:          return 12;
+        case ElementFormatVector4:          return 16;
+        case ElementFormatColor:            return 4;
+        case ElementFormatByte4:            return 4;
+        case ElementFormatShort2:           return 4;
+        case ElementFormatShort4:           return 8;
+        case ElementFormatNormalizedShort2: return 4;
+        case ElementFormatNormalizedShort4: return 8;
+        case ElementFormatHalfVector2:      return 4;
+        case ElementFormatHalfVector4:      return 8;
+        default:                            return 0;
+    }
+}
+
+
+// Converts an IEEE half precision value to float.
+static float HalfToFloat(uint16_t value)
+{
+    uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1F;
+    uint32_t mantissa = value & 0x3FF;
+    uint32_t bits;
+
+    if (exponent == 0x1F)
+    {
+        // Infinity or NaN.
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    }
+    else if (exponent)
+    {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    else if (mantissa)
+    {
+        // Denormal: renormalize it, as float has the range to represent it exactly.
+        exponent = 113;
+
+        while (!(mantissa & 0x400))
+        {
+            mantissa <<= 1;
+            exponent--;
+        }
+
+        bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+    }
+    else
+    {
+        bits = sign;
+    }
+
+    float result;
+
+    memcpy(&result, &bits, sizeof(result));
+
+    return result;
+}
+
+
+void DecodeVertexElement(uint8_t const* data, int32_t format, float result[4])
+{
+    result[0] = 0;
+    result[1] = 0;
+    result[2] = 0;
+    result[3] = 1;
+
+    switch (format)
+    {
+        case ElementFormatSingle:
+        case ElementFormatVector2:
+        case ElementFormatVector3:
+        case ElementFormatVector4:
+            memcpy(result, data, VertexElementSize(format));
+            break;
+
+        case ElementFormatColor:
+            for (int i = 0; i < 4; i++)
+            {
+                result[i] = data[i] / 255.0f;
+            }
+            break;
+
+        case ElementFormatByte4:
+            for (int i = 0; i < 4; i++)
+            {
+                result[i] = data[i];
+            }
+            break;
+
+        case ElementFormatShort2:
+        case ElementFormatShort4:
+        case ElementFormatNormalizedShort2:
+        case ElementFormatNormalizedShort4:
+        {
+            int componentCount = VertexElementSize(format) / 2;
+            bool isNormalized = (format == ElementFormatNormalizedShort2 || format == ElementFormatNormalizedShort4);
+
+            for (int i = 0; i < componentCount; i++)
+            {
+                int16_t value;
+
+                memcpy(&value, data + i * 2, sizeof(value));
+
+                result[i] = isNormalized ? max(value / 32767.0f, -1.0f) : value;
+            }
+            break;
+        }
+
+        case ElementFormatHalfVector2:
+        case ElementFormatHalfVector4:
+        {
+            int componentCount = VertexElementSize(format) / 2;
+
+            for (int i = 0; i < componentCount; i++)
+            {
+                uint16_t value;
+
+                memcpy(&value, data + i * 2, sizeof(value));
+
+                result[i] = HalfToFloat(value);
+            }
+            break;
+        }
+
+        default:
+            throw runtime_error("Unknown vertex element format.");
+    }
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "XnbObjects.h"
+
+
+// Size in bytes of a VertexElementFormat, or zero if the format is unknown.
+uint32_t VertexElementSize(int32_t format);
+
+// Converts a single vertex element to floats, the way the GPU would when reading it.
+// Components the format does not have are filled in from (0, 0, 0, 1).
+void DecodeVertexElement(uint8_t const* data, int32_t format, float result[4]);
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <wchar.h>
+#include <wctype.h>
+#include <assert.h>
+#include <math.h>
+
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace std;
+
+
+// Source annotations are only understood by the Microsoft compiler.
+#ifndef _MSC_VER
+#define _In_z_
+#define _Printf_format_string_
+#define _Deref_pre_z_
+#endif
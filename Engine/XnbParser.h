@@ -1,9 +0,0 @@
-#include "ContentReader.h"
-#include "XnbModelData.h"
-#include "stdafx.h"
-
-class XnbParser
-{
-public: 
-	ContentReader parse(char*);
-};
\ No newline at end of file
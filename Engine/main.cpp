@@ -27,6 +27,8 @@
 #include "SceneGraph.h"
 #include "PhysXObject.h"
 #include "EnginePhysics.h"
+#include "Profiling/D3D11GpuProfiler.h"
+#include "Profiling/FrameProfiler.h"
 #include <vector>
 
 // Constants
@@ -60,6 +62,10 @@ enum {
     UI_LIGHTSPERPASSTEXT,
     UI_CULLTECHNIQUE,
     UI_MSAA,
+    UI_BATCHDRAWS,
+    UI_PARALLELRECORDING,
+    UI_CULLLIGHTS,
+    UI_OVERLAPPHYSICS,
 };
 
 // List these top to bottom, since it is also the reverse draw order
@@ -89,6 +95,7 @@ CDXUTDialogResourceManager gDialogResourceManager;
 CD3DSettingsDlg gD3DSettingsDlg;
 CDXUTDialog gHUD[HUD_NUM];
 CDXUTCheckBox* gAnimateLightCheck = 0;
+CDXUTCheckBox* gCullLightsCheck = 0;
 CDXUTComboBox* gMSAACombo = 0;
 CDXUTComboBox* gSceneSelectCombo = 0;
 CDXUTComboBox* gCullTechniqueCombo = 0;
@@ -98,6 +105,15 @@ CDXUTTextHelper* gTextHelper = 0;
 
 float gAspectRatio;
 bool gDisplayUI = true;
+
+// Per-pass CPU and GPU times, shown with F7 and written out as a Chrome trace with F6
+FrameProfiler gProfiler;
+D3D11GpuProfiler* gGpuProfiler = 0;
+bool gDisplayProfiler = true;
+static const char* kProfileTracePath = "profile.json";
+
+// Start each physics step a frame before it's due, so it runs alongside rendering
+bool gOverlapPhysics = true;
 bool gZeroNextFrameTime = true;
 
 // Any UI state passed directly to rendering shaders
@@ -244,9 +260,21 @@ void InitUI()
         HUD->AddCheckBox(UI_VISUALIZEPERSAMPLESHADING, L"Visualize Shading Freq.", 0, y, width, 23, gUIConstants.visualizePerSampleShading != 0);
         y += 26;
 
+        HUD->AddCheckBox(UI_BATCHDRAWS, L"Batch Scene Draws", 0, y, width, 23, sceneGraph.GetBatching());
+        y += 26;
+
+        HUD->AddCheckBox(UI_PARALLELRECORDING, L"Record On Worker Threads", 0, y, width, 23, sceneGraph.GetParallelRecording());
+        y += 26;
+
+        HUD->AddCheckBox(UI_CULLLIGHTS, L"Cull Lights On CPU", 0, y, width, 23, true, 0, false, &gCullLightsCheck);
+        y += 26;
+
+        HUD->AddCheckBox(UI_OVERLAPPHYSICS, L"Overlap Physics", 0, y, width, 23, gOverlapPhysics);
+        y += 26;
+
         HUD->AddStatic(UI_LIGHTSTEXT, L"Lights:", 0, y, width, 23);
         y += 26;
-        HUD->AddSlider(UI_LIGHTS, 0, y, width, 23, 0, MAX_LIGHTS_POWER, MAX_LIGHTS_POWER, false, &gLightsSlider);
+        HUD->AddSlider(UI_LIGHTS, 0, y, width, 23, 0, MAX_LIGHTS_POWER, DEFAULT_LIGHTS_POWER, false, &gLightsSlider);
         y += 26;
 #pragma endregion
 
@@ -259,6 +287,8 @@ void InitUI()
         gCullTechniqueCombo->AddItem(L"Quad", ULongToPtr(CULL_QUAD));
         gCullTechniqueCombo->AddItem(L"Quad Deferred Light", ULongToPtr(CULL_QUAD_DEFERRED_LIGHTING));
         gCullTechniqueCombo->AddItem(L"Compute Shader Tile", ULongToPtr(CULL_COMPUTE_SHADER_TILE));
+        gCullTechniqueCombo->AddItem(L"Clustered Deferred", ULongToPtr(CULL_CLUSTERED));
+        gCullTechniqueCombo->AddItem(L"Clustered Forward", ULongToPtr(CULL_FORWARD_CLUSTERED));
         gCullTechniqueCombo->SetSelectedByData(ULongToPtr(gUIConstants.lightCullTechnique));
 #pragma endregion
 
@@ -283,7 +313,18 @@ void InitUI()
 
 void UpdateUIState()
 {
-    //int technique = PtrToUint(gCullTechniqueCombo->GetSelectedData());
+    unsigned int technique = PtrToUint(gCullTechniqueCombo->GetSelectedData());
+
+    // The tiled compute shader silently drops lights past its per tile limit, so never offer more
+    // lights than one tile can hold. Clamping the slider sends no event, so update the app here.
+    int maxLightsPower = (technique == CULL_COMPUTE_SHADER_TILE) ? COMPUTE_SHADER_TILE_MAX_LIGHTS_POWER : MAX_LIGHTS_POWER;
+    int lightsPower = gLightsSlider->GetValue();
+
+    gLightsSlider->SetRange(0, maxLightsPower);
+
+    if (gApp && gLightsSlider->GetValue() != lightsPower) {
+        gApp->SetActiveLights(DXUTGetD3D11Device(), 1 << gLightsSlider->GetValue());
+    }
 }
 
 
@@ -295,6 +336,8 @@ void InitApp(ID3D11Device* d3dDevice)
     // Get current UI settings
     unsigned int msaaSamples = PtrToUint(gMSAACombo->GetSelectedData());
     gApp = new App(d3dDevice, 1 << gLightsSlider->GetValue(), msaaSamples);
+    gApp->SetLightCulling(gCullLightsCheck->GetChecked());
+    gApp->SetProfilers(&gProfiler, gGpuProfiler);
 
     // Initialize with the current surface description
     gApp->OnD3D11ResizedSwapChain(d3dDevice, DXUTGetDXGIBackBufferSurfaceDesc());
@@ -472,8 +515,9 @@ void InitScene(ID3D11Device* d3dDevice)
 			{
 				//(*cubeList)[i]->id = sceneGraph.Add(d3dDevice, L"..\\media\\cube\\cube.sdkmesh",
 				//	(*cubeList)[i]->x, (*cubeList)[i]->y, (*cubeList)[i]->z, (*cubeList)[i]->sx, (*cubeList)[i]->sy, (*cubeList)[i]->sz);
+				//Placed at the origin; the first physics update moves every object into place
 				(*cubeList)[i]->id = sceneGraph.AddXnb(d3dDevice, "..\\media\\cube\\Sphere.xnb",
-					(*cubeList)[i]->x, (*cubeList)[i]->y, (*cubeList)[i]->z, (*cubeList)[i]->sx, (*cubeList)[i]->sy, (*cubeList)[i]->sz);
+					0, 0, 0, (*cubeList)[i]->sx, (*cubeList)[i]->sy, (*cubeList)[i]->sz);
 			}
 /*
 			for(float x =0; x<15;x+=5)
@@ -598,6 +642,14 @@ void CALLBACK OnKeyboard(UINT character, bool keyDown, bool altDown, void* userC
         case VK_F9:
             // Toggle display of UI on/off
             gDisplayUI = !gDisplayUI;
+            break;
+        case VK_F7:
+            // Toggle display of per-pass timings
+            gDisplayProfiler = !gDisplayProfiler;
+            break;
+        case VK_F6:
+            // Save the last few seconds of timings for chrome://tracing
+            gProfiler.SaveChromeTrace(kProfileTracePath);
             break;
 
 		default:
@@ -627,6 +679,14 @@ void CALLBACK OnGUIEvent(UINT eventID, INT controlID, CDXUTControl* control, voi
             gUIConstants.visualizePerSampleShading = dynamic_cast<CDXUTCheckBox*>(control)->GetChecked(); break;            
         case UI_SELECTEDSCENE:
             DestroyScene(); break;
+        case UI_BATCHDRAWS:
+            sceneGraph.SetBatching(dynamic_cast<CDXUTCheckBox*>(control)->GetChecked()); break;
+        case UI_PARALLELRECORDING:
+            sceneGraph.SetParallelRecording(dynamic_cast<CDXUTCheckBox*>(control)->GetChecked()); break;
+        case UI_CULLLIGHTS:
+            gApp->SetLightCulling(gCullLightsCheck->GetChecked()); break;
+        case UI_OVERLAPPHYSICS:
+            gOverlapPhysics = dynamic_cast<CDXUTCheckBox*>(control)->GetChecked(); break;
         case UI_LIGHTS:
             gApp->SetActiveLights(DXUTGetD3D11Device(), 1 << gLightsSlider->GetValue()); break;
         case UI_CULLTECHNIQUE:
@@ -655,6 +715,7 @@ void CALLBACK OnD3D11DestroyDevice(void* userContext)
     gD3DSettingsDlg.OnD3D11DestroyDevice();
     DXUTGetGlobalResourceCache().OnDestroyDevice();
     SAFE_DELETE(gTextHelper);
+    SAFE_DELETE(gGpuProfiler);
 }
 
 
@@ -665,6 +726,7 @@ HRESULT CALLBACK OnD3D11CreateDevice(ID3D11Device* d3dDevice, const DXGI_SURFACE
     gDialogResourceManager.OnD3D11CreateDevice(d3dDevice, d3dDeviceContext);
     gD3DSettingsDlg.OnD3D11CreateDevice(d3dDevice);
     gTextHelper = new CDXUTTextHelper(d3dDevice, d3dDeviceContext, &gDialogResourceManager, 15);
+    gGpuProfiler = new D3D11GpuProfiler(d3dDevice, &gProfiler);
     
     gViewerCamera.SetRotateButtons(true, false, false);
     gViewerCamera.SetDrag(true);
@@ -731,22 +793,36 @@ void CALLBACK OnD3D11FrameRender(ID3D11Device* d3dDevice, ID3D11DeviceContext* d
         InitApp(d3dDevice);
     }
 
+    gProfiler.BeginFrame();
+    gGpuProfiler->BeginFrame(d3dDeviceContext);
+
+    gProfiler.BeginScope("Scene update");
+
     // Lazily load scene
 	/*!gMeshOpaque.IsLoaded() && !gMeshAlpha.IsLoaded() &&!gMeshOpaque2.IsLoaded()*/
-    if (!sceneGraph.IsLoaded()) {
+    if (sceneGraph.IsEmpty()) {
         InitScene(d3dDevice);
     }
 
-	EnginePhysics::StepPhysX();
+	// Pick up any models that have finished loading
+	sceneGraph.Update(d3dDevice);
+    gProfiler.EndScope();
+
+    gProfiler.BeginScope("Physics step");
+    // Fixed steps for the time that passed; when overlapped, the next step runs while this frame renders
+    EnginePhysics::AdvancePhysX(elapsedTime, gOverlapPhysics);
 	if(cubeList)
 	{
-		for(int i = 0; i < cubeList->size(); i++)
-		{
-			if( i == 100)
-				int x = 0;
-			sceneGraph.SetMeshPosition((*cubeList)[i]->id, (*cubeList)[i]->x, (*cubeList)[i]->y, (*cubeList)[i]->z);
+		// Only bodies that moved, interpolated between the last two steps, written straight into the scene
+		static vector<SceneHandle> movedIds;
+		static vector<RigidPose> movedPoses;
+
+		EnginePhysics::GetRenderPoses(&movedIds, &movedPoses);
+		if (!movedIds.empty()) {
+			sceneGraph.SetMeshPoses(&movedIds[0], &movedPoses[0], (unsigned int)movedIds.size());
 		}
 	}
+    gProfiler.EndScope();
 
     ID3D11RenderTargetView* pRTV = DXUTGetD3D11RenderTargetView();
 	
@@ -759,10 +835,15 @@ void CALLBACK OnD3D11FrameRender(ID3D11Device* d3dDevice, ID3D11DeviceContext* d
     viewport.TopLeftX = 0.0f;
     viewport.TopLeftY = 0.0f;
 
+    gProfiler.BeginScope("Render");
 		 gApp->Render(d3dDeviceContext, pRTV, sceneGraph, gSkyboxSRV,
         gWorldMatrix, &gViewerCamera, &viewport, &gUIConstants);
+    gProfiler.EndScope();
 	
     if (gDisplayUI) {
+        ScopedCpuTimer hudTimer(&gProfiler, "HUD");
+        ScopedGpuTimer hudGpuTimer(gGpuProfiler, d3dDeviceContext, "HUD");
+
         d3dDeviceContext->RSSetViewports(1, &viewport);
 
         // Render HUDs in reverse order
@@ -782,18 +863,50 @@ void CALLBACK OnD3D11FrameRender(ID3D11Device* d3dDevice, ID3D11DeviceContext* d
         // Output frame time
         {
             std::wostringstream oss;
-            oss << 1000.0f / DXUTGetFPS() << " ms / frame";
+            oss << 1000.0f / DXUTGetFPS() << " ms / frame, physics " << (gOverlapPhysics ? "overlapped" : "serialized");
             gTextHelper->DrawTextLine(oss.str().c_str());
         }
 
         // Output light info
         {
             std::wostringstream oss;
-            oss << "Lights: " << gApp->GetActiveLights();
+            oss << "Lights: " << gApp->GetActiveLights() << ", " << gApp->GetVisibleLights() << " uploaded";
             gTextHelper->DrawTextLine(oss.str().c_str());
         }
+
+        // Output what drawing the scene cost this frame
+        {
+            const SceneGraph::RenderStats& stats = sceneGraph.GetRenderStats();
+            std::wostringstream oss;
+            oss << "Scene: " << stats.objects << " objects in " << stats.drawCalls << " draws, " << stats.maps << " maps, "
+                << stats.commands << " commands on " << stats.commandLists << " deferred lists, " << stats.bytesUploaded / 1024 << " KB uploaded, "
+                << stats.cpuMilliseconds << " ms CPU over " << stats.passes << " passes";
+            gTextHelper->DrawTextLine(oss.str().c_str());
+        }
+
+        // Output per-pass timings, averaged over the last 30 frames
+        if (gDisplayProfiler) {
+            static const char* kTrackNames[] = { "CPU", "GPU" };
+            std::vector<ProfileSummary> summaries;
+            for (int track = 0; track < 2; ++track) {
+                gProfiler.Summarize(static_cast<ProfileTrack>(track), 30, &summaries);
+                for (size_t i = 0; i < summaries.size(); ++i) {
+                    std::wostringstream oss;
+                    oss.setf(std::ios::fixed);
+                    oss.precision(2);
+                    oss << kTrackNames[track] << " " << std::wstring(summaries[i].depth * 2, L' ')
+                        << summaries[i].name << ": " << summaries[i].milliseconds << " ms";
+                    gTextHelper->DrawTextLine(oss.str().c_str());
+                }
+            }
+        }
         
         gTextHelper->End();
     }
+
+    gGpuProfiler->EndFrame(d3dDeviceContext);
+    gProfiler.EndFrame();
+
+    sceneGraph.ResetRenderStats();
 }
 #pragma endregion
\ No newline at end of file
@@ -2,7 +2,8 @@
 // Filename: modelclass.cpp
 ////////////////////////////////////////////////////////////////////////////////
 #include "modelclass.h"
-#include "XnbModelData.h"
+#include "Xnb/XnbModelData.h"
+#include "Xnb/XnbParser.h"
 #include "Shader.h"
 
 
@@ -12,7 +13,13 @@ ModelClass::ModelClass()
 	m_vertexBuffer = 0;
 	m_indexBuffer = 0;
 	m_Texture = 0;
-	m_model = 0;
+	m_vertexCount = 0;
+	m_indexCount = 0;
+	m_indexFormat = DXGI_FORMAT_R32_UINT;
+	D3DXMatrixIdentity(&m_positionTransform);
+	m_boundsCenter = D3DXVECTOR3(0.0f, 0.0f, 0.0f);
+	m_boundsRadius = 0.0f;
+	isLoaded = false;
 	/*
 	std::string msaaSamplesStr;
     {
@@ -38,7 +45,7 @@ ModelClass::~ModelClass()
 }
 
 void ModelClass::ComputeInFrustumFlags(const D3DXMATRIXA16 &worldViewProj, bool cullNear){
-	//nothing
+	// Models are drawn whole, so are culled as a whole by the SceneGraph, from GetBoundingSphere.
 }
 
 
@@ -79,29 +86,74 @@ HRESULT ModelClass::CreateXnb( ID3D11Device* pDev11, string szFileName, bool bCr
 
 bool ModelClass::Initialize(ID3D11Device* device, char* modelFilename, WCHAR* textureFilename)
 {
-	bool result;
+	ModelData data;
 
 
 	// Load in the model data,
-	result = LoadModel(modelFilename);
+	if(!LoadModelData(modelFilename, textureFilename, &data))
+	{
+		return false;
+	}
+
+	return CreateFromData(device, data);
+}
+
+
+bool ModelClass::LoadModelData(char* modelFilename, WCHAR* textureFilename, ModelData* data)
+{
+	bool result;
+
+
+	// Parse the model file.
+	try
+	{
+		result = LoadModel(modelFilename, data);
+	}
+	catch(exception& e)
+	{
+		printf("Error: %s\n", e.what());
+		result = false;
+	}
+
 	if(!result)
 	{
 		return false;
 	}
 
+	// Models without a texture of their own fall back on the texture file, if one was given.
+	// Either way the texture itself is left to be created on the device thread.
+	if(!data->texture && textureFilename)
+	{
+		result = LoadTextureFile(textureFilename, data);
+		if(!result)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+bool ModelClass::CreateFromData(ID3D11Device* device, const ModelData& data)
+{
+	bool result;
+
+
 	// Initialize the vertex and index buffers.
-	result = InitializeBuffers(device);
+	result = InitializeBuffers(device, data);
 	if(!result)
 	{
 		return false;
 	}
 
 	// Load the texture for this model.
-	result = LoadTexture(device, textureFilename);
+	result = LoadTexture(device, data);
 	if(!result)
 	{
 		return false;
 	}
+	m_drawMesh.texture = ToRender(GetTexture());
 	isLoaded = true;
 	return true;
 }
@@ -119,9 +171,6 @@ void ModelClass::Shutdown()
 	// Shutdown the vertex and index buffers.
 	ShutdownBuffers();
 
-	// Release the model data.
-	ReleaseModel();
-
 	return;
 }
 
@@ -139,58 +188,109 @@ void ModelClass::Render(ID3D11DeviceContext* deviceContext,UINT iDiffuseSlot,
 	// Put the vertex and index buffers on the graphics pipeline to prepare them for drawing.
 //	CDXUTSDKMesh::RenderMesh();
 	RenderBuffers(deviceContext);
-	 deviceContext->DrawIndexed( m_indexCount, 0, 0 );
+	RenderTexture(deviceContext, iDiffuseSlot);
+	Draw(deviceContext);
 	return;
 }
 
 
+void ModelClass::RenderTexture(ID3D11DeviceContext* deviceContext, UINT iDiffuseSlot)
+{
+	// Bind the model's texture, where the caller has a slot for it.
+	if(m_Texture && iDiffuseSlot != INVALID_SAMPLER_SLOT)
+	{
+		ID3D11ShaderResourceView* texture = m_Texture->GetTexture();
+
+		deviceContext->PSSetShaderResources(iDiffuseSlot, 1, &texture);
+	}
+}
+
+
+void ModelClass::Draw(ID3D11DeviceContext* deviceContext)
+{
+	deviceContext->DrawIndexed( m_indexCount, 0, 0 );
+}
+
+
 int ModelClass::GetIndexCount()
 {
 	return m_indexCount;
 }
 
 
+ID3D11Buffer* ModelClass::GetVertexBuffer()
+{
+	return m_vertexBuffer;
+}
+
+
+const D3DXMATRIX& ModelClass::GetPositionTransform()
+{
+	return m_positionTransform;
+}
+
+
+void ModelClass::GetBoundingSphere(D3DXVECTOR3* center, float* radius)
+{
+	*center = m_boundsCenter;
+	*radius = m_boundsRadius;
+}
+
+
 ID3D11ShaderResourceView* ModelClass::GetTexture()
 {
+	if(!m_Texture)
+	{
+		return 0;
+	}
+
 	return m_Texture->GetTexture();
 }
 
 
-bool ModelClass::InitializeBuffers(ID3D11Device* device)
+const DrawMesh* ModelClass::GetDrawMesh()
+{
+	return &m_drawMesh;
+}
+
+
+bool ModelClass::InitializeBuffers(ID3D11Device* device, const ModelData& data)
 {
-	VertexType* vertices;
-	unsigned long* indices;
 	D3D11_BUFFER_DESC vertexBufferDesc, indexBufferDesc;
     D3D11_SUBRESOURCE_DATA vertexData, indexData;
 	HRESULT result;
-	int i;
+	bool is16BitIndices;
 
 
-	// Create the vertex array.
-	vertices = new VertexType[m_vertexCount];
-	if(!vertices)
-	{
-		return false;
-	}
+	// The vertex and index arrays were already built when the model was loaded.
+	is16BitIndices = !data.indices16.empty();
 
-	// Create the index array.
-	indices = new unsigned long[m_indexCount];
-	if(!indices)
-	{
-		return false;
-	}
+	// Undo the position quantization with the world matrix, rather than in the vertex shader.
+	D3DXMATRIX scale, translation;
+	D3DXMatrixScaling(&scale, data.positionScale, data.positionScale, data.positionScale);
+	D3DXMatrixTranslation(&translation, data.positionCenter.x, data.positionCenter.y, data.positionCenter.z);
+	m_positionTransform = scale * translation;
+
+	m_boundsCenter = data.boundsCenter;
+	m_boundsRadius = data.boundsRadius;
 
-	// Load the vertex array and index array with data.
-	for(i=0; i<m_vertexCount; i++)
+	m_vertexCount = (int)data.vertices.size();
+	m_indexCount = (int)(is16BitIndices ? data.indices16.size() : data.indices32.size());
+	m_indexFormat = is16BitIndices ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+
+	if(!m_vertexCount || !m_indexCount)
 	{
-		vertices[i].position = D3DXVECTOR3(m_model[i].x, m_model[i].y, m_model[i].z);
-		vertices[i].texture = D3DXVECTOR2(m_model[i].tu, m_model[i].tv);
-		vertices[i].normal = D3DXVECTOR3(m_model[i].nx, m_model[i].ny, m_model[i].nz);
-		//indices[i] = i;
+		return false;
 	}
 
-	for(i=0; i<m_indexCount; i++)
-		indices[i] = m_indices[i];
+	// The batcher applies the same scale and offset as the position transform.
+	m_drawMesh.vertexStride = sizeof(VertexType);
+	m_drawMesh.indexFormat = is16BitIndices ? INDEX_16 : INDEX_32;
+	m_drawMesh.indexCount = m_indexCount;
+	m_drawMesh.positionScale = data.positionScale;
+	m_drawMesh.positionOffset[0] = data.positionCenter.x;
+	m_drawMesh.positionOffset[1] = data.positionCenter.y;
+	m_drawMesh.positionOffset[2] = data.positionCenter.z;
 
 	// Set up the description of the static vertex buffer.
     vertexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
@@ -201,7 +301,7 @@ bool ModelClass::InitializeBuffers(ID3D11Device* device)
 	vertexBufferDesc.StructureByteStride = 0;
 
 	// Give the subresource structure a pointer to the vertex data.
-    vertexData.pSysMem = vertices;
+    vertexData.pSysMem = &data.vertices[0];
 	vertexData.SysMemPitch = 0;
 	vertexData.SysMemSlicePitch = 0;
 
@@ -211,17 +311,25 @@ bool ModelClass::InitializeBuffers(ID3D11Device* device)
 	{
 		return false;
 	}
+	m_drawMesh.vertexBuffer = ToRender(m_vertexBuffer);
 
 	// Set up the description of the static index buffer.
     indexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-    indexBufferDesc.ByteWidth = sizeof(int32_t) * m_indexCount;
+    indexBufferDesc.ByteWidth = (is16BitIndices ? sizeof(uint16_t) : sizeof(uint32_t)) * m_indexCount;
     indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
     indexBufferDesc.CPUAccessFlags = 0;
     indexBufferDesc.MiscFlags = 0;
 	indexBufferDesc.StructureByteStride = 0;
 
 	// Give the subresource structure a pointer to the index data.
-    indexData.pSysMem = indices;
+	if(is16BitIndices)
+	{
+		indexData.pSysMem = &data.indices16[0];
+	}
+	else
+	{
+		indexData.pSysMem = &data.indices32[0];
+	}
 	indexData.SysMemPitch = 0;
 	indexData.SysMemSlicePitch = 0;
 
@@ -231,13 +339,7 @@ bool ModelClass::InitializeBuffers(ID3D11Device* device)
 	{
 		return false;
 	}
-
-	// Release the arrays now that the vertex and index buffers have been created and loaded.
-	delete [] vertices;
-	vertices = 0;
-
-	delete [] indices;
-	indices = 0;
+	m_drawMesh.indexBuffer = ToRender(m_indexBuffer);
 
 	return true;
 }
@@ -258,6 +360,7 @@ void ModelClass::ShutdownBuffers()
 		m_vertexBuffer->Release();
 		m_vertexBuffer = 0;
 	}
+	m_drawMesh = DrawMesh();
 
 	return;
 }
@@ -277,22 +380,26 @@ void ModelClass::RenderBuffers(ID3D11DeviceContext* deviceContext)
 	deviceContext->IASetVertexBuffers(0, 1, &m_vertexBuffer, &stride, &offset);
 
     // Set the index buffer to active in the input assembler so it can be rendered.
-	deviceContext->IASetIndexBuffer(m_indexBuffer, DXGI_FORMAT_R32_UINT, 0);
+	deviceContext->IASetIndexBuffer(m_indexBuffer, m_indexFormat, 0);
 
     // Set the type of primitive that should be rendered from this vertex buffer, in this case triangles.
 	deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-	ID3D11ShaderResourceView *BloodyShader=0;
-	deviceContext->PSGetShaderResources(0,1,&BloodyShader);
-	deviceContext->PSSetShaderResources( 0, 1,&BloodyShader);
-	
+
 	return;
 }
 
 
-bool ModelClass::LoadTexture(ID3D11Device* device, WCHAR* filename)
+bool ModelClass::LoadTexture(ID3D11Device* device, const ModelData& data)
 {
 	bool result;
 
+
+	// Not every model has a texture.
+	if(!data.texture && data.textureFile.empty())
+	{
+		return true;
+	}
+
 	// Create the texture object.
 	m_Texture = new TextureClass;
 	if(!m_Texture)
@@ -300,8 +407,15 @@ bool ModelClass::LoadTexture(ID3D11Device* device, WCHAR* filename)
 		return false;
 	}
 
-	// Initialize the texture object.
-	result = m_Texture->Initialize(device, filename);
+	// Initialize the texture object, uploading .xnb textures exactly as they were stored.
+	if(data.texture)
+	{
+		result = m_Texture->Initialize(device, *data.texture);
+	}
+	else
+	{
+		result = m_Texture->Initialize(device, &data.textureFile[0], data.textureFile.size());
+	}
 	if(!result)
 	{
 		return false;
@@ -325,67 +439,247 @@ void ModelClass::ReleaseTexture()
 }
 
 
-bool ModelClass::LoadModel(char* filename)
+bool ModelClass::LoadTextureFile(WCHAR* filename, ModelData* data)
 {
-	int i;
-	int j;
-	vector<float> vertexData;
-	XnbModelData data(filename);
+	FILE* file;
+	long size;
+
 
-	// Read in the vertex count.
-	m_vertexCount = data.vertexData.size() / data.vertexDataSize; //vertexDataSize is the number of numbers that make up each vertex definition
-	vertexData = data.vertexData;
+	// Read the whole texture file into memory.
+	if(_wfopen_s(&file, filename, L"rb"))
+	{
+		return false;
+	}
 
-	// Set the number of indices
-	m_indexCount = data.indexData.size();
-	m_indices = data.indexData;
+	fseek(file, 0, SEEK_END);
+	size = ftell(file);
+	fseek(file, 0, SEEK_SET);
 
-	// Create the model using the vertex count that was read in.
-	m_model = new ModelType[m_vertexCount];
-	if(!m_model)
+	if(size <= 0)
 	{
+		fclose(file);
 		return false;
 	}
 
-	j=0;
-	ModelType* currentModel;
-	for(i=0; i < m_vertexCount; i++) //need to read xnb vertices backwards to make them compatible
+	data->textureFile.resize(size);
+
+	bool result = (fread(&data->textureFile[0], 1, size, file) == (size_t)size);
+
+	fclose(file);
+
+	return result;
+}
+
+
+// Texture references are relative to the model's directory, without the .xnb extension. A missing
+// or unreadable texture isn't fatal, as the model can still fall back on a texture file.
+void ModelClass::LoadReferencedTexture(char* modelFilename, const string& reference, ModelData* data)
+{
+	string textureFilename(modelFilename);
+	size_t directoryEnd = textureFilename.find_last_of("\\/");
+	XnbParser parser;
+
+
+	textureFilename.erase(directoryEnd == string::npos ? 0 : directoryEnd + 1);
+	textureFilename += reference + ".xnb";
+
+	try
+	{
+		data->texture = dynamic_pointer_cast<XnbTexture>(parser.parse((char*)textureFilename.c_str()));
+	}
+	catch(exception& e)
 	{
-		currentModel = &m_model[i];
+		printf("Error: %s\n", e.what());
+	}
+}
 
-		//pos
-		currentModel->z = vertexData[j++];
-		currentModel->y = vertexData[j++];
-		currentModel->x = vertexData[j++];
 
-		//norm
-		currentModel->nz = vertexData[j++];
-		currentModel->ny = vertexData[j++];
-		currentModel->nx = vertexData[j++];
-	
-		if(data.vertexDataSize > 6)
+// Converts -1..1 to a 16 bit signed normalized value.
+static int16_t QuantizeSnorm16(float value)
+{
+	value = max(-1.0f, min(1.0f, value));
+
+	return (int16_t)floor(value * 32767.0f + 0.5f);
+}
+
+
+// Octahedral normal encoding: project onto the octahedron |x| + |y| + |z| = 1, then fold
+// the lower half over the upper so it flattens to a square. GeometryPackedVS decodes it.
+static void EncodeOctahedralNormal(D3DXVECTOR3 normal, int16_t result[2])
+{
+	float length = fabs(normal.x) + fabs(normal.y) + fabs(normal.z);
+	float x, y;
+
+	if(length <= 0.0f)
+	{
+		result[0] = 0;
+		result[1] = 0;
+		return;
+	}
+
+	x = normal.x / length;
+	y = normal.y / length;
+
+	if(normal.z < 0.0f)
+	{
+		float foldedX = (1.0f - fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+		float foldedY = (1.0f - fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+
+		x = foldedX;
+		y = foldedY;
+	}
+
+	result[0] = QuantizeSnorm16(x);
+	result[1] = QuantizeSnorm16(y);
+}
+
+
+// Smooth normals for models built without them, from the area weighted normals of the faces
+// around each vertex. Fails if any index is out of range.
+template<typename IndexType>
+static bool ComputeNormals(const vector<IndexType>& indices, const vector<D3DXVECTOR3>& positions, vector<D3DXVECTOR3>* normals)
+{
+	size_t i;
+	int j;
+
+
+	normals->assign(positions.size(), D3DXVECTOR3(0.0f, 0.0f, 0.0f));
+
+	for(i = 0; i + 2 < indices.size(); i += 3)
+	{
+		D3DXVECTOR3 edge1, edge2, faceNormal;
+
+		for(j = 0; j < 3; j++)
 		{
-			//texture
-			currentModel->tu = vertexData[j++];
-			currentModel->tv = vertexData[j++];
+			if(indices[i + j] >= positions.size())
+			{
+				return false;
+			}
 		}
 
-		for(int a = data.vertexDataSize; a > 8; a--) //skip past the rest of the values
-			j++;
-		
+		// The models are mirrored into left handed space on load, which leaves this cross product facing outwards.
+		edge1 = positions[indices[i + 1]] - positions[indices[i]];
+		edge2 = positions[indices[i + 2]] - positions[indices[i]];
+		D3DXVec3Cross(&faceNormal, &edge1, &edge2);
+
+		for(j = 0; j < 3; j++)
+		{
+			(*normals)[indices[i + j]] += faceNormal;
+		}
+	}
+
+	for(i = 0; i < normals->size(); i++)
+	{
+		D3DXVec3Normalize(&(*normals)[i], &(*normals)[i]);
 	}
 
 	return true;
 }
 
 
-void ModelClass::ReleaseModel()
+bool ModelClass::LoadModel(char* filename, ModelData* data)
 {
-	if(m_model)
+	unsigned int i;
+	unsigned int vertexCount;
+	XnbModelData xnb(filename);
+	vector<D3DXVECTOR3> positions, normals;
+	D3DXVECTOR3 minimum, maximum, extent;
+
+
+	// The XNB loader has already decoded the vertices from whatever layout the model was built with.
+	vertexCount = xnb.vertexCount;
+
+	if(!vertexCount)
 	{
-		delete [] m_model;
-		m_model = 0;
+		return false;
 	}
 
-	return;
+	// Load the texture the model refers to, if any.
+	if(!xnb.textureReference.empty())
+	{
+		LoadReferencedTexture(filename, xnb.textureReference, data);
+	}
+
+	// Set the indices
+	data->indices16 = move(xnb.indexData16);
+	data->indices32 = move(xnb.indexData32);
+
+	// XNB models are right handed, so swap x and z to make them compatible.
+	positions.resize(vertexCount);
+
+	for(i=0; i < vertexCount; i++)
+	{
+		positions[i] = D3DXVECTOR3(xnb.positions[i*3 + 2], xnb.positions[i*3 + 1], xnb.positions[i*3]);
+	}
+
+	if(!xnb.normals.empty())
+	{
+		normals.resize(vertexCount);
+
+		for(i=0; i < vertexCount; i++)
+		{
+			normals[i] = D3DXVECTOR3(xnb.normals[i*3 + 2], xnb.normals[i*3 + 1], xnb.normals[i*3]);
+		}
+	}
+	else if(!(data->indices16.empty() ? ComputeNormals(data->indices32, positions, &normals) : ComputeNormals(data->indices16, positions, &normals)))
+	{
+		return false;
+	}
+
+	// Quantize the positions within a cube around the model's bounds. Using the same scale on
+	// every axis keeps the position transform uniform, so it doesn't skew the normals.
+	minimum = maximum = positions[0];
+
+	for(i=1; i < vertexCount; i++)
+	{
+		D3DXVec3Minimize(&minimum, &minimum, &positions[i]);
+		D3DXVec3Maximize(&maximum, &maximum, &positions[i]);
+	}
+
+	// Start from the bounding sphere stored with the model, making sure it covers every vertex.
+	data->boundsCenter = D3DXVECTOR3(xnb.boundingSphere[2], xnb.boundingSphere[1], xnb.boundingSphere[0]);
+	data->boundsRadius = xnb.boundingSphere[3];
+
+	for(i=0; i < vertexCount; i++)
+	{
+		D3DXVECTOR3 offset = positions[i] - data->boundsCenter;
+
+		data->boundsRadius = max(data->boundsRadius, D3DXVec3Length(&offset));
+	}
+
+	data->positionCenter = (minimum + maximum) * 0.5f;
+	extent = maximum - data->positionCenter;
+	data->positionScale = max(extent.x, max(extent.y, extent.z));
+
+	if(data->positionScale <= 0.0f)
+	{
+		data->positionScale = 1.0f;
+	}
+
+	// Pack the vertices.
+	data->vertices.resize(vertexCount);
+
+	for(i=0; i < vertexCount; i++)
+	{
+		VertexType* currentVertex = &data->vertices[i];
+		D3DXVECTOR3 position = (positions[i] - data->positionCenter) / data->positionScale;
+		float texture[2] = {0.0f, 0.0f};
+
+		currentVertex->position[0] = QuantizeSnorm16(position.x);
+		currentVertex->position[1] = QuantizeSnorm16(position.y);
+		currentVertex->position[2] = QuantizeSnorm16(position.z);
+		currentVertex->position[3] = 0;
+
+		if(!xnb.texCoords.empty())
+		{
+			texture[0] = xnb.texCoords[i*2];
+			texture[1] = xnb.texCoords[i*2 + 1];
+		}
+
+		D3DXFloat32To16Array(currentVertex->texture, texture, 2);
+
+		EncodeOctahedralNormal(normals[i], currentVertex->normal);
+	}
+
+	return true;
 }
\ No newline at end of file
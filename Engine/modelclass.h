@@ -28,7 +28,10 @@
 
 
 #include "textureclass.h"
-#include "stdafx.h"
+#include "Xnb/stdafx.h"
+#include "Xnb/XnbObjects.h"
+#include "Rendering/D3D11CommandList.h"
+#include "Rendering/DrawBatcher.h"
 
 using namespace std;
 ////////////////////////////////////////////////////////////////////////////////
@@ -36,33 +39,51 @@ using namespace std;
 ////////////////////////////////////////////////////////////////////////////////
 class ModelClass : public CDXUTSDKMesh
 {
-private:
+public:
+	// Vertices are packed into 16 bytes for the GPU, matching the GeometryPackedVS input layout.
 	struct VertexType
 	{
-		D3DXVECTOR3 position;
-	    D3DXVECTOR2 texture;
-		D3DXVECTOR3 normal;
+		int16_t position[4];		// R16G16B16A16_SNORM, quantized within a cube around the model (see GetPositionTransform).
+		D3DXFLOAT16 texture[2];		// R16G16_FLOAT
+		int16_t normal[2];			// R16G16_SNORM, octahedral encoded.
 	};
 
-	struct ModelType
+	// CPU side copy of a model, ready to be turned into GPU buffers. LoadModelData touches
+	// nothing but the disk, so it can run on any thread; CreateFromData must run on the
+	// device thread.
+	struct ModelData
 	{
-		float x, y, z;
-		float tu, tv;
-		float nx, ny, nz;
+		vector<VertexType> vertices;
+		D3DXVECTOR3 positionCenter;	// Quantized positions are scaled by positionScale, then offset by positionCenter.
+		float positionScale;
+		D3DXVECTOR3 boundsCenter;	// Sphere enclosing the model, before quantization.
+		float boundsRadius;
+		vector<uint16_t> indices16;	// Used instead of indices32 when every vertex can be addressed with 16 bits.
+		vector<uint32_t> indices32;
+		shared_ptr<XnbTexture const> texture;	// The texture the model refers to, if there is one.
+		vector<uint8_t> textureFile;			// Otherwise a texture file to fall back on, which may be empty.
 	};
 
+	static bool LoadModelData(char* modelFilename, WCHAR* textureFilename, ModelData* data);
+
 public:
 	ModelClass();
 	ModelClass(const ModelClass&);
 	~ModelClass();
 
 	bool Initialize(ID3D11Device*, char*, WCHAR*);
+	bool CreateFromData(ID3D11Device*, const ModelData&);
 	void Shutdown();
 	//void Render(ID3D11DeviceContext*);
 	void Render(ID3D11DeviceContext*, UINT iDiffuseSlot,
                                             UINT iNormalSlot,
                                             UINT iSpecularSlot);
 
+	// The steps of Render, so a run of draws sharing buffers or a texture sets them just once.
+	void RenderBuffers(ID3D11DeviceContext*);
+	void RenderTexture(ID3D11DeviceContext*, UINT iDiffuseSlot);
+	void Draw(ID3D11DeviceContext*);
+
 	//TODO implement
 	HRESULT Create( ID3D11Device* pDev11, LPCTSTR szFileName, bool bCreateAdjacencyIndices=
                                             false, SDKMESH_CALLBACKS11* pLoaderCallbacks=NULL );
@@ -75,26 +96,38 @@ public:
 	bool IsLoaded();
 
 	int GetIndexCount();
+	ID3D11Buffer* GetVertexBuffer();
 	ID3D11ShaderResourceView* GetTexture();
+	// What a DrawBatcher needs to draw the model, once it is loaded.
+	const DrawMesh* GetDrawMesh();
+
+	// Turns the quantized vertex positions back into model space, so goes in front of the world matrix.
+	const D3DXMATRIX& GetPositionTransform();
+
+	// Sphere enclosing the model, in model space.
+	void GetBoundingSphere(D3DXVECTOR3* center, float* radius);
 
 
 private:
-	bool InitializeBuffers(ID3D11Device*);
+	bool InitializeBuffers(ID3D11Device*, const ModelData&);
 	void ShutdownBuffers();
-	void RenderBuffers(ID3D11DeviceContext*);
 
-	bool LoadTexture(ID3D11Device*, WCHAR*);
+	bool LoadTexture(ID3D11Device*, const ModelData&);
 	void ReleaseTexture();
 
-	bool LoadModel(char*);
-	void ReleaseModel();
+	static bool LoadModel(char*, ModelData*);
+	static void LoadReferencedTexture(char*, const string&, ModelData*);
+	static bool LoadTextureFile(WCHAR*, ModelData*);
 
 private:
 	ID3D11Buffer *m_vertexBuffer, *m_indexBuffer;
 	int m_vertexCount, m_indexCount;
+	DXGI_FORMAT m_indexFormat;
+	D3DXMATRIX m_positionTransform;
+	D3DXVECTOR3 m_boundsCenter;
+	float m_boundsRadius;
 	TextureClass* m_Texture;
-	ModelType* m_model;
-	vector<uint32_t> m_indices;
+	DrawMesh m_drawMesh;
 	string m_textureReference;
 	bool isLoaded;
 	//PixelShader* mGBufferPS;
@@ -28,9 +28,7 @@ PxReal timestep = 1.0f/60.0f;
 void StepPhysX(){
 	dxScene->simulate(timestep);
 	
-	while(!dxScene->fetchResults()){
-
-	}
+	dxScene->fetchResults(true);
 }
 
 void initPhysX() {
@@ -2,6 +2,8 @@
 // Filename: textureclass.cpp
 ////////////////////////////////////////////////////////////////////////////////
 #include "textureclass.h"
+#include "Xnb/stdafx.h"
+#include "Xnb/XnbObjects.h"
 
 
 TextureClass::TextureClass()
@@ -36,6 +38,225 @@ bool TextureClass::Initialize(ID3D11Device* device, WCHAR* filename)
 }
 
 
+bool TextureClass::Initialize(ID3D11Device* device, const void* fileData, size_t fileSize)
+{
+	HRESULT result;
+
+
+	// Create the texture from a file that has already been read into memory.
+	result = D3DX11CreateShaderResourceViewFromMemory(device, fileData, fileSize, NULL, NULL, &m_texture, NULL);
+	if(FAILED(result))
+	{
+		return false;
+	}
+
+	return true;
+}
+
+
+// The DXGI equivalent of an XNA SurfaceFormat, or DXGI_FORMAT_UNKNOWN if Direct3D 11 has none.
+static DXGI_FORMAT GetDxgiFormat(int32_t format)
+{
+	switch(format)
+	{
+	case SurfaceFormatColor:			return DXGI_FORMAT_R8G8B8A8_UNORM;
+	case SurfaceFormatBgr565:			return DXGI_FORMAT_B5G6R5_UNORM;
+	case SurfaceFormatBgra5551:			return DXGI_FORMAT_B5G5R5A1_UNORM;
+	case SurfaceFormatDxt1:				return DXGI_FORMAT_BC1_UNORM;
+	case SurfaceFormatDxt3:				return DXGI_FORMAT_BC2_UNORM;
+	case SurfaceFormatDxt5:				return DXGI_FORMAT_BC3_UNORM;
+	case SurfaceFormatNormalizedByte2:	return DXGI_FORMAT_R8G8_SNORM;
+	case SurfaceFormatNormalizedByte4:	return DXGI_FORMAT_R8G8B8A8_SNORM;
+	case SurfaceFormatRgba1010102:		return DXGI_FORMAT_R10G10B10A2_UNORM;
+	case SurfaceFormatRg32:				return DXGI_FORMAT_R16G16_UNORM;
+	case SurfaceFormatRgba64:			return DXGI_FORMAT_R16G16B16A16_UNORM;
+	case SurfaceFormatAlpha8:			return DXGI_FORMAT_A8_UNORM;
+	case SurfaceFormatSingle:			return DXGI_FORMAT_R32_FLOAT;
+	case SurfaceFormatVector2:			return DXGI_FORMAT_R32G32_FLOAT;
+	case SurfaceFormatVector4:			return DXGI_FORMAT_R32G32B32A32_FLOAT;
+	case SurfaceFormatHalfSingle:		return DXGI_FORMAT_R16_FLOAT;
+	case SurfaceFormatHalfVector2:		return DXGI_FORMAT_R16G16_FLOAT;
+	case SurfaceFormatHalfVector4:
+	case SurfaceFormatHdrBlendable:		return DXGI_FORMAT_R16G16B16A16_FLOAT;
+	default:							return DXGI_FORMAT_UNKNOWN;	// Bgra4444 included.
+	}
+}
+
+
+// Bytes per 4x4 block for the block compressed formats, or per pixel for the rest.
+static UINT GetFormatSize(DXGI_FORMAT format, bool* isBlockCompressed)
+{
+	*isBlockCompressed = false;
+
+	switch(format)
+	{
+	case DXGI_FORMAT_BC1_UNORM:
+		*isBlockCompressed = true;
+		return 8;
+	case DXGI_FORMAT_BC2_UNORM:
+	case DXGI_FORMAT_BC3_UNORM:
+		*isBlockCompressed = true;
+		return 16;
+	case DXGI_FORMAT_A8_UNORM:
+		return 1;
+	case DXGI_FORMAT_B5G6R5_UNORM:
+	case DXGI_FORMAT_B5G5R5A1_UNORM:
+	case DXGI_FORMAT_R8G8_SNORM:
+	case DXGI_FORMAT_R16_FLOAT:
+		return 2;
+	case DXGI_FORMAT_R16G16B16A16_UNORM:
+	case DXGI_FORMAT_R16G16B16A16_FLOAT:
+	case DXGI_FORMAT_R32G32_FLOAT:
+		return 8;
+	case DXGI_FORMAT_R32G32B32A32_FLOAT:
+		return 16;
+	default:
+		return 4;
+	}
+}
+
+
+bool TextureClass::Initialize(ID3D11Device* device, const XnbTexture& texture)
+{
+	D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc;
+	vector<D3D11_SUBRESOURCE_DATA> initialData;
+	ID3D11Resource* resource = 0;
+	DXGI_FORMAT format;
+	UINT formatSize;
+	bool isBlockCompressed;
+	bool isVolume;
+	HRESULT result;
+	UINT face, mip;
+
+
+	format = GetDxgiFormat(texture.format);
+	if(format == DXGI_FORMAT_UNKNOWN || !texture.width || !texture.height || !texture.mipCount)
+	{
+		return false;
+	}
+
+	formatSize = GetFormatSize(format, &isBlockCompressed);
+	isVolume = (dynamic_cast<const XnbTexture3D*>(&texture) != 0);
+
+	if(texture.subresources.size() != texture.faceCount * texture.mipCount)
+	{
+		return false;
+	}
+
+	// Point Direct3D straight at the pixel data from the file, working out the pitches of each mip.
+	// Block compressed data is described in rows of 4x4 blocks, and uploaded as it is.
+	initialData.resize(texture.subresources.size());
+
+	for(face = 0; face < texture.faceCount; face++)
+	{
+		for(mip = 0; mip < texture.mipCount; mip++)
+		{
+			UINT index = face * texture.mipCount + mip;
+			UINT width = max(texture.width >> mip, 1u);
+			UINT height = max(texture.height >> mip, 1u);
+			UINT depth = isVolume ? max(texture.depth >> mip, 1u) : 1;
+			UINT rowPitch, rowCount;
+
+			if(isBlockCompressed)
+			{
+				rowPitch = ((width + 3) / 4) * formatSize;
+				rowCount = (height + 3) / 4;
+			}
+			else
+			{
+				rowPitch = width * formatSize;
+				rowCount = height;
+			}
+
+			if(texture.subresources[index].size < rowPitch * rowCount * depth)
+			{
+				return false;
+			}
+
+			initialData[index].pSysMem = texture.SubresourceData(index);
+			initialData[index].SysMemPitch = rowPitch;
+			initialData[index].SysMemSlicePitch = rowPitch * rowCount;
+		}
+	}
+
+	// Create the texture itself.
+	if(isVolume)
+	{
+		D3D11_TEXTURE3D_DESC desc;
+		ID3D11Texture3D* texture3D;
+
+		desc.Width = texture.width;
+		desc.Height = texture.height;
+		desc.Depth = texture.depth;
+		desc.MipLevels = texture.mipCount;
+		desc.Format = format;
+		desc.Usage = D3D11_USAGE_IMMUTABLE;
+		desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		desc.CPUAccessFlags = 0;
+		desc.MiscFlags = 0;
+
+		result = device->CreateTexture3D(&desc, &initialData[0], &texture3D);
+		resource = texture3D;
+	}
+	else
+	{
+		D3D11_TEXTURE2D_DESC desc;
+		ID3D11Texture2D* texture2D;
+
+		desc.Width = texture.width;
+		desc.Height = texture.height;
+		desc.MipLevels = texture.mipCount;
+		desc.ArraySize = texture.faceCount;
+		desc.Format = format;
+		desc.SampleDesc.Count = 1;
+		desc.SampleDesc.Quality = 0;
+		desc.Usage = D3D11_USAGE_IMMUTABLE;
+		desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		desc.CPUAccessFlags = 0;
+		desc.MiscFlags = (texture.faceCount == 6) ? D3D11_RESOURCE_MISC_TEXTURECUBE : 0;
+
+		result = device->CreateTexture2D(&desc, &initialData[0], &texture2D);
+		resource = texture2D;
+	}
+
+	if(FAILED(result))
+	{
+		return false;
+	}
+
+	// Create a view of the whole mip chain.
+	ZeroMemory(&viewDesc, sizeof(viewDesc));
+	viewDesc.Format = format;
+
+	if(isVolume)
+	{
+		viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE3D;
+		viewDesc.Texture3D.MipLevels = texture.mipCount;
+	}
+	else if(texture.faceCount == 6)
+	{
+		viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBE;
+		viewDesc.TextureCube.MipLevels = texture.mipCount;
+	}
+	else
+	{
+		viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+		viewDesc.Texture2D.MipLevels = texture.mipCount;
+	}
+
+	result = device->CreateShaderResourceView(resource, &viewDesc, &m_texture);
+
+	// The view holds its own reference to the texture.
+	resource->Release();
+
+	if(FAILED(result))
+	{
+		return false;
+	}
+
+	return true;
+}
+
 void TextureClass::Shutdown()
 {
 	// Release the texture resource.
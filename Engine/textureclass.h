@@ -12,6 +12,9 @@
 #include <d3dx11tex.h>
 
 
+class XnbTexture;
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // Class name: TextureClass
 ////////////////////////////////////////////////////////////////////////////////
@@ -23,6 +26,8 @@ public:
 	~TextureClass();
 
 	bool Initialize(ID3D11Device*, WCHAR*);
+	bool Initialize(ID3D11Device*, const void*, size_t);
+	bool Initialize(ID3D11Device*, const XnbTexture&);
 	void Shutdown();
 
 	ID3D11ShaderResourceView* GetTexture();